@@ -6,6 +6,7 @@
  * This project demonstrates controlling two LEDs using the PIC16F877A microcontroller. 
  * The project showcases both current sourcing and current sinking configurations, 
  * along with the use of input pins with pull-up and pull-down resistors.
+ * The inputs are debounced from a 4 ms Timer2 tick (common/debounce.c).
  */
  
 // Configuration Bits
@@ -23,8 +24,28 @@
  
 // Define crystal frequency
 #define _XTAL_FREQ 8000000
+
+#include <stdint.h>
+#include "../../common/debounce.h"
+
+// Timer2 at twice the tick rate, halved by its 1:2 postscaler (one tick does not fit PR2 at 8 MHz)
+#define TMR2_RATE_HZ (2000 / DEBOUNCE_TICK_MS)
+#include "../../common/clockcalc.h"
+
+#define BUTTON1 1   // RB1, pull-up: pressed = low
+#define BUTTON2 2   // RB2, pull-down: pressed = high
+
+void __interrupt() ISR(void) {
+    if (TMR2IF) {
+        TMR2IF = 0;
+        debounce_tick(PORTB);
+    }
+}
  
 void main() {
+    uint8_t event;
+
+
     // Configure I/O pins
     TRISB0 = 0; // Set RB0 as output for current sourcing (LED1)
     TRISB3 = 0; // Set RB3 as output for current sinking (LED2)
@@ -34,21 +55,41 @@ void main() {
     // Initialize outputs
     RB0 = 0; // Ensure LED1 is off initially
     RB3 = 1; // Ensure LED2 is off initially (active low configuration)
+
+    // Debounce RB1/RB2 every DEBOUNCE_TICK_MS
+    debounce_init((1 << BUTTON1) | (1 << BUTTON2), 1 << BUTTON1, 0);
+    T2CON = 0x00;
+    T2CONbits.T2CKPS = TMR2_CKPS_VALUE;
+    T2CONbits.TOUTPS = 1;   // 1:2 postscaler
+    PR2 = TMR2_PR2_VALUE;
+    TMR2IF = 0;
+    TMR2IE = 1;
+    PEIE = 1;
+    GIE = 1;
+    TMR2ON = 1;
     
     // Main program loop
     while (1) {
-        // Check state of RB1 (pull-up configuration)
-        if (RB1 == 0) {
-            RB0 = 1; // Turn on LED1 (current sourcing)
-        } else {
-            RB0 = 0; // Turn off LED1
+        if (!debounce_get(&event)) {
+            continue;
+        }
+        
+        // RB1 (pull-up configuration)
+        if (DEBOUNCE_BIT(event) == BUTTON1) {
+            if (DEBOUNCE_TYPE(event) == DEBOUNCE_PRESS) {
+                RB0 = 1; // Turn on LED1 (current sourcing)
+            } else if (DEBOUNCE_TYPE(event) == DEBOUNCE_RELEASE) {
+                RB0 = 0; // Turn off LED1
+            }
         }
         
-        // Check state of RB2 (pull-down configuration)
-        if (RB2 == 1) {
-            RB3 = 0; // Turn on LED2 (current sinking)
-        } else {
-            RB3 = 1; // Turn off LED2
+        // RB2 (pull-down configuration)
+        if (DEBOUNCE_BIT(event) == BUTTON2) {
+            if (DEBOUNCE_TYPE(event) == DEBOUNCE_PRESS) {
+                RB3 = 0; // Turn on LED2 (current sinking)
+            } else if (DEBOUNCE_TYPE(event) == DEBOUNCE_RELEASE) {
+                RB3 = 1; // Turn off LED2
+            }
         }
     }
 }
\ No newline at end of file
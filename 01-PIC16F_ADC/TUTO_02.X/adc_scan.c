@@ -0,0 +1,170 @@
+/* File:   adc_scan.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Interrupt-driven multi-channel ADC scanner (see adc_scan.h).
+ * The two sample buffers are separate arrays so each one fits in a RAM bank. Ownership is
+ * passed with the single-byte 'ready' flag: the ISR only sets it while it is clear and the
+ * main loop only clears it after the callback, so neither side has to mask interrupts.
+ */
+
+#include <xc.h>
+#include <stdint.h>
+#include "adc_scan.h"
+
+#define ADC_READY_NONE 0
+#define ADC_READY_A    1
+#define ADC_READY_B    2
+
+static uint16_t buffer_a[ADC_SCAN_BUFFER_SIZE];
+static uint16_t buffer_b[ADC_SCAN_BUFFER_SIZE];
+
+// Scan list
+static uint8_t scan_channels[ADC_SCAN_MAX_CHANNELS];
+static uint8_t scan_count = 1;
+static uint8_t scan_samples = ADC_SCAN_DEPTH;   // scan_count * ADC_SCAN_DEPTH
+static adc_scan_callback_t scan_callback;
+
+// ISR state: buffer being filled, next slot in it and the channel being converted
+static uint16_t *volatile fill_buffer = buffer_a;
+static volatile uint8_t fill_pos = 0;
+static volatile uint8_t fill_is_b = 0;
+static volatile uint8_t channel_index = 0;
+
+// Full buffer waiting for the main loop (written by ISR when clear, cleared by main loop)
+static volatile uint8_t ready = ADC_READY_NONE;
+static volatile uint16_t overruns = 0;
+
+static void select_channel(uint8_t channel)
+{
+    ADCON0 = (uint8_t)((ADCON0 & 0xC7) | (channel << 3));
+}
+
+void adc_scan_init(const uint8_t *channels, uint8_t count, adc_scan_callback_t on_ready)
+{
+    uint8_t i;
+
+    if (count == 0) {
+        count = 1;
+    }
+    if (count > ADC_SCAN_MAX_CHANNELS) {
+        count = ADC_SCAN_MAX_CHANNELS;
+    }
+    for (i = 0; i < count; i++) {
+        scan_channels[i] = channels[i] & 0x07;
+    }
+    scan_count = count;
+    scan_samples = (uint8_t)(count * ADC_SCAN_DEPTH);
+    scan_callback = on_ready;
+
+    // ADC: all AN pins analog, right-justified result, A/D clock from ADC_ADCS
+    ADCON1 = (uint8_t)(0x80 | ((ADC_ADCS & 0x4) << 4));
+    ADCON0 = (uint8_t)(((ADC_ADCS & 0x3) << 6) | 0x01);
+    select_channel(scan_channels[0]);
+
+    // Timer1: internal clock, 1:1 prescaler, stopped until adc_scan_start()
+    T1CON = 0x00;
+    TMR1 = 0;
+
+    // CCP2 compare, special event trigger: resets Timer1 and sets GO on every match
+    CCP2CON = 0x00;
+    CCPR2 = (uint16_t)(ADC_FCY / ((unsigned long)ADC_SCAN_RATE_HZ * count) - 1);
+    CCP2CON = 0x0B;
+
+    ADIF = 0;
+    ADIE = 1;
+    PEIE = 1;
+    GIE = 1;
+}
+
+void adc_scan_start(void)
+{
+    TMR1ON = 0;
+    ADIE = 0;
+    fill_buffer = buffer_a;
+    fill_is_b = 0;
+    fill_pos = 0;
+    channel_index = 0;
+    ready = ADC_READY_NONE;
+    overruns = 0;
+    select_channel(scan_channels[0]);
+    ADIF = 0;
+    ADIE = 1;
+
+    // The first trigger comes one full period later, which covers the first acquisition
+    TMR1 = 0;
+    TMR1ON = 1;
+}
+
+void adc_scan_stop(void)
+{
+    TMR1ON = 0;
+    ADIE = 0;
+}
+
+uint8_t adc_scan_poll(void)
+{
+    uint8_t which = ready;
+
+    if (which == ADC_READY_NONE) {
+        return 0;
+    }
+    if (scan_callback != 0) {
+        scan_callback(which == ADC_READY_A ? buffer_a : buffer_b, ADC_SCAN_DEPTH, scan_count);
+    }
+    ready = ADC_READY_NONE;     // Hand the buffer back to the ISR
+    return 1;
+}
+
+uint16_t adc_scan_overruns(void)
+{
+    uint16_t count;
+    uint8_t adie = ADIE;
+
+    // 16-bit counter written by the ISR; ADIE stays off after adc_scan_stop()
+    ADIE = 0;
+    count = overruns;
+    ADIE = adie;
+    return count;
+}
+
+void adc_scan_isr(void)
+{
+    uint8_t next;
+
+    if (!(ADIE && ADIF)) {
+        return;
+    }
+    ADIF = 0;
+
+    // Switch the multiplexer first: the next channel acquires until the next trigger
+    next = (uint8_t)(channel_index + 1);
+    if (next >= scan_count) {
+        next = 0;
+    }
+    select_channel(scan_channels[next]);
+    channel_index = next;
+
+    fill_buffer[fill_pos] = ((uint16_t)ADRESH << 8) | ADRESL;
+    fill_pos++;
+    if (fill_pos < scan_samples) {
+        return;
+    }
+
+    // Buffer full: publish it and continue in the other one, unless the main loop still
+    // holds the other one, in which case this buffer is refilled and counted as lost
+    fill_pos = 0;
+    if (ready != ADC_READY_NONE) {
+        overruns++;
+        return;
+    }
+    if (fill_is_b) {
+        ready = ADC_READY_B;
+        fill_buffer = buffer_a;
+        fill_is_b = 0;
+    } else {
+        ready = ADC_READY_A;
+        fill_buffer = buffer_b;
+        fill_is_b = 1;
+    }
+}
@@ -0,0 +1,114 @@
+/* File:   adc_scan.h
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Interrupt-driven multi-channel ADC scanner for the PIC16F877A.
+ * CCP2 in compare mode with special event trigger resets Timer1 and sets GO at a fixed
+ * rate, so conversions start without any CPU involvement. The ADIF interrupt stores each
+ * result, selects the next channel of the scan list and counts samples into one of two
+ * ping-pong buffers. When a buffer is full it is handed to the main loop (adc_scan_poll()
+ * runs the ready-buffer callback) while the ISR keeps filling the other one.
+ *
+ * The next channel is selected right after each conversion, so it acquires for the rest of
+ * the trigger interval; the compile-time checks below make sure that interval covers the
+ * acquisition time plus the conversion itself.
+ *
+ * The application must call adc_scan_isr() from its __interrupt() routine.
+ */
+
+#ifndef ADC_SCAN_H
+#define ADC_SCAN_H
+
+#include <stdint.h>
+
+// Crystal of this project (see newmain.c)
+#ifndef _XTAL_FREQ
+#define _XTAL_FREQ 4000000
+#endif
+
+// Full scans (every channel of the list once) per second
+#ifndef ADC_SCAN_RATE_HZ
+#define ADC_SCAN_RATE_HZ 1000
+#endif
+
+// Longest scan list and number of scans collected in each buffer
+#ifndef ADC_SCAN_MAX_CHANNELS
+#define ADC_SCAN_MAX_CHANNELS 8
+#endif
+#ifndef ADC_SCAN_DEPTH
+#define ADC_SCAN_DEPTH 4
+#endif
+
+// Acquisition time after a channel switch (datasheet Eq. 11-1: 19.72 us at 5 V, 50 C)
+#ifndef ADC_ACQUISITION_US
+#define ADC_ACQUISITION_US 20
+#endif
+
+// Worst-case cycles from the end of a conversion to the channel switch in the ISR
+#define ADC_SCAN_ISR_CYCLES 40
+
+#define ADC_SCAN_BUFFER_SIZE (ADC_SCAN_MAX_CHANNELS * ADC_SCAN_DEPTH)
+
+// A/D clock: the fastest Fosc divider that keeps TAD >= 1.6 us (datasheet Table 11-1)
+#if _XTAL_FREQ <= 1250000
+#define ADC_TAD_DIV 2
+#define ADC_ADCS    0x0     // ADCS2:ADCS1:ADCS0
+#elif _XTAL_FREQ <= 2500000
+#define ADC_TAD_DIV 4
+#define ADC_ADCS    0x4
+#elif _XTAL_FREQ <= 5000000
+#define ADC_TAD_DIV 8
+#define ADC_ADCS    0x1
+#elif _XTAL_FREQ <= 10000000
+#define ADC_TAD_DIV 16
+#define ADC_ADCS    0x5
+#elif _XTAL_FREQ <= 20000000
+#define ADC_TAD_DIV 32
+#define ADC_ADCS    0x2
+#else
+#define ADC_TAD_DIV 64
+#define ADC_ADCS    0x6
+#endif
+
+// Timer1 counts Fosc/4 with a 1:1 prescaler; CCPR2 = trigger period - 1
+#define ADC_FCY              (_XTAL_FREQ / 4)
+#define ADC_CONVERSION_TCY   (12UL * ADC_TAD_DIV / 4)
+#define ADC_ACQUISITION_TCY  (ADC_ACQUISITION_US * (ADC_FCY / 1000UL) / 1000UL + 1)
+#define ADC_TRIGGER_MIN_TCY  (ADC_CONVERSION_TCY + ADC_ACQUISITION_TCY + ADC_SCAN_ISR_CYCLES)
+
+#if ADC_FCY / (ADC_SCAN_RATE_HZ * ADC_SCAN_MAX_CHANNELS) < ADC_TRIGGER_MIN_TCY
+#error "ADC_SCAN_RATE_HZ too high: no time to acquire and convert every channel"
+#endif
+#if ADC_FCY / ADC_SCAN_RATE_HZ > 65536UL
+#error "ADC_SCAN_RATE_HZ too low for the 16-bit CCP2 compare period"
+#endif
+#if ADC_SCAN_MAX_CHANNELS < 1 || ADC_SCAN_MAX_CHANNELS > 8
+#error "ADC_SCAN_MAX_CHANNELS must be 1..8 (AN0..AN7)"
+#endif
+#if ADC_SCAN_BUFFER_SIZE * 2 > 80
+#error "Each ADC buffer must fit in one 80-byte RAM bank"
+#endif
+
+// Called from adc_scan_poll() with a full buffer: samples[scan * channels + i] is the
+// result of the i-th channel of the list in that scan (right-justified, 0..1023)
+typedef void (*adc_scan_callback_t)(const uint16_t *samples, uint8_t scans, uint8_t channels);
+
+// Configure the ADC, Timer1 and CCP2 for the given channel list (AN numbers, 1..8 entries).
+// The list is copied. Sampling starts with adc_scan_start().
+void adc_scan_init(const uint8_t *channels, uint8_t count, adc_scan_callback_t on_ready);
+
+// Start/stop the trigger; buffers restart empty
+void adc_scan_start(void);
+void adc_scan_stop(void);
+
+// Run the callback if a buffer is ready, then hand it back to the ISR.
+// Returns 1 if the callback ran.
+uint8_t adc_scan_poll(void);
+
+// Buffers discarded because the previous one had not been polled yet
+uint16_t adc_scan_overruns(void);
+
+// Service ADIF; call from the application's interrupt routine
+void adc_scan_isr(void);
+
+#endif /* ADC_SCAN_H */
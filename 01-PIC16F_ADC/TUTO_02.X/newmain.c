@@ -8,13 +8,19 @@
  * and lights up the LEDs based on the ADC values. The ADC results are checked against predefined
  * thresholds to determine which LEDs to turn on, providing a simple method for visualizing analog
  * input values.
+ *
+ * AN0..AN3 are scanned in the background by the interrupt-driven engine in adc_scan.c
+ * (CCP2 special event trigger + ADIF); the LEDs follow the average of the AN0 samples of
+ * each completed buffer.
  */
- 
+
 #include <xc.h>
 #include <stdint.h> // Include stdint.h for uint16_t data type
- 
+
 #define _XTAL_FREQ 4000000 // Define the crystal frequency in Hertz
- 
+
+#include "adc_scan.h"
+
 // CONFIG
 #pragma config FOSC = XT        // Oscillator Selection bits (XT oscillator)
 #pragma config WDTE = OFF       // Watchdog Timer Enable bit (WDT disabled)
@@ -24,13 +30,20 @@
 #pragma config CPD = OFF        // Data EEPROM Memory Code Protection bit (Data EEPROM code protection off)
 #pragma config WRT = OFF        // Flash Program Memory Write Enable bits (Write protection off; all program memory may be written to by EECON control)
 #pragma config CP = OFF         // Flash Program Memory Code Protection bit (Code protection off)
- 
+
+// Channels scanned by the ADC engine; AN0 (potentiometer) drives the LEDs
+static const uint8_t scan_list[] = { 0, 1, 2, 3 };
+#define SCAN_COUNT (sizeof(scan_list) / sizeof(scan_list[0]))
+
 // Function prototypes
-void configure_ADC(void);
-void start_ADC_conversion(void);
-void wait_for_conversion(void);
-void read_ADC_result(void);
- 
+void on_samples_ready(const uint16_t *samples, uint8_t scans, uint8_t channels);
+void show_level(uint16_t ADC_result);
+
+// Interrupt routine: the ADC engine owns ADIF
+void __interrupt() ISR(void) {
+    adc_scan_isr();
+}
+
 // Main function
 void main(void) {
     // Initialize ports for LEDs
@@ -38,58 +51,43 @@ void main(void) {
     TRISBbits.TRISB1 = 0; // Set RB1 as output
     TRISBbits.TRISB2 = 0; // Set RB2 as output
     TRISBbits.TRISB3 = 0; // Set RB3 as output
- 
+
     // Turn off all LEDs initially
     PORTBbits.RB0 = 0;
     PORTBbits.RB1 = 0;
     PORTBbits.RB2 = 0;
     PORTBbits.RB3 = 0;
- 
-    // Configure ADC module
-    configure_ADC();
-    
+
+    // Configure the ADC engine and start sampling at ADC_SCAN_RATE_HZ
+    adc_scan_init(scan_list, SCAN_COUNT, on_samples_ready);
+    adc_scan_start();
+
     while (1) {
-        // Start ADC conversion
-        start_ADC_conversion();
-        
-        // Wait for conversion to complete
-        wait_for_conversion();
-        
-        // Read ADC result and control LEDs
-        read_ADC_result();
-        
-        // Add a delay between ADC conversions to ensure proper timing
-        __delay_ms(1000); // Adjust delay time as needed
+        // Process each full buffer; conversions continue in the background
+        adc_scan_poll();
     }
 }
- 
-// Function to configure the ADC module
-void configure_ADC(void) {
-    ADCON0 = 0x41;  // Turn ADC ON, select AN0 channel, ADC clock = Fosc/8
-    ADCON1 = 0x80;  // All 8 channels are analog, result is "right-justified"
-                    // ADC clock = Fosc/8
-}
- 
-// Function to start ADC conversion
-void start_ADC_conversion(void) {
-    ADCON0bits.GO_DONE = 1; // Start A/D conversion
-}
- 
-// Function to wait for ADC conversion to complete
-void wait_for_conversion(void) {
-    while (ADCON0bits.GO_DONE); // Polling GO_DONE = delay until conversion is complete
+
+// Called by adc_scan_poll() with ADC_SCAN_DEPTH scans of every channel
+void on_samples_ready(const uint16_t *samples, uint8_t scans, uint8_t channels) {
+    uint16_t sum = 0;
+    uint8_t i;
+
+    // AN0 is the first entry of the scan list
+    for (i = 0; i < scans; i++) {
+        sum += samples[i * channels];
+    }
+    show_level(sum / scans);
 }
- 
-// Function to read ADC result and control LEDs
-void read_ADC_result(void) {
-    uint16_t ADC_result = ((uint16_t)ADRESH << 8) + ADRESL; // Read the right-justified 10-bit result
-    
+
+// Function to control the LEDs from a right-justified 10-bit result
+void show_level(uint16_t ADC_result) {
     // Turn off all LEDs initially
     PORTBbits.RB0 = 0;
     PORTBbits.RB1 = 0;
     PORTBbits.RB2 = 0;
     PORTBbits.RB3 = 0;
-    
+
     // Check ADC result and control LEDs accordingly
     if (ADC_result > 250) {
         // ADC result is greater than 250, turn on LED1
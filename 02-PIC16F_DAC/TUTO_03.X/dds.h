@@ -0,0 +1,74 @@
+/* File:   dds.h
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Direct digital synthesis (DDS) waveform generator for the 8-bit DAC on PORTB.
+ * Timer2 interrupts at DDS_SAMPLE_RATE; each interrupt first writes the sample computed for
+ * it to the DAC (a fixed number of cycles after the period match, so the output has no loop
+ * jitter), then adds the tuning word to a 16-bit phase accumulator. The top 8 bits of the
+ * phase index a 256-entry waveform table held in program memory.
+ *
+ *   f_out = tuning_word * DDS_SAMPLE_RATE / 65536
+ *
+ * A new tuning word takes effect at the next sample without a phase jump. A new waveform is
+ * latched when the phase accumulator wraps, so every period is made of one table only (with
+ * a tuning word of 0 the output holds its level and the waveform does not change).
+ *
+ * The application must call dds_isr() from its __interrupt() routine.
+ */
+
+#ifndef DDS_H
+#define DDS_H
+
+#include <stdint.h>
+
+// Crystal of this project (see newmain.c)
+#ifndef _XTAL_FREQ
+#define _XTAL_FREQ 4000000
+#endif
+
+// Samples per second written to the DAC
+#ifndef DDS_SAMPLE_RATE
+#define DDS_SAMPLE_RATE 8000
+#endif
+
+// DAC port
+#ifndef DDS_OUT
+#define DDS_OUT PORTB
+#endif
+
+// Worst-case cycles of the interrupt entry, dds_isr() and exit
+#define DDS_ISR_CYCLES 60
+
+#if _XTAL_FREQ / 4 / DDS_SAMPLE_RATE < DDS_ISR_CYCLES * 2
+#error "DDS_SAMPLE_RATE leaves less than half of the CPU to the main loop"
+#endif
+
+// Waveforms
+#define DDS_SINE     0
+#define DDS_TRIANGLE 1
+#define DDS_SAW      2
+#define DDS_SQUARE   3
+
+// Tuning word for a frequency in Hz (rounded); resolution DDS_SAMPLE_RATE / 65536 Hz
+#define DDS_TUNING_WORD(hz) ((uint16_t)(((hz) * 65536UL + DDS_SAMPLE_RATE / 2) / DDS_SAMPLE_RATE))
+
+// Highest frequency with at least 4 samples per period
+#define DDS_MAX_HZ (DDS_SAMPLE_RATE / 4)
+
+// Set up Timer2 at DDS_SAMPLE_RATE and start generating 'waveform' at 'tuning_word'
+void dds_init(uint8_t waveform, uint16_t tuning_word);
+
+// Change the frequency (phase-continuous, from the next sample)
+void dds_set_tuning(uint16_t tuning_word);
+
+// Change the waveform at the end of the current period
+void dds_set_waveform(uint8_t waveform);
+
+// Waveform currently being output
+uint8_t dds_get_waveform(void);
+
+// Service TMR2IF; call from the application's interrupt routine
+void dds_isr(void);
+
+#endif /* DDS_H */
@@ -51,17 +51,17 @@ OBJECTDIR=build/${CND_CONF}/${IMAGE_TYPE}
 DISTDIR=dist/${CND_CONF}/${IMAGE_TYPE}
 
 # Source Files Quoted if spaced
-SOURCEFILES_QUOTED_IF_SPACED=newmain.c
+SOURCEFILES_QUOTED_IF_SPACED=newmain.c ../../common/crc.c ../../common/frame.c ../../common/uart.c
 
 # Object Files Quoted if spaced
-OBJECTFILES_QUOTED_IF_SPACED=${OBJECTDIR}/newmain.p1
-POSSIBLE_DEPFILES=${OBJECTDIR}/newmain.p1.d
+OBJECTFILES_QUOTED_IF_SPACED=${OBJECTDIR}/newmain.p1 ${OBJECTDIR}/_ext/1329223797/crc.p1 ${OBJECTDIR}/_ext/1329223797/frame.p1 ${OBJECTDIR}/_ext/1329223797/uart.p1
+POSSIBLE_DEPFILES=${OBJECTDIR}/newmain.p1.d ${OBJECTDIR}/_ext/1329223797/crc.p1.d ${OBJECTDIR}/_ext/1329223797/frame.p1.d ${OBJECTDIR}/_ext/1329223797/uart.p1.d
 
 # Object Files
-OBJECTFILES=${OBJECTDIR}/newmain.p1
+OBJECTFILES=${OBJECTDIR}/newmain.p1 ${OBJECTDIR}/_ext/1329223797/crc.p1 ${OBJECTDIR}/_ext/1329223797/frame.p1 ${OBJECTDIR}/_ext/1329223797/uart.p1
 
 # Source Files
-SOURCEFILES=newmain.c
+SOURCEFILES=newmain.c ../../common/crc.c ../../common/frame.c ../../common/uart.c
 
 
 
@@ -96,6 +96,30 @@ ${OBJECTDIR}/newmain.p1: newmain.c  nbproject/Makefile-${CND_CONF}.mk
 	@-${MV} ${OBJECTDIR}/newmain.d ${OBJECTDIR}/newmain.p1.d 
 	@${FIXDEPS} ${OBJECTDIR}/newmain.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
 	
+${OBJECTDIR}/_ext/1329223797/crc.p1: ../../common/crc.c  nbproject/Makefile-${CND_CONF}.mk 
+	@${MKDIR} "${OBJECTDIR}/_ext/1329223797" 
+	@${RM} ${OBJECTDIR}/_ext/1329223797/crc.p1.d 
+	@${RM} ${OBJECTDIR}/_ext/1329223797/crc.p1 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -D__DEBUG=1  -mdebugger=none   -mdfp="${DFP_DIR}/xc8"  -fno-short-double -fno-short-float -O0 -fasmfile -maddrqual=ignore -xassembler-with-cpp -mwarn=-3 -Wa,-a -DXPRJ_default=$(CND_CONF)  -msummary=-psect,-class,+mem,-hex,-file  -ginhx32 -Wl,--data-init -mno-keep-startup -mno-osccal -mno-resetbits -mno-save-resetbits -mno-download -mno-stackcall -mno-default-config-bits $(COMPARISON_BUILD)  -std=c99 -gdwarf-3 -mstack=compiled:auto:auto     -o ${OBJECTDIR}/_ext/1329223797/crc.p1 ../../common/crc.c 
+	@-${MV} ${OBJECTDIR}/_ext/1329223797/crc.d ${OBJECTDIR}/_ext/1329223797/crc.p1.d 
+	@${FIXDEPS} ${OBJECTDIR}/_ext/1329223797/crc.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
+	
+${OBJECTDIR}/_ext/1329223797/frame.p1: ../../common/frame.c  nbproject/Makefile-${CND_CONF}.mk 
+	@${MKDIR} "${OBJECTDIR}/_ext/1329223797" 
+	@${RM} ${OBJECTDIR}/_ext/1329223797/frame.p1.d 
+	@${RM} ${OBJECTDIR}/_ext/1329223797/frame.p1 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -D__DEBUG=1  -mdebugger=none   -mdfp="${DFP_DIR}/xc8"  -fno-short-double -fno-short-float -O0 -fasmfile -maddrqual=ignore -xassembler-with-cpp -mwarn=-3 -Wa,-a -DXPRJ_default=$(CND_CONF)  -msummary=-psect,-class,+mem,-hex,-file  -ginhx32 -Wl,--data-init -mno-keep-startup -mno-osccal -mno-resetbits -mno-save-resetbits -mno-download -mno-stackcall -mno-default-config-bits $(COMPARISON_BUILD)  -std=c99 -gdwarf-3 -mstack=compiled:auto:auto     -o ${OBJECTDIR}/_ext/1329223797/frame.p1 ../../common/frame.c 
+	@-${MV} ${OBJECTDIR}/_ext/1329223797/frame.d ${OBJECTDIR}/_ext/1329223797/frame.p1.d 
+	@${FIXDEPS} ${OBJECTDIR}/_ext/1329223797/frame.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
+	
+${OBJECTDIR}/_ext/1329223797/uart.p1: ../../common/uart.c  nbproject/Makefile-${CND_CONF}.mk 
+	@${MKDIR} "${OBJECTDIR}/_ext/1329223797" 
+	@${RM} ${OBJECTDIR}/_ext/1329223797/uart.p1.d 
+	@${RM} ${OBJECTDIR}/_ext/1329223797/uart.p1 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -D__DEBUG=1  -mdebugger=none   -mdfp="${DFP_DIR}/xc8"  -fno-short-double -fno-short-float -O0 -fasmfile -maddrqual=ignore -xassembler-with-cpp -mwarn=-3 -Wa,-a -DXPRJ_default=$(CND_CONF)  -msummary=-psect,-class,+mem,-hex,-file  -ginhx32 -Wl,--data-init -mno-keep-startup -mno-osccal -mno-resetbits -mno-save-resetbits -mno-download -mno-stackcall -mno-default-config-bits $(COMPARISON_BUILD)  -std=c99 -gdwarf-3 -mstack=compiled:auto:auto     -o ${OBJECTDIR}/_ext/1329223797/uart.p1 ../../common/uart.c 
+	@-${MV} ${OBJECTDIR}/_ext/1329223797/uart.d ${OBJECTDIR}/_ext/1329223797/uart.p1.d 
+	@${FIXDEPS} ${OBJECTDIR}/_ext/1329223797/uart.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
+	
 else
 ${OBJECTDIR}/newmain.p1: newmain.c  nbproject/Makefile-${CND_CONF}.mk 
 	@${MKDIR} "${OBJECTDIR}" 
@@ -105,6 +129,30 @@ ${OBJECTDIR}/newmain.p1: newmain.c  nbproject/Makefile-${CND_CONF}.mk
 	@-${MV} ${OBJECTDIR}/newmain.d ${OBJECTDIR}/newmain.p1.d 
 	@${FIXDEPS} ${OBJECTDIR}/newmain.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
 	
+${OBJECTDIR}/_ext/1329223797/crc.p1: ../../common/crc.c  nbproject/Makefile-${CND_CONF}.mk 
+	@${MKDIR} "${OBJECTDIR}/_ext/1329223797" 
+	@${RM} ${OBJECTDIR}/_ext/1329223797/crc.p1.d 
+	@${RM} ${OBJECTDIR}/_ext/1329223797/crc.p1 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c   -mdfp="${DFP_DIR}/xc8"  -fno-short-double -fno-short-float -O0 -fasmfile -maddrqual=ignore -xassembler-with-cpp -mwarn=-3 -Wa,-a -DXPRJ_default=$(CND_CONF)  -msummary=-psect,-class,+mem,-hex,-file  -ginhx32 -Wl,--data-init -mno-keep-startup -mno-osccal -mno-resetbits -mno-save-resetbits -mno-download -mno-stackcall -mno-default-config-bits $(COMPARISON_BUILD)  -std=c99 -gdwarf-3 -mstack=compiled:auto:auto     -o ${OBJECTDIR}/_ext/1329223797/crc.p1 ../../common/crc.c 
+	@-${MV} ${OBJECTDIR}/_ext/1329223797/crc.d ${OBJECTDIR}/_ext/1329223797/crc.p1.d 
+	@${FIXDEPS} ${OBJECTDIR}/_ext/1329223797/crc.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
+	
+${OBJECTDIR}/_ext/1329223797/frame.p1: ../../common/frame.c  nbproject/Makefile-${CND_CONF}.mk 
+	@${MKDIR} "${OBJECTDIR}/_ext/1329223797" 
+	@${RM} ${OBJECTDIR}/_ext/1329223797/frame.p1.d 
+	@${RM} ${OBJECTDIR}/_ext/1329223797/frame.p1 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c   -mdfp="${DFP_DIR}/xc8"  -fno-short-double -fno-short-float -O0 -fasmfile -maddrqual=ignore -xassembler-with-cpp -mwarn=-3 -Wa,-a -DXPRJ_default=$(CND_CONF)  -msummary=-psect,-class,+mem,-hex,-file  -ginhx32 -Wl,--data-init -mno-keep-startup -mno-osccal -mno-resetbits -mno-save-resetbits -mno-download -mno-stackcall -mno-default-config-bits $(COMPARISON_BUILD)  -std=c99 -gdwarf-3 -mstack=compiled:auto:auto     -o ${OBJECTDIR}/_ext/1329223797/frame.p1 ../../common/frame.c 
+	@-${MV} ${OBJECTDIR}/_ext/1329223797/frame.d ${OBJECTDIR}/_ext/1329223797/frame.p1.d 
+	@${FIXDEPS} ${OBJECTDIR}/_ext/1329223797/frame.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
+	
+${OBJECTDIR}/_ext/1329223797/uart.p1: ../../common/uart.c  nbproject/Makefile-${CND_CONF}.mk 
+	@${MKDIR} "${OBJECTDIR}/_ext/1329223797" 
+	@${RM} ${OBJECTDIR}/_ext/1329223797/uart.p1.d 
+	@${RM} ${OBJECTDIR}/_ext/1329223797/uart.p1 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c   -mdfp="${DFP_DIR}/xc8"  -fno-short-double -fno-short-float -O0 -fasmfile -maddrqual=ignore -xassembler-with-cpp -mwarn=-3 -Wa,-a -DXPRJ_default=$(CND_CONF)  -msummary=-psect,-class,+mem,-hex,-file  -ginhx32 -Wl,--data-init -mno-keep-startup -mno-osccal -mno-resetbits -mno-save-resetbits -mno-download -mno-stackcall -mno-default-config-bits $(COMPARISON_BUILD)  -std=c99 -gdwarf-3 -mstack=compiled:auto:auto     -o ${OBJECTDIR}/_ext/1329223797/uart.p1 ../../common/uart.c 
+	@-${MV} ${OBJECTDIR}/_ext/1329223797/uart.d ${OBJECTDIR}/_ext/1329223797/uart.p1.d 
+	@${FIXDEPS} ${OBJECTDIR}/_ext/1329223797/uart.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
+	
 endif
 
 # ------------------------------------------------------------------------------------
@@ -4,10 +4,17 @@
  * Description:
  * This program demonstrates UART communication between a microcontroller and a computer terminal.
  * Updated to use 16 MHz clock frequency instead of 8 MHz.
+ * Transmission and reception go through the interrupt-driven ring buffers of common/uart.c, so the
+ * main loop never blocks on the USART and no received byte is lost while it is busy.
+ * With UART_FRAMES = 1 each message is echoed as one binary telemetry frame (common/frame.h,
+ * decoded on the PC with host/build/telem) instead of the text banner.
  */
 #include <xc.h>
 #include <stdint.h>
+#include "../../common/uart.h"
 #define _XTAL_FREQ 16000000  // Changed from 8000000 to 16000000 MHz
+#define UART_BAUD_RATE 9600
+#include "../../common/clockcalc.h"
  
 // Configuration bits (updated for 16 MHz crystal)
 #pragma config FOSC = HS    // High-speed oscillator
@@ -23,81 +30,88 @@
 #define LED1 RA0 // LED1 on RA0
 #define LED2 RA1 // LED2 on RA1
  
-// Function to initialize UART transmission
-void UART_TX_Init(void)
-{
-    // Recalculate baud rate generator for 16 MHz
-    // For 9600 bps: SPBRG = (Fosc / (16 * Baud Rate)) - 1
-    // (16000000 / (16 * 9600)) - 1 = 103
-    BRGH = 1;       // High-speed baud rate
-    SPBRG = 103;    // Updated SPBRG value for 16 MHz clock
-    
-    // Enable Asynchronous Serial Port
-    SYNC = 0;
-    SPEN = 1;
-    
-    // Set RX-TX Pins to be in UART mode
-    TRISC6 = 0;     // TX pin (output)
-    TRISC7 = 1;     // RX pin (input)
-    
-    // Enable UART Transmission
-    TXEN = 1;
-    // Enable UART Reception
-    CREN = 1;
-}
+// For 9600 bps: SPBRG = (Fosc / (16 * Baud Rate)) - 1 = 103, computed by clockcalc.h
+#if UART_BRGH_VALUE != 1
+#error "uart.c runs the baud rate generator with BRGH = 1"
+#endif
  
-// Function to check if UART transmitter buffer is empty
-uint8_t UART_TX_Empty()
-{
-    // Check if the output (transmitter) buffer is empty
-    return TRMT;
-}
+#define MAX_MESSAGE_LENGTH 50
+#define MAX_PENDING_LINES  6
+ 
+// 1: echo messages as telemetry frames instead of text
+#ifndef UART_FRAMES
+#define UART_FRAMES 0
+#endif
  
-// Function to transmit a single character over UART
-void UART_Write(uint8_t data)
+// Echo frame payload: overrun, framing and rx_dropped counters (uint16_t each), message text
+#define FRAME_TYPE_ECHO    0x01
+#define ECHO_HEADER_SIZE   6
+ 
+// Lines waiting to be queued into the UART TX buffer
+const char *pending_lines[MAX_PENDING_LINES];
+uint8_t pending_count = 0;
+uint8_t pending_next = 0;
+ 
+// Interrupt Service Routine
+void __interrupt() ISR(void)
 {
-    // Wait until the transmitter buffer is empty
-    while (!UART_TX_Empty());
-    
-    // Write data to the transmitter buffer
-    TXREG = data;
+    uart_isr();
 }
  
-// Function to transmit a string over UART
-void UART_Write_Text(const char* text)
+// Function to queue a line for transmission
+void Queue_Line(const char *line)
 {
-    while (*text != '\0') {
-        UART_Write(*text++);
+    if (pending_count < MAX_PENDING_LINES) {
+        pending_lines[pending_count++] = line;
     }
 }
  
-// Function to receive a single character over UART
-uint8_t UART_Read(void)
+// Function to move queued lines into the TX buffer as space becomes available
+// Returns 1 once every queued line has been handed to the UART driver
+uint8_t Flush_Lines(void)
 {
-    // Wait until data is received
-    while (!RCIF);
-    
-    // Read and return the received data
-    return RCREG;
+    if (pending_next < pending_count && uart_write_text(pending_lines[pending_next])) {
+        pending_next++;
+    }
+    if (pending_next == pending_count) {
+        pending_count = 0;
+        pending_next = 0;
+        return 1;
+    }
+    return 0;
 }
  
-// Function to receive a string over UART until Enter key is pressed
-void UART_Read_Text(char* buffer, uint8_t max_length)
+#if UART_FRAMES
+// Length of the message waiting in received_data to be echoed, 0 if none
+uint8_t echo_length = 0;
+ 
+// Function to send the pending message as an echo frame once it fits in the TX buffer
+// Returns 1 when no message is pending
+uint8_t Flush_Echo(const char *message)
 {
-    uint8_t i = 0;
-    char received_char;
-    
-    // Receive characters until Enter key is pressed or buffer is full
-    do {
-        received_char = UART_Read();
-        if (received_char != '\r' && received_char != '\n') {
-            buffer[i++] = received_char;
-        }
-    } while (received_char != '\r' && received_char != '\n' && i < max_length - 1);
-    
-    // Null-terminate the string
-    buffer[i] = '\0';
+    frame_t frame;
+    uart_stats_t stats;
+    uint8_t i;
+ 
+    if (echo_length == 0) {
+        return 1;
+    }
+    if (uart_tx_free() < (uint8_t)(echo_length + ECHO_HEADER_SIZE + FRAME_OVERHEAD)) {
+        return 0;
+    }
+    uart_get_stats(&stats);
+    uart_frame_begin(&frame, FRAME_TYPE_ECHO);
+    frame_put16(&frame, stats.overrun_errors);
+    frame_put16(&frame, stats.framing_errors);
+    frame_put16(&frame, stats.rx_dropped);
+    for (i = 0; i < echo_length; i++) {
+        frame_put(&frame, (uint8_t)message[i]);
+    }
+    uart_frame_end(&frame);
+    echo_length = 0;
+    return 1;
 }
+#endif
  
 // Function to initialize LEDs
 void LED_Init(void)
@@ -112,35 +126,63 @@ void LED_Init(void)
 void main()
 {
     // Initialize UART and LEDs
-    UART_TX_Init();
+    uart_init(UART_SPBRG_VALUE);
     LED_Init();
     
     // Buffer to store received data
-    char received_data[50];
+    char received_data[MAX_MESSAGE_LENGTH];
+    uint8_t length = 0;
+    uint8_t received_char;
+ 
+#if !UART_FRAMES
+    // Transmit prompt message over UART
+    Queue_Line("Please write your message and press enter \n");
+#endif
  
     while (1) {
-        // Transmit prompt message over UART
-        UART_Write_Text("Please write your message and press enter \n");
-       
-        // Blink LED1 to indicate waiting for data
+        // Keep feeding the transmitter; input is only consumed once the reply is out,
+        // so received_data is never overwritten while it is still being sent
+#if UART_FRAMES
+        if (!Flush_Echo(received_data)) {
+#else
+        if (!Flush_Lines()) {
+#endif
+            LED1 = 0;
+            continue;
+        }
+ 
+        // LED1 on while waiting for data
         LED1 = 1;
-        __delay_ms(500);
-        LED1 = 0;
-      
-        // Receive data via UART
-        UART_Read_Text(received_data, sizeof(received_data));
-        
-        // Blink LED2 once to indicate data received
-        LED2 = 1;
-        __delay_ms(500);
-        LED2 = 0;
-        
-        // Transmit received data back over UART with professional formatting
-        UART_Write_Text("\r\n");
-        UART_Write_Text("*********************************** \r\n");
-        UART_Write_Text("Your message is: \n");
-        UART_Write_Text(received_data);
-        UART_Write_Text("\r\n");
-        UART_Write_Text("********************************** \r\n");
+ 
+        // Collect characters until Enter key is pressed or buffer is full
+        while (uart_read(&received_char)) {
+            if (received_char != '\r' && received_char != '\n') {
+                if (length < MAX_MESSAGE_LENGTH - 1) {
+                    received_data[length++] = received_char;
+                }
+                continue;
+            }
+            if (length == 0) {
+                continue;   // Ignore the second half of a CR/LF pair
+            }
+            received_data[length] = '\0';
+#if UART_FRAMES
+            echo_length = length;
+#endif
+            length = 0;
+ 
+            // Toggle LED2 to indicate data received
+            LED2 = !LED2;
+ 
+#if !UART_FRAMES
+            // Transmit received data back over UART with professional formatting
+            Queue_Line("\r\n*********************************** \r\n");
+            Queue_Line("Your message is: \n");
+            Queue_Line(received_data);
+            Queue_Line("\r\n********************************** \r\n");
+            Queue_Line("Please write your message and press enter \n");
+#endif
+            break;
+        }
     }
-}
\ No newline at end of file
+}
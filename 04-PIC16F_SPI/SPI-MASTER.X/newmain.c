@@ -4,6 +4,8 @@
 * Description: This code demonstrates SPI communication using a PIC16F877A microcontroller as the master device. 
 * It allows incrementing or decrementing a data value using push buttons (UP and Down), and then sending this 
 * data value via SPI when another button (Send) is pressed. The current data value is displayed on PORTD.
+* The transfer runs from the SPI interrupt (common/spi.c), which also drives the slave select on RA5.
+* The buttons are debounced from a 4 ms Timer2 tick (common/debounce.c); holding UP or Down repeats.
 * For more information, visit My Blog at https://theembeddedthings.com/
 */
  // Configuration bits
@@ -19,76 +21,73 @@
 #include <xc.h>
 #include <stdint.h>
 #define _XTAL_FREQ 4000000
+#include "../../common/spi.h"
+#include "../../common/debounce.h"
+
+#define TMR2_RATE_HZ (1000 / DEBOUNCE_TICK_MS)
+#include "../../common/clockcalc.h"
  
-// IO Pins Definitions
-#define UP   RB0
-#define Down RB1
-#define Send RB2
- 
-// Function Declarations
-void SPI_Master_Init();
-void SPI_Write(uint8_t);
+// IO Pins Definitions (PORTB bit numbers, buttons pull the pin high)
+#define UP   0
+#define Down 1
+#define Send 2
+#define BUTTONS ((1 << UP) | (1 << Down) | (1 << Send))
+
+// Byte being sent; spi_transfer() reads it from the ISR
+uint8_t Tx;
+
+// Interrupt Service Routine
+void __interrupt() ISR(void)
+{
+  spi_isr();
+  if (TMR2IF)
+  {
+    TMR2IF = 0;
+    debounce_tick(PORTB);
+  }
+}
  
 // Main Routine
 void main(void)
 {
   // Peripherals & IO Configurations
-  SPI_Master_Init(); // Initialize SPI as Master @ Fosc/64 SCK
+  ADCON1 = 0x06;    // PORTA digital: RA5 drives the slave select
+  spi_master_init(SPI_MODE_1, SPI_CLOCK_FOSC_4); // SPI Master @ Fosc/4 SCK (1 MHz), CS on RA5
   uint8_t Data = 0; // Data Byte
+  uint8_t Event;
   TRISB = 0x07;     // RB0, RB1 & RB2: Input Pins (Push Buttons)
   TRISD = 0x00;     // Output Port (4-Pins)
   PORTD = 0x00;     // Initially OFF
+
+  // Button tick: Timer2 every DEBOUNCE_TICK_MS
+  debounce_init(BUTTONS, 0, (1 << UP) | (1 << Down));
+  T2CON = 0x00;
+  T2CONbits.T2CKPS = TMR2_CKPS_VALUE;
+  PR2 = TMR2_PR2_VALUE;
+  TMR2IF = 0;
+  TMR2IE = 1;
+  TMR2ON = 1;
   
   while(1)
   {
-    // Increment Data Value
-    if (UP)
+    while (debounce_get(&Event))
     {
-      Data++;
-      __delay_ms(250);
-    }
-    // Decrement Data Value
-    if (Down)
-    {
-      Data--;
-      __delay_ms(250);
-    }
-    // Send Data Value Via SPI
-    if (Send)
-    {
-      SPI_Write(Data);
-      __delay_ms(250);
+      if (DEBOUNCE_TYPE(Event) == DEBOUNCE_PRESS || DEBOUNCE_TYPE(Event) == DEBOUNCE_REPEAT)
+      {
+        // Increment / Decrement Data Value
+        if (DEBOUNCE_BIT(Event) == UP)
+          Data++;
+        if (DEBOUNCE_BIT(Event) == Down)
+          Data--;
+      }
+      // Send Data Value Via SPI (skipped if the previous transfer is still running)
+      if (Event == DEBOUNCE_EVENT(DEBOUNCE_PRESS, Send) && !spi_busy())
+      {
+        Tx = Data;
+        spi_transfer(&Tx, 0, 1);
+      }
     }
     PORTD = Data; // Display Current Data Value @ PORTD
   }
   return;
 }
- 
-// Function Definitions
-void SPI_Master_Init()
-{
-  // Set SPI Mode To Master + Set SCK Rate To Fosc/64
-  SSPM0 = 0;
-  SSPM1 = 0;
-  SSPM2 = 0;
-  SSPM3 = 0;
-  // Enable The Synchronous Serial Port
-  SSPEN = 1;
-  // Configure Clock Polarity & Phase (SPI Mode Num. 1)
-  CKP = 0;
-  CKE = 0;
-  // Configure Sampling Time (Middle)
-  SMP = 0;
-  // Configure IO Pins For SPI Master Mode
-  TRISC5 = 0; // SDO -> Output
-  TRISC4 = 1; // SDI -> Input
-  TRISC3 = 0; // SCK -> Output
-}
- 
-void SPI_Write(uint8_t Data)
-{
-  SSPBUF = Data; // Transfer Data To Buffer Register
-  // while(!SSPSTATbits.BF); // Uncomment if Not Using Interrupts!
-  // The Above While Loop Protects Against Writing To Buffer
-  // Before Previous Transmission Ends
-}
\ No newline at end of file
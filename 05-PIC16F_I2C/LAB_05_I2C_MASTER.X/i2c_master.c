@@ -0,0 +1,290 @@
+/* File:   i2c_master.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Interrupt-driven I2C master (see i2c_master.h).
+ * The queue holds transfer pointers with three free-running 8-bit indices: the main loop
+ * writes 'head' (submit) and 'tail' (callbacks done), the ISR writes 'active' (transfer on
+ * the bus). Transfers between tail and active are finished, between active and head waiting.
+ * After a timeout the ISR side is switched off (SSPIE = 0) and the main loop owns the state
+ * until the bus is recovered.
+ */
+
+#include <xc.h>
+#include <stdint.h>
+#include "i2c_master.h"
+
+#define I2C_QUEUE_MASK (I2C_QUEUE_SIZE - 1)
+
+// Bus states: the step whose completion the next SSPIF reports
+#define S_IDLE    0
+#define S_START   1   // Start condition
+#define S_WRITE   2   // Write address or data byte
+#define S_RESTART 3   // Repeated start
+#define S_ADDR_R  4   // Read address
+#define S_READ    5   // Byte received
+#define S_ACK     6   // ACK/NACK sent
+#define S_STOP    7   // Stop condition
+#define S_TIMEOUT 8   // Aborted, waiting for i2c_master_poll() to recover the bus
+
+static i2c_transfer_t *queue[I2C_QUEUE_SIZE];
+static volatile uint8_t head = 0;
+static volatile uint8_t active = 0;
+static volatile uint8_t tail = 0;
+
+// Transfer on the bus
+static volatile uint8_t state = S_IDLE;
+static i2c_transfer_t *current;
+static uint8_t index;       // Next byte of tx or rx
+static uint8_t result;      // Status reported once the stop completes
+static volatile uint8_t timer;
+
+static volatile i2c_stats_t stats;
+
+// Put the next queued transfer on the bus, or go idle
+static void start_next(void)
+{
+    if (active == head) {
+        state = S_IDLE;
+        return;
+    }
+    current = queue[active & I2C_QUEUE_MASK];
+    current->status = I2C_STATUS_BUSY;
+    index = 0;
+    timer = I2C_TIMEOUT_TICKS;
+    state = S_START;
+    SEN = 1;
+}
+
+// Publish the result of the current transfer and move on
+static void complete(uint8_t status)
+{
+    current->status = status;
+    active++;
+    start_next();
+}
+
+// End the transfer with a stop condition; 'status' is reported when it completes
+static void stop(uint8_t status)
+{
+    result = status;
+    state = S_STOP;
+    PEN = 1;
+}
+
+// Clock a stuck slave out of its byte (SDA released after at most 9 SCL pulses), then
+// generate a stop condition by hand. SCL/SDA are driven open-drain through TRISC.
+static void bus_recover(void)
+{
+    uint8_t i;
+
+    SSPEN = 0;          // RC3/RC4 back to port control
+    RC3 = 0;
+    RC4 = 0;
+    TRISC4 = 1;
+    for (i = 0; i < 9 && !RC4; i++) {
+        TRISC3 = 0;
+        __delay_us(5);
+        TRISC3 = 1;
+        __delay_us(5);
+    }
+    TRISC3 = 0;
+    TRISC4 = 0;         // SDA low while SCL is low
+    __delay_us(5);
+    TRISC3 = 1;
+    __delay_us(5);
+    TRISC4 = 1;         // SDA rises while SCL is high: stop
+    __delay_us(5);
+    SSPCON2 = 0;
+    SSPEN = 1;
+}
+
+void i2c_master_init(uint8_t sspadd, uint8_t fast_mode)
+{
+    head = active = tail = 0;
+    state = S_IDLE;
+    stats.nacks = 0;
+    stats.collisions = 0;
+    stats.timeouts = 0;
+
+    // SCL and SDA are inputs; the MSSP drives them open-drain
+    TRISC3 = 1;
+    TRISC4 = 1;
+
+    // SMP = 0 enables the slew rate control required at 400 kHz
+    SSPSTAT = fast_mode ? 0x00 : 0x80;
+    SSPADD = sspadd;
+    SSPCON2 = 0x00;
+    SSPCON = 0x28;      // SSPEN = 1, I2C master mode, clock = Fosc / (4 * (SSPADD + 1))
+
+    SSPIF = 0;
+    BCLIF = 0;
+    SSPIE = 1;
+    BCLIE = 1;
+    PEIE = 1;
+    GIE = 1;
+}
+
+uint8_t i2c_master_submit(i2c_transfer_t *transfer)
+{
+    if ((uint8_t)(head - tail) >= I2C_QUEUE_SIZE) {
+        return 0;
+    }
+    transfer->status = I2C_STATUS_QUEUED;
+    queue[head & I2C_QUEUE_MASK] = transfer;
+    head++;
+
+    // The ISR picks up new transfers itself while the bus is busy; only an idle bus needs
+    // a start from here (the ISR never leaves S_IDLE on its own)
+    if (state == S_IDLE) {
+        start_next();
+    }
+    return 1;
+}
+
+uint8_t i2c_master_poll(void)
+{
+    uint8_t count = 0;
+    i2c_transfer_t *transfer;
+
+    if (state == S_TIMEOUT) {
+        bus_recover();
+        stats.timeouts++;
+        SSPIF = 0;
+        BCLIF = 0;
+        SSPIE = 1;
+        BCLIE = 1;
+        complete(I2C_STATUS_TIMEOUT);
+    }
+
+    while (tail != active) {
+        transfer = queue[tail & I2C_QUEUE_MASK];
+        tail++;
+        if (transfer->done) {
+            transfer->done(transfer);
+        }
+        count++;
+    }
+    return count;
+}
+
+uint8_t i2c_master_busy(void)
+{
+    return head != active;
+}
+
+void i2c_master_get_stats(i2c_stats_t *out)
+{
+    // The 16-bit counters are updated by the ISR, so copy them with SSPIE/BCLIE masked;
+    // both stay off if a timeout switched the ISR side off
+    uint8_t sspie = SSPIE, bclie = BCLIE;
+
+    SSPIE = 0;
+    BCLIE = 0;
+    out->nacks = stats.nacks;
+    out->collisions = stats.collisions;
+    out->timeouts = stats.timeouts;
+    SSPIE = sspie;
+    BCLIE = bclie;
+}
+
+void i2c_master_isr(void)
+{
+    // Bus collision: the MSSP has already gone idle, no stop is needed
+    if (BCLIE && BCLIF) {
+        BCLIF = 0;
+        SSPIF = 0;
+        if (state != S_IDLE && state != S_TIMEOUT) {
+            stats.collisions++;
+            SSPCON2 = 0;
+            complete(I2C_STATUS_COLLISION);
+        }
+        return;
+    }
+
+    if (!(SSPIE && SSPIF)) {
+        return;
+    }
+    SSPIF = 0;
+    timer = I2C_TIMEOUT_TICKS;
+
+    switch (state) {
+    case S_START:
+        if (current->tx_len > 0 || current->rx_len == 0) {
+            state = S_WRITE;
+            SSPBUF = (uint8_t)(current->address << 1);
+        } else {
+            state = S_ADDR_R;
+            SSPBUF = (uint8_t)((current->address << 1) | 1);
+        }
+        break;
+
+    case S_WRITE:
+        if (ACKSTAT) {
+            stats.nacks++;
+            stop(I2C_STATUS_NACK);
+        } else if (index < current->tx_len) {
+            SSPBUF = current->tx[index++];
+        } else if (current->rx_len > 0) {
+            state = S_RESTART;
+            RSEN = 1;
+        } else {
+            stop(I2C_STATUS_OK);
+        }
+        break;
+
+    case S_RESTART:
+        state = S_ADDR_R;
+        SSPBUF = (uint8_t)((current->address << 1) | 1);
+        break;
+
+    case S_ADDR_R:
+        if (ACKSTAT) {
+            stats.nacks++;
+            stop(I2C_STATUS_NACK);
+        } else {
+            index = 0;
+            state = S_READ;
+            RCEN = 1;
+        }
+        break;
+
+    case S_READ:
+        current->rx[index++] = SSPBUF;
+        ACKDT = (index == current->rx_len);    // NACK the last byte
+        state = S_ACK;
+        ACKEN = 1;
+        break;
+
+    case S_ACK:
+        if (index < current->rx_len) {
+            state = S_READ;
+            RCEN = 1;
+        } else {
+            stop(I2C_STATUS_OK);
+        }
+        break;
+
+    case S_STOP:
+        complete(result);
+        break;
+
+    default:
+        break;
+    }
+}
+
+void i2c_master_tick(void)
+{
+    uint8_t s = state;
+
+    if (s == S_IDLE || s == S_TIMEOUT) {
+        return;
+    }
+    if (--timer == 0) {
+        // Stop servicing SSPIF; i2c_master_poll() takes over
+        SSPIE = 0;
+        BCLIE = 0;
+        state = S_TIMEOUT;
+    }
+}
@@ -0,0 +1,98 @@
+/* File:   i2c_master.h
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Interrupt-driven, non-blocking I2C master for the MSSP of the PIC16F877A.
+ * The application queues transfers and carries on; every bus step (start, address, data
+ * byte, repeated start, receive, ACK/NACK, stop) is started from the SSPIF interrupt of the
+ * previous one, so the CPU never waits on the bus. One transfer is a write of tx_len bytes,
+ * a read of rx_len bytes, or a write followed by a repeated start and a read (register
+ * read of a sensor). Received bytes are ACKed except the last, which is NACKed.
+ *
+ * Completion is reported in the transfer's status field and, from i2c_master_poll(), through
+ * its optional callback. A transfer that makes no progress for I2C_TIMEOUT_TICKS ticks is
+ * aborted; i2c_master_poll() then frees the bus (up to 9 SCL pulses and a STOP) before the
+ * next transfer starts.
+ *
+ * The application must call i2c_master_isr() from its __interrupt() routine and
+ * i2c_master_tick() from a periodic (e.g. 1 ms) timer interrupt.
+ */
+
+#ifndef I2C_MASTER_H
+#define I2C_MASTER_H
+
+#include <stdint.h>
+
+// Crystal of this project (see master.c), used for the bus recovery pulses
+#ifndef _XTAL_FREQ
+#define _XTAL_FREQ 16000000
+#endif
+
+// Queued transfers (power of two, at most 128)
+#ifndef I2C_QUEUE_SIZE
+#define I2C_QUEUE_SIZE 4
+#endif
+
+// Ticks without bus progress before a transfer is aborted (at least TICKS - 1 periods)
+#ifndef I2C_TIMEOUT_TICKS
+#define I2C_TIMEOUT_TICKS 5
+#endif
+
+#if (I2C_QUEUE_SIZE & (I2C_QUEUE_SIZE - 1)) || I2C_QUEUE_SIZE > 128
+#error "I2C_QUEUE_SIZE must be a power of two no larger than 128"
+#endif
+
+// Transfer status
+#define I2C_STATUS_QUEUED    0  // Waiting in the queue
+#define I2C_STATUS_BUSY      1  // On the bus
+#define I2C_STATUS_OK        2  // Completed, every byte acknowledged
+#define I2C_STATUS_NACK      3  // Address or data byte not acknowledged (stop sent)
+#define I2C_STATUS_COLLISION 4  // Bus collision (BCLIF), transfer abandoned
+#define I2C_STATUS_TIMEOUT   5  // No progress for I2C_TIMEOUT_TICKS, bus recovered
+
+struct i2c_transfer;
+typedef void (*i2c_callback_t)(struct i2c_transfer *transfer);
+
+// One transfer; owned by the driver from i2c_master_submit() until its status is final
+typedef struct i2c_transfer {
+    uint8_t address;            // 7-bit slave address
+    const uint8_t *tx;          // Bytes written first (tx_len may be 0)
+    uint8_t tx_len;
+    uint8_t *rx;                // Bytes read next, after a repeated start if tx_len > 0
+    uint8_t rx_len;
+    i2c_callback_t done;        // Called from i2c_master_poll() once finished (may be 0)
+    volatile uint8_t status;    // I2C_STATUS_...
+} i2c_transfer_t;
+
+// Bus statistics (written by the driver only)
+typedef struct {
+    uint16_t nacks;
+    uint16_t collisions;
+    uint16_t timeouts;
+} i2c_stats_t;
+
+// Enable the MSSP as I2C master with SCL = (Fosc / 4) / (sspadd + 1). fast_mode enables the
+// slew rate control required at 400 kHz.
+void i2c_master_init(uint8_t sspadd, uint8_t fast_mode);
+
+// Queue a transfer. Returns 1 on success, 0 if the queue is full. With tx_len = rx_len = 0
+// only the address is written (presence check: I2C_STATUS_OK or I2C_STATUS_NACK).
+uint8_t i2c_master_submit(i2c_transfer_t *transfer);
+
+// Run the callbacks of finished transfers and recover the bus after a timeout; call from the
+// main loop. Returns the number of transfers completed.
+uint8_t i2c_master_poll(void);
+
+// 1 while a transfer is queued or in progress
+uint8_t i2c_master_busy(void);
+
+// Copy the bus statistics
+void i2c_master_get_stats(i2c_stats_t *stats);
+
+// Service SSPIF/BCLIF; call from the application's interrupt routine
+void i2c_master_isr(void);
+
+// Timeout time base; call from a periodic timer interrupt
+void i2c_master_tick(void);
+
+#endif /* I2C_MASTER_H */
@@ -6,6 +6,10 @@
 *This code configures a PIC microcontroller as an I2C master.
 *It reads data from an I2C slave device connected to a DIP switch
 *and displays the read value on an LED bar connected to Port D.
+*
+*The bus is driven by the interrupt-driven queue of i2c_master.c at 400 kHz: the read is
+*queued every 100 ms (Timer2 1 ms tick) and its callback updates the LEDs, so the main loop
+*never waits for the bus.
 */
  
 // CONFIG
@@ -19,91 +23,75 @@
 #pragma config CP = OFF     // Flash Program Memory Code Protection bit (Code protection off)
  
 #include <xc.h>
+#include <stdint.h>
  
 #define _XTAL_FREQ 16000000      // 16 MHz Clock Frequency
-#define I2C_BAUD_RATE 100000     // I2C Baud Rate: 100 Kbps
+#define I2C_BAUD_RATE 400000     // I2C Baud Rate: 400 Kbps (fast mode)
+#define TMR2_RATE_HZ 1000        // Timer2 tick: 1 ms
+#include "../../common/clockcalc.h"
+#include "i2c_master.h"
+ 
+#define SLAVE_ADDRESS  0x20      // 7-bit address of the DIP switch slave (0x40 >> 1)
+#define READ_PERIOD_MS 100       // Read the slave every 100 ms
  
 // Function Prototypes
-void I2C_Master_Init(void);
-void I2C_Wait(void);
-void I2C_Start(void);
-void I2C_Stop(void);
-void I2C_Restart(void);
-void I2C_ACK(void);
-void I2C_NACK(void);
-unsigned char I2C_Read(void);
-unsigned char I2C_Write(unsigned char data);
+void Tick_Init(void);
+void On_Switch_Read(i2c_transfer_t *transfer);
+ 
+// 1 ms tick counter (written by the ISR)
+volatile uint8_t tick_ms = 0;
+ 
+// DIP switch read: register 0 of the slave, written as pointer then read back after a
+// repeated start
+const uint8_t switch_register = 0x00;
+uint8_t switch_state;
+i2c_transfer_t switch_read = { SLAVE_ADDRESS, &switch_register, 1, &switch_state, 1, On_Switch_Read, I2C_STATUS_OK };
+ 
+// Interrupt routine: I2C bus steps and the 1 ms tick
+void __interrupt() ISR(void) {
+    i2c_master_isr();
+    if (TMR2IF) {
+        TMR2IF = 0;
+        tick_ms++;
+        i2c_master_tick();
+    }
+}
  
 void main(void) {
+    uint8_t last_read = 0;
+ 
     // Configure Port D as output for LED bar
     TRISD = 0x00;
     PORTD = 0x00;
  
-    // Initialize I2C master
-    I2C_Master_Init();
+    // Initialize I2C master and the 1 ms tick
+    i2c_master_init(I2C_SSPADD_VALUE, I2C_BAUD_RATE > 100000);
+    Tick_Init();
  
     while (1) {
-        I2C_Start();           // I2C Start Sequence
-        I2C_Write(0x41);       // I2C Slave Device Address (0x40) + Read (1)
-        PORTD = I2C_Read();    // Read data from slave and display on Port D
-        I2C_Stop();            // I2C Stop Sequence
-        __delay_ms(100);       // Delay 100 ms
+        // Deliver finished transfers (and recover the bus after a timeout)
+        i2c_master_poll();
+ 
+        // Queue the next read once the previous one has finished
+        if ((uint8_t)(tick_ms - last_read) >= READ_PERIOD_MS && switch_read.status >= I2C_STATUS_OK) {
+            last_read = tick_ms;
+            i2c_master_submit(&switch_read);
+        }
     }
 }
  
-void I2C_Master_Init(void) {
-    SSPCON = 0x28;              // SSPEN = 1, I2C Master mode
-    SSPCON2 = 0x00;
-    SSPSTAT = 0x00;
-    SSPADD = ((_XTAL_FREQ / 4) / I2C_BAUD_RATE) - 1;  // Baud rate formula
-    TRISC3 = 1;                // SCL (clock) as input
-    TRISC4 = 1;                // SDA (data) as input
-}
- 
-void I2C_Wait(void) {
-    while ((SSPSTAT & 0x04) || (SSPCON2 & 0x1F));  // Wait until SSPBUF is clear
-}
- 
-void I2C_Start(void) {
-    I2C_Wait();
-    SEN = 1;  // Initiate I2C start condition
-}
- 
-void I2C_Stop(void) {
-    I2C_Wait();
-    PEN = 1;  // Initiate I2C stop condition
-}
- 
-void I2C_Restart(void) {
-    I2C_Wait();
-    RSEN = 1;  // Initiate I2C restart condition
-}
- 
-void I2C_ACK(void) {
-    I2C_Wait();
-    ACKDT = 0;  // 0 -> ACK
-    ACKEN = 1;  // Send ACK signal
+void Tick_Init(void) {
+    T2CONbits.T2CKPS = TMR2_CKPS_VALUE;
+    PR2 = TMR2_PR2_VALUE;
+    TMR2 = 0;
+    TMR2IF = 0;
+    TMR2IE = 1;
+    T2CONbits.TMR2ON = 1;
 }
  
-void I2C_NACK(void) {
-    I2C_Wait();
-    ACKDT = 1;  // 1 -> NACK
-    ACKEN = 1;  // Send NACK signal
-}
- 
-unsigned char I2C_Write(unsigned char data) {
-    I2C_Wait();
-    SSPBUF = data;  // Load data into buffer
-    I2C_Wait();
-    return ACKSTAT;  // Return ACK/NACK status
+// Called by i2c_master_poll() when the switch read has finished
+void On_Switch_Read(i2c_transfer_t *transfer) {
+    if (transfer->status == I2C_STATUS_OK) {
+        PORTD = switch_state;  // Display the DIP switch state on Port D
+    }
 }
- 
-unsigned char I2C_Read(void) {
-    unsigned char data;
-    I2C_Wait();
-    RCEN = 1;  // Enable receive mode
-    I2C_Wait();
-    data = SSPBUF;  // Read data from buffer
-    I2C_NACK();     // Send NACK signal
-    return data;
-}
\ No newline at end of file
@@ -0,0 +1,142 @@
+/* File:   i2c_slave.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Interrupt-driven I2C slave register file (see i2c_slave.h).
+ * SSPSTAT tells the ISR which state of the transfer it is in (Microchip AN734):
+ *   1. write, address  (R_nW = 0, D_nA = 0, BF = 1): a new write, the next byte is the pointer
+ *   2. write, data     (R_nW = 0, D_nA = 1, BF = 1): pointer or register byte
+ *   3. read, address   (R_nW = 1, D_nA = 0): load the register at the pointer
+ *   4. read, data      (R_nW = 1, D_nA = 1, BF = 0): master ACKed, load the next register
+ *   5. master NACK     (R_nW = 0, D_nA = 1, BF = 0): end of the read, nothing to send
+ * Every state ends by releasing SCL (CKP = 1).
+ */
+
+#include <xc.h>
+#include <stdint.h>
+#include "i2c_slave.h"
+
+static volatile uint8_t registers[I2C_SLAVE_REG_COUNT];
+static volatile uint8_t pointer = 0;
+static volatile uint8_t expect_pointer = 0;   // Next written byte is the register pointer
+static volatile uint8_t written = 0;
+
+static volatile i2c_slave_stats_t stats;
+
+static uint8_t next_register(uint8_t reg)
+{
+    return (uint8_t)(reg + 1 < I2C_SLAVE_REG_COUNT ? reg + 1 : 0);
+}
+
+void i2c_slave_init(uint8_t address)
+{
+    uint8_t i;
+
+    for (i = 0; i < I2C_SLAVE_REG_COUNT; i++) {
+        registers[i] = 0;
+    }
+    pointer = 0;
+    expect_pointer = 0;
+    written = 0;
+    stats.reads = 0;
+    stats.writes = 0;
+    stats.overflows = 0;
+
+    SSPADD = (uint8_t)(address << 1);   // 7-bit address in SSPADD<7:1>
+    SSPSTAT = 0x00;     // SMP = 0: slew rate control for the 400 kHz master
+    SSPCON = 0x36;      // SSPEN, CKP released, I2C slave 7-bit address
+    SSPCON2 = 0x01;     // SEN: stretch the clock after received bytes too
+    TRISC3 = 1;         // SCL input
+    TRISC4 = 1;         // SDA input
+    SSPIF = 0;
+    SSPIE = 1;
+    PEIE = 1;
+    GIE = 1;
+}
+
+void i2c_slave_set(uint8_t reg, uint8_t value)
+{
+    if (reg < I2C_SLAVE_REG_COUNT) {
+        registers[reg] = value;
+    }
+}
+
+uint8_t i2c_slave_get(uint8_t reg)
+{
+    return reg < I2C_SLAVE_REG_COUNT ? registers[reg] : 0;
+}
+
+uint8_t i2c_slave_written(void)
+{
+    uint8_t w = written;
+    if (w) {
+        written = 0;
+    }
+    return w;
+}
+
+void i2c_slave_get_stats(i2c_slave_stats_t *out)
+{
+    // The 16-bit counters are updated by the ISR, so copy them with SSPIE masked
+    uint8_t sspie = SSPIE;
+
+    SSPIE = 0;
+    out->reads = stats.reads;
+    out->writes = stats.writes;
+    out->overflows = stats.overflows;
+    SSPIE = sspie;
+}
+
+void i2c_slave_isr(void)
+{
+    uint8_t data;
+
+    if (!(SSPIE && SSPIF)) {
+        return;
+    }
+    SSPIF = 0;
+
+    // A byte arrived before the previous one was read: drop it and resynchronise
+    if (SSPOV) {
+        data = SSPBUF;
+        SSPOV = 0;
+        stats.overflows++;
+        expect_pointer = 0;
+        CKP = 1;
+        return;
+    }
+
+    if (!R_nW) {
+        if (BF) {
+            data = SSPBUF;      // Reading SSPBUF clears BF
+            if (!D_nA) {
+                // State 1: address of a master write
+                expect_pointer = 1;
+            } else if (expect_pointer) {
+                // State 2: first data byte is the register pointer
+                expect_pointer = 0;
+                pointer = data < I2C_SLAVE_REG_COUNT ? data : 0;
+            } else {
+                // State 2: register data, auto-increment
+                if (pointer >= I2C_SLAVE_READ_ONLY) {
+                    registers[pointer] = data;
+                    written = 1;
+                    stats.writes++;
+                }
+                pointer = next_register(pointer);
+            }
+        }
+        // State 5 (master NACK, BF = 0): the read is over
+    } else {
+        if (!D_nA) {
+            // State 3: address of a master read; clear BF before loading the reply
+            data = SSPBUF;
+        }
+        // States 3 and 4: send the register at the pointer
+        WCOL = 0;
+        SSPBUF = registers[pointer];
+        pointer = next_register(pointer);
+        stats.reads++;
+    }
+    CKP = 1;            // Release SCL
+}
@@ -0,0 +1,61 @@
+/* File:   i2c_slave.h
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Interrupt-driven I2C slave for the MSSP of the PIC16F877A, exposing a register file.
+ * The first data byte of a master write sets the register pointer and the following bytes
+ * are stored at it; a master read returns registers from the pointer on. The pointer
+ * auto-increments after every byte (wrapping at I2C_SLAVE_REG_COUNT), so a whole block is
+ * read or written in one transaction, e.g. write {reg} + repeated start + read N bytes.
+ *
+ * Clock stretching is enabled for both directions (SEN): the MSSP holds SCL low after every
+ * byte until the ISR has handled it, so the ISR never waits on the bus and the master can
+ * run at 400 kHz. The four SSPSTAT states of a transfer are handled (write/read x
+ * address/data), plus the master NACK that ends a read.
+ *
+ * The application must call i2c_slave_isr() from its __interrupt() routine.
+ */
+
+#ifndef I2C_SLAVE_H
+#define I2C_SLAVE_H
+
+#include <stdint.h>
+
+// Registers in the file (at most 128)
+#ifndef I2C_SLAVE_REG_COUNT
+#define I2C_SLAVE_REG_COUNT 16
+#endif
+
+// Registers 0 .. I2C_SLAVE_READ_ONLY - 1 ignore master writes (status block)
+#ifndef I2C_SLAVE_READ_ONLY
+#define I2C_SLAVE_READ_ONLY 1
+#endif
+
+#if I2C_SLAVE_REG_COUNT < 1 || I2C_SLAVE_REG_COUNT > 128 || I2C_SLAVE_READ_ONLY > I2C_SLAVE_REG_COUNT
+#error "I2C_SLAVE_REG_COUNT must be 1..128 and cover I2C_SLAVE_READ_ONLY"
+#endif
+
+// Bus statistics (written by ISR only)
+typedef struct {
+    uint16_t reads;         // Bytes sent to the master
+    uint16_t writes;        // Register bytes stored from the master
+    uint16_t overflows;     // SSPOV events (byte lost)
+} i2c_slave_stats_t;
+
+// Enable the MSSP as a 7-bit address slave with clock stretching, and its interrupt
+void i2c_slave_init(uint8_t address);
+
+// Application access to the register file (single bytes, safe against the ISR)
+void i2c_slave_set(uint8_t reg, uint8_t value);
+uint8_t i2c_slave_get(uint8_t reg);
+
+// 1 if the master has written a register since the last call
+uint8_t i2c_slave_written(void);
+
+// Copy the bus statistics
+void i2c_slave_get_stats(i2c_slave_stats_t *stats);
+
+// Service SSPIF; call from the application's interrupt routine
+void i2c_slave_isr(void);
+
+#endif /* I2C_SLAVE_H */
@@ -51,17 +51,17 @@ OBJECTDIR=build/${CND_CONF}/${IMAGE_TYPE}
 DISTDIR=dist/${CND_CONF}/${IMAGE_TYPE}
 
 # Source Files Quoted if spaced
-SOURCEFILES_QUOTED_IF_SPACED=slave.c
+SOURCEFILES_QUOTED_IF_SPACED=slave.c i2c_slave.c
 
 # Object Files Quoted if spaced
-OBJECTFILES_QUOTED_IF_SPACED=${OBJECTDIR}/slave.p1
-POSSIBLE_DEPFILES=${OBJECTDIR}/slave.p1.d
+OBJECTFILES_QUOTED_IF_SPACED=${OBJECTDIR}/slave.p1 ${OBJECTDIR}/i2c_slave.p1
+POSSIBLE_DEPFILES=${OBJECTDIR}/slave.p1.d ${OBJECTDIR}/i2c_slave.p1.d
 
 # Object Files
-OBJECTFILES=${OBJECTDIR}/slave.p1
+OBJECTFILES=${OBJECTDIR}/slave.p1 ${OBJECTDIR}/i2c_slave.p1
 
 # Source Files
-SOURCEFILES=slave.c
+SOURCEFILES=slave.c i2c_slave.c
 
 
 
@@ -96,6 +96,14 @@ ${OBJECTDIR}/slave.p1: slave.c  nbproject/Makefile-${CND_CONF}.mk
 	@-${MV} ${OBJECTDIR}/slave.d ${OBJECTDIR}/slave.p1.d 
 	@${FIXDEPS} ${OBJECTDIR}/slave.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
 	
+${OBJECTDIR}/i2c_slave.p1: i2c_slave.c  nbproject/Makefile-${CND_CONF}.mk 
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/i2c_slave.p1.d 
+	@${RM} ${OBJECTDIR}/i2c_slave.p1 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -D__DEBUG=1  -mdebugger=none   -mdfp="${DFP_DIR}/xc8"  -fno-short-double -fno-short-float -O0 -fasmfile -maddrqual=ignore -xassembler-with-cpp -mwarn=-3 -Wa,-a -DXPRJ_default=$(CND_CONF)  -msummary=-psect,-class,+mem,-hex,-file  -ginhx32 -Wl,--data-init -mno-keep-startup -mno-osccal -mno-resetbits -mno-save-resetbits -mno-download -mno-stackcall -mno-default-config-bits $(COMPARISON_BUILD)  -std=c99 -gdwarf-3 -mstack=compiled:auto:auto     -o ${OBJECTDIR}/i2c_slave.p1 i2c_slave.c 
+	@-${MV} ${OBJECTDIR}/i2c_slave.d ${OBJECTDIR}/i2c_slave.p1.d 
+	@${FIXDEPS} ${OBJECTDIR}/i2c_slave.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
+	
 else
 ${OBJECTDIR}/slave.p1: slave.c  nbproject/Makefile-${CND_CONF}.mk 
 	@${MKDIR} "${OBJECTDIR}" 
@@ -105,6 +113,14 @@ ${OBJECTDIR}/slave.p1: slave.c  nbproject/Makefile-${CND_CONF}.mk
 	@-${MV} ${OBJECTDIR}/slave.d ${OBJECTDIR}/slave.p1.d 
 	@${FIXDEPS} ${OBJECTDIR}/slave.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
 	
+${OBJECTDIR}/i2c_slave.p1: i2c_slave.c  nbproject/Makefile-${CND_CONF}.mk 
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/i2c_slave.p1.d 
+	@${RM} ${OBJECTDIR}/i2c_slave.p1 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c   -mdfp="${DFP_DIR}/xc8"  -fno-short-double -fno-short-float -O0 -fasmfile -maddrqual=ignore -xassembler-with-cpp -mwarn=-3 -Wa,-a -DXPRJ_default=$(CND_CONF)  -msummary=-psect,-class,+mem,-hex,-file  -ginhx32 -Wl,--data-init -mno-keep-startup -mno-osccal -mno-resetbits -mno-save-resetbits -mno-download -mno-stackcall -mno-default-config-bits $(COMPARISON_BUILD)  -std=c99 -gdwarf-3 -mstack=compiled:auto:auto     -o ${OBJECTDIR}/i2c_slave.p1 i2c_slave.c 
+	@-${MV} ${OBJECTDIR}/i2c_slave.d ${OBJECTDIR}/i2c_slave.p1.d 
+	@${FIXDEPS} ${OBJECTDIR}/i2c_slave.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
+	
 endif
 
 # ------------------------------------------------------------------------------------
@@ -5,6 +5,10 @@
 *This code configures a PIC microcontroller as an I2C slave.
 *It reads the state of a DIP switch connected to Port B and
 *sends this state to the I2C master upon request.
+*
+*The slave exposes a register file (i2c_slave.c): register 0 holds the DIP switch state and
+*is read-only, registers 1..15 can be written and read back by the master. The pointer
+*auto-increments, so several registers are read or written in one transaction.
 */
  
 // CONFIG
@@ -18,11 +22,12 @@
 #pragma config CP = OFF         // Flash Program Memory Code Protection bit (Code protection off)
  
 #include <xc.h>
+#include "i2c_slave.h"
  
 #define _XTAL_FREQ 4000000   // 4 MHz Clock Frequency
  
-// Function Prototypes
-void I2C_Slave_Init(unsigned char address);
+#define SLAVE_ADDRESS 0x20   // 7-bit address (0x40 on the bus for a write)
+#define REG_SWITCHES  0      // DIP switch state (read-only)
  
 void main(void) {
     // Configure Port B as input for DIP switch
@@ -30,35 +35,14 @@ void main(void) {
     nRBPU = 0;  // Enable PORTB pull-ups
  
     // Initialize I2C slave with address 0x40
-    I2C_Slave_Init(0x40);
+    i2c_slave_init(SLAVE_ADDRESS);
  
     while (1) {
-        // Infinite loop, waiting for I2C communication
+        // Keep the switch register current; the ISR serves the master from the register file
+        i2c_slave_set(REG_SWITCHES, PORTB);
     }
 }
  
 void __interrupt() ISR(void) {
-    if (SSPIF) {  // Check if I2C interrupt flag is set
-        if (!D_nA && R_nW) {  // Check if it is an address match and read request
-            volatile char dummy = SSPBUF;  // Clear the buffer
-            SSPBUF = PORTB;  // Load the DIP switch state into the buffer
-            CKP = 1;  // Release the clock
-            while (BF);  // Wait until the buffer is clear
-        }
-        CKP = 1;  // Release the clock
-        SSPIF = 0;  // Clear the interrupt flag
-    }
+    i2c_slave_isr();
 }
- 
-void I2C_Slave_Init(unsigned char address) {
-    SSPADD = address;  // Set the I2C slave address
-    SSPSTAT = 0x80;  // Slew rate control disabled
-    SSPCON = 0x36;  // Enable clock stretching and set slave mode
-    SSPCON2 = 0x01;  // Enable general call
-    TRISC3 = 1;  // Set SCL as input
-    TRISC4 = 1;  // Set SDA as input
-    GIE = 1;  // Enable global interrupts
-    PEIE = 1;  // Enable peripheral interrupts
-    SSPIF = 0;  // Clear SSP interrupt flag
-    SSPIE = 1;  // Enable SSP (I2C) interrupt
-}
\ No newline at end of file
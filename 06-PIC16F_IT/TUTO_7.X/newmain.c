@@ -5,11 +5,29 @@
 * This code demonstrates interrupt-driven ADC reading and UART communication on a PIC microcontroller.
 * It blinks LEDs, reads analog voltage from a potentiometer, and sends the voltage readings via UART.
 * Additionally, it handles an external button interrupt to trigger an LED blink and UART message.
+* The voltage is scaled and formatted with integers only (common/numfmt.h), so neither the
+* float library nor sprintf() is linked.
+* The button ISR only posts an event (common/evq.c); the LED blink and UART message run from
+* the main loop, so the ISR no longer holds interrupts off for half a second.
+* RB0/INT and the RB4-RB7 change interrupt are served by the central dispatcher
+* (common/irq.c), RB0/INT first, then the UART.
+* Output goes through the interrupt-driven TX ring of common/uart.c. By default every record
+* is a binary telemetry frame (common/frame.h, decoded on the PC with host/build/telem); with
+* UART_FRAMES = 0 the records are the text lines, for the Proteus virtual terminal.
 */
  
 #include <xc.h>
 #include <stdint.h>
-#include <stdio.h>
+ 
+// Voltage printed with two decimals: NUMFMT_ADC_UNITS() returns hundredths of a volt
+#define NUMFMT_DECIMALS 2
+#include "../../common/numfmt.h"
+#include "../../common/evq.h"
+#include "../../common/uart.h"
+
+// Interrupt sources used, in service order
+#define IRQ_ORDER(X) X(INT) X(RB) X(RC) X(TX)
+#include "../../common/irq.h"
  
 // Configuration bits
 #pragma config FOSC = HS        // High-Speed Oscillator
@@ -22,37 +40,121 @@
 #pragma config CP = OFF         // Flash Program Memory Code Protection bit (Code protection off)
  
 #define _XTAL_FREQ 20000000  // Define oscillator frequency for delay
+#define UART_BAUD_RATE 9600
+#include "../../common/clockcalc.h"
+ 
+#if UART_BRGH_VALUE != 1
+#error "uart.c runs the baud rate generator with BRGH = 1"
+#endif
+ 
+// 1: send the records as telemetry frames, 0: as text lines
+#ifndef UART_FRAMES
+#define UART_FRAMES 1
+#endif
+ 
+// Frame types and payloads (multi-byte fields little-endian)
+#define FRAME_TYPE_VOLTAGE 0x10  // uint16_t hundredths of a volt
+#define FRAME_TYPE_EVENTS  0x11  // uint16_t dispatched, uint8_t high water, uint16_t lost
+#define FRAME_TYPE_IRQ     0x12  // uint16_t count, max wait, max run: RB0/INT, then RB4-RB7
+#define FRAME_TYPE_BUTTON  0x13  // uint8_t PORTB
+#define FRAME_TYPE_PORT    0x14  // uint8_t PORTB & 0xF0
  
+// Event sources posted by the ISR
+#define EV_BUTTON 0     // RB0/INT edge, payload = PORTB
+#define EV_PORT   1     // RB4..RB7 change, payload = PORTB
+
 // Function Prototypes
 void init_config(void);
 void UART_send_string(const char* str);
+void wait_ms(uint16_t ms);
+#if UART_FRAMES
+void Put_Irq_Stats(frame_t *frame, uint8_t source);
+#else
+void Send_Irq_Stats(const char *name, uint8_t source);
+#endif
+void Button_Handler(const evq_event_t *event);
+void Port_Handler(const evq_event_t *event);
+void Int_Isr(void);
+void Rb_Isr(void);
 void __interrupt() ISR(void);
+
+static const evq_handler_t handlers[] = {
+    Button_Handler,     // EV_BUTTON
+    Port_Handler,       // EV_PORT
+};
  
 void main(void) {
     init_config();
  
     uint16_t adc_value = 0;
-    float voltage = 0.0;
-    char buffer[32];
+    uint16_t voltage = 0;  // Hundredths of a volt
+#if UART_FRAMES
+    frame_t frame;
+#else
+    char buffer[8];
+#endif
+    evq_stats_t stats;
+    uint8_t i;
+    uint16_t lost;
  
     while (1) {
         // Blink four LEDs every two seconds
         PORTD = 0x0F;  // Turn on LEDs RD0, RD1, RD2, RD3
-        __delay_ms(2000);
+        wait_ms(2000);
         PORTD = 0x00;  // Turn off LEDs
-        __delay_ms(2000);
+        wait_ms(2000);
  
         // Read ADC value
         ADCON0bits.GO_DONE = 1;  // Start ADC conversion
         while (ADCON0bits.GO_DONE);  // Wait for conversion to finish
         adc_value = ((uint16_t)(ADRESH << 8)) + ADRESL;  // Cast to uint16_t to avoid warning
  
-        // Convert ADC value to voltage
-        voltage = (adc_value * 5.0) / 1023.0;  // Assuming Vref = 5V and 10-bit ADC resolution
+        // Convert ADC value to voltage (Vref = 5V, 10-bit ADC resolution), rounded to 10 mV
+        voltage = NUMFMT_ADC_UNITS(adc_value);
  
-        // Send voltage value via UART
-        sprintf(buffer, "Voltage: %.2f V\r\n", voltage);
+        // Event queue use
+        evq_get_stats(&stats);
+        for (i = 0, lost = 0; i < EVQ_MAX_SOURCES; i++) {
+            lost += stats.overflows[i];
+        }
+
+#if UART_FRAMES
+        // A frame that does not fit in the TX ring is dropped; telem counts it as lost
+        uart_frame_begin(&frame, FRAME_TYPE_VOLTAGE);
+        frame_put16(&frame, voltage);
+        uart_frame_end(&frame);
+
+        uart_frame_begin(&frame, FRAME_TYPE_EVENTS);
+        frame_put16(&frame, stats.dispatched);
+        frame_put(&frame, stats.high_water);
+        frame_put16(&frame, lost);
+        uart_frame_end(&frame);
+
+        uart_frame_begin(&frame, FRAME_TYPE_IRQ);
+        Put_Irq_Stats(&frame, IRQ_INT);
+        Put_Irq_Stats(&frame, IRQ_RB);
+        uart_frame_end(&frame);
+#else
+        // Send voltage value via UART, e.g. "Voltage: 2.50 V"
+        numfmt_fixed(buffer, voltage, NUMFMT_DECIMALS);
+        UART_send_string("Voltage: ");
+        UART_send_string(buffer);
+        UART_send_string(" V\r\n");
+
+        // e.g. "Events: 3 max 1 lost 0"
+        UART_send_string("Events: ");
+        numfmt_u16(buffer, stats.dispatched);
+        UART_send_string(buffer);
+        UART_send_string(" max ");
+        numfmt_u16(buffer, stats.high_water);
+        UART_send_string(buffer);
+        UART_send_string(" lost ");
+        numfmt_u16(buffer, lost);
         UART_send_string(buffer);
+        UART_send_string("\r\n");
+        Send_Irq_Stats("INT", IRQ_INT);
+        Send_Irq_Stats("RB", IRQ_RB);
+#endif
     }
 }
  
@@ -60,48 +162,137 @@ void init_config(void) {
     // Port configurations
     TRISD = 0x00;  // Set PORTD as output for LEDs
     TRISA = 0x01;  // Set RA0 as input for ADC
-    TRISB = 0x01;  // Set RB0 as input for button interrupt
+    TRISB = 0xF1;  // Set RB0 as input for button interrupt, RB4-RB7 for the port-change interrupt
  
     // ADC configuration
     ADCON0 = 0x41;  // ADC ON, Channel 0 (RA0/AN0), Fosc/8 as conversion clock
     ADCON1 = 0x8E;  // Right justify result, set Vref+ to Vdd and Vref- to Vss, AN0 as analog, rest as digital
  
-    // UART configuration
-    TXSTAbits.SYNC = 0;  // Asynchronous mode
-    TXSTAbits.BRGH = 1;  // High speed
-    SPBRG = 129;  // Baud rate 9600 for 20 MHz
-    RCSTAbits.SPEN = 1;  // Enable serial port
-    TXSTAbits.TXEN = 1;  // Enable transmission
+    // Timer1 free running (1:8, 1.6 us at 20 MHz): event timestamps and interrupt latency
+    T1CON = 0x31;
+    evq_init(handlers, sizeof(handlers) / sizeof(handlers[0]));
+    irq_init();
+    irq_register(IRQ_INT, Int_Isr);
+    irq_register(IRQ_RB, Rb_Isr);
+    irq_register(IRQ_RC, uart_isr);
+    irq_register(IRQ_TX, uart_isr);
+ 
+    // UART: baud rate 9600 for 20 MHz (SPBRG 129), enables RCIE, PEIE and GIE
+    uart_init(UART_SPBRG_VALUE);
  
     // Interrupt configuration
-    INTCONbits.GIE = 1;  // Enable global interrupts
-    INTCONbits.PEIE = 1;  // Enable peripheral interrupts
     INTCONbits.INTE = 1;  // Enable RB0/INT external interrupt
+    OPTION_REGbits.nRBPU = 0;  // Weak pull-ups: the unwired RB4-RB7 idle high, RB0 keeps its 1k pull-down
+    (void)PORTB;  // End the RB4-RB7 mismatch before enabling its interrupt
+    INTCONbits.RBIF = 0;
+    INTCONbits.RBIE = 1;  // Enable RB4-RB7 change interrupt
     OPTION_REGbits.INTEDG = 1;  // Interrupt on rising edge
  
     // Initialize LEDs state
     PORTD = 0x00;
 }
  
+// Waits for room while the TX interrupt drains the ring
 void UART_send_string(const char* str) {
     while (*str) {
-        while (!TXSTAbits.TRMT);  // Wait until transmit buffer is empty
-        TXREG = *str++;  // Transmit character
+        str += uart_write_some(str);
     }
 }
  
-void __interrupt() ISR(void) {
-    if (INTCONbits.INTF) {
-        // External interrupt occurred
-        PORTD = 0x00;  // Turn off the four LEDs
-        PORTDbits.RD4 = 1;  // Turn on interrupt-specific LED (RD4)
-        __delay_ms(500);
-        PORTDbits.RD4 = 0;  // Turn off interrupt-specific LED (RD4)
- 
-        // Send UART message indicating interrupt execution
-        UART_send_string("Interrupt executed\r\n");
- 
-        // Clear the interrupt flag
-        INTCONbits.INTF = 0;
+#if UART_FRAMES
+// Interrupt counters of one source, Timer1 ticks of 1.6 us
+void Put_Irq_Stats(frame_t *frame, uint8_t source) {
+    irq_stats_t stats;
+
+    irq_get_stats(source, &stats);
+    frame_put16(frame, stats.count);
+    frame_put16(frame, stats.max_wait);
+    frame_put16(frame, stats.max_run);
+}
+#else
+// Interrupt counters, e.g. "INT: 2 wait 0 run 9" (Timer1 ticks of 1.6 us)
+void Send_Irq_Stats(const char *name, uint8_t source) {
+    irq_stats_t stats;
+    char buffer[NUMFMT_U16_SIZE];
+
+    irq_get_stats(source, &stats);
+    UART_send_string(name);
+    UART_send_string(": ");
+    numfmt_u16(buffer, stats.count);
+    UART_send_string(buffer);
+    UART_send_string(" wait ");
+    numfmt_u16(buffer, stats.max_wait);
+    UART_send_string(buffer);
+    UART_send_string(" run ");
+    numfmt_u16(buffer, stats.max_run);
+    UART_send_string(buffer);
+    UART_send_string("\r\n");
+}
+#endif
+ 
+// Delay that keeps handling the events posted by the ISR
+void wait_ms(uint16_t ms) {
+    while (ms >= 10) {
+        evq_dispatch();
+        __delay_ms(10);
+        ms -= 10;
     }
-}
\ No newline at end of file
+    evq_dispatch();
+}
+ 
+// Button press, run from the main loop
+void Button_Handler(const evq_event_t *event) {
+#if UART_FRAMES
+    frame_t frame;
+#endif
+
+    PORTD = 0x00;  // Turn off the four LEDs
+    PORTDbits.RD4 = 1;  // Turn on interrupt-specific LED (RD4)
+    __delay_ms(500);
+    PORTDbits.RD4 = 0;  // Turn off interrupt-specific LED (RD4)
+ 
+    // Send UART message indicating interrupt execution
+#if UART_FRAMES
+    uart_frame_begin(&frame, FRAME_TYPE_BUTTON);
+    frame_put(&frame, event->payload);
+    uart_frame_end(&frame);
+#else
+    (void)event;
+    UART_send_string("Interrupt executed\r\n");
+#endif
+}
+ 
+// RB4-RB7 change, run from the main loop
+void Port_Handler(const evq_event_t *event) {
+#if UART_FRAMES
+    frame_t frame;
+
+    uart_frame_begin(&frame, FRAME_TYPE_PORT);
+    frame_put(&frame, event->payload & 0xF0);
+    uart_frame_end(&frame);
+#else
+    char buffer[3];
+
+    // e.g. "Port change: 0xE0"
+    numfmt_hex(buffer, event->payload & 0xF0, 2);
+    UART_send_string("Port change: 0x");
+    UART_send_string(buffer);
+    UART_send_string("\r\n");
+#endif
+}
+ 
+// Interrupt handlers: clear the flag and defer the work
+void Int_Isr(void) {
+    INTCONbits.INTF = 0;
+    evq_post(EV_BUTTON, PORTB);
+}
+ 
+void Rb_Isr(void) {
+    uint8_t port = PORTB;  // Reading PORTB ends the mismatch so RBIF can be cleared
+    INTCONbits.RBIF = 0;
+    evq_post(EV_PORT, port);
+}
+ 
+void __interrupt() ISR(void) {
+    IRQ_DISPATCH();
+}
@@ -5,11 +5,18 @@
  * This code initializes multiple interrupt counters and toggles LEDs connected to different pins of 
  * the PIC16F877A microcontroller based on specific time intervals. Additionally, it implements UART 
  * communication to send a message periodically via serial transmission.
+ * The report goes through the interrupt-driven TX ring of common/uart.c. By default it is one
+ * binary telemetry frame (common/frame.h, decoded on the PC with host/build/telem); with
+ * UART_FRAMES = 0 it is the text line, the loop counter formatted with numfmt_u32().
+ * The Timer2 interrupt only ticks the scheduler (common/sched.h); the LED toggles and the
+ * UART report are periodic tasks run from the main loop, with no delay loops.
  */
  
 #include <xc.h>
 #include <stdint.h>
-#include <stdio.h>
+#include "../../common/numfmt.h"
+#include "../../common/sched.h"
+#include "../../common/uart.h"
  
 // Configuration bits (assuming a PIC16F877A microcontroller)
 #pragma config FOSC = HS
@@ -23,69 +30,81 @@
  
 // Define the system clock frequency
 #define _XTAL_FREQ 8000000 // 8 MHz
+#define UART_BAUD_RATE 9600
+#define TMR2_RATE_HZ 1000  // Timer2 interrupt every 1 ms
+#include "../../common/clockcalc.h"
  
-// Global variables for the interrupt counts
-volatile uint8_t interrupt_count1 = 0;
-volatile uint16_t interrupt_count2 = 0;
-volatile uint16_t interrupt_count3 = 0;
-volatile uint16_t interrupt_count4 = 0;
-volatile uint16_t interrupt_count5 = 0;
+#if UART_BRGH_VALUE != 1
+#error "uart.c runs the baud rate generator with BRGH = 1"
+#endif
  
-// UART initialization function
-void UART_Init(void) {
-    TRISC6 = 0; // TX pin set as output
-    TRISC7 = 1; // RX pin set as input
+// 1: send the report as a telemetry frame, 0: as text (Proteus virtual terminal)
+#ifndef UART_FRAMES
+#define UART_FRAMES 1
+#endif
  
-    TXSTAbits.SYNC = 0;  // Asynchronous mode
-    TXSTAbits.BRGH = 1;  // High-speed mode
+// Report frame payload: loop counter (uint32_t, little-endian), idle percent (uint8_t)
+#define FRAME_TYPE_LOOP 0x20
  
-    SPBRG = 51; // Baud rate 9600 for 8 MHz clock
- 
-    RCSTAbits.SPEN = 1;  // Enable serial port
-    TXSTAbits.TXEN = 1;  // Enable transmission
-}
- 
-// UART transmit function
-void UART_Transmit(char data) {
-    while (!TXIF); // Wait until the transmit buffer is empty
-    TXREG = data;  // Transmit the data
-}
- 
-// UART send string function
+// UART send string function: waits for room while the TX interrupt drains the ring
 void UART_SendString(const char *str) {
     while (*str) {
-        UART_Transmit(*str++);
+        str += uart_write_some(str);
     }
 }
  
+// Periodic tasks
+void Task_LED0(void) { PORTBbits.RB0 ^= 1; }
+void Task_LED1(void) { PORTBbits.RB1 ^= 1; }
+void Task_LED2(void) { PORTBbits.RB2 ^= 1; }
+void Task_LED3(void) { PORTBbits.RB3 ^= 1; }
+
+// Send the loop counter and the idle time, as a frame or e.g. "LOOP EXECUTE 42 IDLE 97%"
+void Task_Report(void) {
+    static uint32_t loop_counter = 0;
+#if UART_FRAMES
+    frame_t frame;
+
+    loop_counter++;
+    uart_frame_begin(&frame, FRAME_TYPE_LOOP);
+    frame_put16(&frame, (uint16_t)loop_counter);
+    frame_put16(&frame, (uint16_t)(loop_counter >> 16));
+    frame_put(&frame, sched_idle_percent());
+    uart_frame_end(&frame);     // Dropped if the ring is full; telem counts it as lost
+#else
+    char buffer[NUMFMT_U32_SIZE];
+
+    loop_counter++;
+    numfmt_u32(buffer, loop_counter);
+    UART_SendString("LOOP EXECUTE ");
+    UART_SendString(buffer);
+    numfmt_u16(buffer, sched_idle_percent());
+    UART_SendString(" IDLE ");
+    UART_SendString(buffer);
+    UART_SendString("%\r\n");
+#endif
+}
+
+// Task table: function, period and first release in Timer2 ticks (1 ms). The report is
+// offset so it does not share a tick with the LED tasks.
+const sched_task_t tasks[] = {
+    { Task_LED0,    100,  100 },
+    { Task_LED1,    200,  200 },
+    { Task_LED2,    300,  300 },
+    { Task_LED3,    400,  400 },
+    { Task_Report, 1000,   50 },
+};
+#define TASK_COUNT (sizeof(tasks) / sizeof(tasks[0]))
+
+void Tasks_Init(void) {
+    sched_init(tasks, TASK_COUNT);
+}
+
 void __interrupt() ISR() {
+    uart_isr();
     if (TMR2IF) { // Check if Timer2 overflow interrupt flag is set
         TMR2IF = 0; // Clear the interrupt flag
-        
-        // Increment the interrupt counts
-        interrupt_count1++;
-        interrupt_count2++;
-        interrupt_count3++;
-        interrupt_count4++;
-        interrupt_count5++;
-        
-        // Toggle LEDs based on the specified intervals
-        if (interrupt_count1 >= 100) { // 10 seconds (assuming 100 ms overflow time)
-            PORTBbits.RB0 ^= 1; // Toggle LED on RB0
-            interrupt_count1 = 0;
-        }
-        if (interrupt_count2 >= 200) { // 20 seconds
-            PORTBbits.RB1 ^= 1; // Toggle LED on RB1
-            interrupt_count2 = 0;
-        }
-        if (interrupt_count3 >= 300) { // 30 seconds
-            PORTBbits.RB2 ^= 1; // Toggle LED on RB2
-            interrupt_count3 = 0;
-        }
-        if (interrupt_count4 >= 400) { // 40 seconds
-            PORTBbits.RB3 ^= 1; // Toggle LED on RB3
-            interrupt_count4 = 0;
-        }
+        sched_tick(); // One scheduler tick per 1 ms
     }
 }
  
@@ -102,9 +121,13 @@ void main(void) {
     PORTBbits.RB2 = 0;
     PORTBbits.RB3 = 0;
  
+    // Initialize UART (TX ring, interrupts on) and the task table
+    uart_init(UART_SPBRG_VALUE);  // Baud rate 9600 for 8 MHz clock (51)
+    Tasks_Init();
+ 
     // Configure Timer2
-    T2CONbits.T2CKPS = 0b11; // Prescaler 1:16
-    PR2 = 124; // Load Period Register (PR2)
+    T2CONbits.T2CKPS = TMR2_CKPS_VALUE; // Prescaler 1:16
+    PR2 = TMR2_PR2_VALUE; // Load Period Register (PR2 = 124)
     TMR2 = 0; // Clear Timer2 register
     T2CONbits.TMR2ON = 1; // Turn on Timer2
  
@@ -113,23 +136,6 @@ void main(void) {
     INTCONbits.PEIE = 1; // Enable peripheral interrupts
     INTCONbits.GIE = 1; // Enable global interrupts
  
-    // Initialize UART
-    UART_Init();
- 
-    uint32_t loop_counter = 0;
-    char buffer[32];
- 
-    while (1) {
-        // Increment loop counter
-        loop_counter++;
-        
-        // Create the message string
-        sprintf(buffer, "LOOP EXECUTE %lu\r\n", loop_counter);
-        
-        // Send the message via UART
-        UART_SendString(buffer);
-        
-        // Delay to prevent flooding the UART
-        __delay_ms(1000);
-    }
-}
\ No newline at end of file
+    // Run the tasks; the CPU is idle between releases
+    sched_run();
+}
@@ -3,6 +3,8 @@
  * Description: This project demonstrates how to control the brightness and color of an RGB LED using PWM 
  * (Pulse Width Modulation) on the PIC16F877A microcontroller. The microcontroller is set up to produce PWM signals t
  * hat control the RGB LED's colors through different duty cycles, creating a smooth fading effect.
+ * Green and blue use the CCP2 (RC1) and CCP1 (RC2) PWM outputs; red, on RC0, has no CCP module and uses the
+ * software channel of pwm.c. The fades run in the Timer2 interrupt, the main loop only picks the next colour.
  */
  
 // Configuration bits for PIC16F877A
@@ -20,59 +22,55 @@
  
 #define _XTAL_FREQ 4000000  // Define the operating frequency of the microcontroller
  
-// Define pin assignments for RGB LEDs
-#define REDPin   RC0  // Red LED pin
-#define GREENPin RC1  // Green LED pin
-#define BLUEPin  RC2  // Blue LED pin
+#include "pwm.h"
  
-/**
- * Initialize Timer2 for PWM
- */
-void PWM_Init() {
-    PR2 = 255;  // Set period register for PWM period
-    T2CKPS0 = 0;  // Set prescaler to 1:1
-    T2CKPS1 = 0;
-    TMR2ON = 1;  // Turn on Timer2
-    CCP1M3 = 1;  // Configure CCP1 module for PWM mode
-    CCP1M2 = 1;
+// PWM channel of each colour
+#define RED   PWM_CH_SOFT   // RC0
+#define GREEN PWM_CH_CCP2   // RC1
+#define BLUE  PWM_CH_CCP1   // RC2
+ 
+// Periods (~1 ms each) per brightness step: a full fade takes about 2.6 s
+#define FADE_STEP 10
+ 
+// Colour sequence: red, green and blue brightness (0-255, gamma corrected)
+static const uint8_t colours[][3] = {
+    { 255,   0,   0 },
+    {   0, 255,   0 },
+    {   0,   0, 255 },
+    { 255, 128,   0 },
+    {  64,   0, 255 },
+    {   0,   0,   0 },
+};
+#define COLOUR_COUNT (sizeof(colours) / sizeof(colours[0]))
+ 
+// Interrupt Service Routine
+void __interrupt() ISR(void) {
+    pwm_isr();
 }
  
 /**
- * Set PWM duty cycle for each color component
- * 
- * @param red_intensity: The duty cycle for the red LED (0-255)
- * @param green_intensity: The duty cycle for the green LED (0-255)
- * @param blue_intensity: The duty cycle for the blue LED (0-255)
+ * Start fading all three channels to a colour
  */
-void RGB_LED_Control(uint8_t red_intensity, uint8_t green_intensity, uint8_t blue_intensity) {
-    CCPR1L = red_intensity;   // Set duty cycle for red LED using CCP1
-    CCPR2L = green_intensity; // Set duty cycle for green LED using CCP2
-    // Note: No CCP module available for the blue LED; additional hardware or software PWM needed.
+void RGB_LED_Fade(const uint8_t *colour) {
+    pwm_fade(RED, colour[0], FADE_STEP);
+    pwm_fade(GREEN, colour[1], FADE_STEP);
+    pwm_fade(BLUE, colour[2], FADE_STEP);
 }
  
 /**
  * Main function
  */
 void main(void) {
-    // Configure RGB LED pins as output
-    TRISC0 = 0; // Red LED
-    TRISC1 = 0; // Green LED
-    TRISC2 = 0; // Blue LED
+    uint8_t next = 0;
  
-    // Initialize PWM
-    PWM_Init();
+    // Initialize PWM (configures RC0-RC2 as outputs)
+    pwm_init();
  
-    // Main program loop
+    // Main program loop: start the next fade once the previous one has finished
     while(1) {
-        // Gradually increase the intensity of the red LED
-        for (int i = 0; i <= 255; i++) {
-            RGB_LED_Control(i, 0, 0);
-            __delay_ms(10); // Delay for smooth transition
-        }
-        // Gradually increase the intensity of the green LED
-        for (int i = 0; i <= 255; i++) {
-            RGB_LED_Control(0, i, 0);
-            __delay_ms(10); // Delay for smooth transition
+        if (!pwm_fading()) {
+            RGB_LED_Fade(colours[next]);
+            next = (uint8_t)((next + 1) % COLOUR_COUNT);
         }
     }
-}
\ No newline at end of file
+}
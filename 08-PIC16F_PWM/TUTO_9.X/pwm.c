@@ -0,0 +1,228 @@
+/* File:   pwm.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Three-channel PWM with a fade engine (see pwm.h).
+ * The main loop hands new duties and fades to the ISR with the Timer2 interrupt disabled,
+ * since a duty is 16 bits and a fade is three bytes that must be seen together.
+ */
+
+#include <xc.h>
+#include <stdint.h>
+#include "pwm.h"
+
+// 1023 * (level / 255) ^ 2.2, rounded: perceived brightness grows evenly with the level
+static const uint16_t gamma_table[256] = {
+       0,    0,    0,    0,    0,    0,    0,    0,    1,    1,    1,    1,    1,    1,    2,    2,
+       2,    3,    3,    3,    4,    4,    5,    5,    6,    6,    7,    7,    8,    9,    9,   10,
+      11,   11,   12,   13,   14,   15,   16,   16,   17,   18,   19,   20,   21,   23,   24,   25,
+      26,   27,   28,   30,   31,   32,   34,   35,   36,   38,   39,   41,   42,   44,   46,   47,
+      49,   51,   52,   54,   56,   58,   60,   61,   63,   65,   67,   69,   71,   73,   76,   78,
+      80,   82,   84,   87,   89,   91,   94,   96,   98,  101,  103,  106,  109,  111,  114,  117,
+     119,  122,  125,  128,  130,  133,  136,  139,  142,  145,  148,  151,  155,  158,  161,  164,
+     167,  171,  174,  177,  181,  184,  188,  191,  195,  198,  202,  206,  209,  213,  217,  221,
+     225,  228,  232,  236,  240,  244,  248,  252,  257,  261,  265,  269,  274,  278,  282,  287,
+     291,  295,  300,  304,  309,  314,  318,  323,  328,  333,  337,  342,  347,  352,  357,  362,
+     367,  372,  377,  382,  387,  393,  398,  403,  408,  414,  419,  425,  430,  436,  441,  447,
+     452,  458,  464,  470,  475,  481,  487,  493,  499,  505,  511,  517,  523,  529,  535,  542,
+     548,  554,  561,  567,  573,  580,  586,  593,  599,  606,  613,  619,  626,  633,  640,  647,
+     653,  660,  667,  674,  681,  689,  696,  703,  710,  717,  725,  732,  739,  747,  754,  762,
+     769,  777,  784,  792,  800,  807,  815,  823,  831,  839,  847,  855,  863,  871,  879,  887,
+     895,  903,  912,  920,  928,  937,  945,  954,  962,  971,  979,  988,  997, 1005, 1014, 1023
+};
+
+// Active settings (ISR only)
+static uint8_t soft_ticks = 0;      // Software channel high time, Timer0 ticks
+static uint8_t soft_error = 0;      // Pulse-skipping accumulator for short pulses
+static uint8_t step_count[PWM_CHANNELS];
+
+// Shared with the main loop
+static uint16_t pending[PWM_CHANNELS];
+static volatile uint8_t pending_mask = 0;
+static volatile uint8_t fading = 0;
+static volatile uint8_t level[PWM_CHANNELS];
+static uint8_t target[PWM_CHANNELS];
+static uint8_t step_periods[PWM_CHANNELS];
+
+// Load a duty; called right after a period boundary, so the CCP latches it whole at the next
+static void apply(uint8_t channel, uint16_t duty)
+{
+    switch (channel) {
+    case PWM_CH_CCP1:
+        CCPR1L = (uint8_t)(duty >> 2);
+        CCP1CON = (uint8_t)(0x0C | ((duty & 3) << 4));
+        break;
+    case PWM_CH_CCP2:
+        CCPR2L = (uint8_t)(duty >> 2);
+        CCP2CON = (uint8_t)(0x0C | ((duty & 3) << 4));
+        break;
+    default:
+        soft_ticks = (uint8_t)(duty >> 2);
+        break;
+    }
+}
+
+// Start the software pulse for this period
+static void soft_pulse(void)
+{
+    uint8_t ticks = soft_ticks;
+
+    if (ticks == 0) {
+        PWM_SOFT_PIN = 0;
+        return;
+    }
+    if (ticks >= (uint8_t)(256 - PWM_SOFT_MIN_TICKS)) {
+        PWM_SOFT_PIN = 1;               // Fully on
+        return;
+    }
+    if (ticks < PWM_SOFT_MIN_TICKS) {
+        // Minimum-width pulse in ticks / PWM_SOFT_MIN_TICKS of the periods
+        soft_error += ticks;
+        if (soft_error < PWM_SOFT_MIN_TICKS) {
+            PWM_SOFT_PIN = 0;
+            return;
+        }
+        soft_error -= PWM_SOFT_MIN_TICKS;
+        ticks = PWM_SOFT_MIN_TICKS;
+    }
+    PWM_SOFT_PIN = 1;
+    TMR0 = (uint8_t)(PWM_SOFT_LATENCY_TICKS - ticks);   // Overflows 'ticks' minus latency later
+    T0IF = 0;
+    T0IE = 1;
+}
+
+void pwm_init(void)
+{
+    uint8_t i;
+
+    TMR2IE = 0;
+    T0IE = 0;
+    pending_mask = 0;
+    fading = 0;
+    soft_ticks = 0;
+    soft_error = 0;
+    for (i = 0; i < PWM_CHANNELS; i++) {
+        level[i] = target[i] = 0;
+        step_periods[i] = step_count[i] = 1;
+    }
+
+    PWM_SOFT_PIN = 0;
+    PWM_SOFT_TRIS = 0;
+    TRISC1 = 0;             // CCP2
+    TRISC2 = 0;             // CCP1
+
+    CCPR1L = 0;
+    CCPR2L = 0;
+    CCP1CON = 0x0C;         // PWM mode, duty 0
+    CCP2CON = 0x0C;
+
+    PR2 = 255;
+    T2CON = 0x01;           // Prescaler 1:4
+    TMR2 = 0;
+    TMR2ON = 1;
+
+    // Timer0 on Fosc/4 with the 1:4 prescaler, like Timer2
+    OPTION_REG = (uint8_t)((OPTION_REG & 0xC0) | 0x01);
+
+    TMR2IF = 0;
+    TMR2IE = 1;
+    PEIE = 1;
+    GIE = 1;
+}
+
+void pwm_set_duty(uint8_t channel, uint16_t duty)
+{
+    uint8_t bit = (uint8_t)(1 << channel);
+
+    if (channel >= PWM_CHANNELS) {
+        return;
+    }
+    if (duty > PWM_DUTY_MAX) {
+        duty = PWM_DUTY_MAX;
+    }
+    TMR2IE = 0;
+    pending[channel] = duty;
+    pending_mask |= bit;
+    fading &= (uint8_t)~bit;
+    TMR2IE = 1;
+}
+
+void pwm_set_level(uint8_t channel, uint8_t value)
+{
+    if (channel >= PWM_CHANNELS) {
+        return;
+    }
+    TMR2IE = 0;
+    level[channel] = target[channel] = value;
+    pending[channel] = gamma_table[value];
+    pending_mask |= (uint8_t)(1 << channel);
+    fading &= (uint8_t)~(1 << channel);
+    TMR2IE = 1;
+}
+
+void pwm_fade(uint8_t channel, uint8_t value, uint8_t periods)
+{
+    if (channel >= PWM_CHANNELS) {
+        return;
+    }
+    if (periods == 0) {
+        periods = 1;
+    }
+    TMR2IE = 0;
+    target[channel] = value;
+    step_periods[channel] = periods;
+    step_count[channel] = periods;
+    fading |= (uint8_t)(1 << channel);
+    TMR2IE = 1;
+}
+
+uint8_t pwm_fading(void)
+{
+    return fading;
+}
+
+uint8_t pwm_get_level(uint8_t channel)
+{
+    return channel < PWM_CHANNELS ? level[channel] : 0;
+}
+
+void pwm_isr(void)
+{
+    uint8_t i, bit;
+
+    // End of the software pulse
+    if (T0IE && T0IF) {
+        PWM_SOFT_PIN = 0;
+        T0IE = 0;
+        T0IF = 0;
+    }
+
+    if (!(TMR2IE && TMR2IF)) {
+        return;
+    }
+    TMR2IF = 0;
+
+    for (i = 0, bit = 1; i < PWM_CHANNELS; i++, bit <<= 1) {
+        if (pending_mask & bit) {
+            apply(i, pending[i]);
+        } else if (fading & bit) {
+            if (--step_count[i] != 0) {
+                continue;
+            }
+            step_count[i] = step_periods[i];
+            if (level[i] < target[i]) {
+                level[i]++;
+            } else if (level[i] > target[i]) {
+                level[i]--;
+            }
+            apply(i, gamma_table[level[i]]);
+            if (level[i] == target[i]) {
+                fading &= (uint8_t)~bit;
+            }
+        }
+    }
+    pending_mask = 0;
+
+    // Last, so the Timer0 interrupt can follow as soon as this one returns
+    soft_pulse();
+}
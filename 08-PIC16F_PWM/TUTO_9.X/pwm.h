@@ -0,0 +1,82 @@
+/* File:   pwm.h
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Three-channel PWM for the PIC16F877A: the two CCP modules in PWM mode plus one software
+ * channel, all sharing the Timer2 period.
+ *
+ * CCP1 drives RC2 and CCP2 drives RC1 with the full 10-bit duty (CCPRxL:DCxB). The software
+ * channel (PWM_SOFT_PIN, RC0 by default) is set by the Timer2 interrupt and cleared by the
+ * Timer0 overflow, Timer0 counting at the same rate as Timer2 (Fosc/4, 1:4); it has 8 bits
+ * of resolution (the top 8 bits of the duty). Its pulse starts at the end of the Timer2
+ * interrupt, so the position in the period may move by a few cycles, but the width is timed
+ * by Timer0. Pulses shorter than the interrupt overhead (PWM_SOFT_MIN_TICKS) are produced as
+ * a minimum-width pulse in a matching fraction of the periods, so the average is kept;
+ * duties within PWM_SOFT_MIN_TICKS of the full period are output as fully on.
+ *
+ * New duties are double-buffered: the Timer2 interrupt applies them right after a period
+ * boundary, so CCPRxL and DCxB always belong to the same value. The same interrupt runs the
+ * fade engine, which moves a channel's brightness level one step every 'step_periods'
+ * periods through a gamma-correction table, leaving the main loop free.
+ *
+ * The application must call pwm_isr() from its __interrupt() routine.
+ */
+
+#ifndef PWM_H
+#define PWM_H
+
+#include <stdint.h>
+
+// Software channel pin
+#ifndef PWM_SOFT_PIN
+#define PWM_SOFT_PIN  RC0
+#define PWM_SOFT_TRIS TRISC0
+#endif
+
+// Shortest software pulse, in Timer0 ticks (4 cycles): Timer0 must not overflow before the
+// Timer2 interrupt has returned and the Timer0 interrupt can be entered
+#ifndef PWM_SOFT_MIN_TICKS
+#define PWM_SOFT_MIN_TICKS 8
+#endif
+
+// Timer0 ticks from the overflow to the pin being cleared (interrupt entry)
+#ifndef PWM_SOFT_LATENCY_TICKS
+#define PWM_SOFT_LATENCY_TICKS 4
+#endif
+
+#if PWM_SOFT_MIN_TICKS <= PWM_SOFT_LATENCY_TICKS
+#error "PWM_SOFT_MIN_TICKS must be larger than PWM_SOFT_LATENCY_TICKS"
+#endif
+
+// Channels
+#define PWM_CH_CCP1 0   // RC2
+#define PWM_CH_CCP2 1   // RC1
+#define PWM_CH_SOFT 2   // PWM_SOFT_PIN
+#define PWM_CHANNELS 3
+
+// Largest duty (10 bits; the period is 1024 duty steps)
+#define PWM_DUTY_MAX 1023
+
+// Timer2 1:4 and PR2 = 255: period = 1024 * Tcy (977 Hz at 4 MHz), one duty step per Tcy.
+// Timer0 uses the 1:4 prescaler too, so one Timer0 tick is 1/256 of the period.
+void pwm_init(void);
+
+// Set the 10-bit duty of a channel from the next period; stops a fade on that channel
+void pwm_set_duty(uint8_t channel, uint16_t duty);
+
+// Set the gamma-corrected brightness (0..255) from the next period; stops a fade
+void pwm_set_level(uint8_t channel, uint8_t level);
+
+// Fade from the current brightness to 'level', one step every 'step_periods' periods (1..255)
+void pwm_fade(uint8_t channel, uint8_t level, uint8_t step_periods);
+
+// Bit mask of the channels still fading (bit n = channel n)
+uint8_t pwm_fading(void);
+
+// Current brightness level of a channel
+uint8_t pwm_get_level(uint8_t channel);
+
+// Service TMR2IF/T0IF; call from the application's interrupt routine
+void pwm_isr(void);
+
+#endif /* PWM_H */
@@ -0,0 +1,180 @@
+/* File:   capture.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * 32-bit input capture on CCP1 + Timer1 (see capture.h).
+ * The ISR owns the ring, the sum and the overflow count; capture_get() copies the reading
+ * with CCP1IE and TMR1IE cleared, which only delays the interrupts by a few instructions
+ * (CCPR1 holds the capture and TMR1IF stays set until they are serviced).
+ */
+
+#include <xc.h>
+#include <stdint.h>
+#include "capture.h"
+
+#define CAPTURE_AVG_MASK (CAPTURE_AVG_SIZE - 1)
+
+static uint16_t overflows;          // Upper 16 bits of the Timer1 time
+static uint8_t idle;                // Overflows since the last capture
+static uint32_t last;               // Time of the previous capture
+static uint8_t have_last;
+
+static uint32_t ring[CAPTURE_AVG_SIZE];
+static uint8_t ring_pos;
+static uint32_t sum;
+static uint8_t count;
+static uint8_t edges = 1;           // Capture prescaler
+static uint32_t previous;           // Last interval measured, kept or not (0: none)
+static uint16_t dropped;
+
+// Forget the previous capture and the average
+static void restart(void)
+{
+    uint8_t i;
+
+    have_last = 0;
+    previous = 0;
+    sum = 0;
+    count = 0;
+    ring_pos = 0;
+    for (i = 0; i < CAPTURE_AVG_SIZE; i++) {
+        ring[i] = 0;
+    }
+}
+
+// CCP1M for every rising edge, every 4th or every 16th
+static uint8_t mode_for(uint8_t prescale)
+{
+    if (prescale >= 16) {
+        return 0x07;
+    }
+    if (prescale >= 4) {
+        return 0x06;
+    }
+    return 0x05;
+}
+
+void capture_init(uint8_t prescale)
+{
+    CCP1IE = 0;
+    TMR1IE = 0;
+    overflows = 0;
+    idle = 0;
+    dropped = 0;
+    restart();
+
+    TRISC2 = 1;         // CCP1 input
+    T1CON = 0x00;       // Fosc/4, 1:1
+    TMR1 = 0;
+
+    capture_set_prescale(prescale);
+
+    TMR1IF = 0;
+    TMR1IE = 1;
+    PEIE = 1;
+    GIE = 1;
+    TMR1ON = 1;
+}
+
+void capture_set_prescale(uint8_t prescale)
+{
+    uint8_t mode = mode_for(prescale);
+
+    CCP1IE = 0;
+    // Changing the prescaler in capture mode can raise a false interrupt: switch the module
+    // off first, as the datasheet recommends, and drop the flag
+    CCP1CON = 0x00;
+    CCP1CON = mode;
+    edges = mode == 0x07 ? 16 : mode == 0x06 ? 4 : 1;
+    restart();
+    CCP1IF = 0;
+    CCP1IE = 1;
+}
+
+void capture_get(capture_result_t *result)
+{
+    CCP1IE = 0;
+    TMR1IE = 0;
+    result->ticks = sum;
+    result->captures = count;
+    result->prescale = edges;
+    result->dropped = dropped;
+    TMR1IE = 1;
+    CCP1IE = 1;
+}
+
+uint32_t capture_period_ticks(const capture_result_t *result)
+{
+    uint16_t periods = (uint16_t)result->captures * result->prescale;
+
+    if (periods == 0) {
+        return 0;
+    }
+    return (result->ticks + periods / 2) / periods;
+}
+
+uint32_t capture_frequency_mhz(const capture_result_t *result)
+{
+    uint32_t n, q, r;
+    uint8_t i;
+
+    if (result->captures == 0 || result->ticks == 0) {
+        return 0;
+    }
+    // f = CAPTURE_TICK_HZ * periods / ticks, with three decimals by long division (the
+    // remainder stays below ticks, so r * 10 fits in 32 bits)
+    n = (uint32_t)CAPTURE_TICK_HZ * ((uint16_t)result->captures * result->prescale);
+    q = n / result->ticks;
+    r = n % result->ticks;
+    for (i = 0; i < 3; i++) {
+        r *= 10;
+        q = q * 10 + r / result->ticks;
+        r %= result->ticks;
+    }
+    return q;
+}
+
+void capture_isr(void)
+{
+    uint16_t captured, high;
+    uint32_t now, interval;
+
+    if (CCP1IE && CCP1IF) {
+        CCP1IF = 0;
+        captured = CCPR1;
+        high = overflows;
+        // Overflow not counted yet: a low capture value was taken after it
+        if (TMR1IF && !(captured & 0x8000)) {
+            high++;
+        }
+        now = ((uint32_t)high << 16) | captured;
+        idle = 0;
+
+        if (have_last) {
+            interval = now - last;
+            if (previous != 0 && interval >= previous + (previous >> 1)) {
+                dropped++;      // Two periods in one interval if a capture was lost
+            } else {
+                sum -= ring[ring_pos];
+                ring[ring_pos] = interval;
+                sum += interval;
+                ring_pos = (ring_pos + 1) & CAPTURE_AVG_MASK;
+                if (count < CAPTURE_AVG_SIZE) {
+                    count++;
+                }
+            }
+            previous = interval;
+        }
+        last = now;
+        have_last = 1;
+    }
+
+    if (TMR1IE && TMR1IF) {
+        TMR1IF = 0;
+        overflows++;
+        if (++idle >= CAPTURE_TIMEOUT_OVERFLOWS) {
+            idle = 0;
+            restart();  // Signal lost
+        }
+    }
+}
@@ -0,0 +1,92 @@
+/* File:   capture.h
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Input-capture period and frequency measurement on CCP1 (RC2) for the PIC16F877A.
+ * Timer1 runs on Fosc/4 and is extended to 32 bits by counting its overflows (TMR1IF), so
+ * the time between two edges can exceed 65535 ticks. Each capture is turned into a 32-bit
+ * timestamp, the interval from the previous one is stored in a ring of the last
+ * CAPTURE_AVG_SIZE intervals, and the main loop reads the rolling sum.
+ *
+ * Capture and overflow race: when a capture and an overflow are both pending in the same
+ * interrupt, a captured value in the lower half of the Timer1 range was taken after the
+ * overflow (it belongs to the next 65536-tick block), one in the upper half before it.
+ * The ISR checks this before counting the overflow.
+ *
+ * The capture prescaler takes one capture every 1, 4 or 16 rising edges, which keeps the
+ * interrupt rate low for fast signals: with an average over CAPTURE_AVG_SIZE captures, a
+ * reading spans up to 16 * CAPTURE_AVG_SIZE signal periods. When no edge arrives for
+ * CAPTURE_TIMEOUT_OVERFLOWS Timer1 overflows, the reading is cleared (no signal).
+ *
+ * Upper limit: capture_isr() with the interrupt entry and exit takes about 200 instruction
+ * cycles, so captures must be at least CAPTURE_ISR_TICKS apart. At the 1:16 prescaler that
+ * is CAPTURE_MAX_HZ (62.5 kHz at 4 MHz). Above it a capture can be overwritten before the
+ * ISR reads it and one interval then spans two capture periods. The ISR leaves out of the
+ * average, and counts, an interval of 1.5 times the previous one or more: a lost capture,
+ * or a step down in frequency, which the next interval confirms.
+ *
+ * The application must call capture_isr() from its __interrupt() routine.
+ */
+
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <stdint.h>
+
+// Crystal of this project (see newmain.c); Timer1 counts Fosc/4
+#ifndef _XTAL_FREQ
+#define _XTAL_FREQ 4000000
+#endif
+
+#define CAPTURE_TICK_HZ (_XTAL_FREQ / 4)
+
+// Shortest capture interval the ISR keeps up with, and the highest frequency measured
+#define CAPTURE_ISR_TICKS 256
+#define CAPTURE_MAX_HZ (CAPTURE_TICK_HZ * 16 / CAPTURE_ISR_TICKS)
+
+// Capture intervals in the rolling average (power of two)
+#ifndef CAPTURE_AVG_SIZE
+#define CAPTURE_AVG_SIZE 8
+#endif
+
+// Timer1 overflows (65536 ticks each) without an edge before the signal counts as lost
+#ifndef CAPTURE_TIMEOUT_OVERFLOWS
+#define CAPTURE_TIMEOUT_OVERFLOWS 32
+#endif
+
+#if (CAPTURE_AVG_SIZE & (CAPTURE_AVG_SIZE - 1)) || CAPTURE_AVG_SIZE > 16
+#error "CAPTURE_AVG_SIZE must be a power of two no larger than 16"
+#endif
+
+// The rolling sum must stay below 2^32 / 10 ticks for capture_frequency_mhz()
+#if CAPTURE_AVG_SIZE * (CAPTURE_TIMEOUT_OVERFLOWS + 1) * 65536ULL > 429496729ULL
+#error "CAPTURE_AVG_SIZE * CAPTURE_TIMEOUT_OVERFLOWS is too large"
+#endif
+
+// A reading: 'ticks' Timer1 ticks for captures * prescale signal periods
+typedef struct {
+    uint32_t ticks;     // Sum of the averaged capture intervals
+    uint8_t captures;   // Intervals in the sum (0: no signal yet, or lost)
+    uint8_t prescale;   // Signal periods per capture interval (1, 4 or 16)
+    uint16_t dropped;   // Intervals left out of the average (1.5 times the previous or more)
+} capture_result_t;
+
+// Start Timer1 (Fosc/4, 1:1) and CCP1 capture every 'prescale' rising edges (1, 4 or 16)
+void capture_init(uint8_t prescale);
+
+// Change the capture prescaler; the average restarts
+void capture_set_prescale(uint8_t prescale);
+
+// Copy the current reading
+void capture_get(capture_result_t *result);
+
+// Average signal period in Timer1 ticks, rounded (0 without a reading)
+uint32_t capture_period_ticks(const capture_result_t *result);
+
+// Signal frequency in mHz (0 without a reading)
+uint32_t capture_frequency_mhz(const capture_result_t *result);
+
+// Service CCP1IF/TMR1IF; call from the application's interrupt routine
+void capture_isr(void);
+
+#endif /* CAPTURE_H */
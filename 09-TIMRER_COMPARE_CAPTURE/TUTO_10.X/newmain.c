@@ -1,12 +1,13 @@
 /* File: Capture-Mode.c
  * Author: Marwen Maghrebi
  * Description: Configures PIC microcontroller for capture mode using CCP1 module.
- *              This code sets up the PIC microcontroller to operate in capture mode
- *              using the CCP1 module. It captures events triggered by an external
- *              signal and toggles an LED connected to pin RC3 when the captured value
- *              reaches 9.The captured value is also displayed on PORTB, and the current count of
- *              Timer1 is displayed on PORTD. The LED on RC3 serves as a visual indicator
- *              of the captured event.
+ *              This code measures the frequency of the signal on the CCP1 pin (RC2) with the
+ *              capture engine of capture.c: Timer1 is extended to 32 bits by its overflow
+ *              interrupt and the interval between captures is averaged. The frequency in Hz
+ *              is displayed on PORTD (high byte) and PORTB (low byte), and the LED on RC3 is
+ *              on while a signal is present. The capture prescaler (every 1, 4 or 16 edges)
+ *              follows the input frequency to keep the interrupt rate low. Inputs above
+ *              CAPTURE_MAX_HZ (62.5 kHz) show 0xFFFF (over range).
  */
  
 #include <xc.h>
@@ -22,64 +23,68 @@
 #pragma config WRT = OFF        // Flash Program Memory Write Enable bits (Write protection off; all program memory may be written to by EECON control)
 #pragma config CP = OFF         // Flash Program Memory Code Protection bit (Code protection off)
  
-// Global variable
-uint8_t captureCount = 0;
+#define _XTAL_FREQ 4000000
+#include "capture.h"
+ 
+// Shown on PORTD:PORTB above CAPTURE_MAX_HZ (or 65535 Hz with a faster crystal)
+#define OVER_RANGE 0xFFFF
+
+// Auto-range limits, in Timer1 ticks per capture interval: above ~2.5 kHz of capture
+// interrupts go to a larger prescaler, back down once the interval is long again
+#define RANGE_UP_TICKS   400
+#define RANGE_DOWN_TICKS 4000
  
 // Main function
 void main(void) {
+    capture_result_t result;
+    uint32_t per_capture, hz;
+    uint8_t prescale = 1;
+ 
     // Configure IO Ports
     TRISC3 = 0; // LED pin (now on RC3) as output
     RC3 = 0;    // Initially OFF
  
-    TRISB = 0x00; // Output Port for Capture Operation (CCPR1 register)
+    TRISB = 0x00; // Output Port for the frequency, low byte
     PORTB = 0x00; // Initial State
  
-    TRISD = 0x00; // Output Port for TMR1 Module (TMR1 register)
+    TRISD = 0x00; // Output Port for the frequency, high byte
     PORTD = 0x00; // Initial State
  
-    // Configure Timer1 Module to Operate in Counter Mode
-    TMR1 = 0;
-    T1CKPS0 = 0;
-    T1CKPS1 = 0;
-    TMR1CS = 1; // Counter mode
-    T1OSCEN = 1;
-    T1SYNC = 0;
-    TMR1ON = 1;
- 
-    // Configure CCP1 Module to Operate in Capture Mode
-    CCP1M0 = 1;
-    CCP1M1 = 0;
-    CCP1M2 = 1;
-    CCP1M3 = 0;
- 
-    // Enable CCP1 Interrupt
-    CCP1IE = 1;
-    PEIE = 1;
-    GIE = 1;
+    // Timer1 on Fosc/4 and CCP1 capture on every rising edge
+    capture_init(prescale);
  
     // Main Loop
     while (1) {
-        // Read & Print Out the TMR1 Counts
-        PORTD = TMR1L;
+        capture_get(&result);
+        if (result.captures == 0) {
+            RC3 = 0;    // No signal
+            PORTB = 0;
+            PORTD = 0;
+            continue;
+        }
+        RC3 = 1;
+ 
+        // Rounded frequency in Hz; past CAPTURE_MAX_HZ the ISR loses captures
+        hz = (capture_frequency_mhz(&result) + 500) / 1000;
+        if (hz > CAPTURE_MAX_HZ || hz > 0xFFFF) {
+            hz = OVER_RANGE;
+        }
+        PORTB = (uint8_t)hz;
+        PORTD = (uint8_t)(hz >> 8);
+ 
+        // Keep the capture interrupt rate reasonable
+        per_capture = result.ticks / result.captures;
+        if (per_capture < RANGE_UP_TICKS && prescale < 16) {
+            prescale *= 4;
+            capture_set_prescale(prescale);
+        } else if (per_capture > RANGE_DOWN_TICKS && prescale > 1) {
+            prescale /= 4;
+            capture_set_prescale(prescale);
+        }
     }
 }
  
 // ISR Handler
 void __interrupt() ISR() {
-    if (CCP1IF) {
-        // Capture event occurred, read CCPR1 value
-        uint16_t capturedValue = CCPR1L | (CCPR1H << 8);
-        
-        if (capturedValue == 9) {
-            // Toggle the LED (now on RC3)
-            RC3 = ~RC3;
-        }
-        
- 
-        // Write CCPR1 value to PORTB
-        PORTB = capturedValue;
- 
-        // Clear the Interrupt Flag Bit
-        CCP1IF = 0;
-    }
-}
\ No newline at end of file
+    capture_isr();
+}
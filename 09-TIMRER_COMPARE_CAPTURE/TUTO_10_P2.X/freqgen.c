@@ -0,0 +1,166 @@
+/* File:   freqgen.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Square-wave generator on CCP1 special event compares (see freqgen.h).
+ * The compare values are stored as CCPR1 values (counts - 1). The main loop hands a new
+ * setting to the ISR with CCP1IE cleared, since it is five bytes that must be seen together.
+ */
+
+#include <xc.h>
+#include <stdint.h>
+#include "freqgen.h"
+
+// Active setting (ISR only once running)
+static uint16_t high_ccpr, low_ccpr;
+static uint8_t high_phase = 0;          // 1 while the pin is high
+
+// Setting waiting for the next period
+static uint16_t next_high, next_low;
+static uint8_t next_ckps;
+static volatile uint8_t pending = 0;
+
+static volatile uint8_t running = 0;
+static uint32_t period_cycles = 0;
+static uint8_t prescale = 1;
+
+// Write CCPR1 with TMR1 just reset: park the high byte at 0xFF first, so no intermediate
+// value can match the small TMR1 count
+static void load_compare(uint16_t value)
+{
+    CCPR1H = 0xFF;
+    CCPR1L = (uint8_t)value;
+    CCPR1H = (uint8_t)(value >> 8);
+}
+
+static void set_ckps(uint8_t ckps)
+{
+    T1CON = (uint8_t)((T1CON & 0xCF) | (ckps << 4));
+}
+
+void freqgen_init(void)
+{
+    CCP1IE = 0;
+    running = 0;
+    pending = 0;
+    period_cycles = 0;
+
+    FREQGEN_PIN = 0;
+    FREQGEN_TRIS = 0;
+
+    T1CON = 0x00;       // Timer mode, stopped
+    TMR1 = 0;
+    CCP1CON = 0x0B;     // Compare, special event trigger (resets TMR1)
+    CCP1IF = 0;
+    PEIE = 1;
+    GIE = 1;
+}
+
+uint8_t freqgen_set(uint16_t hz, uint8_t duty_percent)
+{
+    uint32_t counts, high, low, min_counts;
+    uint8_t ckps, p;
+
+    if (hz == 0) {
+        return 0;
+    }
+    if (duty_percent < 1) {
+        duty_percent = 1;
+    } else if (duty_percent > 99) {
+        duty_percent = 99;
+    }
+
+    // Smallest prescaler for which both halves fit in 16 bits
+    for (ckps = 0, p = 1; ckps < 4; ckps++, p <<= 1) {
+        counts = (FREQGEN_FCY + (uint32_t)hz * p / 2) / ((uint32_t)hz * p);
+        min_counts = (FREQGEN_MIN_CYCLES + p - 1) / p;
+        if (counts < 2 * min_counts) {
+            return 0;                   // Too fast
+        }
+        high = (counts * duty_percent + 50) / 100;
+        if (high < min_counts) {
+            high = min_counts;
+        } else if (high > counts - min_counts) {
+            high = counts - min_counts;
+        }
+        low = counts - high;
+        if (high <= 65536UL && low <= 65536UL) {
+            break;
+        }
+    }
+    if (ckps == 4) {
+        return 0;                       // Too slow
+    }
+
+    CCP1IE = 0;
+    next_high = (uint16_t)(high - 1);
+    next_low = (uint16_t)(low - 1);
+    next_ckps = ckps;
+    period_cycles = counts * p;
+    prescale = p;
+    if (running) {
+        pending = 1;
+        CCP1IE = 1;
+        return 1;
+    }
+
+    // First start: the period begins now, high
+    high_ccpr = next_high;
+    low_ccpr = next_low;
+    set_ckps(ckps);
+    TMR1 = 0;
+    load_compare(high_ccpr);
+    high_phase = 1;
+    FREQGEN_PIN = 1;
+    running = 1;
+    CCP1IF = 0;
+    CCP1IE = 1;
+    TMR1ON = 1;
+    return 1;
+}
+
+uint32_t freqgen_period_cycles(void)
+{
+    return period_cycles;
+}
+
+uint8_t freqgen_prescale(void)
+{
+    return prescale;
+}
+
+void freqgen_stop(void)
+{
+    CCP1IE = 0;
+    TMR1ON = 0;
+    running = 0;
+    pending = 0;
+    FREQGEN_PIN = 0;
+}
+
+void freqgen_isr(void)
+{
+    if (!(CCP1IE && CCP1IF)) {
+        return;
+    }
+    CCP1IF = 0;
+
+    // Pin first: the same latency on every edge
+    if (high_phase) {
+        FREQGEN_PIN = 0;
+        high_phase = 0;
+        load_compare(low_ccpr);
+        return;
+    }
+    FREQGEN_PIN = 1;
+    high_phase = 1;
+
+    // Period boundary: the only point where a new setting is taken
+    if (pending) {
+        high_ccpr = next_high;
+        low_ccpr = next_low;
+        set_ckps(next_ckps);
+        pending = 0;
+    }
+    load_compare(high_ccpr);
+}
@@ -0,0 +1,72 @@
+/* File:   freqgen.h
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Programmable square-wave generator on Timer1 + CCP1 in compare mode with special event
+ * trigger (CCP1M = 1011). Every match resets TMR1 in hardware, so each half period lasts
+ * exactly (CCPR1 + 1) * prescale cycles whatever the interrupt latency; the CCP1 interrupt
+ * only drives the pin and loads the compare value of the next half. The high and low halves
+ * use two different compare values (paired compare events), which gives the duty cycle.
+ *
+ * freqgen_set() picks the smallest Timer1 prescaler (1, 2, 4, 8) for which both halves fit
+ * in 16 bits, the same rule as CLK_TMR1_PRESCALE() in common/clockcalc.h. The new setting is
+ * handed to the interrupt and applied at the start of the next period, so the output never
+ * has a shortened or mixed period. CCPR1 is rewritten right after a match, while TMR1 is
+ * still far below any compare value.
+ *
+ * The pin edges follow the matches by the interrupt latency, which is the same on every
+ * edge, so it delays the waveform without changing its period. A retune that changes the
+ * prescaler counts the few Timer1 ticks between that match and the interrupt at the new
+ * rate, which moves that one edge by at most the latency; the periods stay exact.
+ *
+ * The application must call freqgen_isr() from its __interrupt() routine.
+ */
+
+#ifndef FREQGEN_H
+#define FREQGEN_H
+
+#include <stdint.h>
+
+// Crystal of this project (see main.c)
+#ifndef _XTAL_FREQ
+#define _XTAL_FREQ 4000000
+#endif
+
+// Output pin
+#ifndef FREQGEN_PIN
+#define FREQGEN_PIN  RC4
+#define FREQGEN_TRIS TRISC4
+#endif
+
+// Shortest half period, in cycles: the interrupt must have loaded the next compare value
+// before TMR1 reaches it
+#ifndef FREQGEN_MIN_CYCLES
+#define FREQGEN_MIN_CYCLES 100
+#endif
+
+#define FREQGEN_FCY (_XTAL_FREQ / 4)
+
+// Frequency range with a 50 % duty (the lowest needs 65536 counts per half at 1:8)
+#define FREQGEN_MIN_HZ ((FREQGEN_FCY + 2UL * 8 * 65536 - 1) / (2UL * 8 * 65536))
+#define FREQGEN_MAX_HZ (FREQGEN_FCY / (2UL * FREQGEN_MIN_CYCLES))
+
+// Prepare Timer1, CCP1 and the pin; the output stays low until freqgen_set()
+void freqgen_init(void);
+
+// Output 'hz' with 'duty_percent' (1..99) high time. A duty that would give a half shorter
+// than FREQGEN_MIN_CYCLES is limited. Returns 1, or 0 if 'hz' is out of range.
+uint8_t freqgen_set(uint16_t hz, uint8_t duty_percent);
+
+// Period of the last accepted setting, in instruction cycles (0 before freqgen_set())
+uint32_t freqgen_period_cycles(void);
+
+// Timer1 prescaler of the last accepted setting
+uint8_t freqgen_prescale(void);
+
+// Stop the output (pin low)
+void freqgen_stop(void);
+
+// Service CCP1IF; call from the application's interrupt routine
+void freqgen_isr(void);
+
+#endif /* FREQGEN_H */
@@ -3,6 +3,8 @@
  * Description: Configures PIC microcontroller for compare mode using CCP1 module.
  *Using the Compare mode to generate a 1Hz square wave is a practical application commonly
  *found in various electronic devices and systems.
+ *The generator (freqgen.c) lets the special event trigger reset Timer1 in hardware and loads the
+ *compare value of each half period from the ISR, so the frequency and duty can be changed at run time.
  */
  
 #include <xc.h>
@@ -18,22 +20,28 @@
 #pragma config WRT = OFF        // Flash Program Memory Write Enable bits (Write protection off; all program memory may be written to by EECON control)
 #pragma config CP = OFF         // Flash Program Memory Code Protection bit (Code protection off)
  
-// Frequency settings for 1Hz square wave
+// Frequency settings for 1Hz square wave: two compare events per period, one per half
 #define _XTAL_FREQ 4000000      // Assuming 4MHz crystal oscillator
-#define TIMER1_PRESCALE 1
-#define COMPARE_VALUE ((_XTAL_FREQ / (4 * TIMER1_PRESCALE)) - 1) // Calculation for 1 second
- 
-// Function prototypes
-void Compare_Init();
+#define SQUARE_HZ   1
+#define SQUARE_DUTY 50          // Percent of the period high
+#include "freqgen.h"
+
+// Build-time check of the default: each half is one Timer1 compare interval, with the
+// prescaler chosen by the same rule as freqgen_set() (1:8, CCPR1 = 62499)
+#define TMR1_RATE_HZ (2 * SQUARE_HZ)
+#include "../../common/clockcalc.h"
+
+#if SQUARE_HZ < FREQGEN_MIN_HZ || SQUARE_HZ > FREQGEN_MAX_HZ
+#error "SQUARE_HZ is out of the generator's range for _XTAL_FREQ"
+#endif
  
 // Main function
 void main(void) {
-    // Configure IO Ports
-    TRISC4 = 0; // Set The Output Pin For The Square Wave
-    RC4 = 0;    // Initially OFF
+    // Configure RC4 as the square wave output, initially OFF
+    freqgen_init();
  
-    // Initialize Compare mode
-    Compare_Init();
+    // Start the square wave
+    freqgen_set(SQUARE_HZ, SQUARE_DUTY);
  
     // Main Loop
     while (1) {
@@ -41,40 +49,7 @@ void main(void) {
     }
 }
  
-// Function to initialize Compare mode
-void Compare_Init() {
-    // Configure Timer1 Module to Operate In Timer Mode
-    TMR1 = 0;
-    T1CKPS0 = 0;
-    T1CKPS1 = 0;
-    TMR1CS = 0; // Timer mode
-    TMR1ON = 1;
- 
-    // Configure CCP1 Module to Operate in Compare Mode
-    // Preload The CCPR1 Register with the compare value for 1 second
-    CCPR1 = COMPARE_VALUE;
-    // CCP in Compare Mode, CCPx Pin Is Unchanged & Trigger Special Event
-    CCP1M0 = 1;
-    CCP1M1 = 1;
-    CCP1M2 = 0;
-    CCP1M3 = 1;
- 
-    // Enable CCP1 Interrupt
-    CCP1IE = 1;
-    PEIE = 1;
-    GIE = 1;
-}
- 
 // Interrupt Service Routine for CCP1
 void __interrupt() ISR() {
-    if (CCP1IF) {
-        // Toggle The Output Pin to generate a square wave
-        RC4 = ~RC4;
- 
-        // Clear The Interrupt Flag Bit
-        CCP1IF = 0;
- 
-        // Reset the Timer1 value
-        TMR1 = 0;
-    }
-}
\ No newline at end of file
+    freqgen_isr();
+}
@@ -0,0 +1,164 @@
+/* File:   counter.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * 32-bit Timer0 event counter (see counter.h).
+ * 'overflows' is written by the ISR only. counter_reset() clears TMR0 itself, which may drop
+ * an edge arriving in the same two cycles; that is the only write to TMR0.
+ */
+
+#include <xc.h>
+#include <stdint.h>
+#include "counter.h"
+
+#define TMR2_RATE_HZ 1000
+#include "../../common/clockcalc.h"
+
+static volatile uint32_t overflows = 0;     // Timer0 overflows: count = overflows * 256 + TMR0
+
+// Gate window (ISR only, except 'window')
+static uint16_t gate = COUNTER_GATE_MS;
+static uint32_t gate_start = 0;
+static volatile uint32_t window = 0;        // Events in the last complete window
+
+static const counter_rule_t *table;
+static uint8_t rule_count = 0;
+static uint8_t active = 0;
+static uint8_t first_poll = 1;
+
+// Count from TMR0 and the overflows; T0IE must be clear (or called from the ISR)
+static uint32_t snapshot(void)
+{
+    uint8_t low = TMR0;
+    uint32_t high = overflows;
+
+    // Overflow not counted yet: a low TMR0 value was read after it
+    if (T0IF && low < 128) {
+        high++;
+    }
+    return (high << 8) | low;
+}
+
+// Events per second from the events of one gate window
+static uint32_t per_second(uint32_t events)
+{
+#if COUNTER_GATE_MS == 1000
+    return events;
+#else
+    return events * 1000UL / COUNTER_GATE_MS;
+#endif
+}
+
+void counter_init(const counter_rule_t *rules, uint8_t count)
+{
+    if (count > COUNTER_MAX_RULES) {
+        count = COUNTER_MAX_RULES;
+    }
+    table = rules;
+    rule_count = count;
+    active = 0;
+    first_poll = 1;
+
+    // Timer0: T0CKI rising edges, prescaler assigned to the WDT (one count per edge)
+    TRISA4 = 1;
+    OPTION_REGbits.T0CS = 1;
+    OPTION_REGbits.T0SE = 0;
+    OPTION_REGbits.PSA = 1;
+
+    // Timer2: 1 ms gate tick
+    T2CON = 0x00;
+    T2CONbits.T2CKPS = TMR2_CKPS_VALUE;
+    PR2 = TMR2_PR2_VALUE;
+    TMR2 = 0;
+
+    counter_reset();
+
+    TMR2IF = 0;
+    TMR2IE = 1;
+    TMR2ON = 1;
+    T0IE = 1;
+    PEIE = 1;
+    GIE = 1;
+}
+
+void counter_reset(void)
+{
+    T0IE = 0;
+    TMR2IE = 0;
+    TMR0 = 0;
+    T0IF = 0;
+    overflows = 0;
+    gate = COUNTER_GATE_MS;
+    gate_start = 0;
+    window = 0;
+    TMR2IE = 1;
+    T0IE = 1;
+}
+
+uint32_t counter_count(void)
+{
+    uint32_t count;
+
+    T0IE = 0;
+    count = snapshot();
+    T0IE = 1;
+    return count;
+}
+
+uint32_t counter_rate(void)
+{
+    uint32_t events;
+
+    TMR2IE = 0;
+    events = window;
+    TMR2IE = 1;
+    return per_second(events);
+}
+
+uint8_t counter_poll(void)
+{
+    uint32_t count, rate, value;
+    uint8_t i, bit, state = 0;
+
+    // Count and rate from the same instant: no overflow or gate tick between the two reads
+    T0IE = 0;
+    TMR2IE = 0;
+    count = snapshot();
+    rate = window;
+    TMR2IE = 1;
+    T0IE = 1;
+    rate = per_second(rate);
+
+    for (i = 0, bit = 1; i < rule_count; i++, bit <<= 1) {
+        value = table[i].source == COUNTER_SRC_RATE ? rate : count;
+        if (value >= table[i].threshold) {
+            state |= bit;
+        }
+        if (first_poll || ((state ^ active) & bit)) {
+            table[i].action((state & bit) != 0);
+        }
+    }
+    active = state;
+    first_poll = 0;
+    return state;
+}
+
+void counter_isr(void)
+{
+    uint32_t now;
+
+    if (T0IE && T0IF) {
+        T0IF = 0;
+        overflows++;
+    }
+
+    if (TMR2IE && TMR2IF) {
+        TMR2IF = 0;
+        if (--gate == 0) {
+            gate = COUNTER_GATE_MS;
+            now = snapshot();
+            window = now - gate_start;
+            gate_start = now;
+        }
+    }
+}
@@ -0,0 +1,86 @@
+/* File:   counter.h
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * 32-bit external event counter on Timer0 (T0CKI, RA4) with rate measurement and a table of
+ * threshold rules.
+ *
+ * Timer0 counts the rising edges in hardware; its overflow interrupt (T0IF) counts the upper
+ * 24 bits, so no event is lost between polls and the count never wraps at 256. TMR0 is never
+ * written while counting (a write holds the counter for two cycles and could drop an edge).
+ *
+ * A count read outside the interrupt takes TMR0 and the overflow count together with T0IE
+ * cleared; if an overflow is pending but not yet counted, a TMR0 value in the lower half was
+ * read after it and the overflow is added.
+ *
+ * Timer2 gives a 1 ms tick; every COUNTER_GATE_MS ticks the interrupt takes a snapshot and
+ * stores the events of that window, giving events per second.
+ *
+ * counter_poll() takes one snapshot of the count and the rate, evaluates every rule of the
+ * application's table against it (active while value >= threshold) and calls the rule's
+ * action when its state changes. Call it from the main loop without delays.
+ *
+ * The application must call counter_isr() from its __interrupt() routine.
+ */
+
+#ifndef COUNTER_H
+#define COUNTER_H
+
+#include <stdint.h>
+
+// Crystal of this project (see main.c)
+#ifndef _XTAL_FREQ
+#define _XTAL_FREQ 4000000
+#endif
+
+// Rate measurement window, in 1 ms Timer2 ticks
+#ifndef COUNTER_GATE_MS
+#define COUNTER_GATE_MS 1000
+#endif
+
+// Largest rule table accepted by counter_init()
+#ifndef COUNTER_MAX_RULES
+#define COUNTER_MAX_RULES 8
+#endif
+
+#if COUNTER_GATE_MS < 1 || COUNTER_GATE_MS > 65535
+#error "COUNTER_GATE_MS must be between 1 and 65535"
+#endif
+
+#if COUNTER_MAX_RULES < 1 || COUNTER_MAX_RULES > 8
+#error "COUNTER_MAX_RULES must be between 1 and 8"
+#endif
+
+// Value a rule compares against its threshold
+#define COUNTER_SRC_COUNT 0     // Events since counter_reset()
+#define COUNTER_SRC_RATE  1     // Events per second over the last window
+
+typedef void (*counter_action_t)(uint8_t active);
+
+// One rule (lives in flash): action(1) when the value reaches threshold, action(0) below
+typedef struct {
+    uint8_t source;
+    uint32_t threshold;
+    counter_action_t action;
+} counter_rule_t;
+
+// Count rising edges on RA4/T0CKI, start the 1 ms gate tick and install the rule table.
+// Every action is called once with its initial state on the first counter_poll().
+void counter_init(const counter_rule_t *rules, uint8_t count);
+
+// Restart the count at 0
+void counter_reset(void);
+
+// Events since counter_reset() (wraps at 2^32)
+uint32_t counter_count(void);
+
+// Events per second over the last complete window (0 until one has elapsed)
+uint32_t counter_rate(void);
+
+// Evaluate the rules against one snapshot; returns the bit mask of active rules
+uint8_t counter_poll(void);
+
+// Service T0IF/TMR2IF; call from the application's interrupt routine
+void counter_isr(void);
+
+#endif /* COUNTER_H */
@@ -4,9 +4,9 @@
  * Description:
  * This project demonstrates controlling two LEDs and a relay using the PIC16F877A microcontroller 
  * based on the Timer0 module. The Timer0 is configured to count external clock pulses from a button 
- * connected to the RA4/T0CKI pin. As the Timer0 value increments, the LEDs and relay are triggered 
- * at specific thresholds, providing visual feedback on the count value. The project showcases 
- * simple external clock counting with thresholds for controlling outputs.
+ * connected to the RA4/T0CKI pin. The Timer0 overflow interrupt extends the count to 32 bits and
+ * Timer2 gates a one-second window for the event rate (counter.c). The LEDs and relay are driven by
+ * a table of threshold rules evaluated on every pass of the main loop, without a polling delay.
  */
 
 
@@ -25,7 +25,8 @@
 
 #define _XTAL_FREQ 4000000      // 4 MHz Crystal
 
-#define BUTTON PORTAbits.RA4    // Button connected to RA4/T0CKI
+#include "counter.h"
+
 #define LED1   PORTBbits.RB0    // LED1 connected to RB0
 #define LED2   PORTBbits.RB1    // LED2 connected to RB1
 #define RELAY  PORTBbits.RB2    // Relay connected to RB2
@@ -34,6 +35,20 @@
 #define COUNT_THRESHOLD2 10     // Second threshold for LED2
 #define COUNT_THRESHOLD3 15     // Third threshold for Relay
 
+static void Led1_Set(uint8_t on)  { LED1 = on; }
+static void Led2_Set(uint8_t on)  { LED2 = on; }
+static void Relay_Set(uint8_t on) { RELAY = on; }
+
+static const counter_rule_t rules[] = {
+    { COUNTER_SRC_COUNT, COUNT_THRESHOLD1, Led1_Set },
+    { COUNTER_SRC_COUNT, COUNT_THRESHOLD2, Led2_Set },
+    { COUNTER_SRC_COUNT, COUNT_THRESHOLD3, Relay_Set },
+};
+
+void __interrupt() ISR(void) {
+    counter_isr();
+}
+
 void main(void) {
     // Configure ports
     TRISA = 0xFF;  // Set all PORTA pins as inputs
@@ -42,41 +57,11 @@ void main(void) {
     // Initialize PORTB
     PORTB = 0;
 
-    // Configure TMR0
-    OPTION_REGbits.T0CS = 1;  // TMR0 Clock Source is from T0CKI pin (RA4)
-    OPTION_REGbits.T0SE = 0;  // Increment on low-to-high transition on RA4/T0CKI pin
-    OPTION_REGbits.PSA = 1;   // Prescaler is not assigned to the Timer0 module
-
-    TMR0 = 0;  // Clear TMR0
-
-    uint8_t prevTMR0 = 0;  // To detect TMR0 changes
+    // TMR0 counts rising edges on RA4/T0CKI, Timer2 gates the rate window
+    counter_init(rules, sizeof(rules) / sizeof(rules[0]));
 
     while(1) {
-        // Check if TMR0 has changed
-        if (TMR0 != prevTMR0) {
-            prevTMR0 = TMR0;  // Update prevTMR0
-            
-            // Check thresholds and update outputs
-            if (TMR0 >= COUNT_THRESHOLD1) {
-                LED1 = 1;  // Turn on LED1
-            } else {
-                LED1 = 0;  // Turn off LED1
-            }
-            
-            if (TMR0 >= COUNT_THRESHOLD2) {
-                LED2 = 1;  // Turn on LED2
-            } else {
-                LED2 = 0;  // Turn off LED2
-            }
-            
-            if (TMR0 >= COUNT_THRESHOLD3) {
-                RELAY = 1;  // Activate relay
-            } else {
-                RELAY = 0;  // Deactivate relay
-            }
-        }
-        
-        // Optional: Add a small delay to debounce the button
-        __delay_ms(10);
+        // Outputs follow the count as soon as it crosses a threshold
+        counter_poll();
     }
-}
\ No newline at end of file
+}
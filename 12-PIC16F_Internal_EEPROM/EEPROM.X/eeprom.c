@@ -0,0 +1,179 @@
+/* File:   eeprom.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Interrupt-driven data EEPROM writer (see eeprom.h).
+ * The queue holds address/value pairs with two free-running 8-bit indices: the main loop
+ * writes 'head' (new bytes), the ISR writes 'tail'. The entry at 'tail' stays in the queue
+ * while it is being written, so eeprom_read() finds it. Main-loop code that starts a write
+ * or scans the queue does it with EEIE cleared, then puts back the caller's EEIE.
+ */
+
+#include <xc.h>
+#include <stdint.h>
+#include "eeprom.h"
+
+#define EEPROM_QUEUE_MASK (EEPROM_QUEUE_SIZE - 1)
+
+static uint8_t queue_address[EEPROM_QUEUE_SIZE];
+static uint8_t queue_data[EEPROM_QUEUE_SIZE];
+static volatile uint8_t head = 0;
+static volatile uint8_t tail = 0;
+static volatile uint8_t writing = 0;    // Entry at 'tail' is in the EEPROM write cycle
+
+static volatile eeprom_stats_t stats;
+
+static uint8_t read_byte(uint8_t address)
+{
+    EEADR = address;
+    EEPGD = 0;              // Data memory
+    EECON1bits.RD = 1;
+    return EEDATA;
+}
+
+// Start the write of the next queued byte that differs from the EEPROM, or go idle
+static void start_next(void)
+{
+    uint8_t i, gie;
+
+    while (tail != head) {
+        i = tail & EEPROM_QUEUE_MASK;
+        if (read_byte(queue_address[i]) != queue_data[i]) {
+            EEADR = queue_address[i];
+            EEDATA = queue_data[i];
+            EEPGD = 0;
+            WREN = 1;
+
+            // Unlock sequence: nothing may run between the three writes
+            gie = GIE;
+            GIE = 0;
+            EECON2 = 0x55;
+            EECON2 = 0xAA;
+            WR = 1;
+            if (gie) {
+                GIE = 1;
+            }
+
+            WREN = 0;       // Does not affect the write already started
+            writing = 1;
+            return;
+        }
+        stats.skipped++;
+        tail++;
+    }
+    writing = 0;
+}
+
+// Write cycle finished: check it and move on
+static void write_done(void)
+{
+    uint8_t i = tail & EEPROM_QUEUE_MASK;
+
+    EEIF = 0;
+    if (read_byte(queue_address[i]) == queue_data[i]) {
+        stats.writes++;
+    } else {
+        stats.errors++;
+    }
+    tail++;
+    start_next();
+}
+
+void eeprom_init(void)
+{
+    head = tail = 0;
+    writing = 0;
+    stats.writes = 0;
+    stats.skipped = 0;
+    stats.errors = 0;
+
+    WREN = 0;
+    EEIF = 0;
+    EEIE = 1;
+    PEIE = 1;
+    GIE = 1;
+}
+
+uint8_t eeprom_write_block(uint8_t address, const uint8_t *data, uint8_t len)
+{
+    uint8_t i, eeie;
+
+    if (len > (uint8_t)(EEPROM_QUEUE_SIZE - (uint8_t)(head - tail))) {
+        return 0;
+    }
+    for (i = 0; i < len; i++) {
+        queue_address[head & EEPROM_QUEUE_MASK] = address++;
+        queue_data[head & EEPROM_QUEUE_MASK] = data[i];
+        head++;
+    }
+
+    eeie = EEIE;
+    EEIE = 0;
+    if (!writing) {
+        start_next();
+    }
+    EEIE = eeie;
+    return 1;
+}
+
+uint8_t eeprom_read(uint8_t address)
+{
+    uint8_t i, value;
+    uint8_t eeie = EEIE;
+
+    EEIE = 0;
+    // Newest queued value wins
+    for (i = head; i != tail; i--) {
+        if (queue_address[(uint8_t)(i - 1) & EEPROM_QUEUE_MASK] == address) {
+            break;
+        }
+    }
+    if (i != tail) {
+        value = queue_data[(uint8_t)(i - 1) & EEPROM_QUEUE_MASK];
+    } else {
+        // EEADR/EEDATA must not change during a write cycle
+        while (WR) {
+        }
+        value = read_byte(address);
+    }
+    EEIE = eeie;
+    return value;
+}
+
+uint8_t eeprom_busy(void)
+{
+    return head != tail;
+}
+
+void eeprom_flush(void)
+{
+    uint8_t eeie = EEIE;
+
+    while (head != tail) {
+        // Service the completion here too, in case interrupts are off
+        EEIE = 0;
+        if (EEIF) {
+            write_done();
+        }
+        EEIE = eeie;
+    }
+}
+
+void eeprom_get_stats(eeprom_stats_t *out)
+{
+    // The 16-bit counters are updated by the ISR, so copy them with EEIE masked
+    uint8_t eeie = EEIE;
+
+    EEIE = 0;
+    out->writes = stats.writes;
+    out->skipped = stats.skipped;
+    out->errors = stats.errors;
+    EEIE = eeie;
+}
+
+void eeprom_isr(void)
+{
+    if (EEIE && EEIF) {
+        write_done();
+    }
+}
@@ -0,0 +1,66 @@
+/* File:   eeprom.h
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Non-blocking data EEPROM writer for the PIC16F877A.
+ * eeprom_write_block() copies the bytes into a queue and returns at once; each byte write
+ * (about 4 ms) is started from the EEIF interrupt of the previous one, so the CPU never waits
+ * on the EEPROM. A byte that already holds the value is not written again (no wear, no delay).
+ *
+ * The 55h/AAh unlock sequence runs with GIE cleared and GIE is then put back as the caller
+ * had it, so a write started with interrupts off never turns them on.
+ *
+ * eeprom_read() returns the newest value queued for an address, so a read right after a
+ * write sees the new data before it reaches the EEPROM. Other addresses are read from the
+ * EEPROM once the current byte write ends, since EEADR/EEDATA must not change during it.
+ * eeprom_flush() waits until every queued byte is written (before SLEEP or a reset) and also
+ * works with GIE cleared.
+ *
+ * The application must call eeprom_isr() from its __interrupt() routine.
+ */
+
+#ifndef EEPROM_H
+#define EEPROM_H
+
+#include <stdint.h>
+
+// Queued byte writes (power of two, at most 128)
+#ifndef EEPROM_QUEUE_SIZE
+#define EEPROM_QUEUE_SIZE 16
+#endif
+
+#if (EEPROM_QUEUE_SIZE & (EEPROM_QUEUE_SIZE - 1)) || EEPROM_QUEUE_SIZE > 128
+#error "EEPROM_QUEUE_SIZE must be a power of two no larger than 128"
+#endif
+
+// Write statistics (written by the driver only)
+typedef struct {
+    uint16_t writes;        // Bytes written to the EEPROM
+    uint16_t skipped;       // Bytes that already held the value
+    uint16_t errors;        // Bytes that did not read back as written
+} eeprom_stats_t;
+
+// Empty the queue and enable the EEIF interrupt
+void eeprom_init(void);
+
+// Queue 'len' bytes for address..address+len-1 (wraps at 256). Returns 1 on success, 0 if the
+// queue has less than 'len' free entries (nothing is queued then).
+uint8_t eeprom_write_block(uint8_t address, const uint8_t *data, uint8_t len);
+
+// Byte at 'address', including writes still in the queue. An address with nothing queued is
+// read from the EEPROM, after the byte write in progress if any (up to about 4 ms).
+uint8_t eeprom_read(uint8_t address);
+
+// 1 while a write is queued or in progress
+uint8_t eeprom_busy(void);
+
+// Wait until every queued byte is written
+void eeprom_flush(void);
+
+// Copy the write statistics
+void eeprom_get_stats(eeprom_stats_t *stats);
+
+// Service EEIF; call from the application's interrupt routine
+void eeprom_isr(void);
+
+#endif /* EEPROM_H */
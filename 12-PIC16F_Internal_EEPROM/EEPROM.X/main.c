@@ -13,11 +13,44 @@
 
 #define _XTAL_FREQ 4000000      // Assume 4MHz crystal frequency, adjust if different
 
-// Function prototypes
-void EEPROM_Write(unsigned char address, unsigned char data);
-unsigned char EEPROM_Read(unsigned char address);
+#include <stdint.h>
+#include <string.h>
+#include "eeprom.h"
+#include "store.h"
+#include "../../common/debounce.h"
+
+#define TMR2_RATE_HZ (1000 / DEBOUNCE_TICK_MS)
+#include "../../common/clockcalc.h"
+
+#define MEMO_BUTTON   2         // RA2, pressed = high
+#define COUNT_TICKS   (100 / DEBOUNCE_TICK_MS)   // PORTB increments every 100 ms
+
+// Record kept in the EEPROM ring (store.c)
+#define REC_VALUE     0         // Saved PORTB value
+#define REC_SAVES_LO  1         // Number of saves, 16 bits
+#define REC_SAVES_HI  2
+
+static volatile uint8_t count_due = 0;
+
+void __interrupt() ISR(void) {
+    static uint8_t ticks = 0;
+
+    eeprom_isr();
+    if (TMR2IF) {
+        TMR2IF = 0;
+        debounce_tick(PORTA);
+        if (++ticks == COUNT_TICKS) {
+            ticks = 0;
+            count_due = 1;
+        }
+    }
+}
 
 void main() {
+    uint8_t record[STORE_RECORD_SIZE];
+    uint16_t saves;
+    uint8_t event;
+
     ADCON1 = 0x06;  // Configure all pins as digital I/O
     
     TRISB = 0x00;   // Set all PORTB pins as outputs
@@ -27,41 +60,35 @@ void main() {
     PORTB = 0;      // Initialize PORTB
     PORTD = 0;      // Initialize PORTD
     
-    PORTD = EEPROM_Read(5);  // Read EEPROM memory at address 5
+    eeprom_init();
+    store_init(0);                      // Newest valid record, or zeros on a blank EEPROM
+    PORTD = store_get()[REC_VALUE];
+
+    // Button and counter tick: Timer2 every DEBOUNCE_TICK_MS
+    debounce_init(1 << MEMO_BUTTON, 0, 0);
+    T2CON = 0x00;
+    T2CONbits.T2CKPS = TMR2_CKPS_VALUE;
+    PR2 = TMR2_PR2_VALUE;
+    TMR2IF = 0;
+    TMR2IE = 1;
+    TMR2ON = 1;
     
     while(1) {
-        PORTB++;            // Increment PORTB
-        __delay_ms(100);    // 100ms delay
+        if (count_due) {
+            count_due = 0;
+            PORTB++;        // Increment PORTB every 100ms
+        }
         
-        if (PORTAbits.RA2) {  // If MEMO button (connected to RA2) is pressed
-            EEPROM_Write(5, PORTB);  // Save PORTB value to EEPROM
-            PORTD = EEPROM_Read(5);  // Read written data and display on PORTD
-            
-            while(PORTAbits.RA2);    // Wait for button release
-            __delay_ms(20);          // Simple debounce
+        // MEMO button (connected to RA2) pressed
+        if (debounce_get(&event) && event == DEBOUNCE_EVENT(DEBOUNCE_PRESS, MEMO_BUTTON)) {
+            memcpy(record, store_get(), STORE_RECORD_SIZE);
+            saves = record[REC_SAVES_LO] | ((uint16_t)record[REC_SAVES_HI] << 8);
+            saves++;
+            record[REC_VALUE] = PORTB;
+            record[REC_SAVES_LO] = (uint8_t)saves;
+            record[REC_SAVES_HI] = (uint8_t)(saves >> 8);
+            store_save(record);                 // Next slot of the ring, written in the background
+            PORTD = store_get()[REC_VALUE];     // RAM shadow, no EEPROM access
         }
     }
 }
-
-void EEPROM_Write(unsigned char address, unsigned char data) {
-    while(EECON1bits.WR);    // Wait for write to complete
-    EEADR = address;         // Set up address register
-    EEDATA = data;           // Set up data register
-    EECON1bits.EEPGD = 0;    // Point to Data memory
-    EECON1bits.WREN = 1;     // Enable writes
-    
-    INTCONbits.GIE = 0;      // Disable interrupts
-    EECON2 = 0x55;           // Write 55h
-    EECON2 = 0xAA;           // Write AAh
-    EECON1bits.WR = 1;       // Set WR bit to begin write
-    INTCONbits.GIE = 1;      // Enable interrupts
-    
-    EECON1bits.WREN = 0;     // Disable writes
-}
-
-unsigned char EEPROM_Read(unsigned char address) {
-    EEADR = address;         // Set up address register
-    EECON1bits.EEPGD = 0;    // Point to Data memory
-    EECON1bits.RD = 1;       // EEPROM Read
-    return EEDATA;           // Return data
-}
\ No newline at end of file
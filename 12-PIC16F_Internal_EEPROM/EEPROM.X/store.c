@@ -0,0 +1,106 @@
+/* File:   store.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Wear-levelled record store (see store.h).
+ * The newest slot is the valid one whose sequence number is ahead of every other valid one;
+ * with at most 64 slots the live sequence numbers span less than half of the 255 values, so
+ * "ahead" is a distance of 1..127 modulo 255.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "store.h"
+#include "../../common/crc.h"
+
+#define SEQ_COUNT 255       // 0xFF marks an erased slot
+#define SLOT_CRC_INIT 0xFF  // Non-zero, so an all-zero slot never checks
+
+static uint8_t shadow[STORE_RECORD_SIZE];
+static uint8_t current = STORE_SLOTS;   // Slot of the shadow, STORE_SLOTS = none
+static uint8_t sequence = SEQ_COUNT - 1;
+
+// 1 if sequence number a is newer than b
+static uint8_t seq_newer(uint8_t a, uint8_t b)
+{
+    uint8_t distance = a >= b ? a - b : (uint8_t)(a + SEQ_COUNT - b);
+    return distance != 0 && distance < 128;
+}
+
+static uint8_t slot_address(uint8_t slot)
+{
+    return (uint8_t)(STORE_BASE + slot * STORE_SLOT_SIZE);
+}
+
+uint8_t store_init(const uint8_t *defaults)
+{
+    uint8_t slot, i, address;
+    uint8_t buffer[STORE_SLOT_SIZE];
+
+    current = STORE_SLOTS;
+    sequence = SEQ_COUNT - 1;
+
+    for (slot = 0; slot < STORE_SLOTS; slot++) {
+        address = slot_address(slot);
+        for (i = 0; i < STORE_SLOT_SIZE; i++) {
+            buffer[i] = eeprom_read(address + i);
+        }
+        if (buffer[0] >= SEQ_COUNT || crc8(SLOT_CRC_INIT, buffer, STORE_SLOT_SIZE - 1) != buffer[STORE_SLOT_SIZE - 1]) {
+            continue;
+        }
+        if (current == STORE_SLOTS || seq_newer(buffer[0], sequence)) {
+            current = slot;
+            sequence = buffer[0];
+            memcpy(shadow, buffer + 1, STORE_RECORD_SIZE);
+        }
+    }
+
+    if (current == STORE_SLOTS) {
+        if (defaults) {
+            memcpy(shadow, defaults, STORE_RECORD_SIZE);
+        } else {
+            memset(shadow, 0, STORE_RECORD_SIZE);
+        }
+        return 0;
+    }
+    return 1;
+}
+
+const uint8_t *store_get(void)
+{
+    return shadow;
+}
+
+uint8_t store_save(const uint8_t *record)
+{
+    uint8_t buffer[STORE_SLOT_SIZE];
+    uint8_t slot = current + 1;
+    uint8_t next = sequence + 1;
+
+    if (current != STORE_SLOTS && memcmp(record, shadow, STORE_RECORD_SIZE) == 0) {
+        return 1;
+    }
+    if (slot >= STORE_SLOTS) {
+        slot = 0;
+    }
+    if (next >= SEQ_COUNT) {
+        next = 0;
+    }
+
+    buffer[0] = next;
+    memcpy(buffer + 1, record, STORE_RECORD_SIZE);
+    buffer[STORE_SLOT_SIZE - 1] = crc8(SLOT_CRC_INIT, buffer, STORE_SLOT_SIZE - 1);
+    if (!eeprom_write_block(slot_address(slot), buffer, STORE_SLOT_SIZE)) {
+        return 0;
+    }
+
+    current = slot;
+    sequence = next;
+    memcpy(shadow, record, STORE_RECORD_SIZE);
+    return 1;
+}
+
+uint8_t store_slot(void)
+{
+    return current;
+}
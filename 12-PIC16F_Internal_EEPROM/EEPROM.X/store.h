@@ -0,0 +1,69 @@
+/* File:   store.h
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Wear-levelled record store in the data EEPROM.
+ * The application keeps one record of STORE_RECORD_SIZE bytes (its settings and counters).
+ * Every save goes to the next slot of a ring of STORE_SLOTS slots, so each cell is written
+ * once every STORE_SLOTS saves and the EEPROM endurance is multiplied by STORE_SLOTS.
+ *
+ * Slot layout: sequence number, record bytes, CRC-8 of both. Sequence numbers count 0..254
+ * and wrap; 0xFF is never used, so an erased slot is never taken for a record. A slot whose
+ * CRC does not match (a save cut by a reset or power loss) is ignored and the previous
+ * record stays the newest. The CRC starts from 0xFF rather than 0, so a cleared (all-zero)
+ * slot does not check either.
+ *
+ * store_init() reads every slot once and keeps the newest valid record in a RAM shadow;
+ * store_get() returns the shadow, so reads never touch the EEPROM. store_save() updates the
+ * shadow and queues the slot on the interrupt-driven writer (eeprom.c), so it returns at once.
+ */
+
+#ifndef STORE_H
+#define STORE_H
+
+#include <stdint.h>
+#include "eeprom.h"
+
+// Record bytes kept by the application
+#ifndef STORE_RECORD_SIZE
+#define STORE_RECORD_SIZE 6
+#endif
+
+// Slots in the ring, from EEPROM address STORE_BASE
+#ifndef STORE_SLOTS
+#define STORE_SLOTS 32
+#endif
+
+#ifndef STORE_BASE
+#define STORE_BASE 0x00
+#endif
+
+#define STORE_SLOT_SIZE (STORE_RECORD_SIZE + 2)     // Sequence + record + CRC-8
+
+#if STORE_RECORD_SIZE < 1 || STORE_SLOT_SIZE > EEPROM_QUEUE_SIZE
+#error "STORE_RECORD_SIZE must be at least 1 and a slot must fit in EEPROM_QUEUE_SIZE"
+#endif
+
+#if STORE_SLOTS < 2 || STORE_SLOTS > 64
+#error "STORE_SLOTS must be between 2 and 64"
+#endif
+
+#if STORE_BASE + STORE_SLOTS * STORE_SLOT_SIZE > 256
+#error "The record ring does not fit in the 256-byte data EEPROM"
+#endif
+
+// Find the newest valid record. Returns 1 if one was found; otherwise the shadow is loaded
+// from 'defaults' (or zeros if 0) and 0 is returned. Call after eeprom_init().
+uint8_t store_init(const uint8_t *defaults);
+
+// The current record (RAM shadow, STORE_RECORD_SIZE bytes)
+const uint8_t *store_get(void);
+
+// Save a new record. Returns 1 once queued (or if it equals the current record, which is not
+// written again), 0 if the EEPROM queue has no room for a slot; retry later.
+uint8_t store_save(const uint8_t *record);
+
+// Slot holding the current record (STORE_SLOTS if none has been saved yet)
+uint8_t store_slot(void);
+
+#endif /* STORE_H */
@@ -0,0 +1,160 @@
+/* File:   clockcalc.h
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Compile-time calculators for the clock dividers of the PIC16F877A, driven by _XTAL_FREQ:
+ * USART baud rate (BRGH + SPBRG), MSSP I2C master clock (SSPADD), Timer2 period (prescaler
+ * + PR2) and Timer1 compare period (prescaler + CCPR1/CCPR2 with the special event trigger).
+ *
+ * The CLK_...() macros are plain integer arithmetic with ?: selections, so they work both in
+ * C expressions and in #if. A project defines the rates it needs before including this
+ * header and gets ready-to-use register values, with the build stopped by #error when a rate
+ * cannot be reached within tolerance:
+ *
+ *   #define _XTAL_FREQ     8000000
+ *   #define UART_BAUD_RATE 9600      // -> UART_BRGH_VALUE, UART_SPBRG_VALUE
+ *   #define TMR2_RATE_HZ   1000      // -> TMR2_CKPS_VALUE, TMR2_PR2_VALUE
+ *   #include "../../common/clockcalc.h"
+ *
+ * Rates are in Hz. The CLK_..._ERROR_PPM() macros need 64-bit arithmetic and are meant for
+ * #if (and host tests) only.
+ */
+
+#ifndef CLOCKCALC_H
+#define CLOCKCALC_H
+
+#ifndef _XTAL_FREQ
+#error "Define _XTAL_FREQ before including clockcalc.h"
+#endif
+
+// Largest accepted rate errors, in parts per million of the requested rate
+#ifndef CLK_UART_MAX_ERROR_PPM
+#define CLK_UART_MAX_ERROR_PPM  20000   // 2 %: both ends of a link must stay within ~4.5 % together
+#endif
+#ifndef CLK_I2C_MAX_ERROR_PPM
+#define CLK_I2C_MAX_ERROR_PPM   100000  // 10 % slower than requested (never faster)
+#endif
+#ifndef CLK_TIMER_MAX_ERROR_PPM
+#define CLK_TIMER_MAX_ERROR_PPM 1000    // 0.1 %
+#endif
+
+// |a - b| * 10^6 / b
+#define CLK_ERROR_PPM(actual_num, actual_den, target) \
+    (((actual_num) > (actual_den) * (target) ? \
+      (actual_num) - (actual_den) * (target) : (actual_den) * (target) - (actual_num)) * 1000000ULL / \
+     ((actual_den) * (target)))
+
+/* -------------------------------------------------------------------------------------
+ * USART: baud = Fosc / (16 * (SPBRG + 1)) with BRGH = 1, Fosc / (64 * (SPBRG + 1)) with
+ * BRGH = 0. BRGH = 1 has four times the resolution, so it is used whenever SPBRG fits.
+ * -------------------------------------------------------------------------------------*/
+#define CLK_UART_DIV(brgh) ((brgh) ? 16UL : 64UL)
+
+// SPBRG + 1, rounded to the nearest divisor
+#define CLK_UART_N(fosc, baud, brgh) \
+    (((fosc) + CLK_UART_DIV(brgh) * (baud) / 2) / (CLK_UART_DIV(brgh) * (baud)))
+
+#define CLK_UART_FITS(fosc, baud, brgh) \
+    (CLK_UART_N(fosc, baud, brgh) >= 1 && CLK_UART_N(fosc, baud, brgh) <= 256)
+
+#define CLK_UART_BRGH(fosc, baud)        (CLK_UART_FITS(fosc, baud, 1) ? 1 : 0)
+#define CLK_UART_SPBRG(fosc, baud, brgh) (CLK_UART_N(fosc, baud, brgh) - 1)
+
+#define CLK_UART_ERROR_PPM(fosc, baud, brgh) \
+    CLK_ERROR_PPM((fosc) * 1ULL, CLK_UART_DIV(brgh) * CLK_UART_N(fosc, baud, brgh), (baud))
+
+/* -------------------------------------------------------------------------------------
+ * MSSP I2C master: SCL = (Fosc / 4) / (SSPADD + 1). SSPADD is rounded up so the bus never
+ * runs faster than requested; the baud rate generator uses SSPADD<6:0> and values below 3
+ * are not supported.
+ * -------------------------------------------------------------------------------------*/
+#define CLK_I2C_SSPADD(fosc, scl) (((fosc) / 4 + (scl) - 1) / (scl) - 1)
+
+#define CLK_I2C_FITS(fosc, scl) \
+    (CLK_I2C_SSPADD(fosc, scl) >= 3 && CLK_I2C_SSPADD(fosc, scl) <= 127)
+
+#define CLK_I2C_ERROR_PPM(fosc, scl) \
+    CLK_ERROR_PPM((fosc) * 1ULL / 4, CLK_I2C_SSPADD(fosc, scl) + 1, (scl))
+
+/* -------------------------------------------------------------------------------------
+ * Timer2: TMR2IF rate = (Fosc / 4) / (prescale * (PR2 + 1)), postscaler 1:1. The smallest
+ * prescaler (1, 4, 16) whose PR2 fits is chosen, for the finest resolution.
+ * -------------------------------------------------------------------------------------*/
+#define CLK_TIMER_N(fosc, rate, prescale) \
+    (((fosc) + 2UL * (prescale) * (rate)) / (4UL * (prescale) * (rate)))
+
+#define CLK_TMR2_FITS(fosc, rate, prescale) \
+    (CLK_TIMER_N(fosc, rate, prescale) >= 1 && CLK_TIMER_N(fosc, rate, prescale) <= 256)
+
+#define CLK_TMR2_PRESCALE(fosc, rate) \
+    (CLK_TMR2_FITS(fosc, rate, 1) ? 1 : CLK_TMR2_FITS(fosc, rate, 4) ? 4 : 16)
+
+// T2CKPS<1:0> for the prescaler: 0 = 1:1, 1 = 1:4, 2 = 1:16
+#define CLK_TMR2_CKPS(prescale) ((prescale) == 1 ? 0 : (prescale) == 4 ? 1 : 2)
+
+#define CLK_TMR2_PR2(fosc, rate, prescale) (CLK_TIMER_N(fosc, rate, prescale) - 1)
+
+#define CLK_TIMER_ERROR_PPM(fosc, rate, prescale) \
+    CLK_ERROR_PPM((fosc) * 1ULL, 4ULL * (prescale) * CLK_TIMER_N(fosc, rate, prescale), (rate))
+
+/* -------------------------------------------------------------------------------------
+ * Timer1 + CCP compare with special event trigger: Timer1 is cleared on the match, so the
+ * compare rate is (Fosc / 4) / (prescale * (CCPR + 1)). Prescaler 1, 2, 4 or 8.
+ * -------------------------------------------------------------------------------------*/
+#define CLK_TMR1_FITS(fosc, rate, prescale) \
+    (CLK_TIMER_N(fosc, rate, prescale) >= 1 && CLK_TIMER_N(fosc, rate, prescale) <= 65536UL)
+
+#define CLK_TMR1_PRESCALE(fosc, rate) \
+    (CLK_TMR1_FITS(fosc, rate, 1) ? 1 : CLK_TMR1_FITS(fosc, rate, 2) ? 2 : \
+     CLK_TMR1_FITS(fosc, rate, 4) ? 4 : 8)
+
+// T1CKPS<1:0> for the prescaler: 0 = 1:1, 1 = 1:2, 2 = 1:4, 3 = 1:8
+#define CLK_TMR1_CKPS(prescale) ((prescale) == 1 ? 0 : (prescale) == 2 ? 1 : (prescale) == 4 ? 2 : 3)
+
+#define CLK_TMR1_CCPR(fosc, rate, prescale) (CLK_TIMER_N(fosc, rate, prescale) - 1)
+
+/* -------------------------------------------------------------------------------------
+ * Project values, checked at build time
+ * -------------------------------------------------------------------------------------*/
+#ifdef UART_BAUD_RATE
+#define UART_BRGH_VALUE  CLK_UART_BRGH(_XTAL_FREQ, UART_BAUD_RATE)
+#define UART_SPBRG_VALUE CLK_UART_SPBRG(_XTAL_FREQ, UART_BAUD_RATE, UART_BRGH_VALUE)
+#if !CLK_UART_FITS(_XTAL_FREQ, UART_BAUD_RATE, UART_BRGH_VALUE)
+#error "UART_BAUD_RATE is out of range for _XTAL_FREQ (SPBRG would not fit in 8 bits)"
+#elif CLK_UART_ERROR_PPM(_XTAL_FREQ, UART_BAUD_RATE, UART_BRGH_VALUE) > CLK_UART_MAX_ERROR_PPM
+#error "UART_BAUD_RATE cannot be reached from _XTAL_FREQ within CLK_UART_MAX_ERROR_PPM"
+#endif
+#endif
+
+#ifdef I2C_BAUD_RATE
+#define I2C_SSPADD_VALUE CLK_I2C_SSPADD(_XTAL_FREQ, I2C_BAUD_RATE)
+#if !CLK_I2C_FITS(_XTAL_FREQ, I2C_BAUD_RATE)
+#error "I2C_BAUD_RATE is out of range for _XTAL_FREQ (SSPADD must be 3..127)"
+#elif CLK_I2C_ERROR_PPM(_XTAL_FREQ, I2C_BAUD_RATE) > CLK_I2C_MAX_ERROR_PPM
+#error "I2C_BAUD_RATE cannot be reached from _XTAL_FREQ within CLK_I2C_MAX_ERROR_PPM"
+#endif
+#endif
+
+#ifdef TMR2_RATE_HZ
+#define TMR2_PRESCALE   CLK_TMR2_PRESCALE(_XTAL_FREQ, TMR2_RATE_HZ)
+#define TMR2_CKPS_VALUE CLK_TMR2_CKPS(TMR2_PRESCALE)
+#define TMR2_PR2_VALUE  CLK_TMR2_PR2(_XTAL_FREQ, TMR2_RATE_HZ, TMR2_PRESCALE)
+#if !CLK_TMR2_FITS(_XTAL_FREQ, TMR2_RATE_HZ, TMR2_PRESCALE)
+#error "TMR2_RATE_HZ is out of range for _XTAL_FREQ (PR2 would not fit with a 1:16 prescaler)"
+#elif CLK_TIMER_ERROR_PPM(_XTAL_FREQ, TMR2_RATE_HZ, TMR2_PRESCALE) > CLK_TIMER_MAX_ERROR_PPM
+#error "TMR2_RATE_HZ cannot be reached from _XTAL_FREQ within CLK_TIMER_MAX_ERROR_PPM"
+#endif
+#endif
+
+#ifdef TMR1_RATE_HZ
+#define TMR1_PRESCALE   CLK_TMR1_PRESCALE(_XTAL_FREQ, TMR1_RATE_HZ)
+#define TMR1_CKPS_VALUE CLK_TMR1_CKPS(TMR1_PRESCALE)
+#define TMR1_CCPR_VALUE CLK_TMR1_CCPR(_XTAL_FREQ, TMR1_RATE_HZ, TMR1_PRESCALE)
+#if !CLK_TMR1_FITS(_XTAL_FREQ, TMR1_RATE_HZ, TMR1_PRESCALE)
+#error "TMR1_RATE_HZ is out of range for _XTAL_FREQ (CCPR would not fit with a 1:8 prescaler)"
+#elif CLK_TIMER_ERROR_PPM(_XTAL_FREQ, TMR1_RATE_HZ, TMR1_PRESCALE) > CLK_TIMER_MAX_ERROR_PPM
+#error "TMR1_RATE_HZ cannot be reached from _XTAL_FREQ within CLK_TIMER_MAX_ERROR_PPM"
+#endif
+#endif
+
+#endif /* CLOCKCALC_H */
@@ -0,0 +1,43 @@
+/* File:   crc.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * CRC routines (see crc.h).
+ */
+
+#include <stdint.h>
+#include "crc.h"
+
+uint8_t crc8(uint8_t crc, const uint8_t *data, uint8_t len)
+{
+    uint8_t bit;
+
+    while (len--) {
+        crc ^= *data++;
+        for (bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+// (i << 12) reduced by the CRC-16 polynomial, for each nibble i
+static const uint16_t crc16_nibbles[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+uint16_t crc16_update(uint16_t crc, uint8_t data)
+{
+    crc = (uint16_t)((crc << 4) ^ crc16_nibbles[(uint8_t)(crc >> 12) ^ (data >> 4)]);
+    crc = (uint16_t)((crc << 4) ^ crc16_nibbles[(uint8_t)(crc >> 12) ^ (data & 0x0F)]);
+    return crc;
+}
+
+uint16_t crc16(uint16_t crc, const uint8_t *data, uint8_t len)
+{
+    while (len--) {
+        crc = crc16_update(crc, *data++);
+    }
+    return crc;
+}
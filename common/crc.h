@@ -0,0 +1,36 @@
+/* File:   crc.h
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * CRC routines for data integrity checks on stored and transmitted records.
+ *
+ * CRC-8: polynomial x^8 + x^2 + x + 1 (0x07), initial value 0, no reflection, no final xor
+ * (CRC-8/SMBUS; check value 0xF4 for "123456789"). Bitwise: a byte costs 8 shift/xor steps,
+ * which is small next to an EEPROM or UART byte time and keeps the flash cost to a few words.
+ *
+ * CRC-16: polynomial x^16 + x^12 + x^5 + 1 (0x1021), initial value 0xFFFF, no reflection, no
+ * final xor (CRC-16/CCITT-FALSE; check value 0x29B1 for "123456789"). Table-driven four bits
+ * at a time: two lookups in a 16-entry table per byte instead of 16 shift/xor steps on 16-bit
+ * values, for 32 bytes of program memory (a 256-entry table would take 512 words).
+ *
+ * Chain calls by passing the previous result as 'crc'.
+ */
+
+#ifndef CRC_H
+#define CRC_H
+
+#include <stdint.h>
+
+#define CRC8_INIT  0x00
+#define CRC16_INIT 0xFFFF
+
+// CRC-8 of 'len' bytes, continuing from 'crc' (CRC8_INIT for a new message)
+uint8_t crc8(uint8_t crc, const uint8_t *data, uint8_t len);
+
+// CRC-16 of one byte, for data produced a byte at a time
+uint16_t crc16_update(uint16_t crc, uint8_t data);
+
+// CRC-16 of 'len' bytes, continuing from 'crc' (CRC16_INIT for a new message)
+uint16_t crc16(uint16_t crc, const uint8_t *data, uint8_t len);
+
+#endif /* CRC_H */
@@ -0,0 +1,112 @@
+/* File:   debounce.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Vertical-counter debouncer (see debounce.h).
+ * (ct1, ct0) is a 2-bit down counter per button that restarts at 3 while the sample equals
+ * the debounced state and counts down while it differs; the state toggles when it wraps.
+ * The event queue uses free-running 8-bit indices: the tick writes 'head', the main loop
+ * 'tail'.
+ */
+
+#include <stdint.h>
+#include "debounce.h"
+
+#define DEBOUNCE_QUEUE_MASK (DEBOUNCE_QUEUE_SIZE - 1)
+
+static uint8_t port_mask;
+static uint8_t invert;
+static uint8_t repeat_mask;
+
+static uint8_t ct0, ct1;
+static volatile uint8_t state;
+static uint8_t held[8];                 // Ticks since the press (long press: stops at LONG + 1)
+
+static uint8_t queue[DEBOUNCE_QUEUE_SIZE];
+static volatile uint8_t head = 0;
+static volatile uint8_t tail = 0;
+static volatile uint8_t dropped = 0;
+
+static void post(uint8_t event)
+{
+    if ((uint8_t)(head - tail) >= DEBOUNCE_QUEUE_SIZE) {
+        if (dropped != 0xFF) {
+            dropped++;
+        }
+        return;
+    }
+    queue[head & DEBOUNCE_QUEUE_MASK] = event;
+    head++;
+}
+
+void debounce_init(uint8_t mask, uint8_t active_low, uint8_t repeat)
+{
+    uint8_t i;
+
+    port_mask = mask;
+    invert = active_low;
+    repeat_mask = repeat;
+    ct0 = ct1 = 0xFF;
+    state = 0;
+    for (i = 0; i < 8; i++) {
+        held[i] = 0;
+    }
+    head = tail = 0;
+    dropped = 0;
+}
+
+void debounce_tick(uint8_t sample)
+{
+    uint8_t changed, bit, i;
+
+    // 1 = pressed, for the filtered bits only
+    sample = (uint8_t)((sample ^ invert) & port_mask);
+
+    changed = sample ^ state;
+    ct0 = (uint8_t)~(ct0 & changed);
+    ct1 = ct0 ^ (ct1 & changed);
+    changed &= ct0 & ct1;
+    state ^= changed;
+
+    if ((changed | state) == 0) {
+        return;
+    }
+
+    for (i = 0, bit = 1; i < 8; i++, bit <<= 1) {
+        if (changed & bit) {
+            held[i] = 0;
+            post(DEBOUNCE_EVENT((state & bit) ? DEBOUNCE_PRESS : DEBOUNCE_RELEASE, i));
+        } else if (state & bit) {
+            if (repeat_mask & bit) {
+                if (++held[i] == DEBOUNCE_REPEAT_DELAY_TICKS) {
+                    held[i] = DEBOUNCE_REPEAT_DELAY_TICKS - DEBOUNCE_REPEAT_TICKS;
+                    post(DEBOUNCE_EVENT(DEBOUNCE_REPEAT, i));
+                }
+            } else if (held[i] <= DEBOUNCE_LONG_TICKS) {
+                if (++held[i] == DEBOUNCE_LONG_TICKS) {
+                    post(DEBOUNCE_EVENT(DEBOUNCE_LONG, i));
+                }
+            }
+        }
+    }
+}
+
+uint8_t debounce_get(uint8_t *event)
+{
+    if (tail == head) {
+        return 0;
+    }
+    *event = queue[tail & DEBOUNCE_QUEUE_MASK];
+    tail++;
+    return 1;
+}
+
+uint8_t debounce_state(void)
+{
+    return state;
+}
+
+uint8_t debounce_dropped(void)
+{
+    return dropped;
+}
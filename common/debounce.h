@@ -0,0 +1,91 @@
+/* File:   debounce.h
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Timer-tick debouncer for up to 8 buttons on one port, with a press/release/long-press/
+ * auto-repeat event queue for the main loop.
+ *
+ * The application calls debounce_tick() with the raw port value every DEBOUNCE_TICK_MS from
+ * its timer interrupt. All 8 inputs are filtered at once with 2-bit vertical counters (one
+ * counter bit per byte, one button per bit): an input must read the same for 4 consecutive
+ * ticks before its debounced state changes, so bounces shorter than 3 ticks are ignored.
+ * A tick with no button held costs a few instructions.
+ *
+ * Events are bytes queued for debounce_get(): DEBOUNCE_PRESS and DEBOUNCE_RELEASE for every
+ * change, then while a button is held either one DEBOUNCE_LONG after DEBOUNCE_LONG_MS or, for
+ * buttons in the repeat mask, DEBOUNCE_REPEAT after DEBOUNCE_REPEAT_DELAY_MS and every
+ * DEBOUNCE_REPEAT_MS after that. Events that find the queue full are dropped and counted.
+ */
+
+#ifndef DEBOUNCE_H
+#define DEBOUNCE_H
+
+#include <stdint.h>
+
+// Period of debounce_tick() calls
+#ifndef DEBOUNCE_TICK_MS
+#define DEBOUNCE_TICK_MS 4
+#endif
+
+#ifndef DEBOUNCE_LONG_MS
+#define DEBOUNCE_LONG_MS 1000
+#endif
+
+#ifndef DEBOUNCE_REPEAT_DELAY_MS
+#define DEBOUNCE_REPEAT_DELAY_MS 500
+#endif
+
+#ifndef DEBOUNCE_REPEAT_MS
+#define DEBOUNCE_REPEAT_MS 100
+#endif
+
+// Queued events (power of two, at most 128)
+#ifndef DEBOUNCE_QUEUE_SIZE
+#define DEBOUNCE_QUEUE_SIZE 8
+#endif
+
+#define DEBOUNCE_LONG_TICKS         (DEBOUNCE_LONG_MS / DEBOUNCE_TICK_MS)
+#define DEBOUNCE_REPEAT_DELAY_TICKS (DEBOUNCE_REPEAT_DELAY_MS / DEBOUNCE_TICK_MS)
+#define DEBOUNCE_REPEAT_TICKS       (DEBOUNCE_REPEAT_MS / DEBOUNCE_TICK_MS)
+
+#if DEBOUNCE_LONG_TICKS < 1 || DEBOUNCE_LONG_TICKS > 254 || DEBOUNCE_REPEAT_DELAY_TICKS > 254
+#error "DEBOUNCE_LONG_MS and DEBOUNCE_REPEAT_DELAY_MS must be 1..254 ticks"
+#endif
+
+#if DEBOUNCE_REPEAT_TICKS < 1 || DEBOUNCE_REPEAT_TICKS > DEBOUNCE_REPEAT_DELAY_TICKS
+#error "DEBOUNCE_REPEAT_MS must be at least one tick and no longer than the repeat delay"
+#endif
+
+#if (DEBOUNCE_QUEUE_SIZE & (DEBOUNCE_QUEUE_SIZE - 1)) || DEBOUNCE_QUEUE_SIZE > 128
+#error "DEBOUNCE_QUEUE_SIZE must be a power of two no larger than 128"
+#endif
+
+// Event types
+#define DEBOUNCE_PRESS   0
+#define DEBOUNCE_RELEASE 1
+#define DEBOUNCE_LONG    2      // Held for DEBOUNCE_LONG_MS (buttons without repeat)
+#define DEBOUNCE_REPEAT  3      // Auto-repeat while held (buttons in the repeat mask)
+
+// Event byte: type in bits 4..3, port bit number in bits 2..0
+#define DEBOUNCE_EVENT(type, bit) ((uint8_t)(((type) << 3) | (bit)))
+#define DEBOUNCE_TYPE(event)      ((uint8_t)((event) >> 3))
+#define DEBOUNCE_BIT(event)       ((uint8_t)((event) & 0x07))
+
+// Filter the port bits in 'mask'. Bits in 'active_low' read 0 when pressed (pull-up
+// buttons), the others read 1. Buttons in 'repeat' auto-repeat instead of reporting a long
+// press. Every button starts released and the queue empty.
+void debounce_init(uint8_t mask, uint8_t active_low, uint8_t repeat);
+
+// Feed one raw port sample; call every DEBOUNCE_TICK_MS from the timer interrupt
+void debounce_tick(uint8_t sample);
+
+// Take the oldest event. Returns 1 with it in *event, 0 if the queue is empty.
+uint8_t debounce_get(uint8_t *event);
+
+// Debounced state, one bit per button (1 = pressed)
+uint8_t debounce_state(void);
+
+// Events dropped because the queue was full
+uint8_t debounce_dropped(void);
+
+#endif /* DEBOUNCE_H */
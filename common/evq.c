@@ -0,0 +1,118 @@
+/* File:   evq.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Deferred interrupt work queue (see evq.h).
+ * Free-running 8-bit indices: the ISR writes 'head' after filling the slot, the main loop
+ * writes 'tail' after reading it, so a slot is never shared. Each counter has one writer.
+ */
+
+#include <xc.h>
+#include <stdint.h>
+#include "evq.h"
+#include "tmr1.h"
+
+#define EVQ_MASK (EVQ_SIZE - 1)
+
+static evq_event_t queue[EVQ_SIZE];
+static volatile uint8_t head = 0;
+static volatile uint8_t tail = 0;
+
+static const evq_handler_t *table;
+static uint8_t handler_count = 0;
+
+// Written by the ISR
+static volatile uint16_t posted = 0;
+static volatile uint8_t high_water = 0;
+static volatile uint8_t overflows[EVQ_MAX_SOURCES];
+
+// Written by the main loop
+static uint16_t dispatched = 0;
+static uint16_t max_latency = 0;
+
+void evq_init(const evq_handler_t *handlers, uint8_t count)
+{
+    uint8_t i;
+
+    if (count > EVQ_MAX_SOURCES) {
+        count = EVQ_MAX_SOURCES;
+    }
+    table = handlers;
+    handler_count = count;
+    head = tail = 0;
+    posted = 0;
+    dispatched = 0;
+    high_water = 0;
+    max_latency = 0;
+    for (i = 0; i < EVQ_MAX_SOURCES; i++) {
+        overflows[i] = 0;
+    }
+}
+
+uint8_t evq_post(uint8_t source, uint8_t payload)
+{
+    evq_event_t *event;
+    uint8_t depth = head - tail;
+
+    if (depth >= EVQ_SIZE) {
+        if (source < EVQ_MAX_SOURCES && overflows[source] != 0xFF) {
+            overflows[source]++;
+        }
+        return 0;
+    }
+    event = &queue[head & EVQ_MASK];
+    event->source = source;
+    event->payload = payload;
+    event->timestamp = tmr1_read();
+    head++;
+
+    posted++;
+    if (++depth > high_water) {
+        high_water = depth;
+    }
+    return 1;
+}
+
+uint8_t evq_dispatch(void)
+{
+    evq_event_t *event;
+    uint16_t latency;
+    uint8_t count = 0;
+
+    while (tail != head) {
+        event = &queue[tail & EVQ_MASK];
+        latency = tmr1_read() - event->timestamp;
+        if (latency > max_latency) {
+            max_latency = latency;
+        }
+        if (event->source < handler_count && table[event->source]) {
+            table[event->source](event);
+        }
+        tail++;                 // Slot free only once the handler is done with it
+        dispatched++;
+        count++;
+    }
+    return count;
+}
+
+uint8_t evq_pending(void)
+{
+    return head - tail;
+}
+
+void evq_get_stats(evq_stats_t *out)
+{
+    uint8_t i, gie = GIE;
+
+    GIE = 0;
+    out->posted = posted;
+    out->high_water = high_water;
+    for (i = 0; i < EVQ_MAX_SOURCES; i++) {
+        out->overflows[i] = overflows[i];
+    }
+    if (gie) {
+        GIE = 1;
+    }
+    out->dispatched = dispatched;
+    out->max_latency = max_latency;
+}
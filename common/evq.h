@@ -0,0 +1,76 @@
+/* File:   evq.h
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Deferred interrupt work: interrupt routines post a small event record (source, timestamp,
+ * payload) in a few instructions and return; the main loop runs the handler registered for
+ * each source from evq_dispatch(). Slow work (delays, UART messages, EEPROM writes) then
+ * never runs with interrupts held off.
+ *
+ * The queue has one producer and one consumer: evq_post() is called from the interrupt
+ * routine only (all PIC16 interrupts share it, so they never preempt each other) and
+ * evq_dispatch() from the main loop only. Neither side disables interrupts.
+ *
+ * Timestamps are read from Timer1, which the application keeps running free (any
+ * prescaler); the dispatcher records the longest time from post to handler in those ticks.
+ * An event posted to a full queue is dropped and counted against its source; the deepest
+ * the queue has been (high-water mark) shows whether EVQ_SIZE is large enough.
+ */
+
+#ifndef EVQ_H
+#define EVQ_H
+
+#include <stdint.h>
+
+// Queued events (power of two, at most 128)
+#ifndef EVQ_SIZE
+#define EVQ_SIZE 8
+#endif
+
+// Largest handler table accepted by evq_init(); sources are 0..EVQ_MAX_SOURCES-1
+#ifndef EVQ_MAX_SOURCES
+#define EVQ_MAX_SOURCES 8
+#endif
+
+#if (EVQ_SIZE & (EVQ_SIZE - 1)) || EVQ_SIZE > 128
+#error "EVQ_SIZE must be a power of two no larger than 128"
+#endif
+
+#if EVQ_MAX_SOURCES < 1 || EVQ_MAX_SOURCES > 32
+#error "EVQ_MAX_SOURCES must be between 1 and 32"
+#endif
+
+typedef struct {
+    uint8_t source;
+    uint8_t payload;
+    uint16_t timestamp;         // Timer1 when posted
+} evq_event_t;
+
+typedef void (*evq_handler_t)(const evq_event_t *event);
+
+// Queue statistics
+typedef struct {
+    uint16_t posted;
+    uint16_t dispatched;
+    uint8_t high_water;         // Most events waiting at once
+    uint16_t max_latency;       // Longest post-to-handler time, Timer1 ticks
+    uint8_t overflows[EVQ_MAX_SOURCES];     // Dropped events per source (saturates at 255)
+} evq_stats_t;
+
+// Install the handler table (handlers[source], 0 entries are allowed) and empty the queue
+void evq_init(const evq_handler_t *handlers, uint8_t count);
+
+// Queue an event; interrupt routine only. Returns 0 if the queue was full (event dropped).
+uint8_t evq_post(uint8_t source, uint8_t payload);
+
+// Run the handlers of every queued event, oldest first; main loop only. Returns the number
+// of events handled.
+uint8_t evq_dispatch(void);
+
+// Events waiting
+uint8_t evq_pending(void);
+
+// Copy the statistics (the counters written by the ISR are read with GIE cleared)
+void evq_get_stats(evq_stats_t *stats);
+
+#endif /* EVQ_H */
@@ -0,0 +1,92 @@
+/* File:   frame.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * COBS telemetry frame writer (see frame.h).
+ */
+
+#include <stdint.h>
+#include "frame.h"
+#include "crc.h"
+
+// Store one encoded byte at the write position
+static void frame_store(frame_t *f, uint8_t data)
+{
+    if (f->room == 0) {
+        f->overflow = 1;
+        return;
+    }
+    f->room--;
+    f->ring[f->pos & f->mask] = data;
+    f->pos++;
+}
+
+// Patch the open block's code byte and reserve the next one
+static void frame_close_block(frame_t *f)
+{
+    if (!f->overflow) {
+        f->ring[f->code & f->mask] = f->run;
+    }
+    f->code = f->pos;
+    f->run = 1;
+    frame_store(f, 0);
+}
+
+// CRC and stuff one byte
+static void frame_encode(frame_t *f, uint8_t data)
+{
+    if (data == 0) {
+        frame_close_block(f);   // The zero is implied by the code byte
+        return;
+    }
+    frame_store(f, data);
+    f->run++;
+    if (f->run == FRAME_MAX_BLOCK) {
+        frame_close_block(f);
+    }
+}
+
+void frame_begin(frame_t *f, volatile uint8_t *ring, uint8_t mask, uint8_t head, uint8_t room,
+                 uint8_t type, uint8_t seq)
+{
+    f->ring = ring;
+    f->mask = mask;
+    f->start = head;
+    f->pos = head;
+    f->code = head;
+    f->run = 1;
+    f->room = room;
+    f->overflow = 0;
+    f->crc = CRC16_INIT;
+    frame_store(f, 0);          // First code byte
+    frame_put(f, type);
+    frame_put(f, seq);
+}
+
+void frame_put(frame_t *f, uint8_t data)
+{
+    f->crc = crc16_update(f->crc, data);
+    frame_encode(f, data);
+}
+
+void frame_put16(frame_t *f, uint16_t data)
+{
+    frame_put(f, (uint8_t)data);
+    frame_put(f, (uint8_t)(data >> 8));
+}
+
+uint8_t frame_end(frame_t *f)
+{
+    uint16_t crc = f->crc;
+
+    frame_encode(f, (uint8_t)(crc >> 8));
+    frame_encode(f, (uint8_t)crc);
+    if (!f->overflow) {
+        f->ring[f->code & f->mask] = f->run;
+    }
+    frame_store(f, FRAME_DELIMITER);
+    if (f->overflow) {
+        return 0;
+    }
+    return (uint8_t)(f->pos - f->start);
+}
@@ -0,0 +1,56 @@
+/* File:   frame.h
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Binary telemetry frames, written incrementally into a transmit ring buffer. A frame is
+ *
+ *     COBS( type | seq | payload... | crc_hi | crc_lo ) 0x00
+ *
+ * where type identifies the record, seq counts frames modulo 256 so the receiver can see
+ * lost ones, and crc is the CRC-16 (crc.h) of type, seq and payload. Consistent Overhead
+ * Byte Stuffing removes every zero from the frame for one extra byte per 254, so the 0x00
+ * delimiter always marks a frame boundary and a receiver that starts in the middle of a
+ * stream, or loses bytes, resynchronises on the next one.
+ *
+ * Each byte is CRC'd and stuffed as it is put: the COBS code byte of the open block is
+ * reserved in the ring and patched once the block closes, so no staging copy of the frame
+ * is ever made. The writer only fills slots past the ring head; the caller publishes the
+ * whole frame at once by advancing its head by the count returned from frame_end(), so an
+ * interrupt-driven consumer never sends half a frame. A frame that does not fit in the
+ * free space given to frame_begin() is abandoned without touching queued data.
+ */
+
+#ifndef FRAME_H
+#define FRAME_H
+
+#include <stdint.h>
+
+#define FRAME_DELIMITER 0x00
+#define FRAME_OVERHEAD  6       // Ring slots a frame uses besides a payload of up to 249 bytes
+#define FRAME_MAX_BLOCK 0xFF    // Largest COBS code: 254 data bytes, no implied zero
+
+typedef struct {
+    volatile uint8_t *ring;     // Ring buffer storage
+    uint8_t mask;               // Ring size - 1 (power of two, at most 128)
+    uint8_t start;              // Ring index of the first frame byte (the caller's head)
+    uint8_t pos;                // Next ring index to write
+    uint8_t code;               // Ring index of the open block's code byte
+    uint8_t run;                // Code value of the open block (1 + its data bytes)
+    uint8_t room;               // Free slots left
+    uint8_t overflow;           // Frame did not fit, nothing will be published
+    uint16_t crc;
+} frame_t;
+
+// Start a frame at ring index 'head' with 'room' free slots after it
+void frame_begin(frame_t *f, volatile uint8_t *ring, uint8_t mask, uint8_t head, uint8_t room,
+                 uint8_t type, uint8_t seq);
+
+// Append payload bytes
+void frame_put(frame_t *f, uint8_t data);
+void frame_put16(frame_t *f, uint16_t data);        // Little-endian
+
+// Append the CRC and the delimiter. Returns the number of ring slots the frame used (the
+// amount to advance the head by), or 0 if it did not fit.
+uint8_t frame_end(frame_t *f);
+
+#endif /* FRAME_H */
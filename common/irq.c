@@ -0,0 +1,89 @@
+/* File:   irq.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Central interrupt dispatcher (see irq.h).
+ * Handlers and statistics are written with GIE cleared outside the interrupt routine.
+ */
+
+#include <xc.h>
+#include <stdint.h>
+#include "irq.h"
+#include "tmr1.h"
+
+static irq_handler_t handlers[IRQ_COUNT];
+static irq_stats_t stats[IRQ_COUNT];
+static uint16_t entry;                  // Timer1 at interrupt entry
+
+void irq_init(void)
+{
+    uint8_t i, gie = GIE;
+
+    GIE = 0;
+    for (i = 0; i < IRQ_COUNT; i++) {
+        handlers[i] = 0;
+        stats[i].count = 0;
+        stats[i].max_wait = 0;
+        stats[i].max_run = 0;
+    }
+    if (gie) {
+        GIE = 1;
+    }
+}
+
+void irq_register(uint8_t source, irq_handler_t handler)
+{
+    uint8_t gie = GIE;
+
+    if (source >= IRQ_COUNT) {
+        return;
+    }
+    GIE = 0;
+    handlers[source] = handler;
+    if (gie) {
+        GIE = 1;
+    }
+}
+
+void irq_get_stats(uint8_t source, irq_stats_t *out)
+{
+    uint8_t gie = GIE;
+
+    if (source >= IRQ_COUNT) {
+        return;
+    }
+    GIE = 0;
+    *out = stats[source];
+    if (gie) {
+        GIE = 1;
+    }
+}
+
+void irq_entry(void)
+{
+    entry = tmr1_read();
+}
+
+uint8_t irq_service(uint8_t source)
+{
+    irq_stats_t *s = &stats[source];
+    uint16_t start, time;
+
+    if (!handlers[source]) {
+        return 0;
+    }
+    start = tmr1_read();
+    handlers[source]();
+    time = tmr1_read() - start;
+    if (time > s->max_run) {
+        s->max_run = time;
+    }
+    time = start - entry;
+    if (time > s->max_wait) {
+        s->max_wait = time;
+    }
+    if (s->count != 0xFFFF) {
+        s->count++;
+    }
+    return 1;
+}
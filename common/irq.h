@@ -0,0 +1,110 @@
+/* File:   irq.h
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Central interrupt dispatcher for the PIC16F877A.
+ * Drivers and the application register one handler per interrupt source; the project's
+ * __interrupt() routine is a single IRQ_DISPATCH(), which tests every source in IRQ_ORDER
+ * and calls the handler of each one whose enable bit and flag are both set. A handler
+ * clears its own flag (some flags clear only by reading or writing a data register).
+ *
+ * The order is fixed at compile time: a project defines IRQ_ORDER before including this
+ * header to list the sources it uses, most urgent first. Sources left out cost nothing.
+ * A source that interrupts with no handler registered has its enable bit cleared, so a
+ * forgotten flag cannot lock the CPU in the interrupt routine.
+ *
+ * Per source the dispatcher counts the calls and measures, with Timer1, the longest wait
+ * from interrupt entry to the handler (time spent on the sources served before it) and the
+ * longest handler run. Timer1 must run free (no CCP special event reset); its prescaler sets
+ * the unit. The hardware entry latency (3 to 4 cycles) is not included.
+ */
+
+#ifndef IRQ_H
+#define IRQ_H
+
+#include <xc.h>
+#include <stdint.h>
+
+// Interrupt sources
+#define IRQ_INT   0     // RB0/INT external interrupt
+#define IRQ_RB    1     // RB4..RB7 change
+#define IRQ_TMR0  2
+#define IRQ_TMR1  3
+#define IRQ_TMR2  4
+#define IRQ_CCP1  5
+#define IRQ_CCP2  6
+#define IRQ_SSP   7     // MSSP (SPI / I2C)
+#define IRQ_BCL   8     // I2C bus collision
+#define IRQ_AD    9
+#define IRQ_RC    10    // USART receive
+#define IRQ_TX    11    // USART transmit
+#define IRQ_EE    12    // Data EEPROM write complete
+#define IRQ_COUNT 13
+
+// Enable bit and flag of every source
+#define IRQ_IE_INT  INTE
+#define IRQ_IF_INT  INTF
+#define IRQ_IE_RB   RBIE
+#define IRQ_IF_RB   RBIF
+#define IRQ_IE_TMR0 TMR0IE
+#define IRQ_IF_TMR0 TMR0IF
+#define IRQ_IE_TMR1 TMR1IE
+#define IRQ_IF_TMR1 TMR1IF
+#define IRQ_IE_TMR2 TMR2IE
+#define IRQ_IF_TMR2 TMR2IF
+#define IRQ_IE_CCP1 CCP1IE
+#define IRQ_IF_CCP1 CCP1IF
+#define IRQ_IE_CCP2 CCP2IE
+#define IRQ_IF_CCP2 CCP2IF
+#define IRQ_IE_SSP  SSPIE
+#define IRQ_IF_SSP  SSPIF
+#define IRQ_IE_BCL  BCLIE
+#define IRQ_IF_BCL  BCLIF
+#define IRQ_IE_AD   ADIE
+#define IRQ_IF_AD   ADIF
+#define IRQ_IE_RC   RCIE
+#define IRQ_IF_RC   RCIF
+#define IRQ_IE_TX   TXIE
+#define IRQ_IF_TX   TXIF
+#define IRQ_IE_EE   EEIE
+#define IRQ_IF_EE   EEIF
+
+// Service order, most urgent first; X(name) per source used
+#ifndef IRQ_ORDER
+#define IRQ_ORDER(X) X(INT) X(CCP1) X(CCP2) X(TMR1) X(TMR2) X(TMR0) X(SSP) X(BCL) X(RC) X(TX) \
+                     X(AD) X(RB) X(EE)
+#endif
+
+typedef void (*irq_handler_t)(void);
+
+// Per-source statistics, Timer1 ticks
+typedef struct {
+    uint16_t count;             // Handler calls (saturates at 65535)
+    uint16_t max_wait;          // Longest interrupt entry to handler start
+    uint16_t max_run;           // Longest handler run
+} irq_stats_t;
+
+// Remove every handler and clear the statistics
+void irq_init(void);
+
+// Install the handler of a source (0 removes it). The source's enable bit is not changed.
+void irq_register(uint8_t source, irq_handler_t handler);
+
+// Copy the statistics of a source (read with GIE cleared)
+void irq_get_stats(uint8_t source, irq_stats_t *stats);
+
+// Called by IRQ_DISPATCH()
+void irq_entry(void);
+uint8_t irq_service(uint8_t source);
+
+#define IRQ_SERVICE(name) \
+    if (IRQ_IE_##name && IRQ_IF_##name) { \
+        if (!irq_service(IRQ_##name)) { \
+            IRQ_IE_##name = 0; \
+        } \
+    }
+
+// The whole body of the project's __interrupt() routine
+#define IRQ_DISPATCH() do { irq_entry(); IRQ_ORDER(IRQ_SERVICE) } while (0)
+
+#endif /* IRQ_H */
@@ -0,0 +1,111 @@
+/* File:   numfmt.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Integer-only number formatting (see numfmt.h).
+ * Each decimal digit is found by subtracting its power of ten until the value drops below
+ * it: at most 9 subtractions per digit, no division and no library calls.
+ */
+
+#include <stdint.h>
+#include "numfmt.h"
+
+static const uint16_t pow10_u16[] = { 10000, 1000, 100, 10 };
+
+static const uint32_t pow10_u32[] = {
+    1000000000UL, 100000000UL, 10000000UL, 1000000UL, 100000UL,
+    10000UL, 1000UL, 100UL, 10UL
+};
+
+static const char hex_digits[] = "0123456789ABCDEF";
+
+// Decimal digits of value, at least min_digits of them (zero-padded)
+static uint8_t u16_digits(char *buf, uint16_t value, uint8_t min_digits)
+{
+    uint8_t i, n = 0;
+    char digit;
+
+    for (i = 0; i < 4; i++) {
+        uint16_t p = pow10_u16[i];
+        digit = '0';
+        while (value >= p) {
+            value -= p;
+            digit++;
+        }
+        // Leading zeros are kept only inside the requested width
+        if (n > 0 || digit != '0' || min_digits >= (uint8_t)(5 - i)) {
+            buf[n++] = digit;
+        }
+    }
+    buf[n++] = (char)('0' + value);
+    buf[n] = '\0';
+    return n;
+}
+
+uint8_t numfmt_u16(char *buf, uint16_t value)
+{
+    return u16_digits(buf, value, 1);
+}
+
+uint8_t numfmt_u32(char *buf, uint32_t value)
+{
+    uint8_t i, n = 0;
+    char digit;
+
+    // Values that fit in 16 bits take the cheaper path
+    if ((value >> 16) == 0) {
+        return u16_digits(buf, (uint16_t)value, 1);
+    }
+    for (i = 0; i < 9; i++) {
+        uint32_t p = pow10_u32[i];
+        digit = '0';
+        while (value >= p) {
+            value -= p;
+            digit++;
+        }
+        if (n > 0 || digit != '0') {
+            buf[n++] = digit;
+        }
+    }
+    buf[n++] = (char)('0' + (uint8_t)value);
+    buf[n] = '\0';
+    return n;
+}
+
+uint8_t numfmt_hex(char *buf, uint16_t value, uint8_t digits)
+{
+    uint8_t i;
+
+    if (digits < 1) {
+        digits = 1;
+    } else if (digits > 4) {
+        digits = 4;
+    }
+    for (i = digits; i > 0; i--) {
+        buf[i - 1] = hex_digits[value & 0x0F];
+        value >>= 4;
+    }
+    buf[digits] = '\0';
+    return digits;
+}
+
+uint8_t numfmt_fixed(char *buf, uint16_t value, uint8_t decimals)
+{
+    uint8_t n, i;
+
+    if (decimals == 0) {
+        return u16_digits(buf, value, 1);
+    }
+    if (decimals > 4) {
+        decimals = 4;
+    }
+
+    // Format with at least one integer digit, then open a gap for the point
+    n = u16_digits(buf, value, (uint8_t)(decimals + 1));
+    for (i = n; i > n - decimals; i--) {
+        buf[i] = buf[i - 1];
+    }
+    buf[n - decimals] = '.';
+    buf[n + 1] = '\0';
+    return (uint8_t)(n + 1);
+}
@@ -0,0 +1,98 @@
+/* File:   numfmt.h
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Integer-only number formatting and ADC scaling for the PIC16 projects, replacing
+ * float arithmetic and sprintf() (which pull in the software float library and the whole
+ * printf engine). Decimal conversion subtracts powers of ten instead of dividing, since the
+ * PIC16 has no divide instruction; the ADC scaling is one 32-bit multiply and a shift by a
+ * constant computed at compile time from NUMFMT_VREF_MV, NUMFMT_ADC_MAX and NUMFMT_DECIMALS.
+ *
+ * Every formatter writes a NUL-terminated string and returns its length (without the NUL).
+ */
+
+#ifndef NUMFMT_H
+#define NUMFMT_H
+
+#include <stdint.h>
+
+// Longest outputs, NUL included
+#define NUMFMT_U16_SIZE 6       // "65535"
+#define NUMFMT_U32_SIZE 11      // "4294967295"
+
+// ADC scaling: NUMFMT_ADC_UNITS() returns raw * NUMFMT_VREF_MV / NUMFMT_ADC_MAX, rounded,
+// in units of 10^-NUMFMT_DECIMALS volt (3 = millivolts, 2 = 10 mV, 1 = 100 mV)
+#ifndef NUMFMT_VREF_MV
+#define NUMFMT_VREF_MV 5000
+#endif
+#ifndef NUMFMT_ADC_MAX
+#define NUMFMT_ADC_MAX 1023
+#endif
+#ifndef NUMFMT_DECIMALS
+#define NUMFMT_DECIMALS 3
+#endif
+
+#if NUMFMT_DECIMALS == 3
+#define NUMFMT_UNIT_DIV 1
+#elif NUMFMT_DECIMALS == 2
+#define NUMFMT_UNIT_DIV 10
+#elif NUMFMT_DECIMALS == 1
+#define NUMFMT_UNIT_DIV 100
+#else
+#error "NUMFMT_DECIMALS must be 1, 2 or 3"
+#endif
+
+#if NUMFMT_ADC_MAX > 1023 || NUMFMT_VREF_MV > 8191
+#error "NUMFMT_ADC_UNITS() handles 10-bit results and references up to 8.191 V"
+#endif
+
+/*
+ * Fixed-point factor K = round(VREF_MV * 2^SHIFT / (ADC_MAX * UNIT_DIV)). SHIFT is the
+ * largest that keeps K below 2^21, so raw * K (raw <= 1023) stays under 2^31 and the
+ * result matches exact rounding for every raw value. K is built in two steps so no
+ * intermediate exceeds 32 bits.
+ */
+#define NUMFMT_DIVISOR ((unsigned long)NUMFMT_ADC_MAX * NUMFMT_UNIT_DIV)
+
+#if NUMFMT_VREF_MV * 32 < NUMFMT_ADC_MAX * NUMFMT_UNIT_DIV
+#define NUMFMT_SHIFT 26
+#elif NUMFMT_VREF_MV * 16 < NUMFMT_ADC_MAX * NUMFMT_UNIT_DIV
+#define NUMFMT_SHIFT 25
+#elif NUMFMT_VREF_MV * 8 < NUMFMT_ADC_MAX * NUMFMT_UNIT_DIV
+#define NUMFMT_SHIFT 24
+#elif NUMFMT_VREF_MV * 4 < NUMFMT_ADC_MAX * NUMFMT_UNIT_DIV
+#define NUMFMT_SHIFT 23
+#elif NUMFMT_VREF_MV * 2 < NUMFMT_ADC_MAX * NUMFMT_UNIT_DIV
+#define NUMFMT_SHIFT 22
+#elif NUMFMT_VREF_MV < NUMFMT_ADC_MAX * NUMFMT_UNIT_DIV
+#define NUMFMT_SHIFT 21
+#elif NUMFMT_VREF_MV < 2 * NUMFMT_ADC_MAX * NUMFMT_UNIT_DIV
+#define NUMFMT_SHIFT 20
+#elif NUMFMT_VREF_MV < 4 * NUMFMT_ADC_MAX * NUMFMT_UNIT_DIV
+#define NUMFMT_SHIFT 19
+#elif NUMFMT_VREF_MV < 8 * NUMFMT_ADC_MAX * NUMFMT_UNIT_DIV
+#define NUMFMT_SHIFT 18
+#else
+#define NUMFMT_SHIFT 17
+#endif
+
+#define NUMFMT_K_HIGH ((unsigned long)NUMFMT_VREF_MV << (NUMFMT_SHIFT - 14))
+#define NUMFMT_K ((NUMFMT_K_HIGH / NUMFMT_DIVISOR) * 16384UL + \
+                  ((NUMFMT_K_HIGH % NUMFMT_DIVISOR) * 16384UL + NUMFMT_DIVISOR / 2) / NUMFMT_DIVISOR)
+
+// Raw ADC result to 10^-NUMFMT_DECIMALS volt, e.g. 1023 -> 5000 with the defaults.
+// A macro so each project picks its own scale before including this header.
+#define NUMFMT_ADC_UNITS(raw) \
+    ((uint16_t)(((uint32_t)(raw) * NUMFMT_K + (1UL << (NUMFMT_SHIFT - 1))) >> NUMFMT_SHIFT))
+
+// Unsigned decimal, no leading zeros
+uint8_t numfmt_u16(char *buf, uint16_t value);
+uint8_t numfmt_u32(char *buf, uint32_t value);
+
+// Upper-case hexadecimal, exactly 'digits' digits (1..4), no prefix
+uint8_t numfmt_hex(char *buf, uint16_t value, uint8_t digits);
+
+// value / 10^decimals (0..4) with a decimal point, e.g. (489, 2) -> "4.89", (5, 2) -> "0.05"
+uint8_t numfmt_fixed(char *buf, uint16_t value, uint8_t decimals);
+
+#endif /* NUMFMT_H */
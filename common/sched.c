@@ -0,0 +1,122 @@
+/* File:   sched.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Cooperative tick scheduler (see sched.h).
+ * Release times are kept as absolute 16-bit tick values and compared through a signed
+ * difference, so the tick counter may wrap. The ISR writes 'ticks' and the idle counters;
+ * the main loop reads 'ticks' twice until both reads agree, since a 16-bit read is not
+ * atomic on the PIC16 and the ISR may update it in between.
+ */
+
+#include <xc.h>
+#include <stdint.h>
+#include "sched.h"
+
+static const sched_task_t *tasks;
+static uint8_t task_count = 0;
+static uint16_t next_release[SCHED_MAX_TASKS];
+static sched_task_stats_t task_stats[SCHED_MAX_TASKS];
+
+static volatile uint16_t ticks = 0;
+static volatile uint8_t running = 0;        // 1 while a task runs
+
+// Idle accounting (ISR only, except idle_percent)
+static uint16_t window_ticks = 0;
+static uint16_t window_idle = 0;
+static volatile uint8_t idle_percent = 100;
+
+void sched_init(const sched_task_t *table, uint8_t count)
+{
+    uint8_t i;
+
+    if (count > SCHED_MAX_TASKS) {
+        count = SCHED_MAX_TASKS;
+    }
+    task_count = 0;                     // Dispatcher sees no tasks while the table changes
+    ticks = 0;
+    window_ticks = 0;
+    window_idle = 0;
+    idle_percent = 100;
+    tasks = table;
+    for (i = 0; i < count; i++) {
+        next_release[i] = table[i].offset;
+        task_stats[i].runs = 0;
+        task_stats[i].overruns = 0;
+    }
+    task_count = count;
+}
+
+void sched_tick(void)
+{
+    ticks++;
+    if (!running) {
+        window_idle++;
+    }
+    if (++window_ticks >= SCHED_LOAD_WINDOW) {
+        idle_percent = (uint8_t)((uint32_t)window_idle * 100 / SCHED_LOAD_WINDOW);
+        window_ticks = 0;
+        window_idle = 0;
+    }
+}
+
+uint16_t sched_ticks(void)
+{
+    uint16_t now;
+
+    do {
+        now = ticks;
+    } while (now != ticks);
+    return now;
+}
+
+uint8_t sched_dispatch(void)
+{
+    uint8_t i, count = 0;
+    uint16_t now, period;
+
+    for (i = 0; i < task_count; i++) {
+        now = sched_ticks();
+        if ((int16_t)(now - next_release[i]) < 0) {
+            continue;
+        }
+
+        // Next release; every release that has already passed as well is missed
+        period = tasks[i].period;
+        next_release[i] += period;
+        while ((int16_t)(now - next_release[i]) >= 0) {
+            next_release[i] += period;
+            task_stats[i].overruns++;
+        }
+
+        running = 1;
+        tasks[i].run();
+        running = 0;
+        task_stats[i].runs++;
+        count++;
+    }
+    return count;
+}
+
+void sched_run(void)
+{
+    while (1) {
+        sched_dispatch();
+    }
+}
+
+void sched_get_task_stats(uint8_t index, sched_task_stats_t *out)
+{
+    if (index >= task_count) {
+        out->runs = 0;
+        out->overruns = 0;
+        return;
+    }
+    out->runs = task_stats[index].runs;
+    out->overruns = task_stats[index].overruns;
+}
+
+uint8_t sched_idle_percent(void)
+{
+    return idle_percent;
+}
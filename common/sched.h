@@ -0,0 +1,74 @@
+/* File:   sched.h
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Cooperative, run-to-completion task scheduler driven by a periodic timer tick.
+ * The application describes its periodic jobs in a const table (function, period and
+ * offset in ticks), calls sched_tick() from its timer interrupt and sched_run() from main().
+ * The dispatcher runs every task that is due, one after the other; a task must return
+ * quickly and never wait in a delay loop.
+ *
+ * A task that starts a whole period or more after its release has missed releases: each
+ * one is counted as an overrun and skipped (the task runs once, not in a burst), keeping
+ * its original phase. The offsets spread tasks with a common period over different ticks.
+ *
+ * Idle time is sampled by the tick: every tick that arrives while no task is running is
+ * counted as idle, giving the CPU load over the last SCHED_LOAD_WINDOW ticks.
+ */
+
+#ifndef SCHED_H
+#define SCHED_H
+
+#include <stdint.h>
+
+// Largest task table accepted by sched_init()
+#ifndef SCHED_MAX_TASKS
+#define SCHED_MAX_TASKS 8
+#endif
+
+// Ticks per idle-time measurement window
+#ifndef SCHED_LOAD_WINDOW
+#define SCHED_LOAD_WINDOW 1000
+#endif
+
+#if SCHED_MAX_TASKS < 1 || SCHED_MAX_TASKS > 255
+#error "SCHED_MAX_TASKS must be between 1 and 255"
+#endif
+
+typedef void (*sched_fn_t)(void);
+
+// One periodic task (lives in flash)
+typedef struct {
+    sched_fn_t run;
+    uint16_t period;    // Ticks between releases (1..32767)
+    uint16_t offset;    // Ticks from sched_init() to the first release
+} sched_task_t;
+
+// Per-task counters
+typedef struct {
+    uint16_t runs;
+    uint16_t overruns;  // Releases skipped because the task started a period late or more
+} sched_task_stats_t;
+
+// Install the task table (at most SCHED_MAX_TASKS entries) and restart the tick count
+void sched_init(const sched_task_t *table, uint8_t count);
+
+// Time base; call from the periodic timer interrupt
+void sched_tick(void);
+
+// Ticks since sched_init() (wraps at 65536)
+uint16_t sched_ticks(void);
+
+// Run every task that is due, in table order. Returns the number of tasks run.
+uint8_t sched_dispatch(void);
+
+// Dispatch forever; never returns
+void sched_run(void);
+
+// Counters of task 'index'
+void sched_get_task_stats(uint8_t index, sched_task_stats_t *stats);
+
+// Idle ticks in the last complete window, in percent (100 until a window has elapsed)
+uint8_t sched_idle_percent(void);
+
+#endif /* SCHED_H */
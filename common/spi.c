@@ -0,0 +1,191 @@
+/* File:   spi.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Interrupt-driven SPI master/slave driver (see spi.h).
+ * The slave FIFO uses free-running 8-bit head/tail indices like the UART driver (uart.c):
+ * the ISR only writes the head and the main loop only writes the tail.
+ */
+
+#include <xc.h>
+#include <stdint.h>
+#include "spi.h"
+
+#define SPI_RX_MASK (SPI_RX_FIFO_SIZE - 1)
+
+#define ROLE_OFF    0
+#define ROLE_MASTER 1
+#define ROLE_SLAVE  2
+
+static uint8_t role = ROLE_OFF;
+
+// Master block in progress (pos = byte being shifted)
+static const uint8_t *tx_data;
+static uint8_t *rx_data;
+static uint8_t length;
+static uint8_t pos;
+static volatile uint8_t busy = 0;
+
+// Slave receive FIFO
+static volatile uint8_t rx_fifo[SPI_RX_FIFO_SIZE];
+static volatile uint8_t rx_head = 0;
+static volatile uint8_t rx_tail = 0;
+
+static volatile spi_stats_t stats;
+
+// CKP = CPOL; the MSSP's CKE is the inverse of CPHA (CKE = 1: transmit on active-to-idle)
+static void set_mode(uint8_t mode)
+{
+    CKP = (mode & 2) ? 1 : 0;
+    CKE = (mode & 1) ? 0 : 1;
+}
+
+static void reset_state(uint8_t new_role)
+{
+    role = new_role;
+    busy = 0;
+    rx_head = rx_tail = 0;
+    stats.transfers = 0;
+    stats.overflows = 0;
+    stats.rx_dropped = 0;
+    SSPEN = 0;
+    SSPIF = 0;
+}
+
+void spi_master_init(uint8_t mode, uint8_t clock)
+{
+    reset_state(ROLE_MASTER);
+
+    // Chip select idle high
+    SPI_CS_PIN = 1;
+    SPI_CS_TRIS = 0;
+
+    SSPCON = clock & 0x0F;
+    set_mode(mode);
+    SMP = 0;            // Sample input in the middle of the data output time
+
+    TRISC5 = 0;         // SDO -> Output
+    TRISC4 = 1;         // SDI -> Input
+    TRISC3 = 0;         // SCK -> Output
+    SSPEN = 1;
+
+    SSPIE = 1;
+    PEIE = 1;
+    GIE = 1;
+}
+
+uint8_t spi_transfer(const uint8_t *tx, uint8_t *rx, uint8_t len)
+{
+    if (busy || len == 0) {
+        return 0;
+    }
+    tx_data = tx;
+    rx_data = rx;
+    length = len;
+    pos = 0;
+    busy = 1;
+
+    SPI_CS_PIN = 0;
+    SSPBUF = tx ? tx[0] : SPI_FILL_BYTE;    // Starts the first byte
+    return 1;
+}
+
+uint8_t spi_busy(void)
+{
+    return busy;
+}
+
+void spi_slave_init(uint8_t mode, uint8_t use_ss)
+{
+    reset_state(ROLE_SLAVE);
+
+    // With CKE = 1 (modes 0 and 2) the slave needs SS to find the first bit
+    if (!(mode & 1)) {
+        use_ss = 1;
+    }
+    SSPCON = use_ss ? 0x04 : 0x05;
+    set_mode(mode);
+    SMP = 0;            // Must be clear in slave mode
+
+    TRISC5 = 0;         // SDO -> Output
+    TRISC4 = 1;         // SDI -> Input
+    TRISC3 = 1;         // SCK -> Input
+    if (use_ss) {
+        TRISA5 = 1;     // SS -> Input (RA5/AN4 made digital by the application)
+    }
+    SSPEN = 1;
+
+    SSPIE = 1;
+    PEIE = 1;
+    GIE = 1;
+}
+
+uint8_t spi_slave_read(uint8_t *data)
+{
+    uint8_t tail = rx_tail;
+
+    if (rx_head == tail) {
+        return 0;
+    }
+    *data = rx_fifo[tail & SPI_RX_MASK];
+    rx_tail = (uint8_t)(tail + 1);
+    return 1;
+}
+
+uint8_t spi_slave_available(void)
+{
+    return (uint8_t)(rx_head - rx_tail);
+}
+
+void spi_get_stats(spi_stats_t *out)
+{
+    // The 16-bit counters are updated by the ISR, so copy them with SSPIE masked
+    uint8_t sspie = SSPIE;
+
+    SSPIE = 0;
+    out->transfers = stats.transfers;
+    out->overflows = stats.overflows;
+    out->rx_dropped = stats.rx_dropped;
+    SSPIE = sspie;
+}
+
+void spi_isr(void)
+{
+    uint8_t data, head;
+
+    if (!(SSPIE && SSPIF)) {
+        return;
+    }
+    SSPIF = 0;
+    data = SSPBUF;      // Reading SSPBUF clears BF
+
+    if (role == ROLE_MASTER) {
+        if (!busy) {
+            return;
+        }
+        if (rx_data) {
+            rx_data[pos] = data;
+        }
+        if (++pos < length) {
+            SSPBUF = tx_data ? tx_data[pos] : SPI_FILL_BYTE;
+        } else {
+            SPI_CS_PIN = 1;
+            busy = 0;
+            stats.transfers++;
+        }
+        return;
+    }
+
+    // Slave: SSPBUF still holds the byte before the one that overflowed
+    if (SSPOV) {
+        SSPOV = 0;
+        stats.overflows++;
+    }
+    head = rx_head;
+    if ((uint8_t)(head - rx_tail) < SPI_RX_FIFO_SIZE) {
+        rx_fifo[head & SPI_RX_MASK] = data;
+        rx_head = (uint8_t)(head + 1);
+    } else {
+        stats.rx_dropped++;
+    }
+}
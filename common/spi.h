@@ -0,0 +1,95 @@
+/* File:   spi.h
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Interrupt-driven SPI driver for the MSSP of the PIC16F877A, master or slave.
+ *
+ * Master: spi_transfer(tx, rx, len) asserts the chip select, loads the first byte and
+ * returns; each SSPIF stores the byte clocked in and loads the next one, and the last one
+ * releases the chip select. SSPBUF is only written after the previous byte has completed,
+ * so no write collision (WCOL) can occur. The SPI clock is Fosc/4, /16, /64 or Timer2/2.
+ *
+ * Slave: every received byte goes into a receive FIFO that the main loop drains with
+ * spi_slave_read(). Bytes lost in hardware (SSPOV: a byte completed before the ISR read the
+ * previous one) and bytes dropped because the FIFO was full are counted separately.
+ *
+ * At Fosc/4 a byte takes 8 instruction cycles, less than the interrupt entry and exit, so
+ * the master's byte rate is set by its ISR; a slave at the same Fosc keeps up because its
+ * ISR is shorter than the master's.
+ *
+ * The application must call spi_isr() from its __interrupt() routine.
+ */
+
+#ifndef SPI_H
+#define SPI_H
+
+#include <stdint.h>
+
+// SPI modes (CPOL, CPHA): 0 = (0, 0), 1 = (0, 1), 2 = (1, 0), 3 = (1, 1)
+#define SPI_MODE_0 0
+#define SPI_MODE_1 1
+#define SPI_MODE_2 2
+#define SPI_MODE_3 3
+
+// Master clock (SSPM<3:0>)
+#define SPI_CLOCK_FOSC_4  0x00
+#define SPI_CLOCK_FOSC_16 0x01
+#define SPI_CLOCK_FOSC_64 0x02
+#define SPI_CLOCK_TMR2    0x03  // Timer2 output / 2
+
+// Master chip select: driven low for the whole block, high when idle
+#ifndef SPI_CS_PIN
+#define SPI_CS_PIN  RA5
+#define SPI_CS_TRIS TRISA5
+#endif
+
+// Byte sent when spi_transfer() has no transmit buffer
+#ifndef SPI_FILL_BYTE
+#define SPI_FILL_BYTE 0xFF
+#endif
+
+// Slave receive FIFO size (power of two, at most 128)
+#ifndef SPI_RX_FIFO_SIZE
+#define SPI_RX_FIFO_SIZE 32
+#endif
+
+#if (SPI_RX_FIFO_SIZE & (SPI_RX_FIFO_SIZE - 1)) || SPI_RX_FIFO_SIZE > 128
+#error "SPI_RX_FIFO_SIZE must be a power of two no larger than 128"
+#endif
+
+// Transfer statistics
+typedef struct {
+    uint16_t transfers;     // Master blocks completed
+    uint16_t overflows;     // Slave: SSPOV events (byte lost in the MSSP)
+    uint16_t rx_dropped;    // Slave: bytes lost because the FIFO was full
+} spi_stats_t;
+
+// Master on SCK/SDO/SDI (RC3/RC5/RC4) with the given mode and clock; chip select released
+void spi_master_init(uint8_t mode, uint8_t clock);
+
+// Start a full-duplex block transfer of len bytes. tx may be 0 (SPI_FILL_BYTE is sent) and
+// rx may be 0 (received bytes discarded). The buffers must stay valid until spi_busy()
+// returns 0. Returns 1 if started, 0 if a transfer is still running or len is 0.
+uint8_t spi_transfer(const uint8_t *tx, uint8_t *rx, uint8_t len);
+
+// 1 while a master transfer is running
+uint8_t spi_busy(void);
+
+// Slave with the given mode; use_ss enables the SS pin (RA5), which modes 0 and 2 require.
+// ADCON1 is left to the application, which must configure RA5/AN4 as digital for SS
+// (e.g. ADCON1 = 0x06, or PCFG = 0100 to keep AN0, AN1 and AN3 analog).
+void spi_slave_init(uint8_t mode, uint8_t use_ss);
+
+// Fetch one received byte. Returns 1 and stores it in *data, or 0 if the FIFO is empty.
+uint8_t spi_slave_read(uint8_t *data);
+
+// Number of received bytes waiting in the FIFO
+uint8_t spi_slave_available(void);
+
+// Copy the statistics
+void spi_get_stats(spi_stats_t *stats);
+
+// Service SSPIF; call from the application's interrupt routine
+void spi_isr(void);
+
+#endif /* SPI_H */
@@ -0,0 +1,21 @@
+/* File:   tmr1.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Timer1 read without the carry race (see tmr1.h).
+ */
+
+#include <xc.h>
+#include <stdint.h>
+#include "tmr1.h"
+
+uint16_t tmr1_read(void)
+{
+    uint8_t high, low;
+
+    do {
+        high = TMR1H;
+        low = TMR1L;
+    } while (high != TMR1H);
+    return ((uint16_t)high << 8) | low;
+}
@@ -0,0 +1,18 @@
+/* File:   tmr1.h
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Timer1 read shared by the modules that timestamp with a free-running Timer1 (evq.c,
+ * irq.c). TMR1H and TMR1L are separate bytes, so a carry between the two reads would give
+ * a value up to 255 ticks off; tmr1_read() re-reads until the high byte is stable.
+ */
+
+#ifndef TMR1_H
+#define TMR1_H
+
+#include <stdint.h>
+
+// Current Timer1 count; safe from the main loop and from the interrupt routine
+uint16_t tmr1_read(void);
+
+#endif /* TMR1_H */
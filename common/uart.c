@@ -0,0 +1,196 @@
+/* File:   uart.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Interrupt-driven USART driver (see uart.h).
+ * Each ring buffer uses free-running 8-bit head/tail indices: the producer only writes the
+ * head and the consumer only writes the tail, so the main loop and the ISR never need to
+ * disable interrupts to share a buffer. The fill level is (head - tail) and the slot is
+ * (index & (SIZE - 1)), which is why the sizes must be powers of two.
+ */
+
+#include <xc.h>
+#include <stdint.h>
+#include "uart.h"
+
+#define UART_TX_MASK (UART_TX_BUFFER_SIZE - 1)
+#define UART_RX_MASK (UART_RX_BUFFER_SIZE - 1)
+
+// Transmit ring buffer (head written by main loop, tail by ISR)
+static volatile uint8_t tx_buffer[UART_TX_BUFFER_SIZE];
+static volatile uint8_t tx_head = 0;
+static volatile uint8_t tx_tail = 0;
+
+// Sequence number of the next telemetry frame
+static uint8_t tx_seq = 0;
+
+// Receive ring buffer (head written by ISR, tail by main loop)
+static volatile uint8_t rx_buffer[UART_RX_BUFFER_SIZE];
+static volatile uint8_t rx_head = 0;
+static volatile uint8_t rx_tail = 0;
+
+// Receive error counters (written by ISR only)
+static volatile uart_stats_t stats;
+
+void uart_init(uint8_t spbrg)
+{
+    // Start with empty buffers and cleared counters
+    tx_head = tx_tail = 0;
+    tx_seq = 0;
+    rx_head = rx_tail = 0;
+    stats.overrun_errors = 0;
+    stats.framing_errors = 0;
+    stats.rx_dropped = 0;
+
+    // Baud rate generator: SPBRG = (Fosc / (16 * Baud Rate)) - 1
+    BRGH = 1;       // High-speed baud rate
+    SPBRG = spbrg;
+
+    // Enable Asynchronous Serial Port
+    SYNC = 0;
+    SPEN = 1;
+
+    // Set RX-TX Pins to be in UART mode
+    TRISC6 = 0;     // TX pin (output)
+    TRISC7 = 1;     // RX pin (input)
+
+    // Enable transmission and continuous reception
+    TXEN = 1;
+    CREN = 1;
+
+    // RX interrupt stays on; TX interrupt is enabled only while data is queued
+    TXIE = 0;
+    RCIE = 1;
+    PEIE = 1;
+    GIE = 1;
+}
+
+uint8_t uart_write(uint8_t data)
+{
+    if ((uint8_t)(tx_head - tx_tail) >= UART_TX_BUFFER_SIZE) {
+        return 0;   // Buffer full
+    }
+    tx_buffer[tx_head & UART_TX_MASK] = data;
+    tx_head++;
+    TXIE = 1;       // Let the ISR drain the buffer
+    return 1;
+}
+
+uint8_t uart_write_text(const char *text)
+{
+    const char *p = text;
+    while (*p != '\0') {
+        p++;
+    }
+    if ((uint16_t)(p - text) > uart_tx_free()) {
+        return 0;
+    }
+    while (*text != '\0') {
+        tx_buffer[tx_head & UART_TX_MASK] = (uint8_t)*text++;
+        tx_head++;
+    }
+    TXIE = 1;
+    return 1;
+}
+
+uint8_t uart_write_some(const char *text)
+{
+    uint8_t count = 0;
+    uint8_t room = uart_tx_free();
+
+    while (count < room && text[count] != '\0') {
+        tx_buffer[tx_head & UART_TX_MASK] = (uint8_t)text[count++];
+        tx_head++;
+    }
+    if (count != 0) {
+        TXIE = 1;
+    }
+    return count;
+}
+
+void uart_frame_begin(frame_t *f, uint8_t type)
+{
+    // The frame is built past tx_head, where the ISR does not read
+    frame_begin(f, tx_buffer, UART_TX_MASK, tx_head, uart_tx_free(), type, tx_seq);
+}
+
+uint8_t uart_frame_end(frame_t *f)
+{
+    uint8_t length = frame_end(f);
+
+    tx_seq++;
+    if (length == 0) {
+        return 0;
+    }
+    tx_head += length;  // Publish the whole frame at once
+    TXIE = 1;
+    return 1;
+}
+
+uint8_t uart_tx_free(void)
+{
+    return (uint8_t)(UART_TX_BUFFER_SIZE - (uint8_t)(tx_head - tx_tail));
+}
+
+uint8_t uart_read(uint8_t *data)
+{
+    if (rx_head == rx_tail) {
+        return 0;   // Nothing received
+    }
+    *data = rx_buffer[rx_tail & UART_RX_MASK];
+    rx_tail++;
+    return 1;
+}
+
+uint8_t uart_available(void)
+{
+    return (uint8_t)(rx_head - rx_tail);
+}
+
+void uart_get_stats(uart_stats_t *out)
+{
+    // The 16-bit counters are updated by the ISR, so copy them with RX interrupts masked
+    uint8_t rcie = RCIE;
+
+    RCIE = 0;
+    out->overrun_errors = stats.overrun_errors;
+    out->framing_errors = stats.framing_errors;
+    out->rx_dropped = stats.rx_dropped;
+    RCIE = rcie;
+}
+
+void uart_isr(void)
+{
+    // Receive: one byte per interrupt, the flag re-asserts while the FIFO holds more
+    if (RCIF) {
+        if (FERR) {
+            (void)RCREG;                // Discard the corrupted byte (also clears FERR)
+            stats.framing_errors++;
+        } else {
+            uint8_t data = RCREG;
+            if ((uint8_t)(rx_head - rx_tail) < UART_RX_BUFFER_SIZE) {
+                rx_buffer[rx_head & UART_RX_MASK] = data;
+                rx_head++;
+            } else {
+                stats.rx_dropped++;
+            }
+        }
+    }
+    if (OERR) {
+        // Overrun stops the receiver until CREN is cycled
+        CREN = 0;
+        CREN = 1;
+        stats.overrun_errors++;
+    }
+
+    // Transmit: refill TXREG while data is queued, then mask the interrupt
+    if (TXIE && TXIF) {
+        if (tx_head != tx_tail) {
+            TXREG = tx_buffer[tx_tail & UART_TX_MASK];
+            tx_tail++;
+        }
+        if (tx_head == tx_tail) {
+            TXIE = 0;
+        }
+    }
+}
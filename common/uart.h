@@ -0,0 +1,83 @@
+/* File:   uart.h
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Interrupt-driven USART driver for the PIC16F877A. Transmit and receive data go through
+ * power-of-two ring buffers that are serviced from the TXIF/RCIF interrupts, so none of the
+ * uart_write/uart_read/uart_available calls ever wait on the hardware. Receive errors
+ * (OERR/FERR) and bytes dropped because the RX buffer was full are counted.
+ *
+ * Binary telemetry frames (common/frame.h) are encoded straight into the TX buffer between
+ * uart_frame_begin() and uart_frame_end() and handed to the ISR only once complete. The
+ * driver numbers them; a frame that does not fit is dropped but still uses up its sequence
+ * number, so the receiver counts it as lost.
+ *
+ * Shared by 03-PIC16F_UART, 06-PIC16F_IT and 07-PIC16F_TIMER. The application must call
+ * uart_isr() from its __interrupt() routine, or register it for IRQ_RC and IRQ_TX (irq.h).
+ */
+
+#ifndef UART_H
+#define UART_H
+
+#include <stdint.h>
+#include "frame.h"
+
+// Ring buffer sizes (must be powers of two, at most 128)
+#ifndef UART_TX_BUFFER_SIZE
+#define UART_TX_BUFFER_SIZE 64
+#endif
+#ifndef UART_RX_BUFFER_SIZE
+#define UART_RX_BUFFER_SIZE 32
+#endif
+
+#if (UART_TX_BUFFER_SIZE & (UART_TX_BUFFER_SIZE - 1)) || UART_TX_BUFFER_SIZE > 128
+#error "UART_TX_BUFFER_SIZE must be a power of two no larger than 128"
+#endif
+#if (UART_RX_BUFFER_SIZE & (UART_RX_BUFFER_SIZE - 1)) || UART_RX_BUFFER_SIZE > 128
+#error "UART_RX_BUFFER_SIZE must be a power of two no larger than 128"
+#endif
+
+// Receive error counters
+typedef struct {
+    uint16_t overrun_errors;  // OERR events (receiver restarted)
+    uint16_t framing_errors;  // FERR events (byte discarded)
+    uint16_t rx_dropped;      // Bytes lost because the RX buffer was full
+} uart_stats_t;
+
+// Initialize the USART in asynchronous high-speed mode (BRGH = 1) and enable its interrupts
+void uart_init(uint8_t spbrg);
+
+// Queue one byte for transmission. Returns 1 on success, 0 if the TX buffer is full.
+uint8_t uart_write(uint8_t data);
+
+// Queue a whole string. Returns 1 on success, 0 (nothing queued) if it does not fit in the
+// free space (uart_tx_free()); a string longer than UART_TX_BUFFER_SIZE never fits.
+uint8_t uart_write_text(const char *text);
+
+// Queue as much of a string as fits and return the number of characters queued; call again
+// with text + count to send the rest once the ISR has made room
+uint8_t uart_write_some(const char *text);
+
+// Start a telemetry frame of the given type in the free part of the TX buffer; append the
+// payload with frame_put()/frame_put16()
+void uart_frame_begin(frame_t *f, uint8_t type);
+
+// Finish the frame and queue it. Returns 1 on success, 0 if it did not fit (dropped).
+uint8_t uart_frame_end(frame_t *f);
+
+// Number of bytes free in the TX buffer
+uint8_t uart_tx_free(void);
+
+// Fetch one received byte. Returns 1 and stores it in *data, or 0 if nothing was received.
+uint8_t uart_read(uint8_t *data);
+
+// Number of received bytes waiting in the RX buffer
+uint8_t uart_available(void);
+
+// Copy the receive error counters
+void uart_get_stats(uart_stats_t *stats);
+
+// Service TXIF/RCIF; call from the application's interrupt routine
+void uart_isr(void);
+
+#endif /* UART_H */
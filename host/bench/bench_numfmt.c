@@ -0,0 +1,109 @@
+/* File:   bench_numfmt.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Host benchmark of the 06-PIC16F_IT voltage report: float scaling + sprintf("%.2f") against
+ * NUMFMT_ADC_UNITS() + numfmt_fixed(), and sprintf("%lu") against numfmt_u32() for the
+ * 07-PIC16F_TIMER loop counter. Every ADC code 0..1023 is first checked to give the same
+ * text on both paths, then each path is timed over the full range.
+ *
+ * Host nanoseconds only rank the two paths; PIC cycle counts and code sizes come from the
+ * XC8 listings (make profile, see host/README.md).
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define NUMFMT_DECIMALS 2       // Same scale as 06-PIC16F_IT
+#include "../../common/numfmt.h"
+
+#define ROUNDS 2000
+
+static volatile uint32_t sink;
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void float_voltage(char *buf, uint16_t adc_value)
+{
+    float voltage = (adc_value * 5.0) / 1023.0;
+    sprintf(buf, "%.2f", voltage);
+}
+
+static void fixed_voltage(char *buf, uint16_t adc_value)
+{
+    numfmt_fixed(buf, NUMFMT_ADC_UNITS(adc_value), NUMFMT_DECIMALS);
+}
+
+static void printf_counter(char *buf, uint32_t value)
+{
+    sprintf(buf, "%lu", (unsigned long)value);
+}
+
+static void numfmt_counter(char *buf, uint32_t value)
+{
+    numfmt_u32(buf, value);
+}
+
+static double time_voltage(void (*fn)(char *, uint16_t))
+{
+    char buf[16];
+    double start = now_ns();
+    int r;
+    uint16_t v;
+    for (r = 0; r < ROUNDS; r++) {
+        for (v = 0; v <= 1023; v++) {
+            fn(buf, v);
+            sink += (uint8_t)buf[0];
+        }
+    }
+    return (now_ns() - start) / (ROUNDS * 1024.0);
+}
+
+static double time_counter(void (*fn)(char *, uint32_t))
+{
+    char buf[16];
+    double start = now_ns();
+    uint32_t i, v = 1;
+    for (i = 0; i < ROUNDS * 1024UL; i++) {
+        fn(buf, v);
+        sink += (uint8_t)buf[0];
+        v = v * 2654435761UL + 1;
+    }
+    return (now_ns() - start) / (ROUNDS * 1024.0);
+}
+
+int main(void)
+{
+    char a[16], b[16];
+    uint16_t v;
+    int mismatches = 0;
+    double t_float, t_fixed, t_printf, t_numfmt;
+
+    for (v = 0; v <= 1023; v++) {
+        float_voltage(a, v);
+        fixed_voltage(b, v);
+        if (strcmp(a, b) != 0) {
+            printf("mismatch at %u: \"%s\" vs \"%s\"\n", v, a, b);
+            mismatches++;
+        }
+    }
+    printf("voltage text identical for %d of 1024 ADC codes\n", 1024 - mismatches);
+
+    t_float = time_voltage(float_voltage);
+    t_fixed = time_voltage(fixed_voltage);
+    t_printf = time_counter(printf_counter);
+    t_numfmt = time_counter(numfmt_counter);
+
+    printf("%-28s %8.1f ns/call\n", "float + sprintf(\"%.2f\")", t_float);
+    printf("%-28s %8.1f ns/call  (%.1fx)\n", "NUMFMT_ADC_UNITS + fixed", t_fixed, t_float / t_fixed);
+    printf("%-28s %8.1f ns/call\n", "sprintf(\"%lu\")", t_printf);
+    printf("%-28s %8.1f ns/call  (%.1fx)\n", "numfmt_u32", t_numfmt, t_printf / t_numfmt);
+    return mismatches ? 1 : 0;
+}
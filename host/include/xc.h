@@ -0,0 +1,530 @@
+/* File:   xc.h
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Host (gcc/Linux) stand-in for the XC8 <xc.h> header, limited to the PIC16F877A.
+ * Every SFR is an ordinary global variable, so firmware sources build unchanged with gcc
+ * and tests can poke interrupt flags, read back port writes and call the ISR directly.
+ * Delay and CLRWDT() calls advance a virtual instruction-cycle counter instead of waiting.
+ *
+ * The same names as XC8 are provided: the byte registers (PORTB, TRISC, ...), the
+ * XXXbits unions (PORTBbits.RB0, ADCON0bits.GO_DONE, ...) and the single-bit aliases
+ * (RB0, SSPIF, TMR2IF, ...). See host/README.md.
+ */
+
+#ifndef PIC_HOST_XC_H
+#define PIC_HOST_XC_H
+
+#include <stdint.h>
+
+#ifndef __PIC_HOST__
+#define __PIC_HOST__ 1
+#endif
+#define _16F877A 1
+
+// XC8 keywords and qualifiers that have no meaning on the host
+#define __interrupt(...)
+#define __at(address)
+#define __section(name)
+#define __persistent
+#define __bank(n)
+#define __near
+#define __far
+#define __eeprom
+
+/* -------------------------------------------------------------------------------------
+ * Special function registers: name and data memory address (bank 0..3 linear address)
+ * -------------------------------------------------------------------------------------*/
+#define PIC_HOST_SFR_LIST(X) \
+    X(INDF,      0x000) \
+    X(TMR0,      0x001) \
+    X(PCL,       0x002) \
+    X(STATUS,    0x003) \
+    X(FSR,       0x004) \
+    X(PORTA,     0x005) \
+    X(PORTB,     0x006) \
+    X(PORTC,     0x007) \
+    X(PORTD,     0x008) \
+    X(PORTE,     0x009) \
+    X(PCLATH,    0x00A) \
+    X(INTCON,    0x00B) \
+    X(PIR1,      0x00C) \
+    X(PIR2,      0x00D) \
+    X(TMR1L,     0x00E) \
+    X(TMR1H,     0x00F) \
+    X(T1CON,     0x010) \
+    X(TMR2,      0x011) \
+    X(T2CON,     0x012) \
+    X(SSPBUF,    0x013) \
+    X(SSPCON,    0x014) \
+    X(CCPR1L,    0x015) \
+    X(CCPR1H,    0x016) \
+    X(CCP1CON,   0x017) \
+    X(RCSTA,     0x018) \
+    X(TXREG,     0x019) \
+    X(RCREG,     0x01A) \
+    X(CCPR2L,    0x01B) \
+    X(CCPR2H,    0x01C) \
+    X(CCP2CON,   0x01D) \
+    X(ADRESH,    0x01E) \
+    X(ADCON0,    0x01F) \
+    X(OPTION_REG, 0x081) \
+    X(TRISA,     0x085) \
+    X(TRISB,     0x086) \
+    X(TRISC,     0x087) \
+    X(TRISD,     0x088) \
+    X(TRISE,     0x089) \
+    X(PIE1,      0x08C) \
+    X(PIE2,      0x08D) \
+    X(PCON,      0x08E) \
+    X(SSPCON2,   0x091) \
+    X(PR2,       0x092) \
+    X(SSPADD,    0x093) \
+    X(SSPSTAT,   0x094) \
+    X(TXSTA,     0x098) \
+    X(SPBRG,     0x099) \
+    X(CMCON,     0x09C) \
+    X(CVRCON,    0x09D) \
+    X(ADRESL,    0x09E) \
+    X(ADCON1,    0x09F) \
+    X(EEDATA,    0x10C) \
+    X(EEADR,     0x10D) \
+    X(EEDATH,    0x10E) \
+    X(EEADRH,    0x10F) \
+    X(EECON1,    0x18C) \
+    X(EECON2,    0x18D)
+
+// Declares <REG>bits_t. The union holds the bit-fields, the whole byte, and itself again
+// under the <REG>bits name: "PORTBbits.RB0" expands to PORTBbits.PORTBbits.RB0 once the
+// RB0 alias below is defined, and must still name the same bit.
+#define PIC_HOST_BITS(name, ...) \
+    typedef union { __VA_ARGS__ uint8_t name; } pic_##name##bits_t; \
+    typedef union { pic_##name##bits_t name##bits; __VA_ARGS__ uint8_t name; } name##bits_t; \
+    extern volatile name##bits_t name##bits;
+
+PIC_HOST_BITS(STATUS,
+    struct { unsigned C:1, DC:1, Z:1, nPD:1, nTO:1, RP0:1, RP1:1, IRP:1; };
+    struct { unsigned :5, RP:2; };
+    struct { unsigned CARRY:1, :1, ZERO:1; };)
+PIC_HOST_BITS(PORTA, struct { unsigned RA0:1, RA1:1, RA2:1, RA3:1, RA4:1, RA5:1; };)
+PIC_HOST_BITS(PORTB, struct { unsigned RB0:1, RB1:1, RB2:1, RB3:1, RB4:1, RB5:1, RB6:1, RB7:1; };)
+PIC_HOST_BITS(PORTC, struct { unsigned RC0:1, RC1:1, RC2:1, RC3:1, RC4:1, RC5:1, RC6:1, RC7:1; };)
+PIC_HOST_BITS(PORTD, struct { unsigned RD0:1, RD1:1, RD2:1, RD3:1, RD4:1, RD5:1, RD6:1, RD7:1; };)
+PIC_HOST_BITS(PORTE, struct { unsigned RE0:1, RE1:1, RE2:1; };)
+PIC_HOST_BITS(INTCON,
+    struct { unsigned RBIF:1, INTF:1, TMR0IF:1, RBIE:1, INTE:1, TMR0IE:1, PEIE:1, GIE:1; };
+    struct { unsigned :2, T0IF:1, :2, T0IE:1; };)
+PIC_HOST_BITS(PIR1, struct { unsigned TMR1IF:1, TMR2IF:1, CCP1IF:1, SSPIF:1, TXIF:1, RCIF:1, ADIF:1, PSPIF:1; };)
+PIC_HOST_BITS(PIR2, struct { unsigned CCP2IF:1, :2, BCLIF:1, EEIF:1, :1, CMIF:1; };)
+PIC_HOST_BITS(T1CON,
+    struct { unsigned TMR1ON:1, TMR1CS:1, nT1SYNC:1, T1OSCEN:1, T1CKPS0:1, T1CKPS1:1; };
+    struct { unsigned :2, T1SYNC:1, :1, T1CKPS:2; };
+    struct { unsigned :2, T1INSYNC:1; };)
+PIC_HOST_BITS(T2CON,
+    struct { unsigned T2CKPS0:1, T2CKPS1:1, TMR2ON:1, TOUTPS0:1, TOUTPS1:1, TOUTPS2:1, TOUTPS3:1; };
+    struct { unsigned T2CKPS:2, :1, TOUTPS:4; };)
+PIC_HOST_BITS(SSPCON,
+    struct { unsigned SSPM0:1, SSPM1:1, SSPM2:1, SSPM3:1, CKP:1, SSPEN:1, SSPOV:1, WCOL:1; };
+    struct { unsigned SSPM:4; };)
+PIC_HOST_BITS(CCP1CON,
+    struct { unsigned CCP1M0:1, CCP1M1:1, CCP1M2:1, CCP1M3:1, CCP1Y:1, CCP1X:1; };
+    struct { unsigned CCP1M:4, DC1B:2; };)
+PIC_HOST_BITS(RCSTA, struct { unsigned RX9D:1, OERR:1, FERR:1, ADDEN:1, CREN:1, SREN:1, RX9:1, SPEN:1; };)
+PIC_HOST_BITS(CCP2CON,
+    struct { unsigned CCP2M0:1, CCP2M1:1, CCP2M2:1, CCP2M3:1, CCP2Y:1, CCP2X:1; };
+    struct { unsigned CCP2M:4, DC2B:2; };)
+PIC_HOST_BITS(ADCON0,
+    struct { unsigned ADON:1, :1, GO_DONE:1, CHS0:1, CHS1:1, CHS2:1, ADCS0:1, ADCS1:1; };
+    struct { unsigned :2, GO:1, CHS:3, ADCS:2; };
+    struct { unsigned :2, nDONE:1; };
+    struct { unsigned :2, GO_nDONE:1; };)
+PIC_HOST_BITS(OPTION_REG,
+    struct { unsigned PS0:1, PS1:1, PS2:1, PSA:1, T0SE:1, T0CS:1, INTEDG:1, nRBPU:1; };
+    struct { unsigned PS:3; };)
+PIC_HOST_BITS(TRISA, struct { unsigned TRISA0:1, TRISA1:1, TRISA2:1, TRISA3:1, TRISA4:1, TRISA5:1; };)
+PIC_HOST_BITS(TRISB, struct { unsigned TRISB0:1, TRISB1:1, TRISB2:1, TRISB3:1, TRISB4:1, TRISB5:1, TRISB6:1, TRISB7:1; };)
+PIC_HOST_BITS(TRISC, struct { unsigned TRISC0:1, TRISC1:1, TRISC2:1, TRISC3:1, TRISC4:1, TRISC5:1, TRISC6:1, TRISC7:1; };)
+PIC_HOST_BITS(TRISD, struct { unsigned TRISD0:1, TRISD1:1, TRISD2:1, TRISD3:1, TRISD4:1, TRISD5:1, TRISD6:1, TRISD7:1; };)
+PIC_HOST_BITS(TRISE, struct { unsigned TRISE0:1, TRISE1:1, TRISE2:1, :1, PSPMODE:1, IBOV:1, OBF:1, IBF:1; };)
+PIC_HOST_BITS(PIE1, struct { unsigned TMR1IE:1, TMR2IE:1, CCP1IE:1, SSPIE:1, TXIE:1, RCIE:1, ADIE:1, PSPIE:1; };)
+PIC_HOST_BITS(PIE2, struct { unsigned CCP2IE:1, :2, BCLIE:1, EEIE:1, :1, CMIE:1; };)
+PIC_HOST_BITS(PCON, struct { unsigned nBOR:1, nPOR:1; };)
+PIC_HOST_BITS(SSPCON2, struct { unsigned SEN:1, RSEN:1, PEN:1, RCEN:1, ACKEN:1, ACKDT:1, ACKSTAT:1, GCEN:1; };)
+PIC_HOST_BITS(SSPSTAT,
+    struct { unsigned BF:1, UA:1, R_nW:1, S:1, P:1, D_nA:1, CKE:1, SMP:1; };
+    struct { unsigned :2, R_W:1, :2, D_A:1; };
+    struct { unsigned :2, nW:1, :2, nA:1; };)
+PIC_HOST_BITS(TXSTA, struct { unsigned TX9D:1, TRMT:1, BRGH:1, :1, SYNC:1, TXEN:1, TX9:1, CSRC:1; };)
+PIC_HOST_BITS(CMCON,
+    struct { unsigned CM0:1, CM1:1, CM2:1, CIS:1, C1INV:1, C2INV:1, C1OUT:1, C2OUT:1; };
+    struct { unsigned CM:3; };)
+PIC_HOST_BITS(CVRCON,
+    struct { unsigned CVR0:1, CVR1:1, CVR2:1, CVR3:1, :1, CVRR:1, CVROE:1, CVREN:1; };
+    struct { unsigned CVR:4; };)
+PIC_HOST_BITS(ADCON1,
+    struct { unsigned PCFG0:1, PCFG1:1, PCFG2:1, PCFG3:1, :2, ADCS2:1, ADFM:1; };
+    struct { unsigned PCFG:4; };)
+PIC_HOST_BITS(EECON1, struct { unsigned RD:1, WR:1, WREN:1, WRERR:1, :3, EEPGD:1; };)
+
+// 16-bit register pairs (little endian, like the TMRxL/TMRxH layout on the part)
+#define PIC_HOST_PAIR(name) \
+    typedef union { uint16_t name; struct { uint8_t name##L, name##H; }; } pic_##name##_t; \
+    extern volatile pic_##name##_t pic_##name;
+
+PIC_HOST_PAIR(TMR1)
+PIC_HOST_PAIR(CCPR1)
+PIC_HOST_PAIR(CCPR2)
+
+// Plain byte registers
+extern volatile uint8_t INDF, TMR0, PCL, FSR, PCLATH, TMR2, SSPBUF, TXREG, RCREG, ADRESH;
+extern volatile uint8_t PR2, SSPADD, SPBRG, ADRESL, EEADR, EEDATH, EEADRH, EECON2;
+
+// EEDATA goes through the EEPROM model, which performs a read started with EECON1bits.RD
+extern volatile uint8_t pic_host_EEDATA;
+volatile uint8_t *pic_host_eedata(void);
+#define EEDATA       (*pic_host_eedata())
+
+#define TMR1         pic_TMR1.TMR1
+#define TMR1L        pic_TMR1.TMR1L
+#define TMR1H        pic_TMR1.TMR1H
+#define CCPR1        pic_CCPR1.CCPR1
+#define CCPR1L       pic_CCPR1.CCPR1L
+#define CCPR1H       pic_CCPR1.CCPR1H
+#define CCPR2        pic_CCPR2.CCPR2
+#define CCPR2L       pic_CCPR2.CCPR2L
+#define CCPR2H       pic_CCPR2.CCPR2H
+
+// Byte names and single-bit aliases of the bit-addressable registers
+#define STATUS       STATUSbits.STATUS
+#define CARRY        STATUSbits.CARRY
+#define DC           STATUSbits.DC
+#define ZERO         STATUSbits.ZERO
+#define nPD          STATUSbits.nPD
+#define nTO          STATUSbits.nTO
+#define RP0          STATUSbits.RP0
+#define RP1          STATUSbits.RP1
+#define IRP          STATUSbits.IRP
+
+#define PORTA        PORTAbits.PORTA
+#define RA0          PORTAbits.RA0
+#define RA1          PORTAbits.RA1
+#define RA2          PORTAbits.RA2
+#define RA3          PORTAbits.RA3
+#define RA4          PORTAbits.RA4
+#define RA5          PORTAbits.RA5
+
+#define PORTB        PORTBbits.PORTB
+#define RB0          PORTBbits.RB0
+#define RB1          PORTBbits.RB1
+#define RB2          PORTBbits.RB2
+#define RB3          PORTBbits.RB3
+#define RB4          PORTBbits.RB4
+#define RB5          PORTBbits.RB5
+#define RB6          PORTBbits.RB6
+#define RB7          PORTBbits.RB7
+
+#define PORTC        PORTCbits.PORTC
+#define RC0          PORTCbits.RC0
+#define RC1          PORTCbits.RC1
+#define RC2          PORTCbits.RC2
+#define RC3          PORTCbits.RC3
+#define RC4          PORTCbits.RC4
+#define RC5          PORTCbits.RC5
+#define RC6          PORTCbits.RC6
+#define RC7          PORTCbits.RC7
+
+#define PORTD        PORTDbits.PORTD
+#define RD0          PORTDbits.RD0
+#define RD1          PORTDbits.RD1
+#define RD2          PORTDbits.RD2
+#define RD3          PORTDbits.RD3
+#define RD4          PORTDbits.RD4
+#define RD5          PORTDbits.RD5
+#define RD6          PORTDbits.RD6
+#define RD7          PORTDbits.RD7
+
+#define PORTE        PORTEbits.PORTE
+#define RE0          PORTEbits.RE0
+#define RE1          PORTEbits.RE1
+#define RE2          PORTEbits.RE2
+
+#define INTCON       INTCONbits.INTCON
+#define RBIF         INTCONbits.RBIF
+#define INTF         INTCONbits.INTF
+#define TMR0IF       INTCONbits.TMR0IF
+#define RBIE         INTCONbits.RBIE
+#define INTE         INTCONbits.INTE
+#define TMR0IE       INTCONbits.TMR0IE
+#define PEIE         INTCONbits.PEIE
+#define GIE          INTCONbits.GIE
+#define T0IF         INTCONbits.T0IF
+#define T0IE         INTCONbits.T0IE
+
+#define PIR1         PIR1bits.PIR1
+#define TMR1IF       PIR1bits.TMR1IF
+#define TMR2IF       PIR1bits.TMR2IF
+#define CCP1IF       PIR1bits.CCP1IF
+#define SSPIF        PIR1bits.SSPIF
+#define TXIF         PIR1bits.TXIF
+#define RCIF         PIR1bits.RCIF
+#define ADIF         PIR1bits.ADIF
+#define PSPIF        PIR1bits.PSPIF
+
+#define PIR2         PIR2bits.PIR2
+#define CCP2IF       PIR2bits.CCP2IF
+#define BCLIF        PIR2bits.BCLIF
+#define EEIF         PIR2bits.EEIF
+#define CMIF         PIR2bits.CMIF
+
+#define T1CON        T1CONbits.T1CON
+#define TMR1ON       T1CONbits.TMR1ON
+#define TMR1CS       T1CONbits.TMR1CS
+#define nT1SYNC      T1CONbits.nT1SYNC
+#define T1OSCEN      T1CONbits.T1OSCEN
+#define T1CKPS0      T1CONbits.T1CKPS0
+#define T1CKPS1      T1CONbits.T1CKPS1
+#define T1SYNC       T1CONbits.T1SYNC
+#define T1INSYNC     T1CONbits.T1INSYNC
+
+#define T2CON        T2CONbits.T2CON
+#define T2CKPS0      T2CONbits.T2CKPS0
+#define T2CKPS1      T2CONbits.T2CKPS1
+#define TMR2ON       T2CONbits.TMR2ON
+#define TOUTPS0      T2CONbits.TOUTPS0
+#define TOUTPS1      T2CONbits.TOUTPS1
+#define TOUTPS2      T2CONbits.TOUTPS2
+#define TOUTPS3      T2CONbits.TOUTPS3
+
+#define SSPCON       SSPCONbits.SSPCON
+#define SSPM0        SSPCONbits.SSPM0
+#define SSPM1        SSPCONbits.SSPM1
+#define SSPM2        SSPCONbits.SSPM2
+#define SSPM3        SSPCONbits.SSPM3
+#define CKP          SSPCONbits.CKP
+#define SSPEN        SSPCONbits.SSPEN
+#define SSPOV        SSPCONbits.SSPOV
+#define WCOL         SSPCONbits.WCOL
+
+#define CCP1CON      CCP1CONbits.CCP1CON
+#define CCP1M0       CCP1CONbits.CCP1M0
+#define CCP1M1       CCP1CONbits.CCP1M1
+#define CCP1M2       CCP1CONbits.CCP1M2
+#define CCP1M3       CCP1CONbits.CCP1M3
+#define CCP1Y        CCP1CONbits.CCP1Y
+#define CCP1X        CCP1CONbits.CCP1X
+
+#define RCSTA        RCSTAbits.RCSTA
+#define RX9D         RCSTAbits.RX9D
+#define OERR         RCSTAbits.OERR
+#define FERR         RCSTAbits.FERR
+#define ADDEN        RCSTAbits.ADDEN
+#define CREN         RCSTAbits.CREN
+#define SREN         RCSTAbits.SREN
+#define RX9          RCSTAbits.RX9
+#define SPEN         RCSTAbits.SPEN
+
+#define CCP2CON      CCP2CONbits.CCP2CON
+#define CCP2M0       CCP2CONbits.CCP2M0
+#define CCP2M1       CCP2CONbits.CCP2M1
+#define CCP2M2       CCP2CONbits.CCP2M2
+#define CCP2M3       CCP2CONbits.CCP2M3
+#define CCP2Y        CCP2CONbits.CCP2Y
+#define CCP2X        CCP2CONbits.CCP2X
+
+#define ADCON0       ADCON0bits.ADCON0
+#define ADON         ADCON0bits.ADON
+#define GO_DONE      ADCON0bits.GO_DONE
+#define CHS0         ADCON0bits.CHS0
+#define CHS1         ADCON0bits.CHS1
+#define CHS2         ADCON0bits.CHS2
+#define ADCS0        ADCON0bits.ADCS0
+#define ADCS1        ADCON0bits.ADCS1
+#define GO           ADCON0bits.GO
+#define nDONE        ADCON0bits.nDONE
+#define GO_nDONE     ADCON0bits.GO_nDONE
+
+#define OPTION_REG   OPTION_REGbits.OPTION_REG
+#define PS0          OPTION_REGbits.PS0
+#define PS1          OPTION_REGbits.PS1
+#define PS2          OPTION_REGbits.PS2
+#define PSA          OPTION_REGbits.PSA
+#define T0SE         OPTION_REGbits.T0SE
+#define T0CS         OPTION_REGbits.T0CS
+#define INTEDG       OPTION_REGbits.INTEDG
+#define nRBPU        OPTION_REGbits.nRBPU
+
+#define TRISA        TRISAbits.TRISA
+#define TRISA0       TRISAbits.TRISA0
+#define TRISA1       TRISAbits.TRISA1
+#define TRISA2       TRISAbits.TRISA2
+#define TRISA3       TRISAbits.TRISA3
+#define TRISA4       TRISAbits.TRISA4
+#define TRISA5       TRISAbits.TRISA5
+
+#define TRISB        TRISBbits.TRISB
+#define TRISB0       TRISBbits.TRISB0
+#define TRISB1       TRISBbits.TRISB1
+#define TRISB2       TRISBbits.TRISB2
+#define TRISB3       TRISBbits.TRISB3
+#define TRISB4       TRISBbits.TRISB4
+#define TRISB5       TRISBbits.TRISB5
+#define TRISB6       TRISBbits.TRISB6
+#define TRISB7       TRISBbits.TRISB7
+
+#define TRISC        TRISCbits.TRISC
+#define TRISC0       TRISCbits.TRISC0
+#define TRISC1       TRISCbits.TRISC1
+#define TRISC2       TRISCbits.TRISC2
+#define TRISC3       TRISCbits.TRISC3
+#define TRISC4       TRISCbits.TRISC4
+#define TRISC5       TRISCbits.TRISC5
+#define TRISC6       TRISCbits.TRISC6
+#define TRISC7       TRISCbits.TRISC7
+
+#define TRISD        TRISDbits.TRISD
+#define TRISD0       TRISDbits.TRISD0
+#define TRISD1       TRISDbits.TRISD1
+#define TRISD2       TRISDbits.TRISD2
+#define TRISD3       TRISDbits.TRISD3
+#define TRISD4       TRISDbits.TRISD4
+#define TRISD5       TRISDbits.TRISD5
+#define TRISD6       TRISDbits.TRISD6
+#define TRISD7       TRISDbits.TRISD7
+
+#define TRISE        TRISEbits.TRISE
+#define TRISE0       TRISEbits.TRISE0
+#define TRISE1       TRISEbits.TRISE1
+#define TRISE2       TRISEbits.TRISE2
+#define PSPMODE      TRISEbits.PSPMODE
+#define IBOV         TRISEbits.IBOV
+#define OBF          TRISEbits.OBF
+#define IBF          TRISEbits.IBF
+
+#define PIE1         PIE1bits.PIE1
+#define TMR1IE       PIE1bits.TMR1IE
+#define TMR2IE       PIE1bits.TMR2IE
+#define CCP1IE       PIE1bits.CCP1IE
+#define SSPIE        PIE1bits.SSPIE
+#define TXIE         PIE1bits.TXIE
+#define RCIE         PIE1bits.RCIE
+#define ADIE         PIE1bits.ADIE
+#define PSPIE        PIE1bits.PSPIE
+
+#define PIE2         PIE2bits.PIE2
+#define CCP2IE       PIE2bits.CCP2IE
+#define BCLIE        PIE2bits.BCLIE
+#define EEIE         PIE2bits.EEIE
+#define CMIE         PIE2bits.CMIE
+
+#define PCON         PCONbits.PCON
+#define nBOR         PCONbits.nBOR
+#define nPOR         PCONbits.nPOR
+
+#define SSPCON2      SSPCON2bits.SSPCON2
+#define SEN          SSPCON2bits.SEN
+#define RSEN         SSPCON2bits.RSEN
+#define PEN          SSPCON2bits.PEN
+#define RCEN         SSPCON2bits.RCEN
+#define ACKEN        SSPCON2bits.ACKEN
+#define ACKDT        SSPCON2bits.ACKDT
+#define ACKSTAT      SSPCON2bits.ACKSTAT
+#define GCEN         SSPCON2bits.GCEN
+
+#define SSPSTAT      SSPSTATbits.SSPSTAT
+#define BF           SSPSTATbits.BF
+#define UA           SSPSTATbits.UA
+#define R_nW         SSPSTATbits.R_nW
+#define R_W          SSPSTATbits.R_W
+#define nW           SSPSTATbits.nW
+#define D_nA         SSPSTATbits.D_nA
+#define D_A          SSPSTATbits.D_A
+#define nA           SSPSTATbits.nA
+#define CKE          SSPSTATbits.CKE
+#define SMP          SSPSTATbits.SMP
+
+#define TXSTA        TXSTAbits.TXSTA
+#define TX9D         TXSTAbits.TX9D
+#define TRMT         TXSTAbits.TRMT
+#define BRGH         TXSTAbits.BRGH
+#define SYNC         TXSTAbits.SYNC
+#define TXEN         TXSTAbits.TXEN
+#define TX9          TXSTAbits.TX9
+#define CSRC         TXSTAbits.CSRC
+
+#define CMCON        CMCONbits.CMCON
+#define CM0          CMCONbits.CM0
+#define CM1          CMCONbits.CM1
+#define CM2          CMCONbits.CM2
+#define CIS          CMCONbits.CIS
+#define C1INV        CMCONbits.C1INV
+#define C2INV        CMCONbits.C2INV
+#define C1OUT        CMCONbits.C1OUT
+#define C2OUT        CMCONbits.C2OUT
+
+#define CVRCON       CVRCONbits.CVRCON
+#define CVR0         CVRCONbits.CVR0
+#define CVR1         CVRCONbits.CVR1
+#define CVR2         CVRCONbits.CVR2
+#define CVR3         CVRCONbits.CVR3
+#define CVRR         CVRCONbits.CVRR
+#define CVROE        CVRCONbits.CVROE
+#define CVREN        CVRCONbits.CVREN
+
+#define ADCON1       ADCON1bits.ADCON1
+#define PCFG0        ADCON1bits.PCFG0
+#define PCFG1        ADCON1bits.PCFG1
+#define PCFG2        ADCON1bits.PCFG2
+#define PCFG3        ADCON1bits.PCFG3
+#define ADCS2        ADCON1bits.ADCS2
+#define ADFM         ADCON1bits.ADFM
+
+#define EECON1       EECON1bits.EECON1
+#define WR           EECON1bits.WR
+#define WREN         EECON1bits.WREN
+#define WRERR        EECON1bits.WRERR
+#define EEPGD        EECON1bits.EEPGD
+
+/* -------------------------------------------------------------------------------------
+ * Built-ins
+ * -------------------------------------------------------------------------------------*/
+
+// Virtual instruction cycles (Fosc / 4) consumed by delays, CLRWDT(), NOP() and tests
+extern volatile uint64_t pic_host_cycles;
+
+// Number of CLRWDT() and SLEEP() executions since the last reset
+extern volatile uint32_t pic_host_wdt_clears;
+extern volatile uint32_t pic_host_sleeps;
+
+// Optional callback run after each delay, e.g. to move peripherals forward in time
+extern void (*pic_host_delay_hook)(unsigned long cycles);
+
+void pic_host_delay(unsigned long cycles);
+void pic_host_clrwdt(void);
+void pic_host_sleep(void);
+
+// Data EEPROM model (erased to 0xFF by pic_host_reset()). A read started with
+// 'EECON1bits.RD = 1' loads EEDATA from pic_host_eeprom[EEADR] and clears RD at the next
+// access to EEDATA, which is where the hardware result is first visible; a write started with WR = 1 stays in progress
+// until pic_host_eeprom_complete() stores EEDATA, clears WR and sets EEIF (returns 1), or
+// returns 0 with no write in progress.
+extern uint8_t pic_host_eeprom[256];
+extern uint32_t pic_host_eeprom_writes;
+int pic_host_eeprom_complete(void);
+
+// Put every SFR back in its power-on reset state and clear the counters above
+void pic_host_reset(void);
+
+// Look up an SFR by data memory address (NULL if unimplemented) or by name
+volatile uint8_t *pic_host_sfr(uint16_t address);
+volatile uint8_t *pic_host_sfr_by_name(const char *name);
+
+#define _delay(x)       pic_host_delay((unsigned long)(x))
+#define __delay_ms(x)   _delay((unsigned long)((x) * (_XTAL_FREQ / 4000.0)))
+#define __delay_us(x)   _delay((unsigned long)((x) * (_XTAL_FREQ / 4000000.0)))
+#define CLRWDT()        pic_host_clrwdt()
+#define SLEEP()         pic_host_sleep()
+#define NOP()           pic_host_delay(1)
+#define ei()            (GIE = 1)
+#define di()            (GIE = 0)
+
+#endif /* PIC_HOST_XC_H */
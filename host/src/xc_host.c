@@ -0,0 +1,172 @@
+/* File:   xc_host.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Storage and built-ins for the host <xc.h> shim: one global per SFR, power-on reset
+ * values, an address/name lookup table and the virtual cycle counter behind the delays.
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include <xc.h>
+
+// The SFR table needs the EEDATA storage itself, not the model's accessor
+#undef EEDATA
+#define EEDATA pic_host_EEDATA
+
+// Register storage
+#define PIC_HOST_DEFINE_BITS(name) volatile name##bits_t name##bits;
+PIC_HOST_DEFINE_BITS(STATUS)
+PIC_HOST_DEFINE_BITS(PORTA)
+PIC_HOST_DEFINE_BITS(PORTB)
+PIC_HOST_DEFINE_BITS(PORTC)
+PIC_HOST_DEFINE_BITS(PORTD)
+PIC_HOST_DEFINE_BITS(PORTE)
+PIC_HOST_DEFINE_BITS(INTCON)
+PIC_HOST_DEFINE_BITS(PIR1)
+PIC_HOST_DEFINE_BITS(PIR2)
+PIC_HOST_DEFINE_BITS(T1CON)
+PIC_HOST_DEFINE_BITS(T2CON)
+PIC_HOST_DEFINE_BITS(SSPCON)
+PIC_HOST_DEFINE_BITS(CCP1CON)
+PIC_HOST_DEFINE_BITS(RCSTA)
+PIC_HOST_DEFINE_BITS(CCP2CON)
+PIC_HOST_DEFINE_BITS(ADCON0)
+PIC_HOST_DEFINE_BITS(OPTION_REG)
+PIC_HOST_DEFINE_BITS(TRISA)
+PIC_HOST_DEFINE_BITS(TRISB)
+PIC_HOST_DEFINE_BITS(TRISC)
+PIC_HOST_DEFINE_BITS(TRISD)
+PIC_HOST_DEFINE_BITS(TRISE)
+PIC_HOST_DEFINE_BITS(PIE1)
+PIC_HOST_DEFINE_BITS(PIE2)
+PIC_HOST_DEFINE_BITS(PCON)
+PIC_HOST_DEFINE_BITS(SSPCON2)
+PIC_HOST_DEFINE_BITS(SSPSTAT)
+PIC_HOST_DEFINE_BITS(TXSTA)
+PIC_HOST_DEFINE_BITS(CMCON)
+PIC_HOST_DEFINE_BITS(CVRCON)
+PIC_HOST_DEFINE_BITS(ADCON1)
+PIC_HOST_DEFINE_BITS(EECON1)
+
+volatile pic_TMR1_t pic_TMR1;
+volatile pic_CCPR1_t pic_CCPR1;
+volatile pic_CCPR2_t pic_CCPR2;
+
+volatile uint8_t INDF, TMR0, PCL, FSR, PCLATH, TMR2, SSPBUF, TXREG, RCREG, ADRESH;
+volatile uint8_t PR2, SSPADD, SPBRG, ADRESL, EEDATA, EEADR, EEDATH, EEADRH, EECON2;
+
+volatile uint64_t pic_host_cycles;
+volatile uint32_t pic_host_wdt_clears;
+volatile uint32_t pic_host_sleeps;
+void (*pic_host_delay_hook)(unsigned long cycles);
+
+uint8_t pic_host_eeprom[256];
+uint32_t pic_host_eeprom_writes;
+
+// Address map built from the register list in xc.h
+typedef struct {
+    const char *name;
+    uint16_t address;
+    volatile uint8_t *reg;
+} pic_host_sfr_t;
+
+#define PIC_HOST_SFR_ENTRY(name, address) { #name, address, (volatile uint8_t *)&(name) },
+static const pic_host_sfr_t sfr_table[] = {
+    PIC_HOST_SFR_LIST(PIC_HOST_SFR_ENTRY)
+};
+#define SFR_COUNT (sizeof(sfr_table) / sizeof(sfr_table[0]))
+
+void pic_host_reset(void)
+{
+    size_t i;
+    for (i = 0; i < SFR_COUNT; i++) {
+        *sfr_table[i].reg = 0x00;
+    }
+
+    // Non-zero power-on reset values (PIC16F877A datasheet, Table 2-1)
+    STATUS = 0x18;      // nTO = nPD = 1
+    OPTION_REG = 0xFF;
+    TRISA = 0x3F;
+    TRISB = 0xFF;
+    TRISC = 0xFF;
+    TRISD = 0xFF;
+    TRISE = 0x07;
+    PR2 = 0xFF;
+    TXSTA = 0x02;       // TRMT = 1: transmit shift register empty
+    CMCON = 0x07;
+    PCON = 0x03;
+    PIR1bits.TXIF = 1;  // TXREG empty
+
+    pic_host_cycles = 0;
+    pic_host_wdt_clears = 0;
+    pic_host_sleeps = 0;
+    pic_host_delay_hook = NULL;
+
+    memset(pic_host_eeprom, 0xFF, sizeof(pic_host_eeprom));
+    pic_host_eeprom_writes = 0;
+}
+
+volatile uint8_t *pic_host_sfr(uint16_t address)
+{
+    size_t i;
+    for (i = 0; i < SFR_COUNT; i++) {
+        if (sfr_table[i].address == address) {
+            return sfr_table[i].reg;
+        }
+    }
+    return NULL;
+}
+
+volatile uint8_t *pic_host_sfr_by_name(const char *name)
+{
+    size_t i;
+    for (i = 0; i < SFR_COUNT; i++) {
+        if (strcmp(sfr_table[i].name, name) == 0) {
+            return sfr_table[i].reg;
+        }
+    }
+    return NULL;
+}
+
+void pic_host_delay(unsigned long cycles)
+{
+    pic_host_cycles += cycles;
+    if (pic_host_delay_hook != NULL) {
+        pic_host_delay_hook(cycles);
+    }
+}
+
+void pic_host_clrwdt(void)
+{
+    pic_host_wdt_clears++;
+    pic_host_delay(1);
+}
+
+void pic_host_sleep(void)
+{
+    pic_host_sleeps++;
+    pic_host_delay(1);
+}
+
+volatile uint8_t *pic_host_eedata(void)
+{
+    // The read takes one cycle on the part: RD is back to 0 by the time EEDATA is read
+    if (EECON1bits.RD) {
+        EEDATA = pic_host_eeprom[EEADR];
+        EECON1bits.RD = 0;
+    }
+    return &EEDATA;
+}
+
+int pic_host_eeprom_complete(void)
+{
+    if (!WR) {
+        return 0;
+    }
+    pic_host_eeprom[EEADR] = EEDATA;
+    pic_host_eeprom_writes++;
+    WR = 0;
+    EEIF = 1;
+    return 1;
+}
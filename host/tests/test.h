@@ -0,0 +1,45 @@
+/* File:   test.h
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Minimal assertion helpers for the host unit tests. Each test file is its own program:
+ * it runs its test functions through RUN_TEST() and returns TEST_RESULT() from main().
+ */
+
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <stdio.h>
+#include <xc.h>
+
+static int test_failures = 0;
+static int test_count = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("  %s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        test_failures++; \
+    } \
+} while (0)
+
+#define CHECK_EQ(actual, expected) do { \
+    long long check_a_ = (long long)(actual); \
+    long long check_e_ = (long long)(expected); \
+    if (check_a_ != check_e_) { \
+        printf("  %s:%d: %s == %lld, expected %lld\n", __FILE__, __LINE__, #actual, check_a_, check_e_); \
+        test_failures++; \
+    } \
+} while (0)
+
+// Every test starts from power-on register values
+#define RUN_TEST(fn) do { \
+    int failures_before_ = test_failures; \
+    pic_host_reset(); \
+    fn(); \
+    test_count++; \
+    printf("%s %s\n", test_failures == failures_before_ ? "PASS" : "FAIL", #fn); \
+} while (0)
+
+#define TEST_RESULT() (printf("%d test(s), %d failure(s)\n", test_count, test_failures), test_failures != 0)
+
+#endif /* HOST_TEST_H */
@@ -0,0 +1,179 @@
+/* File:   test_adc_scan.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Host tests for the interrupt-driven ADC scanner of 01-PIC16F_ADC (adc_scan.c).
+ * Each conversion is simulated by loading ADRESH:ADRESL, setting ADIF and calling the ISR,
+ * as the special event trigger and the A/D module would.
+ */
+
+#include <xc.h>
+#include "test.h"
+#include "../../01-PIC16F_ADC/TUTO_02.X/adc_scan.h"
+
+static const uint8_t four_channels[] = { 0, 1, 2, 3 };
+
+// Last buffer delivered to the callback
+static uint16_t got_samples[ADC_SCAN_BUFFER_SIZE];
+static uint8_t got_scans;
+static uint8_t got_channels;
+static int callbacks;
+
+static void on_ready(const uint16_t *samples, uint8_t scans, uint8_t channels)
+{
+    uint8_t i;
+    for (i = 0; i < scans * channels; i++) {
+        got_samples[i] = samples[i];
+    }
+    got_scans = scans;
+    got_channels = channels;
+    callbacks++;
+}
+
+// Finish one conversion: the result encodes the channel that was selected
+static void convert(uint16_t value)
+{
+    ADRESH = (uint8_t)(value >> 8);
+    ADRESL = (uint8_t)value;
+    ADIF = 1;
+    adc_scan_isr();
+}
+
+static uint16_t sample_value(uint8_t scan)
+{
+    return (uint16_t)(ADCON0bits.CHS * 100 + scan);
+}
+
+// Run n full scans, each conversion returning sample_value()
+static void run_scans(uint8_t count, uint8_t first_scan, uint8_t n)
+{
+    uint8_t s, c;
+    for (s = 0; s < n; s++) {
+        for (c = 0; c < count; c++) {
+            convert(sample_value((uint8_t)(first_scan + s)));
+        }
+    }
+}
+
+static void test_init_configures_trigger(void)
+{
+    callbacks = 0;
+    adc_scan_init(four_channels, 4, on_ready);
+    CHECK_EQ(CCP2CON, 0x0B);                                    // Compare, special event
+    CHECK_EQ(CCPR2, ADC_FCY / (ADC_SCAN_RATE_HZ * 4UL) - 1);   // 1 kHz scan of 4 channels at 4 MHz
+    CHECK_EQ(CCPR2, 249);
+    CHECK_EQ(ADCON0bits.ADON, 1);
+    CHECK_EQ(ADCON0bits.CHS, 0);
+    CHECK_EQ(ADCON1bits.ADFM, 1);
+    CHECK_EQ(ADIE, 1);
+    CHECK_EQ(PEIE, 1);
+    CHECK_EQ(GIE, 1);
+    CHECK_EQ(TMR1ON, 0);
+    adc_scan_start();
+    CHECK_EQ(TMR1ON, 1);
+}
+
+static void test_trigger_leaves_time_to_acquire(void)
+{
+    // Fosc/8 at 4 MHz: TAD = 2 us, 24 us conversion; 20 us acquisition
+    CHECK_EQ(ADC_TAD_DIV, 8);
+    CHECK(ADC_FCY / (ADC_SCAN_RATE_HZ * (unsigned long)ADC_SCAN_MAX_CHANNELS) >= ADC_TRIGGER_MIN_TCY);
+}
+
+static void test_channels_follow_scan_list(void)
+{
+    static const uint8_t list[] = { 5, 2, 7 };
+    adc_scan_init(list, 3, on_ready);
+    adc_scan_start();
+    CHECK_EQ(ADCON0bits.CHS, 5);
+    convert(0);
+    CHECK_EQ(ADCON0bits.CHS, 2);
+    convert(0);
+    CHECK_EQ(ADCON0bits.CHS, 7);
+    convert(0);
+    CHECK_EQ(ADCON0bits.CHS, 5);
+    CHECK_EQ(ADIF, 0);
+}
+
+static void test_full_buffer_reaches_callback(void)
+{
+    uint8_t s, c;
+    callbacks = 0;
+    adc_scan_init(four_channels, 4, on_ready);
+    adc_scan_start();
+
+    run_scans(4, 0, ADC_SCAN_DEPTH - 1);
+    CHECK_EQ(adc_scan_poll(), 0);
+    run_scans(4, ADC_SCAN_DEPTH - 1, 1);
+    CHECK_EQ(adc_scan_poll(), 1);
+    CHECK_EQ(callbacks, 1);
+    CHECK_EQ(got_scans, ADC_SCAN_DEPTH);
+    CHECK_EQ(got_channels, 4);
+    for (s = 0; s < ADC_SCAN_DEPTH; s++) {
+        for (c = 0; c < 4; c++) {
+            CHECK_EQ(got_samples[s * 4 + c], c * 100 + s);
+        }
+    }
+    CHECK_EQ(adc_scan_poll(), 0);
+}
+
+static void test_ping_pong_keeps_sampling(void)
+{
+    callbacks = 0;
+    adc_scan_init(four_channels, 4, on_ready);
+    adc_scan_start();
+
+    // First buffer is ready; the second fills while it waits
+    run_scans(4, 0, ADC_SCAN_DEPTH);
+    run_scans(4, 10, ADC_SCAN_DEPTH - 1);
+    CHECK_EQ(adc_scan_poll(), 1);
+    CHECK_EQ(got_samples[0], 0);
+    run_scans(4, 10 + ADC_SCAN_DEPTH - 1, 1);
+    CHECK_EQ(adc_scan_poll(), 1);
+    CHECK_EQ(got_samples[0], 10);
+    CHECK_EQ(got_samples[4 * ADC_SCAN_DEPTH - 1], 300 + 10 + ADC_SCAN_DEPTH - 1);
+    CHECK_EQ(callbacks, 2);
+    CHECK_EQ(adc_scan_overruns(), 0);
+}
+
+static void test_unpolled_buffer_counts_overrun(void)
+{
+    callbacks = 0;
+    adc_scan_init(four_channels, 4, on_ready);
+    adc_scan_start();
+
+    run_scans(4, 0, ADC_SCAN_DEPTH);
+    run_scans(4, 20, ADC_SCAN_DEPTH);
+    CHECK_EQ(adc_scan_overruns(), 1);
+
+    // The buffer that was ready first is still intact
+    CHECK_EQ(adc_scan_poll(), 1);
+    CHECK_EQ(got_samples[0], 0);
+    CHECK_EQ(adc_scan_poll(), 0);
+}
+
+static void test_stop_masks_interrupt(void)
+{
+    callbacks = 0;
+    adc_scan_init(four_channels, 4, on_ready);
+    adc_scan_start();
+    adc_scan_stop();
+    CHECK_EQ(TMR1ON, 0);
+    CHECK_EQ(ADIE, 0);
+    CHECK_EQ(adc_scan_overruns(), 0);
+    CHECK_EQ(ADIE, 0);                  // Reading the counter does not re-enable it
+    run_scans(4, 0, ADC_SCAN_DEPTH);
+    CHECK_EQ(adc_scan_poll(), 0);
+}
+
+int main(void)
+{
+    RUN_TEST(test_init_configures_trigger);
+    RUN_TEST(test_trigger_leaves_time_to_acquire);
+    RUN_TEST(test_channels_follow_scan_list);
+    RUN_TEST(test_full_buffer_reaches_callback);
+    RUN_TEST(test_ping_pong_keeps_sampling);
+    RUN_TEST(test_unpolled_buffer_counts_overrun);
+    RUN_TEST(test_stop_masks_interrupt);
+    return TEST_RESULT();
+}
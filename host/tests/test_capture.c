@@ -0,0 +1,243 @@
+/* File:   test_capture.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Host tests for the 32-bit input capture engine of 09 capture mode (capture.c).
+ * run_signal() plays Timer1 and CCP1 against a square wave of a given period: Timer1
+ * overflows and the captured edges are delivered in time order, each followed by the ISR.
+ * With 'late' set, an overflow and a capture close to it are delivered to one ISR call,
+ * as when the interrupt is held off, to exercise the capture/overflow race.
+ */
+
+#include <xc.h>
+#include "test.h"
+#include "../../09-TIMRER_COMPARE_CAPTURE/TUTO_10.X/capture.h"
+
+static unsigned long long now;          // Timer1 ticks
+static unsigned long long next_edge;
+static unsigned edge_count;
+static unsigned lose_captures;          // Captures overwritten before the ISR runs
+
+static void start(uint8_t prescale, unsigned long long first_edge)
+{
+    capture_init(prescale);
+    now = 0;
+    next_edge = first_edge;
+    edge_count = 0;
+    lose_captures = 0;
+}
+
+static uint8_t edges_per_capture(void)
+{
+    uint8_t mode = CCP1CON & 0x0F;
+    return mode == 0x07 ? 16 : mode == 0x06 ? 4 : 1;
+}
+
+// Advance to 'until', delivering overflows and edges. With 'late', an edge within 'late'
+// ticks after an overflow is delivered in the same ISR call as the overflow, and so is an
+// overflow within 'late' ticks after an edge.
+static void run_signal(unsigned long long period, unsigned long long until, unsigned long long late)
+{
+    unsigned long long next_ovf = (now / 65536 + 1) * 65536;
+
+    while (1) {
+        int edge_first = next_edge <= next_ovf;
+        unsigned long long t = edge_first ? next_edge : next_ovf;
+        if (t > until) {
+            break;
+        }
+        now = t;
+        if (edge_first) {
+            if (++edge_count % edges_per_capture() == 0) {
+                CCPR1 = (uint16_t)now;
+                CCP1IF = 1;
+                if (lose_captures) {
+                    lose_captures--;    // The next capture overwrites CCPR1
+                    next_edge += period;
+                    continue;
+                }
+            }
+            next_edge += period;
+            if (late && next_ovf - now <= late) {
+                continue;               // ISR delayed past the overflow
+            }
+        } else {
+            TMR1IF = 1;
+            next_ovf += 65536;
+            if (late && next_edge - now <= late) {
+                continue;               // ISR delayed past the next edge
+            }
+        }
+        capture_isr();
+    }
+    now = until;
+}
+
+static void test_init(void)
+{
+    start(1, 100);
+    CHECK_EQ(T1CON, 0x01);              // Fosc/4, 1:1, on
+    CHECK_EQ(CCP1CON, 0x05);            // Every rising edge
+    CHECK_EQ(TRISC2, 1);
+    CHECK_EQ(CCP1IE, 1);
+    CHECK_EQ(TMR1IE, 1);
+    capture_set_prescale(4);
+    CHECK_EQ(CCP1CON, 0x06);
+    capture_set_prescale(16);
+    CHECK_EQ(CCP1CON, 0x07);
+}
+
+static void test_short_period(void)
+{
+    capture_result_t r;
+
+    start(1, 100);
+    run_signal(1000, 20000, 0);         // 1 kHz
+    capture_get(&r);
+    CHECK_EQ(r.captures, CAPTURE_AVG_SIZE);
+    CHECK_EQ(r.ticks, 1000UL * CAPTURE_AVG_SIZE);
+    CHECK_EQ(capture_period_ticks(&r), 1000);
+    CHECK_EQ(capture_frequency_mhz(&r), 1000000);
+}
+
+static void test_period_longer_than_timer1(void)
+{
+    capture_result_t r;
+
+    // 0.5 Hz: 2,000,000 ticks between edges, 30 Timer1 overflows
+    start(1, 12345);
+    run_signal(2000000, 3 * 2000000ULL + 20000, 0);
+    capture_get(&r);
+    CHECK_EQ(r.captures, 3);
+    CHECK_EQ(capture_period_ticks(&r), 2000000);
+    CHECK_EQ(capture_frequency_mhz(&r), 500);
+}
+
+static void test_overflow_race(void)
+{
+    capture_result_t r;
+
+    // Period of 65536 + 3 ticks: the edges drift across the overflow, some landing just
+    // after it and some just before, with the ISR delayed past both
+    start(1, 65536 - 40);
+    run_signal(65539, 65539ULL * 40, 64);
+    capture_get(&r);
+    CHECK_EQ(r.captures, CAPTURE_AVG_SIZE);
+    CHECK_EQ(r.ticks, 65539UL * CAPTURE_AVG_SIZE);
+
+    // Same with a period just below the overflow
+    start(1, 30);
+    run_signal(65533, 65533ULL * 40, 64);
+    capture_get(&r);
+    CHECK_EQ(r.ticks, 65533UL * CAPTURE_AVG_SIZE);
+}
+
+static void test_prescaled_fast_signal(void)
+{
+    capture_result_t r;
+
+    // Arithmetic only: on the chip these rates are above CAPTURE_MAX_HZ
+    // 200 kHz: 5 ticks per period, one capture every 16 edges
+    start(16, 3);
+    run_signal(5, 5 * 16 * 20, 0);
+    capture_get(&r);
+    CHECK_EQ(r.prescale, 16);
+    CHECK_EQ(r.captures, CAPTURE_AVG_SIZE);
+    CHECK_EQ(r.ticks, 5UL * 16 * CAPTURE_AVG_SIZE);
+    CHECK_EQ(capture_period_ticks(&r), 5);
+    CHECK_EQ(capture_frequency_mhz(&r), 200000000UL);
+
+    // 3 ticks per period is not an integer frequency: 333333.333 Hz
+    start(4, 7);
+    run_signal(3, 3 * 4 * 20, 0);
+    capture_get(&r);
+    CHECK_EQ(capture_frequency_mhz(&r), 333333333UL);
+}
+
+static void test_rolling_average(void)
+{
+    capture_result_t r;
+    unsigned i;
+
+    start(1, 10);
+    run_signal(1000, 10 + 1000 * CAPTURE_AVG_SIZE, 0);
+    run_signal(1100, now + 1100 * (CAPTURE_AVG_SIZE / 2), 0);
+    capture_get(&r);
+    // The edge already scheduled still ends a 1000-tick interval, then three of 1100
+    CHECK_EQ(r.ticks, 1000UL * (CAPTURE_AVG_SIZE / 2 + 1) + 1100UL * (CAPTURE_AVG_SIZE / 2 - 1));
+    for (i = 0; i < CAPTURE_AVG_SIZE; i++) {
+        run_signal(1100, now + 1100, 0);
+    }
+    capture_get(&r);
+    CHECK_EQ(capture_period_ticks(&r), 1100);
+}
+
+static void test_lost_capture_is_dropped(void)
+{
+    capture_result_t r;
+
+    // One capture lost: a 2000-tick interval that must not pull the average to 1125
+    start(1, 10);
+    run_signal(1000, 10 + 1000 * 4, 0);
+    lose_captures = 1;
+    run_signal(1000, now + 1000 * (CAPTURE_AVG_SIZE + 2), 0);
+    capture_get(&r);
+    CHECK_EQ(r.dropped, 1);
+    CHECK_EQ(capture_period_ticks(&r), 1000);
+    CHECK_EQ(CAPTURE_MAX_HZ, 62500);    // Below the 65535 Hz of the display at 4 MHz
+    CHECK_EQ(r.ticks, 1000UL * CAPTURE_AVG_SIZE);
+
+    // A step down in frequency costs one interval, the next one is kept
+    run_signal(2500, now + 2500 * 3, 0);
+    capture_get(&r);
+    CHECK_EQ(r.dropped, 2);
+    // The edge already scheduled ends a 1000-tick interval, then 2500 dropped, 2500 kept
+    CHECK_EQ(r.ticks, 1000UL * (CAPTURE_AVG_SIZE - 1) + 2500UL);
+}
+
+static void test_signal_lost(void)
+{
+    capture_result_t r;
+
+    start(1, 10);
+    run_signal(1000, 10000, 0);
+    capture_get(&r);
+    CHECK(r.captures > 0);
+    next_edge = ~0ULL;                  // Input stops
+    run_signal(1000, now + 65536ULL * (CAPTURE_TIMEOUT_OVERFLOWS + 1), 0);
+    capture_get(&r);
+    CHECK_EQ(r.captures, 0);
+    CHECK_EQ(capture_frequency_mhz(&r), 0);
+    CHECK_EQ(capture_period_ticks(&r), 0);
+}
+
+static void test_prescale_change_restarts_average(void)
+{
+    capture_result_t r;
+
+    start(1, 10);
+    run_signal(100, 5000, 0);
+    capture_set_prescale(4);
+    capture_get(&r);
+    CHECK_EQ(r.captures, 0);
+    CHECK_EQ(r.prescale, 4);
+    edge_count = 0;
+    run_signal(100, now + 400 * 3 + 50, 0);
+    capture_get(&r);
+    CHECK_EQ(r.captures, 2);
+    CHECK_EQ(capture_period_ticks(&r), 100);
+}
+
+int main(void)
+{
+    RUN_TEST(test_init);
+    RUN_TEST(test_short_period);
+    RUN_TEST(test_period_longer_than_timer1);
+    RUN_TEST(test_overflow_race);
+    RUN_TEST(test_prescaled_fast_signal);
+    RUN_TEST(test_rolling_average);
+    RUN_TEST(test_lost_capture_is_dropped);
+    RUN_TEST(test_signal_lost);
+    RUN_TEST(test_prescale_change_restarts_average);
+    return TEST_RESULT();
+}
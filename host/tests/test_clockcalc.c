@@ -0,0 +1,164 @@
+/* File:   test_clockcalc.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Host tests for the compile-time clock calculators of common/clockcalc.h: the register values
+ * used by the projects, and an exhaustive search over every divider for a range of crystals
+ * and rates that the selected BRGH/prescaler/divider must match.
+ */
+
+#include <xc.h>
+#include "test.h"
+
+#define _XTAL_FREQ     16000000
+#define UART_BAUD_RATE 9600
+#define I2C_BAUD_RATE  100000
+#define TMR2_RATE_HZ   1000
+#define TMR1_RATE_HZ   50
+#include "../../common/clockcalc.h"
+
+static const unsigned long crystals[] = {
+    1000000, 3686400, 4000000, 8000000, 11059200, 16000000, 18432000, 20000000
+};
+#define CRYSTAL_COUNT (sizeof(crystals) / sizeof(crystals[0]))
+
+static unsigned long long abs_diff(unsigned long long a, unsigned long long b)
+{
+    return a > b ? a - b : b - a;
+}
+
+static void test_project_values(void)
+{
+    // Divisors that used to be written by hand in the projects
+    CHECK_EQ(CLK_UART_BRGH(16000000, 9600), 1);
+    CHECK_EQ(CLK_UART_SPBRG(16000000, 9600, 1), 103);   // 03-PIC16F_UART
+    CHECK_EQ(CLK_UART_SPBRG(8000000, 9600, 1), 51);     // 07-PIC16F_TIMER
+    CHECK_EQ(CLK_UART_SPBRG(20000000, 9600, 1), 129);   // 06-PIC16F_IT
+    CHECK_EQ(CLK_I2C_SSPADD(16000000, 100000), 39);     // 05 master
+    CHECK_EQ(CLK_TMR2_PRESCALE(8000000, 1000), 16);     // 07-PIC16F_TIMER
+    CHECK_EQ(CLK_TMR2_CKPS(16), 2);
+    CHECK_EQ(CLK_TMR2_PR2(8000000, 1000, 16), 124);
+    CHECK_EQ(CLK_TMR1_PRESCALE(4000000, 2), 8);         // 09 P2: 500 ms compare
+    CHECK_EQ(CLK_TMR1_CKPS(8), 3);
+    CHECK_EQ(CLK_TMR1_CCPR(4000000, 2, 8), 62499);
+    CHECK_EQ(CLK_TIMER_ERROR_PPM(4000000, 2, 8), 0);
+
+    // Values produced from the rates defined above
+    CHECK_EQ(UART_BRGH_VALUE, 1);
+    CHECK_EQ(UART_SPBRG_VALUE, 103);
+    CHECK_EQ(I2C_SSPADD_VALUE, 39);
+    CHECK_EQ(TMR2_PRESCALE, 16);
+    CHECK_EQ(TMR2_PR2_VALUE, 249);
+    CHECK_EQ(TMR1_PRESCALE, 2);
+    CHECK_EQ(TMR1_CKPS_VALUE, 1);
+    CHECK_EQ(TMR1_CCPR_VALUE, 39999);
+}
+
+static void test_uart_error(void)
+{
+    // 9600 at 16 MHz: 16000000 / (16 * 104) = 9615.4 -> +0.16 %
+    CHECK_EQ(CLK_UART_ERROR_PPM(16000000, 9600, 1), 1602);
+    // 2400 at 20 MHz does not fit with BRGH = 1 (SPBRG 520)
+    CHECK_EQ(CLK_UART_BRGH(20000000, 2400), 0);
+    CHECK_EQ(CLK_UART_SPBRG(20000000, 2400, 0), 129);
+    // 1200 at 20 MHz fits neither (BRGH = 0 would need SPBRG 259)
+    CHECK(!CLK_UART_FITS(20000000, 1200, CLK_UART_BRGH(20000000, 1200)));
+    // 115200 at 4 MHz: best divisor still 8.5 % off, rejected by the default limit
+    CHECK(CLK_UART_ERROR_PPM(4000000, 115200, 1) > CLK_UART_MAX_ERROR_PPM);
+    CHECK_EQ(CLK_UART_ERROR_PPM(18432000, 115200, 1), 0);
+}
+
+static void test_uart_matches_search(void)
+{
+    static const unsigned long bauds[] = { 300, 1200, 2400, 9600, 19200, 38400, 57600, 115200 };
+    unsigned c, b, n;
+    for (c = 0; c < CRYSTAL_COUNT; c++) {
+        for (b = 0; b < sizeof(bauds) / sizeof(bauds[0]); b++) {
+            unsigned long f = crystals[c], baud = bauds[b];
+            int brgh = CLK_UART_BRGH(f, baud);
+            unsigned long long div = brgh ? 16 : 64, best = ~0ULL;
+            unsigned best_n = 0;
+            if (!CLK_UART_FITS(f, baud, brgh)) {
+                continue;
+            }
+            // BRGH = 0 only when no BRGH = 1 setting is close
+            if (brgh == 0) {
+                CHECK((f + 8UL * baud) / (16UL * baud) > 256);
+            }
+            for (n = 1; n <= 256; n++) {
+                unsigned long long err = abs_diff(f, div * n * baud) * 1000000ULL / (div * n * baud);
+                if (err < best) {
+                    best = err;
+                    best_n = n;
+                }
+            }
+            CHECK_EQ(CLK_UART_SPBRG(f, baud, brgh), best_n - 1);
+            CHECK_EQ(CLK_UART_ERROR_PPM(f, baud, brgh), best);
+        }
+    }
+}
+
+static void test_i2c_never_faster(void)
+{
+    static const unsigned long rates[] = { 100000, 400000 };
+    unsigned c, r;
+    for (c = 0; c < CRYSTAL_COUNT; c++) {
+        for (r = 0; r < 2; r++) {
+            unsigned long fcy = crystals[c] / 4, scl = rates[r];
+            unsigned long sspadd = CLK_I2C_SSPADD(crystals[c], scl);
+            CHECK(fcy / (sspadd + 1) <= scl);
+            CHECK(sspadd == 0 || fcy / sspadd > scl);   // The next faster setting is too fast
+        }
+    }
+    CHECK_EQ(CLK_I2C_SSPADD(16000000, 400000), 9);
+    CHECK(!CLK_I2C_FITS(4000000, 400000));              // SSPADD 2 is not supported
+    CHECK(!CLK_I2C_FITS(20000000, 10000));              // SSPADD 499 does not fit in 7 bits
+}
+
+static void test_timers_match_search(void)
+{
+    static const unsigned long rates[] = { 1, 2, 10, 50, 100, 1000, 4000, 10000, 50000 };
+    static const unsigned tmr2_prescalers[] = { 1, 4, 16 };
+    static const unsigned tmr1_prescalers[] = { 1, 2, 4, 8 };
+    unsigned c, r, p;
+    for (c = 0; c < CRYSTAL_COUNT; c++) {
+        for (r = 0; r < sizeof(rates) / sizeof(rates[0]); r++) {
+            unsigned long f = crystals[c], rate = rates[r];
+            unsigned long prescale = CLK_TMR2_PRESCALE(f, rate);
+            // Smallest prescaler with a period that fits
+            for (p = 0; p < 3; p++) {
+                unsigned long n = (f + 2UL * tmr2_prescalers[p] * rate) / (4UL * tmr2_prescalers[p] * rate);
+                if (n >= 1 && n <= 256) {
+                    CHECK_EQ(prescale, tmr2_prescalers[p]);
+                    CHECK_EQ(CLK_TMR2_PR2(f, rate, prescale), n - 1);
+                    break;
+                }
+            }
+            if (p == 3) {
+                CHECK(!CLK_TMR2_FITS(f, rate, prescale));
+            }
+            prescale = CLK_TMR1_PRESCALE(f, rate);
+            for (p = 0; p < 4; p++) {
+                unsigned long n = (f + 2UL * tmr1_prescalers[p] * rate) / (4UL * tmr1_prescalers[p] * rate);
+                if (n >= 1 && n <= 65536) {
+                    CHECK_EQ(prescale, tmr1_prescalers[p]);
+                    CHECK_EQ(CLK_TMR1_CCPR(f, rate, prescale), n - 1);
+                    break;
+                }
+            }
+            if (p == 4) {
+                CHECK(!CLK_TMR1_FITS(f, rate, prescale));
+            }
+        }
+    }
+}
+
+int main(void)
+{
+    RUN_TEST(test_project_values);
+    RUN_TEST(test_uart_error);
+    RUN_TEST(test_uart_matches_search);
+    RUN_TEST(test_i2c_never_faster);
+    RUN_TEST(test_timers_match_search);
+    return TEST_RESULT();
+}
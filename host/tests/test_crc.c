@@ -0,0 +1,132 @@
+/* File:   test_crc.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Host tests for the CRC routines of common/crc.c: catalogue check values of CRC-8 and
+ * CRC-16, chaining, and comparison with bitwise reference implementations over random
+ * messages.
+ */
+
+#include <stdlib.h>
+#include <xc.h>
+#include "test.h"
+#include "../../common/crc.h"
+
+static const uint8_t check[] = "123456789";
+
+// Reference CRC-8/SMBUS, one bit at a time from the message polynomial
+static uint8_t crc8_reference(const uint8_t *data, unsigned len)
+{
+    unsigned reg = 0, i, bit;
+    for (i = 0; i < len; i++) {
+        for (bit = 0; bit < 8; bit++) {
+            unsigned in = (data[i] >> (7 - bit)) & 1;
+            unsigned top = (reg >> 7) & 1;
+            reg = (reg << 1) & 0xFF;
+            if (top ^ in) {
+                reg ^= 0x07;
+            }
+        }
+    }
+    return (uint8_t)reg;
+}
+
+// Reference CRC-16/CCITT-FALSE, bitwise, MSB first
+static uint16_t crc16_reference(const uint8_t *data, unsigned len)
+{
+    unsigned reg = 0xFFFF, i, bit;
+    for (i = 0; i < len; i++) {
+        reg ^= (unsigned)data[i] << 8;
+        for (bit = 0; bit < 8; bit++) {
+            reg = (reg & 0x8000) ? ((reg << 1) ^ 0x1021) : (reg << 1);
+            reg &= 0xFFFF;
+        }
+    }
+    return (uint16_t)reg;
+}
+
+static void test_crc8_check_value(void)
+{
+    CHECK_EQ(crc8(CRC8_INIT, check, 9), 0xF4);
+    CHECK_EQ(crc8(CRC8_INIT, check, 0), CRC8_INIT);
+}
+
+static void test_crc8_chains(void)
+{
+    uint8_t crc = crc8(CRC8_INIT, check, 4);
+    CHECK_EQ(crc8(crc, check + 4, 5), 0xF4);
+}
+
+static void test_crc8_matches_reference(void)
+{
+    uint8_t data[64];
+    unsigned n, i, len;
+
+    srand(1);
+    for (n = 0; n < 200; n++) {
+        len = (unsigned)rand() % sizeof(data);
+        for (i = 0; i < len; i++) {
+            data[i] = (uint8_t)rand();
+        }
+        CHECK_EQ(crc8(CRC8_INIT, data, (uint8_t)len), crc8_reference(data, len));
+    }
+}
+
+static void test_crc8_detects_single_bit_errors(void)
+{
+    uint8_t data[8] = { 0x10, 0x20, 0x30, 0x40, 0x50, 0x60, 0x70, 0x80 };
+    uint8_t good = crc8(CRC8_INIT, data, 8);
+    unsigned i, bit;
+
+    for (i = 0; i < 8; i++) {
+        for (bit = 0; bit < 8; bit++) {
+            data[i] ^= (uint8_t)(1 << bit);
+            CHECK(crc8(CRC8_INIT, data, 8) != good);
+            data[i] ^= (uint8_t)(1 << bit);
+        }
+    }
+}
+
+static void test_crc16_check_value(void)
+{
+    CHECK_EQ(crc16(CRC16_INIT, check, 9), 0x29B1);
+    CHECK_EQ(crc16(CRC16_INIT, check, 0), CRC16_INIT);
+}
+
+static void test_crc16_chains(void)
+{
+    uint16_t crc = crc16(CRC16_INIT, check, 3);
+    unsigned i;
+
+    for (i = 3; i < 9; i++) {
+        crc = crc16_update(crc, check[i]);
+    }
+    CHECK_EQ(crc, 0x29B1);
+}
+
+static void test_crc16_matches_reference(void)
+{
+    uint8_t data[200];
+    unsigned n, i, len;
+
+    srand(2);
+    for (n = 0; n < 200; n++) {
+        len = (unsigned)rand() % sizeof(data);
+        for (i = 0; i < len; i++) {
+            data[i] = (uint8_t)rand();
+        }
+        CHECK_EQ(crc16(CRC16_INIT, data, (uint8_t)len), crc16_reference(data, len));
+    }
+}
+
+int main(void)
+{
+    RUN_TEST(test_crc8_check_value);
+    RUN_TEST(test_crc8_chains);
+    RUN_TEST(test_crc8_matches_reference);
+    RUN_TEST(test_crc8_detects_single_bit_errors);
+    RUN_TEST(test_crc16_check_value);
+    RUN_TEST(test_crc16_chains);
+    RUN_TEST(test_crc16_matches_reference);
+    return TEST_RESULT();
+}
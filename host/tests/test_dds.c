@@ -0,0 +1,132 @@
+/* File:   test_dds.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Host tests for the DDS waveform generator of 02-PIC16F_DAC (dds.c): Timer2 set-up, the
+ * exact output period for a tuning word, table contents, and waveform changes that only
+ * happen at a period boundary. sample() plays one Timer2 period match.
+ */
+
+#include <xc.h>
+#include "test.h"
+#include "../../02-PIC16F_DAC/TUTO_03.X/dds.h"
+
+static uint8_t sample(void)
+{
+    TMR2IF = 1;
+    dds_isr();
+    CHECK_EQ(TMR2IF, 0);
+    return PORTB;
+}
+
+static void test_timer2_rate(void)
+{
+    dds_init(DDS_SINE, 0);
+    // 4 MHz / 4 / 8000 = 125 cycles: prescaler 1:1, PR2 = 124
+    CHECK_EQ(T2CONbits.T2CKPS, 0);
+    CHECK_EQ(PR2, 124);
+    CHECK_EQ(TMR2ON, 1);
+    CHECK_EQ(TMR2IE, 1);
+    CHECK_EQ(GIE, 1);
+}
+
+static void test_tuning_word(void)
+{
+    CHECK_EQ(DDS_TUNING_WORD(40), 328);     // 40.04 Hz
+    CHECK_EQ(DDS_TUNING_WORD(1000), 8192);  // Exactly 8 samples per period
+    CHECK_EQ(DDS_TUNING_WORD(1), 8);
+}
+
+static void test_exact_period(void)
+{
+    unsigned i, rises = 0, first = 0, last = 0;
+    uint8_t prev, now;
+
+    // 1000 Hz at 8000 samples/s: the square wave repeats every 8 samples
+    dds_init(DDS_SQUARE, DDS_TUNING_WORD(1000));
+    prev = sample();
+    for (i = 1; i < 8000; i++) {
+        now = sample();
+        if (now > prev) {
+            if (rises == 0) {
+                first = i;
+            }
+            last = i;
+            rises++;
+        }
+        prev = now;
+    }
+    CHECK_EQ(rises, 999);
+    CHECK_EQ((last - first) % 8, 0);
+    CHECK_EQ((last - first) / 8, 998);
+}
+
+static void test_sine_samples(void)
+{
+    uint8_t out[4];
+    uint8_t i;
+
+    // A quarter period per sample: 0, 90, 180, 270 degrees
+    dds_init(DDS_SINE, 0x4000);
+    for (i = 0; i < 4; i++) {
+        out[i] = sample();
+    }
+    CHECK_EQ(out[0], 128);
+    CHECK_EQ(out[1], 255);
+    CHECK_EQ(out[2], 128);
+    CHECK_EQ(out[3], 0);
+}
+
+static void test_tables(void)
+{
+    dds_init(DDS_TRIANGLE, 0x0100);         // One table entry per sample
+    CHECK_EQ(sample(), 0);
+    CHECK_EQ(sample(), 2);
+    dds_init(DDS_SAW, 0x0100);
+    CHECK_EQ(sample(), 0);
+    CHECK_EQ(sample(), 1);
+    dds_init(DDS_SQUARE, 0x8000);
+    CHECK_EQ(sample(), 255);
+    CHECK_EQ(sample(), 0);
+}
+
+static void test_waveform_switch_at_wrap(void)
+{
+    unsigned i;
+
+    dds_init(DDS_SAW, 0x1000);              // 16 samples per period
+    for (i = 0; i < 5; i++) {
+        sample();
+    }
+    dds_set_waveform(DDS_SQUARE);
+    CHECK_EQ(dds_get_waveform(), DDS_SAW);
+    // The saw period runs to its end
+    for (i = 5; i < 16; i++) {
+        CHECK_EQ(sample(), i * 16);
+    }
+    CHECK_EQ(dds_get_waveform(), DDS_SQUARE);
+    CHECK_EQ(sample(), 255);                // New period starts with the square wave
+}
+
+static void test_retune_is_phase_continuous(void)
+{
+    dds_init(DDS_SAW, 0x0100);
+    sample();
+    sample();                               // Phase 0x0200
+    dds_set_tuning(0x0400);
+    CHECK_EQ(TMR2IE, 1);
+    CHECK_EQ(sample(), 2);
+    CHECK_EQ(sample(), 6);
+}
+
+int main(void)
+{
+    RUN_TEST(test_timer2_rate);
+    RUN_TEST(test_tuning_word);
+    RUN_TEST(test_exact_period);
+    RUN_TEST(test_sine_samples);
+    RUN_TEST(test_tables);
+    RUN_TEST(test_waveform_switch_at_wrap);
+    RUN_TEST(test_retune_is_phase_continuous);
+    return TEST_RESULT();
+}
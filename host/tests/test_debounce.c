@@ -0,0 +1,165 @@
+/* File:   test_debounce.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Host tests for the vertical-counter debouncer of common/debounce.c. hold() feeds the
+ * same port sample for a number of ticks, as a timer interrupt reading a steady port would.
+ */
+
+#include <xc.h>
+#include "test.h"
+#include "../../common/debounce.h"
+
+static void hold(uint8_t sample, unsigned ticks)
+{
+    while (ticks--) {
+        debounce_tick(sample);
+    }
+}
+
+static int next_event(void)
+{
+    uint8_t event;
+    return debounce_get(&event) ? event : -1;
+}
+
+static void test_press_after_four_samples(void)
+{
+    debounce_init(0x01, 0, 0);
+    hold(0x01, 3);
+    CHECK_EQ(debounce_state(), 0);
+    CHECK_EQ(next_event(), -1);
+    hold(0x01, 1);
+    CHECK_EQ(debounce_state(), 0x01);
+    CHECK_EQ(next_event(), DEBOUNCE_EVENT(DEBOUNCE_PRESS, 0));
+    CHECK_EQ(next_event(), -1);
+
+    hold(0x00, 4);
+    CHECK_EQ(debounce_state(), 0);
+    CHECK_EQ(next_event(), DEBOUNCE_EVENT(DEBOUNCE_RELEASE, 0));
+}
+
+static void test_bounce_is_filtered(void)
+{
+    unsigned i;
+
+    debounce_init(0x04, 0, 0);
+    // Contact bounce: never 4 equal samples in a row
+    for (i = 0; i < 20; i++) {
+        hold((i & 1) ? 0x04 : 0x00, 1 + (i % 3));
+    }
+    CHECK_EQ(next_event(), -1);
+    CHECK_EQ(debounce_state(), 0);
+    hold(0x04, 4);
+    CHECK_EQ(next_event(), DEBOUNCE_EVENT(DEBOUNCE_PRESS, 2));
+    CHECK_EQ(next_event(), -1);
+}
+
+static void test_active_low_and_mask(void)
+{
+    debounce_init(0x06, 0x02, 0);       // RB1 pull-up, RB2 pull-down, others ignored
+    hold(0xFF & ~0x02, 4);              // RB1 low = pressed, RB2 high = pressed
+    CHECK_EQ(debounce_state(), 0x06);
+    CHECK_EQ(next_event(), DEBOUNCE_EVENT(DEBOUNCE_PRESS, 1));
+    CHECK_EQ(next_event(), DEBOUNCE_EVENT(DEBOUNCE_PRESS, 2));
+    CHECK_EQ(next_event(), -1);
+
+    debounce_init(0x06, 0x02, 0);
+    hold(0x02, 10);                     // Both idle
+    CHECK_EQ(debounce_state(), 0);
+    CHECK_EQ(next_event(), -1);
+}
+
+static void test_whole_port_at_once(void)
+{
+    uint8_t bit;
+
+    debounce_init(0xFF, 0, 0);
+    hold(0xA5, 4);
+    CHECK_EQ(debounce_state(), 0xA5);
+    for (bit = 0; bit < 8; bit++) {
+        if (0xA5 & (1 << bit)) {
+            CHECK_EQ(next_event(), DEBOUNCE_EVENT(DEBOUNCE_PRESS, bit));
+        }
+    }
+    // One bit changes while the others stay held
+    hold(0xA4, 4);
+    CHECK_EQ(debounce_state(), 0xA4);
+    CHECK_EQ(next_event(), DEBOUNCE_EVENT(DEBOUNCE_RELEASE, 0));
+    CHECK_EQ(next_event(), -1);
+}
+
+static void test_long_press(void)
+{
+    debounce_init(0x01, 0, 0);
+    hold(0x01, 4);
+    CHECK_EQ(next_event(), DEBOUNCE_EVENT(DEBOUNCE_PRESS, 0));
+    hold(0x01, DEBOUNCE_LONG_TICKS - 1);
+    CHECK_EQ(next_event(), -1);
+    hold(0x01, 1);
+    CHECK_EQ(next_event(), DEBOUNCE_EVENT(DEBOUNCE_LONG, 0));
+    hold(0x01, 3 * DEBOUNCE_LONG_TICKS);   // Reported once
+    CHECK_EQ(next_event(), -1);
+    hold(0x00, 4);
+    CHECK_EQ(next_event(), DEBOUNCE_EVENT(DEBOUNCE_RELEASE, 0));
+
+    // A new press starts a new long-press time
+    hold(0x01, 4 + DEBOUNCE_LONG_TICKS);
+    CHECK_EQ(next_event(), DEBOUNCE_EVENT(DEBOUNCE_PRESS, 0));
+    CHECK_EQ(next_event(), DEBOUNCE_EVENT(DEBOUNCE_LONG, 0));
+}
+
+static void test_auto_repeat(void)
+{
+    int repeats = 0, event;
+
+    debounce_init(0x03, 0, 0x02);
+    hold(0x02, 4);
+    CHECK_EQ(next_event(), DEBOUNCE_EVENT(DEBOUNCE_PRESS, 1));
+    hold(0x02, DEBOUNCE_REPEAT_DELAY_TICKS - 1);
+    CHECK_EQ(next_event(), -1);
+    hold(0x02, 1);
+    CHECK_EQ(next_event(), DEBOUNCE_EVENT(DEBOUNCE_REPEAT, 1));
+    hold(0x02, DEBOUNCE_REPEAT_TICKS - 1);
+    CHECK_EQ(next_event(), -1);
+    hold(0x02, 1);
+    CHECK_EQ(next_event(), DEBOUNCE_EVENT(DEBOUNCE_REPEAT, 1));
+
+    // No long press for a repeating button; drain as the main loop would
+    while (repeats < 20) {
+        hold(0x02, DEBOUNCE_REPEAT_TICKS);
+        while ((event = next_event()) >= 0) {
+            CHECK_EQ(event, DEBOUNCE_EVENT(DEBOUNCE_REPEAT, 1));
+            repeats++;
+        }
+    }
+    CHECK_EQ(debounce_dropped(), 0);
+}
+
+static void test_full_queue_drops(void)
+{
+    unsigned i;
+
+    debounce_init(0x01, 0, 0);
+    for (i = 0; i < DEBOUNCE_QUEUE_SIZE / 2 + 1; i++) {
+        hold(0x01, 4);
+        hold(0x00, 4);
+    }
+    CHECK_EQ(debounce_dropped(), 2);
+    for (i = 0; i < DEBOUNCE_QUEUE_SIZE; i++) {
+        CHECK_EQ(next_event(), DEBOUNCE_EVENT((i & 1) ? DEBOUNCE_RELEASE : DEBOUNCE_PRESS, 0));
+    }
+    CHECK_EQ(next_event(), -1);
+}
+
+int main(void)
+{
+    RUN_TEST(test_press_after_four_samples);
+    RUN_TEST(test_bounce_is_filtered);
+    RUN_TEST(test_active_low_and_mask);
+    RUN_TEST(test_whole_port_at_once);
+    RUN_TEST(test_long_press);
+    RUN_TEST(test_auto_repeat);
+    RUN_TEST(test_full_queue_drops);
+    return TEST_RESULT();
+}
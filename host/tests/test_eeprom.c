@@ -0,0 +1,216 @@
+/* File:   test_eeprom.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Host tests for the interrupt-driven data EEPROM writer of 12-PIC16F_Internal_EEPROM
+ * (eeprom.c), against the EEPROM model of the shim: complete() ends the write cycle in
+ * progress and runs the ISR, as the EEIF interrupt does.
+ */
+
+#include <xc.h>
+#include "test.h"
+#include "../../12-PIC16F_Internal_EEPROM/EEPROM.X/eeprom.h"
+
+static int complete(void)
+{
+    if (!pic_host_eeprom_complete()) {
+        return 0;
+    }
+    eeprom_isr();
+    return 1;
+}
+
+static int complete_all(void)
+{
+    int n = 0;
+    while (complete()) {
+        n++;
+    }
+    return n;
+}
+
+static void test_init(void)
+{
+    eeprom_init();
+    CHECK_EQ(EEIE, 1);
+    CHECK_EQ(PEIE, 1);
+    CHECK_EQ(GIE, 1);
+    CHECK_EQ(eeprom_busy(), 0);
+    CHECK_EQ(eeprom_read(0), 0xFF);
+}
+
+static void test_block_is_written_in_background(void)
+{
+    static const uint8_t data[] = { 1, 2, 3, 4 };
+    eeprom_stats_t stats;
+
+    eeprom_init();
+    pic_host_eeprom[0x14] = 0x99;
+    CHECK_EQ(eeprom_read(0x14), 0x99);
+    CHECK_EQ(eeprom_write_block(0x10, data, 4), 1);
+    CHECK_EQ(eeprom_busy(), 1);
+    CHECK_EQ(WR, 1);                    // First byte started, nothing waited for
+    CHECK_EQ(WREN, 0);
+    CHECK_EQ(EEADR, 0x10);
+    CHECK_EQ(pic_host_eeprom[0x10], 0xFF);
+
+    // Reads see the queued data already
+    CHECK_EQ(eeprom_read(0x10), 1);
+    CHECK_EQ(eeprom_read(0x13), 4);
+    CHECK_EQ(EEADR, 0x10);              // Write cycle left alone
+
+    CHECK_EQ(complete_all(), 4);
+    CHECK_EQ(eeprom_busy(), 0);
+    CHECK_EQ(pic_host_eeprom[0x10], 1);
+    CHECK_EQ(pic_host_eeprom[0x13], 4);
+    CHECK_EQ(EEIF, 0);
+    eeprom_get_stats(&stats);
+    CHECK_EQ(stats.writes, 4);
+    CHECK_EQ(stats.skipped, 0);
+    CHECK_EQ(EEIE, 1);
+}
+
+static void test_same_value_is_skipped(void)
+{
+    static const uint8_t data[] = { 7, 0xFF, 9 };
+    eeprom_stats_t stats;
+
+    eeprom_init();
+    pic_host_eeprom[0x21] = 0xFF;
+    pic_host_eeprom[0x22] = 9;
+    eeprom_write_block(0x20, data, 3);
+    CHECK_EQ(complete_all(), 1);        // Only 0x20 needed a write
+    CHECK_EQ(pic_host_eeprom_writes, 1);
+    eeprom_get_stats(&stats);
+    CHECK_EQ(stats.writes, 1);
+    CHECK_EQ(stats.skipped, 2);
+
+    // Nothing to write at all: the call completes without a write cycle
+    eeprom_write_block(0x20, data, 3);
+    CHECK_EQ(WR, 0);
+    CHECK_EQ(eeprom_busy(), 0);
+}
+
+static void test_gie_is_restored(void)
+{
+    static const uint8_t a = 0x11, b = 0x22;
+
+    eeprom_init();
+    GIE = 0;
+    eeprom_write_block(0, &a, 1);
+    CHECK_EQ(WR, 1);
+    CHECK_EQ(EECON2, 0xAA);
+    CHECK_EQ(GIE, 0);                   // Not switched on behind the caller's back
+
+    GIE = 1;
+    eeprom_write_block(1, &b, 1);
+    CHECK_EQ(GIE, 1);
+    complete_all();
+    CHECK_EQ(pic_host_eeprom[0], 0x11);
+    CHECK_EQ(pic_host_eeprom[1], 0x22);
+}
+
+static void test_queue_full_is_all_or_nothing(void)
+{
+    uint8_t data[EEPROM_QUEUE_SIZE];
+    uint8_t i;
+
+    eeprom_init();
+    for (i = 0; i < EEPROM_QUEUE_SIZE; i++) {
+        data[i] = i;
+    }
+    CHECK_EQ(eeprom_write_block(0x40, data, EEPROM_QUEUE_SIZE - 2), 1);
+    CHECK_EQ(eeprom_write_block(0x80, data, 3), 0);
+    CHECK_EQ(eeprom_write_block(0x80, data, 2), 1);
+    CHECK_EQ(eeprom_write_block(0x90, data, 1), 0);
+    complete();                         // One slot free again
+    CHECK_EQ(eeprom_write_block(0x90, data + 5, 1), 1);
+    complete_all();
+    CHECK_EQ(pic_host_eeprom[0x4D], 13);
+    CHECK_EQ(pic_host_eeprom[0x81], 1);
+    CHECK_EQ(pic_host_eeprom[0x90], 5);
+}
+
+static void test_newest_queued_value_wins(void)
+{
+    static const uint8_t first[] = { 1, 2 };
+    static const uint8_t second[] = { 3 };
+
+    eeprom_init();
+    eeprom_write_block(0x30, first, 2);
+    eeprom_write_block(0x31, second, 1);
+    CHECK_EQ(eeprom_read(0x31), 3);
+    complete_all();
+    CHECK_EQ(pic_host_eeprom[0x31], 3);
+    CHECK_EQ(eeprom_read(0x31), 3);
+    CHECK_EQ(EEPGD, 0);
+}
+
+static void test_flush_without_interrupts(void)
+{
+    static const uint8_t data[] = { 5, 6 };
+    eeprom_stats_t stats;
+
+    eeprom_init();
+    eeprom_flush();                     // Nothing queued: returns at once
+    GIE = 0;
+    eeprom_write_block(0xFF, data, 2);  // Wraps to address 0
+    complete();
+    CHECK_EQ(EEADR, 0x00);              // Second byte in its write cycle
+    pic_host_eeprom_complete();         // EEIF set, no ISR runs with GIE = 0
+    CHECK_EQ(eeprom_busy(), 1);
+    eeprom_flush();                     // Picks up EEIF itself
+    CHECK_EQ(eeprom_busy(), 0);
+    CHECK_EQ(EEIF, 0);
+    CHECK_EQ(pic_host_eeprom[0xFF], 5);
+    CHECK_EQ(pic_host_eeprom[0x00], 6);
+    CHECK_EQ(GIE, 0);
+    eeprom_get_stats(&stats);
+    CHECK_EQ(stats.writes, 2);
+    CHECK_EQ(stats.errors, 0);
+}
+
+static void test_masked_eeie_stays_masked(void)
+{
+    static const uint8_t data[] = { 7 };
+
+    eeprom_init();
+    EEIE = 0;                           // Caller polls the writer itself
+    eeprom_write_block(0x40, data, 1);
+    CHECK_EQ(EEIE, 0);
+    CHECK_EQ(eeprom_read(0x40), 7);
+    CHECK_EQ(EEIE, 0);
+    pic_host_eeprom_complete();
+    eeprom_flush();
+    CHECK_EQ(EEIE, 0);
+    CHECK_EQ(pic_host_eeprom[0x40], 7);
+}
+
+static void test_failed_write_is_counted(void)
+{
+    static const uint8_t data[] = { 0x5A };
+    eeprom_stats_t stats;
+
+    eeprom_init();
+    eeprom_write_block(0x50, data, 1);
+    EEDATA = 0x58;                      // Cell did not take the value
+    complete();
+    eeprom_get_stats(&stats);
+    CHECK_EQ(stats.errors, 1);
+    CHECK_EQ(stats.writes, 0);
+    CHECK_EQ(eeprom_busy(), 0);
+}
+
+int main(void)
+{
+    RUN_TEST(test_init);
+    RUN_TEST(test_block_is_written_in_background);
+    RUN_TEST(test_same_value_is_skipped);
+    RUN_TEST(test_gie_is_restored);
+    RUN_TEST(test_queue_full_is_all_or_nothing);
+    RUN_TEST(test_newest_queued_value_wins);
+    RUN_TEST(test_flush_without_interrupts);
+    RUN_TEST(test_masked_eeie_stays_masked);
+    RUN_TEST(test_failed_write_is_counted);
+    return TEST_RESULT();
+}
@@ -0,0 +1,177 @@
+/* File:   test_evq.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Host tests for the deferred interrupt work queue of common/evq.c. The test plays the
+ * interrupt routine (evq_post) and the main loop (evq_dispatch) in turn; Timer1 is set by
+ * hand to give the timestamps.
+ */
+
+#include <xc.h>
+#include "test.h"
+#include "../../common/evq.h"
+
+static evq_event_t seen[32];
+static unsigned seen_count;
+
+static void record(const evq_event_t *event)
+{
+    seen[seen_count++] = *event;
+}
+
+static void post_from_handler(const evq_event_t *event)
+{
+    record(event);
+    // An interrupt while a handler runs can reuse every free slot, not the one being read
+    while (evq_post(1, 0xEE)) {
+    }
+}
+
+static const evq_handler_t handlers[] = { record, record, 0 };
+
+static void start(void)
+{
+    seen_count = 0;
+    evq_init(handlers, 3);
+}
+
+static void test_events_dispatched_in_order(void)
+{
+    start();
+    TMR1 = 100;
+    CHECK_EQ(evq_post(0, 0x11), 1);
+    TMR1 = 0x1234;
+    CHECK_EQ(evq_post(1, 0x22), 1);
+    CHECK_EQ(evq_pending(), 2);
+    CHECK_EQ(seen_count, 0);
+
+    CHECK_EQ(evq_dispatch(), 2);
+    CHECK_EQ(seen_count, 2);
+    CHECK_EQ(seen[0].source, 0);
+    CHECK_EQ(seen[0].payload, 0x11);
+    CHECK_EQ(seen[0].timestamp, 100);
+    CHECK_EQ(seen[1].source, 1);
+    CHECK_EQ(seen[1].payload, 0x22);
+    CHECK_EQ(seen[1].timestamp, 0x1234);
+    CHECK_EQ(evq_pending(), 0);
+    CHECK_EQ(evq_dispatch(), 0);
+}
+
+static void test_unhandled_sources_are_consumed(void)
+{
+    evq_stats_t stats;
+
+    start();
+    evq_post(2, 1);                     // Null handler
+    evq_post(7, 2);                     // Beyond the table
+    evq_post(40, 3);                    // Beyond EVQ_MAX_SOURCES
+    CHECK_EQ(evq_dispatch(), 3);
+    CHECK_EQ(seen_count, 0);
+    evq_get_stats(&stats);
+    CHECK_EQ(stats.posted, 3);
+    CHECK_EQ(stats.dispatched, 3);
+}
+
+static void test_overflow_and_high_water(void)
+{
+    evq_stats_t stats;
+    unsigned i;
+
+    start();
+    for (i = 0; i < EVQ_SIZE; i++) {
+        CHECK_EQ(evq_post(0, (uint8_t)i), 1);
+    }
+    CHECK_EQ(evq_post(1, 0xAA), 0);
+    CHECK_EQ(evq_post(1, 0xAB), 0);
+    CHECK_EQ(evq_post(0, 0xAC), 0);
+    evq_get_stats(&stats);
+    CHECK_EQ(stats.high_water, EVQ_SIZE);
+    CHECK_EQ(stats.overflows[0], 1);
+    CHECK_EQ(stats.overflows[1], 2);
+    CHECK_EQ(stats.posted, EVQ_SIZE);
+
+    CHECK_EQ(evq_dispatch(), EVQ_SIZE);
+    CHECK_EQ(seen[EVQ_SIZE - 1].payload, EVQ_SIZE - 1);
+
+    // Overflow counters saturate
+    for (i = 0; i < 300; i++) {
+        evq_post(3, 0);
+    }
+    evq_get_stats(&stats);
+    CHECK_EQ(stats.overflows[3], 255);
+}
+
+static void test_high_water_tracks_depth(void)
+{
+    evq_stats_t stats;
+
+    start();
+    evq_post(0, 1);
+    evq_post(0, 2);
+    evq_dispatch();
+    evq_post(0, 3);
+    evq_dispatch();
+    evq_get_stats(&stats);
+    CHECK_EQ(stats.high_water, 2);
+    CHECK_EQ(stats.dispatched, 3);
+}
+
+static void test_latency_is_measured(void)
+{
+    evq_stats_t stats;
+
+    start();
+    TMR1 = 0xFFF0;
+    evq_post(0, 0);
+    TMR1 = 0x0010;                      // Across the Timer1 wrap: 0x20 ticks
+    evq_dispatch();
+    TMR1 = 500;
+    evq_post(0, 0);
+    TMR1 = 510;
+    evq_dispatch();
+    evq_get_stats(&stats);
+    CHECK_EQ(stats.max_latency, 0x20);
+}
+
+static void test_post_during_handler(void)
+{
+    static const evq_handler_t nested[] = { post_from_handler, record };
+    evq_stats_t stats;
+
+    seen_count = 0;
+    evq_init(nested, 2);
+    evq_post(0, 0x55);
+    // The handler fills the queue around the slot it is reading
+    CHECK_EQ(evq_dispatch(), EVQ_SIZE);
+    CHECK_EQ(seen[0].payload, 0x55);
+    CHECK_EQ(seen[1].payload, 0xEE);
+    CHECK_EQ(seen_count, EVQ_SIZE);
+    evq_get_stats(&stats);
+    CHECK_EQ(stats.overflows[1], 1);
+    CHECK_EQ(stats.high_water, EVQ_SIZE);
+}
+
+static void test_stats_keep_gie(void)
+{
+    evq_stats_t stats;
+
+    start();
+    GIE = 1;
+    evq_get_stats(&stats);
+    CHECK_EQ(GIE, 1);
+    GIE = 0;
+    evq_get_stats(&stats);
+    CHECK_EQ(GIE, 0);
+}
+
+int main(void)
+{
+    RUN_TEST(test_events_dispatched_in_order);
+    RUN_TEST(test_unhandled_sources_are_consumed);
+    RUN_TEST(test_overflow_and_high_water);
+    RUN_TEST(test_high_water_tracks_depth);
+    RUN_TEST(test_latency_is_measured);
+    RUN_TEST(test_post_during_handler);
+    RUN_TEST(test_stats_keep_gie);
+    return TEST_RESULT();
+}
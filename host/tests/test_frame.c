@@ -0,0 +1,207 @@
+/* File:   test_frame.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Host tests for the telemetry frames: the firmware writer (common/frame.c) encoding into
+ * a ring buffer at every head position, decoded by the host library (host/tools/framedec.c);
+ * frames that do not fit, corrupted and lost frames, a stream joined mid-frame, and full
+ * 254-byte COBS blocks.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <xc.h>
+#include "test.h"
+#include "../../common/frame.h"
+#include "../tools/framedec.h"
+
+#define RING_SIZE 128
+#define RING_MASK (RING_SIZE - 1)
+
+static volatile uint8_t ring[RING_SIZE];
+static framedec_t dec;
+
+// Last frame delivered by the decoder
+static uint8_t got_type, got_seq, got_payload[256];
+static unsigned got_length, got_frames;
+
+static void on_frame(void *context, const framedec_frame_t *frame)
+{
+    (void)context;
+    got_type = frame->type;
+    got_seq = frame->seq;
+    got_length = frame->length;
+    memcpy(got_payload, frame->payload, frame->length);
+    got_frames++;
+}
+
+// Encode a frame at ring index 'head' and copy the published bytes out in order
+static uint8_t encode(uint8_t head, uint8_t room, uint8_t type, uint8_t seq,
+                      const uint8_t *payload, unsigned length, uint8_t *wire)
+{
+    frame_t f;
+    uint8_t n, i;
+
+    frame_begin(&f, ring, RING_MASK, head, room, type, seq);
+    for (i = 0; i < length; i++) {
+        frame_put(&f, payload[i]);
+    }
+    n = frame_end(&f);
+    for (i = 0; i < n; i++) {
+        wire[i] = ring[(uint8_t)(head + i) & RING_MASK];
+    }
+    return n;
+}
+
+static void test_round_trip_at_every_head(void)
+{
+    uint8_t payload[100], wire[RING_SIZE];
+    unsigned head, i, length, zeros;
+    uint8_t n;
+
+    srand(3);
+    framedec_init(&dec, on_frame, NULL);
+    got_frames = 0;
+    for (head = 0; head < 256; head++) {
+        length = (unsigned)rand() % sizeof(payload);
+        for (i = 0; i < length; i++) {
+            payload[i] = (rand() & 3) ? (uint8_t)rand() : 0;    // Plenty of zeros
+        }
+        n = encode((uint8_t)head, RING_SIZE, 0x10, (uint8_t)head, payload, length, wire);
+        CHECK(n > 0);
+        CHECK(n <= length + FRAME_OVERHEAD);
+        for (i = 0, zeros = 0; i < n; i++) {
+            zeros += (wire[i] == 0);
+        }
+        CHECK_EQ(zeros, 1);                     // Only the delimiter
+        CHECK_EQ(wire[n - 1], FRAME_DELIMITER);
+
+        framedec_feed(&dec, wire, n);
+        CHECK_EQ(got_frames, head + 1);
+        CHECK_EQ(got_type, 0x10);
+        CHECK_EQ(got_seq, (uint8_t)head);
+        CHECK_EQ(got_length, length);
+        CHECK_EQ(memcmp(got_payload, payload, length), 0);
+    }
+    CHECK_EQ(dec.lost, 0);
+    CHECK_EQ(dec.crc_errors, 0);
+    CHECK_EQ(dec.malformed, 0);
+    CHECK_EQ(dec.types[0x10], 256);
+}
+
+static void test_frame_put16_is_little_endian(void)
+{
+    uint8_t wire[16];
+    frame_t f;
+    uint8_t n, i;
+
+    framedec_init(&dec, on_frame, NULL);
+    frame_begin(&f, ring, RING_MASK, 0, RING_SIZE, 0x20, 7);
+    frame_put16(&f, 0x1234);
+    n = frame_end(&f);
+    CHECK_EQ(n, 2 + FRAME_OVERHEAD);
+    for (i = 0; i < n; i++) {
+        wire[i] = ring[i];
+    }
+    framedec_feed(&dec, wire, n);
+    CHECK_EQ(got_length, 2);
+    CHECK_EQ(got_payload[0], 0x34);
+    CHECK_EQ(got_payload[1], 0x12);
+}
+
+static void test_overflow_leaves_queued_data(void)
+{
+    uint8_t payload[8] = { 1, 0, 2, 0, 3, 0, 4, 0 };
+    uint8_t wire[RING_SIZE];
+    unsigned i;
+
+    memset((void *)ring, 0xEE, sizeof(ring));
+    // 14 slots needed, 13 free from index 120: only 120..127 and 0..4 may be touched
+    CHECK_EQ(encode(120, 13, 0x01, 0, payload, sizeof(payload), wire), 0);
+    for (i = 5; i < 120; i++) {
+        CHECK_EQ(ring[i], 0xEE);
+    }
+    CHECK_EQ(encode(120, 14, 0x01, 0, payload, sizeof(payload), wire), 14);
+}
+
+static void test_corrupted_and_lost_frames(void)
+{
+    uint8_t payload[4] = { 'a', 'b', 'c', 'd' };
+    uint8_t wire[RING_SIZE];
+    uint8_t n;
+
+    framedec_init(&dec, on_frame, NULL);
+    got_frames = 0;
+    n = encode(0, RING_SIZE, 0x01, 0, payload, sizeof(payload), wire);
+    framedec_feed(&dec, wire, n);
+    n = encode(0, RING_SIZE, 0x01, 1, payload, sizeof(payload), wire);
+    wire[4] ^= 0x40;                            // 'b' -> '"' in transit
+    framedec_feed(&dec, wire, n);
+    n = encode(0, RING_SIZE, 0x01, 3, payload, sizeof(payload), wire);   // Seq 2 never sent
+    framedec_feed(&dec, wire, n);
+
+    CHECK_EQ(got_frames, 2);
+    CHECK_EQ(got_seq, 3);
+    CHECK_EQ(dec.frames, 2);
+    CHECK_EQ(dec.crc_errors, 1);
+    CHECK_EQ(dec.lost, 2);                      // 1 (bad CRC) and 2
+    CHECK_EQ(dec.malformed, 0);
+    CHECK_EQ(dec.payload_bytes, 8);
+}
+
+static void test_joins_stream_mid_frame(void)
+{
+    uint8_t payload[3] = { 9, 0, 9 };
+    uint8_t wire[RING_SIZE];
+    uint8_t n;
+    static const uint8_t tail[] = { 0x05, 0x31 };
+
+    framedec_init(&dec, on_frame, NULL);
+    got_frames = 0;
+    framedec_feed(&dec, tail, sizeof(tail));    // End of a frame sent before we listened
+    n = encode(0, RING_SIZE, 0x01, 42, payload, sizeof(payload), wire);
+    framedec_feed(&dec, wire, 1);               // Split anywhere
+    framedec_feed(&dec, wire + 1, (size_t)(n - 1));
+    CHECK_EQ(got_frames, 0);                    // Still part of the garbage frame
+    CHECK_EQ(dec.malformed + dec.crc_errors, 1);
+
+    n = encode(0, RING_SIZE, 0x01, 43, payload, sizeof(payload), wire);
+    framedec_feed(&dec, wire, n);
+    CHECK_EQ(got_frames, 1);
+    CHECK_EQ(got_seq, 43);
+    CHECK_EQ(dec.lost, 0);
+}
+
+static void test_cobs_full_blocks(void)
+{
+    uint8_t in[260], out[260];
+    unsigned i;
+
+    // 254 non-zero bytes, then a zero and one byte: FF <254> 01 02 07
+    in[0] = 0xFF;
+    for (i = 1; i <= 254; i++) {
+        in[i] = (uint8_t)i;
+    }
+    in[255] = 0x01;
+    in[256] = 0x02;
+    in[257] = 0x07;
+    CHECK_EQ(framedec_cobs(in, 258, out), 256);
+    CHECK_EQ(out[253], 254);
+    CHECK_EQ(out[254], 0);
+    CHECK_EQ(out[255], 7);
+
+    CHECK_EQ(framedec_cobs(in, 255, out), 254);     // No zero after a full last block
+    in[0] = 0x05;
+    CHECK_EQ(framedec_cobs(in, 3, out), -1);        // Code past the end
+}
+
+int main(void)
+{
+    RUN_TEST(test_round_trip_at_every_head);
+    RUN_TEST(test_frame_put16_is_little_endian);
+    RUN_TEST(test_overflow_leaves_queued_data);
+    RUN_TEST(test_corrupted_and_lost_frames);
+    RUN_TEST(test_joins_stream_mid_frame);
+    RUN_TEST(test_cobs_full_blocks);
+    return TEST_RESULT();
+}
@@ -0,0 +1,158 @@
+/* File:   test_freqgen.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Host tests for the CCP1 square-wave generator of 09 compare mode (freqgen.c).
+ * match() plays Timer1 with the special event trigger: the next match comes
+ * (CCPR1 + 1) * prescale cycles after the previous one, using the CCPR1 and T1CKPS values
+ * the ISR left behind. The times of the pin edges are checked over thousands of periods.
+ */
+
+#include <xc.h>
+#include "test.h"
+#include "../../09-TIMRER_COMPARE_CAPTURE/TUTO_10_P2.X/freqgen.h"
+
+#define TMR1_RATE_HZ 2
+#include "../../common/clockcalc.h"
+
+static unsigned long long now;          // Cycles since freqgen_set()
+static unsigned long long last_rise, last_fall;
+
+static void match(void)
+{
+    uint8_t before = RC4;
+
+    now += (unsigned long long)(CCPR1 + 1) << T1CONbits.T1CKPS;
+    CCP1IF = 1;
+    freqgen_isr();
+    CHECK_EQ(CCP1IF, 0);
+    CHECK_EQ(RC4, !before);             // Every match is one edge
+    if (RC4) {
+        last_rise = now;
+    } else {
+        last_fall = now;
+    }
+}
+
+static void start(uint16_t hz, uint8_t duty)
+{
+    freqgen_init();
+    CHECK_EQ(freqgen_set(hz, duty), 1);
+    now = last_rise = last_fall = 0;
+}
+
+// Run 'periods' periods and check each one is exactly 'period' cycles, 'high' of them high
+static void check_periods(unsigned periods, unsigned long long period, unsigned long long high)
+{
+    unsigned i;
+    unsigned long long rise;
+
+    for (i = 0; i < periods; i++) {
+        rise = last_rise;
+        match();
+        CHECK_EQ(last_fall - rise, high);
+        match();
+        CHECK_EQ(last_rise - rise, period);
+    }
+}
+
+static void test_init_and_default(void)
+{
+    start(1, 50);
+    CHECK_EQ(CCP1CON, 0x0B);            // Compare, special event trigger
+    CHECK_EQ(TMR1ON, 1);
+    CHECK_EQ(TRISC4, 0);
+    CHECK_EQ(RC4, 1);
+    CHECK_EQ(CCP1IE, 1);
+    // Same prescaler and compare value as clockcalc.h for 2 events per second
+    CHECK_EQ(freqgen_prescale(), TMR1_PRESCALE);
+    CHECK_EQ(T1CONbits.T1CKPS, TMR1_CKPS_VALUE);
+    CHECK_EQ(CCPR1, TMR1_CCPR_VALUE);
+    CHECK_EQ(freqgen_period_cycles(), 1000000);
+}
+
+static void test_exact_period(void)
+{
+    start(1, 50);
+    check_periods(2000, 1000000, 500000);
+    CHECK_EQ(now, 2000ULL * 1000000);   // No drift after 2000 s
+
+    start(1000, 25);
+    check_periods(5000, 1000, 250);
+    CHECK_EQ(freqgen_prescale(), 1);
+
+    // 3 kHz: 333 cycles, rounded from 333.3; the duty is limited by FREQGEN_MIN_CYCLES
+    start(3000, 10);
+    check_periods(5000, 333, FREQGEN_MIN_CYCLES);
+}
+
+static void test_prescaler_matches_clockcalc(void)
+{
+    static const uint16_t rates[] = { 1, 2, 5, 8, 10, 25, 50, 100, 500, 1000, 2500 };
+    unsigned i;
+
+    for (i = 0; i < sizeof(rates) / sizeof(rates[0]); i++) {
+        start(rates[i], 50);
+        CHECK_EQ(freqgen_prescale(), CLK_TMR1_PRESCALE(_XTAL_FREQ, 2UL * rates[i]));
+        CHECK_EQ(CCPR1, CLK_TMR1_CCPR(_XTAL_FREQ, 2UL * rates[i], freqgen_prescale()));
+    }
+}
+
+static void test_range(void)
+{
+    freqgen_init();
+    CHECK_EQ(freqgen_set(0, 50), 0);
+    CHECK_EQ(freqgen_set(FREQGEN_MAX_HZ + FREQGEN_MAX_HZ / 10, 50), 0);
+    CHECK_EQ(freqgen_set(FREQGEN_MAX_HZ, 50), 1);
+    CHECK_EQ(FREQGEN_MIN_HZ, 1);
+    CHECK_EQ(FREQGEN_MAX_HZ, 5000);
+}
+
+static void test_retune_at_period_boundary(void)
+{
+    unsigned long long rise;
+
+    start(100, 50);                     // 10000-cycle periods, prescaler 1
+    check_periods(10, 10000, 5000);
+
+    // Requested in the high half: that period still completes with the old setting
+    CHECK_EQ(freqgen_set(2, 20), 1);
+    rise = last_rise;
+    match();
+    CHECK_EQ(last_fall - rise, 5000);
+    match();
+    CHECK_EQ(last_rise - rise, 10000);
+    CHECK_EQ(T1CONbits.T1CKPS, 3);      // 1:8 from the new period on
+    check_periods(100, 500000, 100000);
+
+    // Requested in the low half
+    match();
+    CHECK_EQ(freqgen_set(1000, 50), 1);
+    rise = last_rise;
+    match();
+    CHECK_EQ(last_rise - rise, 500000);
+    check_periods(100, 1000, 500);
+}
+
+static void test_stop(void)
+{
+    start(10, 50);
+    match();
+    freqgen_stop();
+    CHECK_EQ(RC4, 0);
+    CHECK_EQ(TMR1ON, 0);
+    CHECK_EQ(CCP1IE, 0);
+    CHECK_EQ(freqgen_set(10, 50), 1);   // Restarts high
+    CHECK_EQ(RC4, 1);
+}
+
+int main(void)
+{
+    RUN_TEST(test_init_and_default);
+    RUN_TEST(test_exact_period);
+    RUN_TEST(test_prescaler_matches_clockcalc);
+    RUN_TEST(test_range);
+    RUN_TEST(test_retune_at_period_boundary);
+    RUN_TEST(test_stop);
+    return TEST_RESULT();
+}
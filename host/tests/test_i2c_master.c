@@ -0,0 +1,309 @@
+/* File:   test_i2c_master.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Host tests for the interrupt-driven I2C master of 05-PIC16F_I2C (i2c_master.c).
+ * bus_step() plays the MSSP and a slave: it completes the command the driver issued
+ * (SEN/RSEN/PEN/RCEN/ACKEN, or the byte written to SSPBUF), records it in 'bus_log',
+ * then raises SSPIF and calls the ISR.
+ */
+
+#include <string.h>
+#include <xc.h>
+#include "test.h"
+#include "../../05-PIC16F_I2C/LAB_05_I2C_MASTER.X/i2c_master.h"
+
+// Bus trace: S start, R repeated start, P stop, W byte written, r byte read, A/N ack/nack sent
+static char bus_log[64];
+static uint8_t log_len;
+static uint8_t written[16];
+static uint8_t written_count;
+
+// Simulated slave
+static uint8_t slave_data[8] = { 0xA1, 0xB2, 0xC3, 0xD4, 0xE5, 0xF6, 0x07, 0x18 };
+static uint8_t slave_pos;
+static uint8_t slave_nack_at;   // Written byte number that is not acknowledged (0 = none)
+
+static int callbacks;
+static i2c_transfer_t *last_done;
+
+static void on_done(i2c_transfer_t *transfer)
+{
+    callbacks++;
+    last_done = transfer;
+}
+
+static void reset_bus(void)
+{
+    memset(bus_log, 0, sizeof(bus_log));
+    log_len = 0;
+    written_count = 0;
+    slave_pos = 0;
+    slave_nack_at = 0;
+    callbacks = 0;
+    last_done = 0;
+    i2c_master_init(9, 1);
+}
+
+static void bus_step(void)
+{
+    char event;
+    if (SEN) {
+        SEN = 0;
+        event = 'S';
+    } else if (RSEN) {
+        RSEN = 0;
+        event = 'R';
+    } else if (PEN) {
+        PEN = 0;
+        event = 'P';
+    } else if (RCEN) {
+        RCEN = 0;
+        SSPBUF = slave_data[slave_pos++ & 7];
+        event = 'r';
+    } else if (ACKEN) {
+        ACKEN = 0;
+        event = ACKDT ? 'N' : 'A';
+    } else {
+        written[written_count++] = SSPBUF;
+        ACKSTAT = (written_count == slave_nack_at);
+        event = 'W';
+    }
+    bus_log[log_len++] = event;
+    SSPIF = 1;
+    i2c_master_isr();
+}
+
+static void run_bus(void)
+{
+    int guard = 200;
+    while (i2c_master_busy() && guard--) {
+        bus_step();
+    }
+}
+
+static void test_init_fast_mode(void)
+{
+    i2c_master_init(9, 1);
+    CHECK_EQ(SSPCON, 0x28);
+    CHECK_EQ(SSPADD, 9);
+    CHECK_EQ(SSPSTATbits.SMP, 0);   // Slew rate control on at 400 kHz
+    CHECK_EQ(SSPIE, 1);
+    CHECK_EQ(BCLIE, 1);
+    CHECK_EQ(GIE, 1);
+    i2c_master_init(39, 0);
+    CHECK_EQ(SSPSTATbits.SMP, 1);
+}
+
+static void test_write_then_read_with_repeated_start(void)
+{
+    static const uint8_t reg[] = { 0x10 };
+    uint8_t rx[2] = { 0, 0 };
+    i2c_transfer_t t = { 0x20, reg, 1, rx, 2, on_done, 0 };
+
+    reset_bus();
+    CHECK_EQ(i2c_master_submit(&t), 1);
+    CHECK_EQ(t.status, I2C_STATUS_BUSY);
+    CHECK_EQ(SEN, 1);
+    run_bus();
+    CHECK(strcmp(bus_log, "SWWRWrArNP") == 0);
+    CHECK_EQ(written[0], 0x40);     // Address + write
+    CHECK_EQ(written[1], 0x10);
+    CHECK_EQ(written[2], 0x41);     // Address + read
+    CHECK_EQ(rx[0], 0xA1);
+    CHECK_EQ(rx[1], 0xB2);
+    CHECK_EQ(t.status, I2C_STATUS_OK);
+
+    // Callbacks run from the main loop only
+    CHECK_EQ(callbacks, 0);
+    CHECK_EQ(i2c_master_poll(), 1);
+    CHECK_EQ(callbacks, 1);
+    CHECK(last_done == &t);
+    CHECK_EQ(i2c_master_poll(), 0);
+}
+
+static void test_burst_read(void)
+{
+    uint8_t rx[5];
+    i2c_transfer_t t = { 0x20, 0, 0, rx, 5, 0, 0 };
+
+    reset_bus();
+    i2c_master_submit(&t);
+    run_bus();
+    CHECK(strcmp(bus_log, "SWrArArArArNP") == 0);
+    CHECK_EQ(written_count, 1);
+    CHECK_EQ(written[0], 0x41);
+    CHECK_EQ(rx[0], 0xA1);
+    CHECK_EQ(rx[4], 0xE5);
+    CHECK_EQ(t.status, I2C_STATUS_OK);
+}
+
+static void test_burst_write(void)
+{
+    static const uint8_t data[] = { 1, 2, 3 };
+    i2c_transfer_t t = { 0x50, data, 3, 0, 0, 0, 0 };
+
+    reset_bus();
+    i2c_master_submit(&t);
+    run_bus();
+    CHECK(strcmp(bus_log, "SWWWWP") == 0);
+    CHECK_EQ(written[0], 0xA0);
+    CHECK_EQ(written[3], 3);
+    CHECK_EQ(t.status, I2C_STATUS_OK);
+}
+
+static void test_nack_stops_transfer(void)
+{
+    static const uint8_t data[] = { 1, 2, 3 };
+    i2c_transfer_t t = { 0x50, data, 3, 0, 0, on_done, 0 };
+    i2c_transfer_t probe = { 0x51, 0, 0, 0, 0, on_done, 0 };
+    i2c_stats_t stats;
+
+    // Address not acknowledged
+    reset_bus();
+    slave_nack_at = 1;
+    i2c_master_submit(&t);
+    run_bus();
+    CHECK(strcmp(bus_log, "SWP") == 0);
+    CHECK_EQ(t.status, I2C_STATUS_NACK);
+
+    // Second data byte not acknowledged
+    reset_bus();
+    slave_nack_at = 3;
+    i2c_master_submit(&t);
+    run_bus();
+    CHECK(strcmp(bus_log, "SWWWP") == 0);
+    CHECK_EQ(t.status, I2C_STATUS_NACK);
+    i2c_master_get_stats(&stats);
+    CHECK_EQ(stats.nacks, 1);
+
+    // Address-only probe
+    reset_bus();
+    i2c_master_submit(&probe);
+    run_bus();
+    CHECK(strcmp(bus_log, "SWP") == 0);
+    CHECK_EQ(probe.status, I2C_STATUS_OK);
+}
+
+static void test_queue_runs_back_to_back(void)
+{
+    uint8_t rx[4][1];
+    i2c_transfer_t t[5];
+    int i;
+
+    reset_bus();
+    for (i = 0; i < 5; i++) {
+        i2c_transfer_t init = { (uint8_t)(0x20 + i), 0, 0, rx[i & 3], 1, on_done, 0 };
+        t[i] = init;
+    }
+    for (i = 0; i < I2C_QUEUE_SIZE; i++) {
+        CHECK_EQ(i2c_master_submit(&t[i]), 1);
+    }
+    CHECK_EQ(i2c_master_submit(&t[4]), 0);     // Full
+    CHECK_EQ(t[0].status, I2C_STATUS_BUSY);
+    CHECK_EQ(t[1].status, I2C_STATUS_QUEUED);
+
+    run_bus();
+    CHECK(strcmp(bus_log, "SWrNPSWrNPSWrNPSWrNP") == 0);
+    CHECK_EQ(written[3], 0x47);
+    CHECK_EQ(t[3].status, I2C_STATUS_OK);
+
+    // Slots are reused only once the main loop has seen the results
+    CHECK_EQ(i2c_master_submit(&t[4]), 0);
+    CHECK_EQ(i2c_master_poll(), 4);
+    CHECK_EQ(callbacks, 4);
+    CHECK_EQ(i2c_master_submit(&t[4]), 1);
+}
+
+static void test_timeout_recovers_bus(void)
+{
+    uint8_t rx[2];
+    i2c_transfer_t stuck = { 0x20, 0, 0, rx, 2, on_done, 0 };
+    i2c_transfer_t next = { 0x21, 0, 0, rx, 1, on_done, 0 };
+    i2c_stats_t stats;
+    int i;
+
+    reset_bus();
+    i2c_master_submit(&stuck);
+    i2c_master_submit(&next);
+    bus_step();                         // Start done, address written; the slave holds SCL
+    for (i = 0; i < I2C_TIMEOUT_TICKS - 1; i++) {
+        i2c_master_tick();
+    }
+    CHECK_EQ(stuck.status, I2C_STATUS_BUSY);
+    i2c_master_tick();
+    CHECK_EQ(SSPIE, 0);
+    i2c_master_get_stats(&stats);       // Leaves the ISR side switched off
+    CHECK_EQ(SSPIE, 0);
+    CHECK_EQ(BCLIE, 0);
+
+    CHECK_EQ(i2c_master_poll(), 1);
+    CHECK_EQ(stuck.status, I2C_STATUS_TIMEOUT);
+    CHECK(last_done == &stuck);
+    CHECK_EQ(SSPEN, 1);
+    CHECK_EQ(SSPIE, 1);
+    CHECK_EQ(TRISC & 0x18, 0x18);      // SCL and SDA released
+    i2c_master_get_stats(&stats);
+    CHECK_EQ(stats.timeouts, 1);
+
+    // The next transfer starts on the recovered bus
+    CHECK_EQ(next.status, I2C_STATUS_BUSY);
+    CHECK_EQ(SEN, 1);
+    run_bus();
+    CHECK_EQ(next.status, I2C_STATUS_OK);
+}
+
+static void test_progress_restarts_timeout(void)
+{
+    uint8_t rx[8];
+    i2c_transfer_t t = { 0x20, 0, 0, rx, 8, 0, 0 };
+    int i;
+
+    reset_bus();
+    i2c_master_submit(&t);
+    while (i2c_master_busy()) {
+        for (i = 0; i < I2C_TIMEOUT_TICKS - 1; i++) {
+            i2c_master_tick();
+        }
+        bus_step();
+    }
+    CHECK_EQ(t.status, I2C_STATUS_OK);
+}
+
+static void test_collision_abandons_transfer(void)
+{
+    uint8_t rx[2];
+    i2c_transfer_t a = { 0x20, 0, 0, rx, 2, on_done, 0 };
+    i2c_transfer_t b = { 0x21, 0, 0, rx, 1, on_done, 0 };
+    i2c_stats_t stats;
+
+    reset_bus();
+    i2c_master_submit(&a);
+    i2c_master_submit(&b);
+    bus_step();
+    BCLIF = 1;
+    SEN = 0;
+    i2c_master_isr();
+    CHECK_EQ(BCLIF, 0);
+    CHECK_EQ(a.status, I2C_STATUS_COLLISION);
+    CHECK_EQ(b.status, I2C_STATUS_BUSY);
+    i2c_master_get_stats(&stats);
+    CHECK_EQ(stats.collisions, 1);
+    run_bus();
+    CHECK_EQ(b.status, I2C_STATUS_OK);
+    CHECK_EQ(i2c_master_poll(), 2);
+}
+
+int main(void)
+{
+    RUN_TEST(test_init_fast_mode);
+    RUN_TEST(test_write_then_read_with_repeated_start);
+    RUN_TEST(test_burst_read);
+    RUN_TEST(test_burst_write);
+    RUN_TEST(test_nack_stops_transfer);
+    RUN_TEST(test_queue_runs_back_to_back);
+    RUN_TEST(test_timeout_recovers_bus);
+    RUN_TEST(test_progress_restarts_timeout);
+    RUN_TEST(test_collision_abandons_transfer);
+    return TEST_RESULT();
+}
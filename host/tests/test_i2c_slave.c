@@ -0,0 +1,183 @@
+/* File:   test_i2c_slave.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Host tests for the I2C slave register file of 05-PIC16F_I2C (i2c_slave.c).
+ * Each helper sets SSPSTAT/SSPBUF as the MSSP does in one of the AN734 states, holds SCL
+ * (CKP = 0, clock stretching) and calls the ISR, which must release it again.
+ */
+
+#include <xc.h>
+#include "test.h"
+#include "../../05-PIC16F_I2C/LAB_05_I2C_SLAVE.X/i2c_slave.h"
+
+#define ADDRESS 0x20
+
+static void event(uint8_t r_nw, uint8_t d_na, uint8_t bf, uint8_t data)
+{
+    R_nW = r_nw;
+    D_nA = d_na;
+    BF = bf;
+    if (bf) {
+        SSPBUF = data;
+    }
+    CKP = 0;
+    SSPIF = 1;
+    i2c_slave_isr();
+    CHECK_EQ(CKP, 1);
+    CHECK_EQ(SSPIF, 0);
+}
+
+// State 1 + state 2 bytes: write 'count' bytes after the address
+static void master_write(const uint8_t *bytes, uint8_t count)
+{
+    uint8_t i;
+    event(0, 0, 1, (uint8_t)(ADDRESS << 1));
+    for (i = 0; i < count; i++) {
+        event(0, 1, 1, bytes[i]);
+    }
+}
+
+// State 3, state 4 for every ACKed byte, then the master NACK (state 5)
+static void master_read(uint8_t *bytes, uint8_t count)
+{
+    uint8_t i;
+    event(1, 0, 1, (uint8_t)((ADDRESS << 1) | 1));
+    bytes[0] = SSPBUF;
+    for (i = 1; i < count; i++) {
+        event(1, 1, 0, 0);
+        bytes[i] = SSPBUF;
+    }
+    event(0, 1, 0, 0);
+}
+
+static void test_init(void)
+{
+    i2c_slave_init(ADDRESS);
+    CHECK_EQ(SSPADD, 0x40);
+    CHECK_EQ(SSPCON, 0x36);
+    CHECK_EQ(SSPCON2bits.SEN, 1);       // Stretch on receive too
+    CHECK_EQ(SSPIE, 1);
+    CHECK_EQ(GIE, 1);
+    CHECK_EQ(i2c_slave_get(5), 0);
+}
+
+static void test_write_block_auto_increment(void)
+{
+    static const uint8_t frame[] = { 4, 0x11, 0x22, 0x33 };
+    i2c_slave_stats_t stats;
+
+    i2c_slave_init(ADDRESS);
+    CHECK_EQ(i2c_slave_written(), 0);
+    master_write(frame, sizeof(frame));
+    CHECK_EQ(i2c_slave_get(3), 0);
+    CHECK_EQ(i2c_slave_get(4), 0x11);
+    CHECK_EQ(i2c_slave_get(5), 0x22);
+    CHECK_EQ(i2c_slave_get(6), 0x33);
+    CHECK_EQ(i2c_slave_written(), 1);
+    CHECK_EQ(i2c_slave_written(), 0);
+    i2c_slave_get_stats(&stats);
+    CHECK_EQ(stats.writes, 3);
+    CHECK_EQ(SSPIE, 1);
+}
+
+static void test_register_read_after_pointer_write(void)
+{
+    static const uint8_t pointer[] = { 2 };
+    uint8_t got[4];
+    uint8_t i;
+
+    i2c_slave_init(ADDRESS);
+    for (i = 0; i < I2C_SLAVE_REG_COUNT; i++) {
+        i2c_slave_set(i, (uint8_t)(0xA0 + i));
+    }
+    // Write {2} + repeated start + read 4 bytes
+    master_write(pointer, 1);
+    master_read(got, 4);
+    CHECK_EQ(got[0], 0xA2);
+    CHECK_EQ(got[1], 0xA3);
+    CHECK_EQ(got[2], 0xA4);
+    CHECK_EQ(got[3], 0xA5);
+    CHECK_EQ(i2c_slave_written(), 0);   // A pointer alone writes nothing
+
+    // A read without a new pointer continues where the last one stopped
+    master_read(got, 1);
+    CHECK_EQ(got[0], 0xA6);
+}
+
+static void test_pointer_wraps(void)
+{
+    static const uint8_t frame[] = { I2C_SLAVE_REG_COUNT - 1, 0x55, 0x66 };
+    static const uint8_t last[] = { I2C_SLAVE_REG_COUNT - 1 };
+    uint8_t got[3];
+
+    i2c_slave_init(ADDRESS);
+    i2c_slave_set(0, 0x99);
+    master_write(frame, sizeof(frame));
+    CHECK_EQ(i2c_slave_get(I2C_SLAVE_REG_COUNT - 1), 0x55);
+    CHECK_EQ(i2c_slave_get(0), 0x99);   // Wrapped to register 0, which is read-only
+    CHECK_EQ(i2c_slave_get(1), 0);
+
+    master_write(last, 1);
+    master_read(got, 3);
+    CHECK_EQ(got[0], 0x55);
+    CHECK_EQ(got[1], 0x99);
+    CHECK_EQ(got[2], 0);
+}
+
+static void test_master_nack_ends_read(void)
+{
+    uint8_t got[2];
+
+    i2c_slave_init(ADDRESS);
+    i2c_slave_set(0, 0x12);
+    i2c_slave_set(1, 0x34);
+    master_read(got, 2);
+    SSPBUF = 0xEE;
+    event(0, 1, 0, 0);                  // Another NACK event loads nothing
+    CHECK_EQ(SSPBUF, 0xEE);
+    master_read(got, 1);
+    CHECK_EQ(got[0], 0);                // Register 2, after the two already read
+}
+
+static void test_overflow_is_counted(void)
+{
+    static const uint8_t frame[] = { 3, 0x77 };
+    i2c_slave_stats_t stats;
+
+    i2c_slave_init(ADDRESS);
+    event(0, 0, 1, 0x40);
+    SSPOV = 1;
+    event(0, 1, 1, 3);
+    CHECK_EQ(SSPOV, 0);
+    i2c_slave_get_stats(&stats);
+    CHECK_EQ(stats.overflows, 1);
+
+    // The next write starts cleanly
+    master_write(frame, sizeof(frame));
+    CHECK_EQ(i2c_slave_get(3), 0x77);
+}
+
+static void test_out_of_range_pointer(void)
+{
+    static const uint8_t frame[] = { 0xF0, 0x42 };
+
+    i2c_slave_init(ADDRESS);
+    master_write(frame, sizeof(frame));
+    CHECK_EQ(i2c_slave_get(0), 0);      // Pointer 0: read-only, ignored
+    CHECK_EQ(i2c_slave_get(1), 0);
+    i2c_slave_set(I2C_SLAVE_REG_COUNT, 1);
+    CHECK_EQ(i2c_slave_get(I2C_SLAVE_REG_COUNT), 0);
+}
+
+int main(void)
+{
+    RUN_TEST(test_init);
+    RUN_TEST(test_write_block_auto_increment);
+    RUN_TEST(test_register_read_after_pointer_write);
+    RUN_TEST(test_pointer_wraps);
+    RUN_TEST(test_master_nack_ends_read);
+    RUN_TEST(test_overflow_is_counted);
+    RUN_TEST(test_out_of_range_pointer);
+    return TEST_RESULT();
+}
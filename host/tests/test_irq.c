@@ -0,0 +1,155 @@
+/* File:   test_irq.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Host tests for the central interrupt dispatcher of common/irq.c. isr() is an interrupt
+ * routine with a test service order; the handlers log their source and move Timer1 on to
+ * stand for their run time.
+ */
+
+#include <string.h>
+#include "test.h"
+
+#define IRQ_ORDER(X) X(INT) X(TMR2) X(SSP) X(EE)
+#include "../../common/irq.h"
+
+static char order[16];
+static uint8_t order_len;
+
+static void isr(void)
+{
+    IRQ_DISPATCH();
+}
+
+static void log_source(char c, unsigned run)
+{
+    order[order_len++] = c;
+    order[order_len] = 0;
+    TMR1 = (uint16_t)(TMR1 + run);
+}
+
+static void int_handler(void)  { INTF = 0; log_source('I', 10); }
+static void tmr2_handler(void) { TMR2IF = 0; log_source('T', 25); }
+static void ssp_handler(void)  { SSPIF = 0; log_source('S', 40); }
+
+static void start(void)
+{
+    order_len = 0;
+    order[0] = 0;
+    irq_init();
+    irq_register(IRQ_INT, int_handler);
+    irq_register(IRQ_TMR2, tmr2_handler);
+    irq_register(IRQ_SSP, ssp_handler);
+    INTE = 1;
+    TMR2IE = 1;
+    SSPIE = 1;
+}
+
+static void test_service_order(void)
+{
+    start();
+    SSPIF = 1;
+    TMR2IF = 1;
+    INTF = 1;
+    isr();
+    CHECK(strcmp(order, "ITS") == 0);
+    CHECK_EQ(INTF, 0);
+    CHECK_EQ(TMR2IF, 0);
+    CHECK_EQ(SSPIF, 0);
+
+    // Only pending sources run
+    order_len = 0;
+    SSPIF = 1;
+    isr();
+    CHECK(strcmp(order, "S") == 0);
+}
+
+static void test_enable_bit_is_checked(void)
+{
+    irq_stats_t stats;
+
+    start();
+    TMR2IE = 0;
+    TMR2IF = 1;                         // Flag set by a timer used without its interrupt
+    INTF = 1;
+    isr();
+    CHECK(strcmp(order, "I") == 0);
+    CHECK_EQ(TMR2IF, 1);
+    irq_get_stats(IRQ_TMR2, &stats);
+    CHECK_EQ(stats.count, 0);
+}
+
+static void test_unregistered_source_is_disabled(void)
+{
+    start();
+    EEIE = 1;
+    EEIF = 1;
+    INTF = 1;
+    isr();
+    CHECK(strcmp(order, "I") == 0);
+    CHECK_EQ(EEIE, 0);                  // Would otherwise re-enter forever
+    CHECK_EQ(INTE, 1);
+
+    // A source outside IRQ_ORDER is never looked at
+    irq_register(IRQ_CCP1, int_handler);
+    CCP1IE = 1;
+    CCP1IF = 1;
+    order_len = 0;
+    order[0] = 0;
+    isr();
+    CHECK_EQ(order_len, 0);
+}
+
+static void test_counts_and_latency(void)
+{
+    irq_stats_t stats;
+
+    start();
+    TMR1 = 1000;
+    INTF = 1;
+    TMR2IF = 1;
+    SSPIF = 1;
+    isr();
+    TMR1 = 0xFFF0;                      // Across the Timer1 wrap
+    SSPIF = 1;
+    isr();
+
+    irq_get_stats(IRQ_INT, &stats);
+    CHECK_EQ(stats.count, 1);
+    CHECK_EQ(stats.max_wait, 0);
+    CHECK_EQ(stats.max_run, 10);
+    irq_get_stats(IRQ_TMR2, &stats);
+    CHECK_EQ(stats.max_wait, 10);       // Behind INT
+    CHECK_EQ(stats.max_run, 25);
+    irq_get_stats(IRQ_SSP, &stats);
+    CHECK_EQ(stats.count, 2);
+    CHECK_EQ(stats.max_wait, 35);       // Behind INT and TMR2
+    CHECK_EQ(stats.max_run, 40);
+
+    irq_init();
+    irq_get_stats(IRQ_SSP, &stats);
+    CHECK_EQ(stats.count, 0);
+    CHECK_EQ(stats.max_run, 0);
+}
+
+static void test_register_keeps_gie(void)
+{
+    start();
+    GIE = 1;
+    irq_register(IRQ_TMR2, 0);
+    CHECK_EQ(GIE, 1);
+    irq_register(IRQ_COUNT, int_handler);  // Ignored
+    GIE = 0;
+    irq_init();
+    CHECK_EQ(GIE, 0);
+}
+
+int main(void)
+{
+    RUN_TEST(test_service_order);
+    RUN_TEST(test_enable_bit_is_checked);
+    RUN_TEST(test_unregistered_source_is_disabled);
+    RUN_TEST(test_counts_and_latency);
+    RUN_TEST(test_register_keeps_gie);
+    return TEST_RESULT();
+}
@@ -0,0 +1,126 @@
+/* File:   test_numfmt.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Host tests for the integer formatting module common/numfmt.c, checked against the C
+ * library (sprintf) and exact integer arithmetic.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <xc.h>
+#include "test.h"
+#include "../../common/numfmt.h"
+
+#define CHECK_STR(actual, expected) do { \
+    if (strcmp((actual), (expected)) != 0) { \
+        printf("  %s:%d: \"%s\", expected \"%s\"\n", __FILE__, __LINE__, (actual), (expected)); \
+        test_failures++; \
+    } \
+} while (0)
+
+static void test_u16_matches_printf(void)
+{
+    char buf[NUMFMT_U16_SIZE], ref[16];
+    uint32_t v;
+    for (v = 0; v <= 0xFFFF; v++) {
+        uint8_t n = numfmt_u16(buf, (uint16_t)v);
+        sprintf(ref, "%u", (unsigned)v);
+        if (strcmp(buf, ref) != 0 || n != strlen(ref)) {
+            CHECK_STR(buf, ref);
+            break;
+        }
+    }
+}
+
+static void test_u32_boundaries(void)
+{
+    static const uint32_t values[] = {
+        0, 9, 10, 65535, 65536, 99999, 100000, 999999999UL, 1000000000UL,
+        1234567890UL, 4000000000UL, 4294967295UL
+    };
+    char buf[NUMFMT_U32_SIZE], ref[16];
+    size_t i;
+    for (i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        uint8_t n = numfmt_u32(buf, values[i]);
+        sprintf(ref, "%lu", (unsigned long)values[i]);
+        CHECK_STR(buf, ref);
+        CHECK_EQ(n, strlen(ref));
+    }
+}
+
+static void test_u32_sweep(void)
+{
+    char buf[NUMFMT_U32_SIZE], ref[16];
+    uint32_t v = 1;
+    // Multiplicative sweep through every digit count
+    while (v < 4000000000UL) {
+        numfmt_u32(buf, v);
+        sprintf(ref, "%lu", (unsigned long)v);
+        if (strcmp(buf, ref) != 0) {
+            CHECK_STR(buf, ref);
+            break;
+        }
+        v = v * 3 + 7;
+    }
+}
+
+static void test_hex(void)
+{
+    char buf[5];
+    CHECK_EQ(numfmt_hex(buf, 0xBEEF, 4), 4);
+    CHECK_STR(buf, "BEEF");
+    numfmt_hex(buf, 0x0A, 2);
+    CHECK_STR(buf, "0A");
+    numfmt_hex(buf, 0x1234, 2);
+    CHECK_STR(buf, "34");
+    numfmt_hex(buf, 0x7, 1);
+    CHECK_STR(buf, "7");
+    numfmt_hex(buf, 0x7, 0);
+    CHECK_STR(buf, "7");
+}
+
+static void test_fixed(void)
+{
+    char buf[8];
+    CHECK_EQ(numfmt_fixed(buf, 489, 2), 4);
+    CHECK_STR(buf, "4.89");
+    numfmt_fixed(buf, 5, 2);
+    CHECK_STR(buf, "0.05");
+    numfmt_fixed(buf, 0, 3);
+    CHECK_STR(buf, "0.000");
+    numfmt_fixed(buf, 5000, 3);
+    CHECK_STR(buf, "5.000");
+    numfmt_fixed(buf, 65535, 1);
+    CHECK_STR(buf, "6553.5");
+    numfmt_fixed(buf, 42, 0);
+    CHECK_STR(buf, "42");
+    CHECK_EQ(numfmt_fixed(buf, 7, 4), 6);
+    CHECK_STR(buf, "0.0007");
+}
+
+static void test_adc_units_exact(void)
+{
+    // Default scale: millivolts from a 5 V reference
+    uint32_t raw;
+    CHECK_EQ(NUMFMT_ADC_UNITS(0), 0);
+    CHECK_EQ(NUMFMT_ADC_UNITS(1023), 5000);
+    for (raw = 0; raw <= 1023; raw++) {
+        uint32_t exact = (raw * NUMFMT_VREF_MV * 2 + NUMFMT_DIVISOR) / (2 * NUMFMT_DIVISOR);
+        if (NUMFMT_ADC_UNITS(raw) != exact) {
+            CHECK_EQ(NUMFMT_ADC_UNITS(raw), exact);
+            break;
+        }
+    }
+}
+
+int main(void)
+{
+    RUN_TEST(test_u16_matches_printf);
+    RUN_TEST(test_u32_boundaries);
+    RUN_TEST(test_u32_sweep);
+    RUN_TEST(test_hex);
+    RUN_TEST(test_fixed);
+    RUN_TEST(test_adc_units_exact);
+    return TEST_RESULT();
+}
@@ -0,0 +1,391 @@
+/* File:   test_periph14.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Host tests for the PIC16F877A peripheral models (host/tools/periph14.c). Small
+ * hand-assembled programs configure one peripheral each; the checks compare the cycle of
+ * every flag and output edge with the datasheet timing. The last test runs the shipped
+ * 03 UART image, types a line into its receiver and reads back the echo.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "test.h"
+#include "../tools/periph14.h"
+
+// Opcodes
+#define NOP_           0x0000
+#define SLEEP_         0x0063
+#define MOVWF_(f)      (0x0080 | (f))
+#define CLRF_(f)       (0x0180 | (f))
+#define MOVF_(f, d)    (0x0800 | ((d) << 7) | (f))
+#define INCF_(f, d)    (0x0A00 | ((d) << 7) | (f))
+#define BCF_(f, b)     (0x1000 | ((b) << 7) | (f))
+#define BSF_(f, b)     (0x1400 | ((b) << 7) | (f))
+#define BTFSC_(f, b)   (0x1800 | ((b) << 7) | (f))
+#define BTFSS_(f, b)   (0x1C00 | ((b) << 7) | (f))
+#define GOTO_(k)       (0x2800 | (k))
+#define MOVLW_(k)      (0x3000 | (k))
+#define RETFIE_        0x0009
+
+// Register file offsets (bank selected with RP0/RP1)
+#define F_TMR0    0x01
+#define F_STATUS  0x03
+#define F_PORTB   0x06
+#define F_INTCON  0x0B
+#define F_PIR1    0x0C
+#define F_T2CON   0x12
+#define F_SSPBUF  0x13
+#define F_SSPCON  0x14
+#define F_CCPR1L  0x15
+#define F_CCP1CON 0x17
+#define F_RCSTA   0x18
+#define F_TXREG   0x19
+#define F_ADCON0  0x1F
+#define F_OPTION  0x01      // Bank 1
+#define F_TRISB   0x06
+#define F_TRISC   0x07
+#define F_PIE1    0x0C
+#define F_PR2     0x12
+#define F_TXSTA   0x18
+#define F_SPBRG   0x19
+#define F_ADCON1  0x1F
+#define F_EEDATA  0x0C      // Bank 2
+#define F_EEADR   0x0D
+#define F_EECON1  0x0C      // Bank 3
+#define F_EECON2  0x0D
+
+#define BANK1     BSF_(F_STATUS, 5)
+#define BANK0     BCF_(F_STATUS, 5)
+#define BANK2     BSF_(F_STATUS, 6)
+#define BANK3     BSF_(F_STATUS, 5)     // After BANK2
+
+#define UART_IMAGE "../03-PIC16F_UART/TUTO_04.X/dist/default/production/TUTO_04.X.production.hex"
+
+static sim14_t sim;
+static periph14_t periph;
+
+// Observer log
+static uint64_t edge_cycles[64];
+static uint8_t edge_levels[64];
+static unsigned edge_count;
+static uint8_t serial_bytes[512];
+static uint64_t serial_cycles[512];
+static uint8_t serial_channels[512];
+static unsigned serial_count;
+
+static void on_pin(void *ctx, uint64_t cycle, uint8_t port, uint8_t level)
+{
+    (void)ctx;
+    if (port == PERIPH14_PORTC && edge_count < 64) {
+        edge_cycles[edge_count] = cycle;
+        edge_levels[edge_count++] = level;
+    }
+}
+
+static void on_serial(void *ctx, uint64_t cycle, uint8_t channel, uint8_t byte)
+{
+    (void)ctx;
+    if (serial_count < sizeof(serial_bytes)) {
+        serial_cycles[serial_count] = cycle;
+        serial_channels[serial_count] = channel;
+        serial_bytes[serial_count++] = byte;
+    }
+}
+
+static void start(const uint16_t *words, unsigned count, unsigned long fosc)
+{
+    unsigned i;
+
+    sim14_init(&sim);
+    for (i = 0; i < count; i++) {
+        sim14_set_word(&sim, (uint16_t)i, words[i]);
+    }
+    periph14_attach(&periph, &sim, fosc);
+    periph.observer.pin = on_pin;
+    periph.observer.serial = on_serial;
+    periph.observer.ctx = NULL;
+    edge_count = 0;
+    serial_count = 0;
+}
+
+static void test_timer0_overflow_cycle(void)
+{
+    static const uint16_t prog[] = {
+        BANK1, MOVLW_(0x00), MOVWF_(F_OPTION),  // Internal clock, prescaler 1:2
+        BANK0, CLRF_(F_TMR0),                   // Written during cycle 5: counts from cycle 7
+        NOP_, GOTO_(5)
+    };
+
+    start(prog, sizeof(prog) / sizeof(prog[0]), 4000000);
+    sim14_run(&sim, 300);
+    periph14_sync(&periph);
+    CHECK_EQ(sim14_peek(&sim, F_TMR0), (sim.cycles - 7) / 2);
+    CHECK_EQ(sim14_peek(&sim, F_INTCON) & 0x04, 0);
+
+    // 256 counts of 2 cycles: T0IF at cycle 7 + 512
+    sim14_run(&sim, 519 - sim.cycles);
+    CHECK_EQ(sim14_peek(&sim, F_INTCON) & 0x04, 0);
+    sim14_run(&sim, 3);
+    CHECK_EQ(sim14_peek(&sim, F_INTCON) & 0x04, 0x04);
+}
+
+static void test_timer2_postscaler_interrupts(void)
+{
+    static const uint16_t prog[] = {
+        GOTO_(8), NOP_, NOP_, NOP_,
+        INCF_(0x70, 1), BCF_(F_PIR1, 1), RETFIE_, NOP_,
+        BANK1, MOVLW_(9), MOVWF_(F_PR2),        // Period 10 cycles
+        BSF_(F_PIE1, 1), BANK0,
+        MOVLW_(0xC0), MOVWF_(F_INTCON),         // GIE, PEIE
+        MOVLW_(0x1C), MOVWF_(F_T2CON),          // On, postscaler 1:4, written during cycle 11
+        NOP_, GOTO_(17)
+    };
+
+    start(prog, sizeof(prog) / sizeof(prog[0]), 4000000);
+    sim14_run(&sim, 11 + 4000 + 10);
+    // TMR2IF every 40 cycles from cycle 11
+    CHECK_EQ(sim14_peek(&sim, 0x70), 100);
+    periph14_sync(&periph);
+    CHECK_EQ(sim14_peek(&sim, 0x11), (sim.cycles - 11) % 10);
+}
+
+static void test_pwm_output_edges(void)
+{
+    static const uint16_t prog[] = {
+        BANK1, MOVLW_(99), MOVWF_(F_PR2),       // 100-cycle period
+        BCF_(F_TRISC, 2), BANK0,
+        MOVLW_(25), MOVWF_(F_CCPR1L),           // Duty 100 Tosc = 25 cycles
+        MOVLW_(0x0C), MOVWF_(F_CCP1CON),
+        MOVLW_(0x04), MOVWF_(F_T2CON),          // Written during cycle 11
+        NOP_, GOTO_(11)
+    };
+
+    start(prog, sizeof(prog) / sizeof(prog[0]), 4000000);
+    sim14_run(&sim, 1000);
+    CHECK(edge_count >= 6);
+    CHECK_EQ(edge_levels[0] & 0x04, 0x04);
+    CHECK_EQ(edge_cycles[0], 111);
+    CHECK_EQ(edge_levels[1] & 0x04, 0);
+    CHECK_EQ(edge_cycles[1] - edge_cycles[0], 25);
+    CHECK_EQ(edge_cycles[2] - edge_cycles[0], 100);
+    CHECK_EQ(edge_cycles[4] - edge_cycles[2], 100);
+}
+
+static void test_uart_back_to_back_frames(void)
+{
+    static const uint16_t prog[] = {
+        BANK1, MOVLW_(25), MOVWF_(F_SPBRG),
+        MOVLW_(0x24), MOVWF_(F_TXSTA),          // TXEN, BRGH: 4 x 26 cycles per bit
+        BANK0, MOVLW_(0x80), MOVWF_(F_RCSTA),   // SPEN during cycle 8
+        MOVLW_('A'), MOVWF_(F_TXREG),           // TSR loaded during cycle 10
+        BTFSS_(F_PIR1, 4), GOTO_(10),           // TXIF: TXREG empty again
+        MOVLW_('B'), MOVWF_(F_TXREG),
+        NOP_, GOTO_(14)
+    };
+
+    start(prog, sizeof(prog) / sizeof(prog[0]), 4000000);
+    sim14_run(&sim, 3000);
+    CHECK_EQ(serial_count, 2);
+    CHECK_EQ(serial_bytes[0], 'A');
+    CHECK_EQ(serial_bytes[1], 'B');
+    CHECK_EQ(serial_cycles[0], 10 + 1040);
+    CHECK_EQ(serial_cycles[1], 10 + 2080);
+    CHECK_EQ(periph.bytes[PERIPH14_UART_TX], 2);
+    CHECK_EQ(sim14_peek(&sim, 0x98) & 0x02, 0x02);  // TRMT
+}
+
+static void test_uart_receive_overrun(void)
+{
+    static const uint16_t prog[] = {
+        BANK1, MOVLW_(25), MOVWF_(F_SPBRG), MOVLW_(0x04), MOVWF_(F_TXSTA),
+        BANK0, MOVLW_(0x90), MOVWF_(F_RCSTA),   // SPEN, CREN
+        NOP_, GOTO_(8)
+    };
+
+    start(prog, sizeof(prog) / sizeof(prog[0]), 4000000);
+    CHECK(periph14_uart(&periph, 100, (const uint8_t *)"xyz", 3));
+    sim14_run(&sim, 100 + 2 * 1040 + 10);
+    CHECK_EQ(sim14_peek(&sim, F_PIR1) & 0x20, 0x20);  // RCIF
+    CHECK_EQ(periph.rx_count, 2);
+    CHECK_EQ(sim14_peek(&sim, F_RCSTA) & 0x02, 0);
+
+    // The third byte finds the two-byte FIFO full
+    sim14_run(&sim, 1040);
+    CHECK_EQ(sim14_peek(&sim, F_RCSTA) & 0x02, 0x02);  // OERR
+    CHECK_EQ(periph.rx_overruns, 1);
+    CHECK_EQ(periph.rx_fifo[0], 'x');
+    CHECK_EQ(periph.rx_fifo[1], 'y');
+}
+
+static void test_adc_conversion(void)
+{
+    static const uint16_t prog[] = {
+        BANK1, MOVLW_(0x80), MOVWF_(F_ADCON1),  // Right justified
+        BANK0, MOVLW_(0x81), MOVWF_(F_ADCON0),  // Fosc/32, AN0, ADON
+        BSF_(F_ADCON0, 2),                      // GO during cycle 7
+        BTFSC_(F_ADCON0, 2), GOTO_(7),
+        GOTO_(9)
+    };
+
+    start(prog, sizeof(prog) / sizeof(prog[0]), 4000000);
+    CHECK(periph14_analog(&periph, 0, 0, 2500));
+    CHECK_EQ(sim14_run(&sim, 1000), SIM14_HALT);
+    CHECK_EQ(periph.conversions, 1);
+    CHECK_EQ(sim14_peek(&sim, 0x1E) << 8 | sim14_peek(&sim, 0x9E), 512);
+    CHECK_EQ(sim14_peek(&sim, F_PIR1) & 0x40, 0x40);  // ADIF
+    // 12 TAD of 8 cycles, then at most one poll loop, the skip and goto $
+    CHECK(sim.cycles >= 7 + 96 && sim.cycles <= 7 + 96 + 7);
+}
+
+static void test_eeprom_write_needs_unlock(void)
+{
+    static const uint16_t prog[] = {
+        BANK2, MOVLW_(5), MOVWF_(F_EEADR),
+        MOVLW_(0x3C), MOVWF_(F_EEDATA),
+        BANK3, BSF_(F_EECON1, 2),               // WREN
+        BSF_(F_EECON1, 1),                      // WR without 55h/AAh: ignored
+        MOVLW_(0x55), MOVWF_(F_EECON2), MOVLW_(0xAA), MOVWF_(F_EECON2),
+        BSF_(F_EECON1, 1),                      // Starts during cycle 13
+        BTFSC_(F_EECON1, 1), GOTO_(13),
+        GOTO_(15)
+    };
+
+    start(prog, sizeof(prog) / sizeof(prog[0]), 4000000);
+    sim14_run(&sim, 12);
+    CHECK_EQ(sim14_peek(&sim, 0x18C) & 0x02, 0);
+    CHECK_EQ(sim14_run(&sim, 10000), SIM14_HALT);
+    CHECK_EQ(periph.eeprom[5], 0x3C);
+    CHECK_EQ(periph.ee_writes, 1);
+    CHECK_EQ(sim14_peek(&sim, 0x0D) & 0x10, 0x10);    // EEIF
+    // 4 ms at 1 MHz instruction rate, then at most one poll loop, the skip and goto $
+    CHECK(sim.cycles >= 13 + 4000 && sim.cycles <= 13 + 4000 + 7);
+}
+
+static void test_spi_master_exchange(void)
+{
+    static const uint16_t prog[] = {
+        BANK1, BCF_(F_TRISC, 5), BCF_(F_TRISC, 3), BANK0,
+        MOVLW_(0x21), MOVWF_(F_SSPCON),         // Master, Fosc/16: 4 cycles per bit
+        MOVLW_(0x3C), MOVWF_(F_SSPBUF),
+        BANK1, BTFSS_(0x14, 0), GOTO_(9),       // SSPSTAT.BF
+        BANK0, MOVF_(F_SSPBUF, 0), MOVWF_(0x70),
+        GOTO_(14)
+    };
+    static const uint8_t reply[] = { 0xA5 };
+
+    start(prog, sizeof(prog) / sizeof(prog[0]), 4000000);
+    CHECK(periph14_spi_reply(&periph, reply, 1));
+    CHECK_EQ(sim14_run(&sim, 1000), SIM14_HALT);
+    CHECK_EQ(sim14_peek(&sim, 0x70), 0xA5);
+    CHECK_EQ(sim14_peek(&sim, 0x94) & 0x01, 0);       // BF cleared by the read
+    CHECK_EQ(serial_count, 2);
+    CHECK_EQ(serial_channels[0], PERIPH14_SPI_OUT);
+    CHECK_EQ(serial_bytes[0], 0x3C);
+    CHECK_EQ(serial_cycles[0], 8 + 32);
+    CHECK_EQ(serial_channels[1], PERIPH14_SPI_IN);
+}
+
+static void test_sleep_until_rb0_edge(void)
+{
+    static const uint16_t prog[] = {
+        BANK1, MOVLW_(0x04), MOVWF_(F_PR2), BANK0,
+        MOVLW_(0x04), MOVWF_(F_T2CON),          // Timer2 runs, frozen during SLEEP
+        MOVLW_(0x10), MOVWF_(F_INTCON),         // INTE only: wake up, no vector
+        SLEEP_,
+        MOVLW_(0x42), GOTO_(10)
+    };
+
+    start(prog, sizeof(prog) / sizeof(prog[0]), 4000000);
+    CHECK(periph14_pin(&periph, 1000000, PERIPH14_PORTB, 0, 1));
+    CHECK_EQ(sim14_run(&sim, 2000000), SIM14_HALT);
+    CHECK_EQ(sim.w, 0x42);
+    CHECK(sim.cycles >= 1000000 && sim.cycles < 1000010);
+    CHECK(sim.instructions < 20);
+    // Timer2 (one event every 5 cycles) was frozen for the whole sleep
+    CHECK(periph.events < 20);
+}
+
+static void test_script_commands(void)
+{
+    char path[] = "/tmp/periph14_XXXXXX";
+    char err[128];
+    FILE *f;
+    int fd = mkstemp(path);
+
+    CHECK(fd >= 0);
+    f = fdopen(fd, "w");
+    fprintf(f, "# stimuli\n10ms pin RB0 1\n250us analog AN3 1.25\n1200c uart \"ok\\r\\n\"\n"
+               "0 clock RA4 1000 4\ni2c-device 50\nspi-reply A5 5A\n");
+    fclose(f);
+    start(NULL, 0, 4000000);
+    CHECK_EQ(periph14_load_script(&periph, path, err, sizeof(err)), 0);
+    CHECK_EQ(periph.stimulus_count, 4);
+    CHECK_EQ(periph.stimuli[0].at, 10000);
+    CHECK_EQ(periph.stimuli[1].at, 250);
+    CHECK_EQ(periph.stimuli[2].at, 1200);
+    CHECK_EQ(periph.stimuli[2].length, 4);
+    CHECK_EQ(periph.stimuli[3].half_period, 500);
+    CHECK_EQ(periph.i2c_device, 0x50);
+    CHECK_EQ(periph.spi_in_head, 2);
+
+    f = fopen(path, "w");
+    fprintf(f, "1ms pin RB0 1\n2ms pin RX9 1\n");
+    fclose(f);
+    CHECK_EQ(periph14_load_script(&periph, path, err, sizeof(err)), -1);
+    CHECK(strstr(err, ":2:") != NULL);
+    unlink(path);
+}
+
+static void test_uart_image_echo(void)
+{
+    static const char prompt[] = "Please write your message and press enter \n";
+    static const char expected[] = "Your message is: \nhi\r\n";
+    char err[256];
+    char text[512];
+    unsigned i;
+
+    sim14_init(&sim);
+    if (sim14_load_hex(&sim, UART_IMAGE, err, sizeof(err)) != 0) {
+        printf("  %s\n", err);
+        CHECK(0);
+        return;
+    }
+    periph14_attach(&periph, &sim, 16000000);
+    periph.observer.serial = on_serial;
+    serial_count = 0;
+
+    // After the prompt and the 500 ms LED blink the firmware waits on RCIF
+    CHECK(periph14_uart(&periph, periph14_cycles(&periph, 0.7), (const uint8_t *)"hi\r", 3));
+    CHECK_EQ(sim14_run(&sim, periph14_cycles(&periph, 1.5)), SIM14_LIMIT);
+    for (i = 0; i < serial_count && i < sizeof(text) - 1; i++) {
+        text[i] = (char)serial_bytes[i];
+    }
+    text[i] = '\0';
+    CHECK(strncmp(text, prompt, sizeof(prompt) - 1) == 0);
+    CHECK(strstr(text, expected) != NULL);
+    CHECK_EQ(periph.rx_bytes, 3);
+    CHECK_EQ(periph.rx_overruns, 0);
+    // 9600 baud at 16 MHz: SPBRG 103, BRGH = 1, 4160 cycles per frame. The firmware
+    // waits for TRMT before each write, so frames are never closer than that.
+    for (i = 1; i < serial_count; i++) {
+        CHECK(serial_cycles[i] - serial_cycles[i - 1] >= 4160);
+    }
+}
+
+int main(void)
+{
+    RUN_TEST(test_timer0_overflow_cycle);
+    RUN_TEST(test_timer2_postscaler_interrupts);
+    RUN_TEST(test_pwm_output_edges);
+    RUN_TEST(test_uart_back_to_back_frames);
+    RUN_TEST(test_uart_receive_overrun);
+    RUN_TEST(test_adc_conversion);
+    RUN_TEST(test_eeprom_write_needs_unlock);
+    RUN_TEST(test_spi_master_exchange);
+    RUN_TEST(test_sleep_until_rb0_edge);
+    RUN_TEST(test_script_commands);
+    RUN_TEST(test_uart_image_echo);
+    return TEST_RESULT();
+}
@@ -0,0 +1,171 @@
+/* File:   test_pwm.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Host tests for the three-channel PWM of 08-PIC16F_PWM (pwm.c): Timer2/CCP set-up, 10-bit
+ * duties applied only at a period boundary, the Timer0-timed software channel with pulse
+ * skipping, and the gamma-corrected fade engine. period() plays one Timer2 period match.
+ */
+
+#include <xc.h>
+#include "test.h"
+#include "../../08-PIC16F_PWM/TUTO_9.X/pwm.h"
+
+static void period(void)
+{
+    TMR2IF = 1;
+    pwm_isr();
+    CHECK_EQ(TMR2IF, 0);
+}
+
+// Timer0 overflow ending the software pulse
+static void timer0_overflow(void)
+{
+    T0IF = 1;
+    pwm_isr();
+}
+
+static void test_init(void)
+{
+    pwm_init();
+    CHECK_EQ(PR2, 255);
+    CHECK_EQ(T2CONbits.T2CKPS, 1);      // 1:4
+    CHECK_EQ(TMR2ON, 1);
+    CHECK_EQ(CCP1CON, 0x0C);
+    CHECK_EQ(CCP2CON, 0x0C);
+    CHECK_EQ(TRISC & 0x07, 0);
+    CHECK_EQ(OPTION_REG & 0x3F, 0x01);  // Timer0 on Fosc/4, prescaler 1:4
+    CHECK_EQ(TMR2IE, 1);
+    CHECK_EQ(GIE, 1);
+}
+
+static void test_duty_applied_at_period_boundary(void)
+{
+    pwm_init();
+    pwm_set_duty(PWM_CH_CCP1, 0x2B7);
+    pwm_set_duty(PWM_CH_CCP2, 1023);
+    CHECK_EQ(CCPR1L, 0);                // Not yet
+    period();
+    CHECK_EQ(CCPR1L, 0xAD);
+    CHECK_EQ(CCP1CONbits.DC1B, 3);
+    CHECK_EQ(CCP1CON & 0x0F, 0x0C);
+    CHECK_EQ(CCPR2L, 0xFF);
+    CHECK_EQ(CCP2CONbits.DC2B, 3);
+    pwm_set_duty(PWM_CH_CCP2, 2000);    // Clamped
+    period();
+    CHECK_EQ(CCPR2L, 0xFF);
+}
+
+static void test_soft_channel_pulse(void)
+{
+    pwm_init();
+    pwm_set_duty(PWM_CH_SOFT, 400);     // 100 of 256 ticks
+    period();                           // Duty latched, pulse starts
+    CHECK_EQ(RC0, 1);
+    CHECK_EQ(TMR0, (uint8_t)(PWM_SOFT_LATENCY_TICKS - 100));
+    CHECK_EQ(T0IE, 1);
+    timer0_overflow();
+    CHECK_EQ(RC0, 0);
+    CHECK_EQ(T0IE, 0);
+    period();
+    CHECK_EQ(RC0, 1);
+
+    pwm_set_duty(PWM_CH_SOFT, 0);
+    timer0_overflow();
+    period();
+    CHECK_EQ(RC0, 0);
+    CHECK_EQ(T0IE, 0);
+
+    pwm_set_duty(PWM_CH_SOFT, PWM_DUTY_MAX);
+    period();
+    CHECK_EQ(RC0, 1);                   // Fully on, Timer0 not used
+    CHECK_EQ(T0IE, 0);
+}
+
+static void test_soft_channel_pulse_skipping(void)
+{
+    unsigned i, pulses = 0;
+
+    pwm_init();
+    pwm_set_duty(PWM_CH_SOFT, 3 * 4);   // 3 ticks, shorter than PWM_SOFT_MIN_TICKS
+    for (i = 0; i < PWM_SOFT_MIN_TICKS * 10; i++) {
+        period();
+        if (RC0) {
+            pulses++;
+            CHECK_EQ(TMR0, (uint8_t)(PWM_SOFT_LATENCY_TICKS - PWM_SOFT_MIN_TICKS));
+            timer0_overflow();
+        }
+    }
+    // Same average: 3 ticks per period over PWM_SOFT_MIN_TICKS * 10 periods
+    CHECK_EQ(pulses, 3 * 10);
+}
+
+static void test_fade(void)
+{
+    unsigned i;
+
+    pwm_init();
+    pwm_fade(PWM_CH_CCP1, 255, 2);
+    CHECK_EQ(pwm_fading(), 1 << PWM_CH_CCP1);
+    for (i = 0; i < 255 * 2 - 1; i++) {
+        period();
+    }
+    CHECK_EQ(pwm_get_level(PWM_CH_CCP1), 254);
+    CHECK_EQ(pwm_fading(), 1 << PWM_CH_CCP1);
+    period();
+    CHECK_EQ(pwm_get_level(PWM_CH_CCP1), 255);
+    CHECK_EQ(pwm_fading(), 0);
+    CHECK_EQ(CCPR1L, 0xFF);
+    CHECK_EQ(CCP1CONbits.DC1B, 3);
+
+    // Down again to the middle: gamma 2.2 puts level 128 well below half duty
+    pwm_fade(PWM_CH_CCP1, 128, 1);
+    for (i = 0; i < 127; i++) {
+        period();
+    }
+    CHECK_EQ(pwm_fading(), 0);
+    CHECK_EQ((CCPR1L << 2) | CCP1CONbits.DC1B, 225);
+}
+
+static void test_gamma_table_monotonic(void)
+{
+    unsigned lvl;
+    uint16_t prev = 0, duty;
+
+    pwm_init();
+    for (lvl = 0; lvl < 256; lvl++) {
+        pwm_set_level(PWM_CH_CCP2, (uint8_t)lvl);
+        period();
+        duty = (uint16_t)((CCPR2L << 2) | CCP2CONbits.DC2B);
+        CHECK(duty >= prev);
+        prev = duty;
+    }
+    CHECK_EQ(prev, PWM_DUTY_MAX);
+    pwm_set_level(PWM_CH_CCP2, 0);
+    period();
+    CHECK_EQ(CCPR2L, 0);
+}
+
+static void test_set_duty_cancels_fade(void)
+{
+    pwm_init();
+    pwm_fade(PWM_CH_CCP2, 200, 1);
+    period();
+    pwm_set_duty(PWM_CH_CCP2, 100);
+    CHECK_EQ(pwm_fading(), 0);
+    period();
+    period();
+    CHECK_EQ(CCPR2L, 25);
+}
+
+int main(void)
+{
+    RUN_TEST(test_init);
+    RUN_TEST(test_duty_applied_at_period_boundary);
+    RUN_TEST(test_soft_channel_pulse);
+    RUN_TEST(test_soft_channel_pulse_skipping);
+    RUN_TEST(test_fade);
+    RUN_TEST(test_gamma_table_monotonic);
+    RUN_TEST(test_set_duty_cancels_fade);
+    return TEST_RESULT();
+}
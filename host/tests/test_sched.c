@@ -0,0 +1,183 @@
+/* File:   test_sched.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Host tests for the cooperative tick scheduler (common/sched.c): release times from period
+ * and offset, overrun counting without bursts, tick counter wrap and idle-time sampling.
+ * tick() plays the timer interrupt; a task can call it to simulate its own run time.
+ */
+
+#include <xc.h>
+#include "test.h"
+
+#include "../../common/sched.h"
+
+static uint16_t log_tick[32];
+static uint8_t log_task[32];
+static uint8_t log_len;
+static uint8_t slow_ticks;      // Ticks task B spends running
+static uint8_t slow_once;       // Extra ticks for B's next run only
+
+static void tick(unsigned n)
+{
+    while (n--) {
+        sched_tick();
+    }
+}
+
+static void record(uint8_t task)
+{
+    if (log_len < 32) {
+        log_tick[log_len] = sched_ticks();
+        log_task[log_len++] = task;
+    }
+}
+
+static void task_a(void) { record('A'); }
+static void task_b(void) { record('B'); tick(slow_ticks + slow_once); slow_once = 0; }
+static void task_c(void) { record('C'); }
+
+static const sched_task_t table[] = {
+    { task_a, 10, 0 },
+    { task_b, 20, 5 },
+    { task_c, 20, 15 },
+};
+
+static void reset(void)
+{
+    log_len = 0;
+    slow_ticks = 0;
+    slow_once = 0;
+    sched_init(table, 3);
+}
+
+// Tick once and dispatch, 'n' times, like the timer interrupt and the main loop
+static void run(unsigned n)
+{
+    while (n--) {
+        sched_dispatch();
+        tick(1);
+    }
+}
+
+static void test_periods_and_offsets(void)
+{
+    sched_task_stats_t stats;
+
+    reset();
+    run(40);
+    CHECK_EQ(log_len, 8);
+    CHECK_EQ(log_task[0], 'A'); CHECK_EQ(log_tick[0], 0);
+    CHECK_EQ(log_task[1], 'B'); CHECK_EQ(log_tick[1], 5);
+    CHECK_EQ(log_task[2], 'A'); CHECK_EQ(log_tick[2], 10);
+    CHECK_EQ(log_task[3], 'C'); CHECK_EQ(log_tick[3], 15);
+    CHECK_EQ(log_task[4], 'A'); CHECK_EQ(log_tick[4], 20);
+    CHECK_EQ(log_task[5], 'B'); CHECK_EQ(log_tick[5], 25);
+    CHECK_EQ(log_task[7], 'C'); CHECK_EQ(log_tick[7], 35);
+    sched_get_task_stats(0, &stats);
+    CHECK_EQ(stats.runs, 4);
+    CHECK_EQ(stats.overruns, 0);
+}
+
+static void test_same_tick_runs_in_table_order(void)
+{
+    static const sched_task_t same[] = {
+        { task_c, 5, 3 },
+        { task_a, 5, 3 },
+    };
+
+    log_len = 0;
+    sched_init(same, 2);
+    tick(3);
+    CHECK_EQ(sched_dispatch(), 2);
+    CHECK_EQ(log_task[0], 'C');
+    CHECK_EQ(log_task[1], 'A');
+    CHECK_EQ(sched_dispatch(), 0);
+}
+
+static void test_overrun_skips_missed_releases(void)
+{
+    sched_task_stats_t stats;
+
+    reset();
+    slow_once = 25;             // B (tick 5) returns at tick 30
+    run(6);
+    CHECK_EQ(sched_ticks(), 31);
+    CHECK_EQ(log_len, 3);
+    CHECK_EQ(log_task[2], 'C'); CHECK_EQ(log_tick[2], 30);  // Late, within its period
+
+    // A missed its releases at 10 and 20: it runs once for 30, no burst
+    run(1);
+    CHECK_EQ(log_len, 5);
+    CHECK_EQ(log_task[3], 'A'); CHECK_EQ(log_tick[3], 31);
+    CHECK_EQ(log_task[4], 'B'); CHECK_EQ(log_tick[4], 31);
+    sched_get_task_stats(0, &stats);
+    CHECK_EQ(stats.runs, 2);
+    CHECK_EQ(stats.overruns, 2);
+    sched_get_task_stats(1, &stats);
+    CHECK_EQ(stats.overruns, 0);
+    sched_get_task_stats(2, &stats);
+    CHECK_EQ(stats.overruns, 0);
+
+    // Phase is kept: C at 35, A at 40, B at 45
+    log_len = 0;
+    run(15);
+    CHECK_EQ(log_len, 3);
+    CHECK_EQ(log_task[0], 'C'); CHECK_EQ(log_tick[0], 35);
+    CHECK_EQ(log_task[1], 'A'); CHECK_EQ(log_tick[1], 40);
+    CHECK_EQ(log_task[2], 'B'); CHECK_EQ(log_tick[2], 45);
+}
+
+static void test_tick_wrap(void)
+{
+    static const sched_task_t one[] = { { task_a, 1000, 0 } };
+    sched_task_stats_t stats;
+    int i;
+
+    log_len = 0;
+    sched_init(one, 1);
+    // Dispatch every 100 ticks up to 70000 (the counter wraps at 65536)
+    for (i = 0; i < 700; i++) {
+        tick(100);
+        sched_dispatch();
+    }
+    sched_get_task_stats(0, &stats);
+    CHECK_EQ(stats.runs, 71);          // Releases 0, 1000, ..., 70000
+    CHECK_EQ(stats.overruns, 0);
+    CHECK_EQ(sched_ticks(), (uint16_t)70000);
+}
+
+static void test_idle_percent(void)
+{
+    reset();
+    slow_ticks = 3;             // B busy 3 ticks every 20
+    while (sched_ticks() < SCHED_LOAD_WINDOW - 1) {
+        run(1);
+    }
+    CHECK_EQ(sched_idle_percent(), 100);    // First window not complete yet
+    run(1);
+    CHECK_EQ(sched_ticks(), SCHED_LOAD_WINDOW);
+    CHECK_EQ(sched_idle_percent(), 85);
+}
+
+static void test_stats_out_of_range(void)
+{
+    sched_task_stats_t stats = { 1, 1 };
+
+    reset();
+    run(10);
+    sched_get_task_stats(3, &stats);
+    CHECK_EQ(stats.runs, 0);
+    CHECK_EQ(stats.overruns, 0);
+}
+
+int main(void)
+{
+    RUN_TEST(test_periods_and_offsets);
+    RUN_TEST(test_same_tick_runs_in_table_order);
+    RUN_TEST(test_overrun_skips_missed_releases);
+    RUN_TEST(test_tick_wrap);
+    RUN_TEST(test_idle_percent);
+    RUN_TEST(test_stats_out_of_range);
+    return TEST_RESULT();
+}
@@ -0,0 +1,314 @@
+/* File:   test_sim14.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Host tests for the PIC16F877A instruction-set simulator (host/tools/sim14.c).
+ * Each test assembles a few words by hand, runs them and checks registers, flags and the
+ * exact cycle count against the datasheet (PIC16F87XA, Table 15-2).
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "test.h"
+#include "../tools/sim14.h"
+
+// Opcodes
+#define NOP_           0x0000
+#define RETURN_        0x0008
+#define RETFIE_        0x0009
+#define SLEEP_         0x0063
+#define MOVWF_(f)      (0x0080 | (f))
+#define CLRF_(f)       (0x0180 | (f))
+#define ADDWF_(f, d)   (0x0700 | ((d) << 7) | (f))
+#define MOVF_(f, d)    (0x0800 | ((d) << 7) | (f))
+#define INCF_(f, d)    (0x0A00 | ((d) << 7) | (f))
+#define DECFSZ_(f, d)  (0x0B00 | ((d) << 7) | (f))
+#define BCF_(f, b)     (0x1000 | ((b) << 7) | (f))
+#define BSF_(f, b)     (0x1400 | ((b) << 7) | (f))
+#define CALL_(k)       (0x2000 | (k))
+#define GOTO_(k)       (0x2800 | (k))
+#define MOVLW_(k)      (0x3000 | (k))
+#define RETLW_(k)      (0x3400 | (k))
+#define SUBLW_(k)      (0x3C00 | (k))
+#define ADDLW_(k)      (0x3E00 | (k))
+
+#define F_INDF   0x00
+#define F_PCL    0x02
+#define F_STATUS 0x03
+#define F_FSR    0x04
+#define F_PCLATH 0x0A
+#define F_INTCON 0x0B
+
+static sim14_t sim;
+
+static void load(uint16_t address, const uint16_t *words, unsigned count)
+{
+    unsigned i;
+    for (i = 0; i < count; i++) {
+        sim14_set_word(&sim, (uint16_t)(address + i), words[i]);
+    }
+}
+
+static uint8_t status(void)
+{
+    return sim14_peek(&sim, F_STATUS);
+}
+
+static void test_literal_flags(void)
+{
+    static const uint16_t prog[] = {
+        MOVLW_(0x0F), ADDLW_(0x01),             // 0x10: DC
+        MOVWF_(0x20),
+        ADDLW_(0xF0),                           // 0x100: C, Z
+        MOVLW_(0x06), SUBLW_(0x05),             // 5 - 6: borrow, C = 0
+        GOTO_(6)
+    };
+
+    sim14_init(&sim);
+    load(0, prog, 2);
+    sim14_set_word(&sim, 2, GOTO_(2));
+    CHECK_EQ(sim14_run(&sim, 100), SIM14_HALT);
+    CHECK_EQ(sim.w, 0x10);
+    CHECK_EQ(status() & (SIM14_C | SIM14_DC | SIM14_Z), SIM14_DC);
+
+    sim14_init(&sim);
+    load(0, prog, 4);
+    sim14_set_word(&sim, 4, GOTO_(4));
+    CHECK_EQ(sim14_run(&sim, 100), SIM14_HALT);
+    CHECK_EQ(sim.w, 0x00);
+    CHECK_EQ(sim14_peek(&sim, 0x20), 0x10);
+    CHECK_EQ(status() & (SIM14_C | SIM14_DC | SIM14_Z), SIM14_C | SIM14_Z);
+
+    sim14_init(&sim);
+    load(0, prog, sizeof(prog) / sizeof(prog[0]));
+    CHECK_EQ(sim14_run(&sim, 100), SIM14_HALT);
+    CHECK_EQ(sim.w, 0xFF);
+    CHECK_EQ(status() & (SIM14_C | SIM14_Z), 0);
+    CHECK_EQ(status() & (SIM14_TO | SIM14_PD), SIM14_TO | SIM14_PD);
+}
+
+static void test_loop_cycles(void)
+{
+    static const uint16_t prog[] = {
+        MOVLW_(3), MOVWF_(0x20),
+        DECFSZ_(0x20, 1), GOTO_(2),
+        GOTO_(4)
+    };
+
+    sim14_init(&sim);
+    load(0, prog, sizeof(prog) / sizeof(prog[0]));
+    CHECK_EQ(sim14_run(&sim, 1000), SIM14_HALT);
+    // 2 + 2 x (decfsz + goto) + taken skip + goto
+    CHECK_EQ(sim.cycles, 2 + 2 * 3 + 2 + 2);
+    CHECK_EQ(sim.instructions, 8);
+    CHECK_EQ(sim.pc, 4);
+
+    // The cycle limit stops between instructions
+    sim14_reset(&sim);
+    CHECK_EQ(sim14_run(&sim, 5), SIM14_LIMIT);
+    CHECK_EQ(sim.cycles, 5);
+}
+
+static void test_banks_mirrors_and_indirect(void)
+{
+    static const uint16_t prog[] = {
+        MOVLW_(0x55),
+        BSF_(F_STATUS, 5),                      // Bank 1
+        MOVWF_(0x20),                           // 0xA0
+        MOVWF_(0x70),                           // Common RAM
+        MOVWF_(0x0F),                           // 0x8F: unimplemented
+        BCF_(F_STATUS, 5),
+        MOVLW_(0xA0), MOVWF_(F_FSR),
+        MOVF_(F_INDF, 0),                       // W = [0xA0]
+        MOVWF_(0x21),
+        BSF_(F_STATUS, 7),                      // IRP: banks 2/3
+        MOVLW_(0x10), MOVWF_(F_FSR),
+        MOVLW_(0x99), MOVWF_(F_INDF),           // [0x110]
+        GOTO_(15)
+    };
+
+    sim14_init(&sim);
+    load(0, prog, sizeof(prog) / sizeof(prog[0]));
+    CHECK_EQ(sim14_run(&sim, 1000), SIM14_HALT);
+    CHECK_EQ(sim14_peek(&sim, 0xA0), 0x55);
+    CHECK_EQ(sim14_peek(&sim, 0x20), 0x00);
+    CHECK_EQ(sim14_peek(&sim, 0x21), 0x55);
+    CHECK_EQ(sim14_peek(&sim, 0x70), 0x55);
+    CHECK_EQ(sim14_peek(&sim, 0x1F0), 0x55);
+    CHECK_EQ(sim14_peek(&sim, 0x8F), 0x00);
+    CHECK_EQ(sim14_peek(&sim, 0x110), 0x99);
+    CHECK_EQ(sim14_peek(&sim, 0x183), status());
+    CHECK_EQ(sim14_peek(&sim, 0x184), 0x10);
+
+    // TRISB and PORTB are shared with banks 3 and 2
+    sim14_poke(&sim, 0x186, 0x0F);
+    CHECK_EQ(sim14_peek(&sim, 0x86), 0x0F);
+    sim14_poke(&sim, 0x106, 0x3C);
+    CHECK_EQ(sim14_peek(&sim, 0x06), 0x3C);
+}
+
+static void test_pclath_paging_and_table(void)
+{
+    static const uint16_t prog[] = {
+        MOVLW_(0x01), MOVWF_(F_PCLATH),
+        MOVLW_(2), CALL_(0x100),
+        MOVWF_(0x20),
+        MOVLW_(0x08), MOVWF_(F_PCLATH),
+        GOTO_(0x005)                            // Page 1: 0x0805
+    };
+    static const uint16_t table[] = { ADDWF_(F_PCL, 1), RETLW_(0x10), RETLW_(0x20), RETLW_(0x30) };
+    static const uint16_t page1[] = { MOVLW_(0x11), GOTO_(0x006) };
+
+    sim14_init(&sim);
+    load(0, prog, sizeof(prog) / sizeof(prog[0]));
+    load(0x100, table, 4);
+    load(0x805, page1, 2);
+    CHECK_EQ(sim14_run(&sim, 1000), SIM14_HALT);
+    CHECK_EQ(sim14_peek(&sim, 0x20), 0x30);
+    CHECK_EQ(sim.w, 0x11);
+    CHECK_EQ(sim.pc, 0x806);
+    // movlw, movwf, movlw, call (2), addwf PCL (2), retlw (2), movwf, movlw, movwf,
+    // goto (2), movlw, goto (2)
+    CHECK_EQ(sim.cycles, 17);
+    CHECK_EQ(sim.max_depth, 1);
+}
+
+static void test_stack_wraps_after_eight_levels(void)
+{
+    int i;
+
+    sim14_init(&sim);
+    sim14_set_word(&sim, 0, CALL_(0x10));
+    sim14_set_word(&sim, 1, GOTO_(1));
+    for (i = 0; i < 8; i++) {
+        sim14_set_word(&sim, (uint16_t)(0x10 + 2 * i), CALL_(0x12 + 2 * i));
+        sim14_set_word(&sim, (uint16_t)(0x11 + 2 * i), RETURN_);
+    }
+    sim14_set_word(&sim, 0x20, RETURN_);
+
+    // Nine nested calls: the return address of the first one is overwritten
+    CHECK_EQ(sim14_run(&sim, 10000), SIM14_LIMIT);
+    CHECK_EQ(sim.max_depth, PIC14_STACK_LEVELS);
+    CHECK_EQ(sim.stack_overflows, 1);
+    CHECK(sim.pc != 1);
+}
+
+static void test_interrupt_vector(void)
+{
+    static const uint16_t isr[] = { INCF_(0x21, 1), BCF_(F_INTCON, 2), RETFIE_ };
+    static const uint16_t main_loop[] = { BSF_(F_INTCON, 5), BSF_(F_INTCON, 7), GOTO_(0x12) };
+
+    sim14_init(&sim);
+    sim14_set_word(&sim, 0, GOTO_(0x10));
+    load(PIC14_INT_VECTOR, isr, 3);
+    load(0x10, main_loop, 3);
+    CHECK_EQ(sim14_run(&sim, 100), SIM14_LIMIT);   // GIE set: goto $ is not a halt
+    CHECK_EQ(sim.interrupts, 0);
+
+    sim14_poke(&sim, F_INTCON, sim14_peek(&sim, F_INTCON) | 0x04);     // T0IF
+    CHECK_EQ(sim14_run(&sim, 100), SIM14_LIMIT);
+    CHECK_EQ(sim.interrupts, 1);
+    CHECK_EQ(sim14_peek(&sim, 0x21), 1);
+    CHECK_EQ(sim14_peek(&sim, F_INTCON), 0xA0);    // GIE restored, T0IF cleared
+    CHECK_EQ(sim.pc, 0x12);
+    CHECK_EQ(sim.depth, 0);
+
+    // Peripheral flags need PEIE
+    sim14_poke(&sim, SIM14_PIE1, 0x02);
+    sim14_poke(&sim, SIM14_PIR1, 0x02);
+    CHECK_EQ(sim.irq, 0);
+    sim14_poke(&sim, F_INTCON, 0xE0);
+    CHECK_EQ(sim.irq, 1);
+}
+
+static void test_sleep_wakes_on_enabled_flag(void)
+{
+    static const uint16_t prog[] = { SLEEP_, MOVLW_(0x42), GOTO_(2) };
+
+    sim14_init(&sim);
+    load(0, prog, 3);
+    CHECK_EQ(sim14_run(&sim, 100), SIM14_ASLEEP);
+    CHECK_EQ(status() & (SIM14_TO | SIM14_PD), SIM14_TO);
+    CHECK_EQ(sim14_run(&sim, 100), SIM14_ASLEEP);
+
+    // INTE + INTF without GIE: wake up and continue after SLEEP
+    sim14_poke(&sim, F_INTCON, 0x12);
+    CHECK_EQ(sim14_run(&sim, 100), SIM14_HALT);
+    CHECK_EQ(sim.w, 0x42);
+    CHECK_EQ(sim.interrupts, 0);
+}
+
+static void test_unprogrammed_word_stops(void)
+{
+    sim14_init(&sim);
+    sim14_set_word(&sim, 0, NOP_);
+    CHECK_EQ(sim14_run(&sim, 100), SIM14_BAD_OPCODE);
+    CHECK_EQ(sim.pc, 1);
+    CHECK_EQ(sim.cycles, 1);
+}
+
+static void hex_record(FILE *f, uint16_t offset, uint8_t type, const uint8_t *data, uint8_t count)
+{
+    unsigned sum = count + (offset >> 8) + (offset & 0xFF) + type;
+    uint8_t i;
+
+    fprintf(f, ":%02X%04X%02X", count, offset, type);
+    for (i = 0; i < count; i++) {
+        fprintf(f, "%02X", data[i]);
+        sum += data[i];
+    }
+    fprintf(f, "%02X\n", (unsigned)(-sum & 0xFF));
+}
+
+static void test_hex_image(void)
+{
+    static const uint8_t code[] = { 0x42, 0x30, 0x01, 0x28 };  // movlw 0x42; goto $
+    static const uint8_t config[] = { 0x72, 0x3F };
+    static const uint8_t eeprom[] = { 0x5A, 0x00, 0xA5, 0x00 };
+    char path[] = "/tmp/sim14_XXXXXX";
+    char err[128];
+    FILE *f;
+    int fd = mkstemp(path);
+
+    CHECK(fd >= 0);
+    f = fdopen(fd, "w");
+    hex_record(f, 0x0000, 0x00, code, sizeof(code));
+    hex_record(f, 0x400E, 0x00, config, sizeof(config));
+    hex_record(f, 0x4200, 0x00, eeprom, sizeof(eeprom));
+    hex_record(f, 0x0000, 0x01, NULL, 0);
+    fclose(f);
+
+    sim14_init(&sim);
+    CHECK_EQ(sim14_load_hex(&sim, path, err, sizeof(err)), 0);
+    CHECK_EQ(sim.program[0], 0x3042);
+    CHECK_EQ(sim.program[1], 0x2801);
+    CHECK_EQ(sim.config, 0x3F72);
+    CHECK_EQ(sim.eeprom[0], 0x5A);
+    CHECK_EQ(sim.eeprom[1], 0xA5);
+    CHECK_EQ(sim.eeprom[2], 0xFF);
+    CHECK_EQ(sim14_run(&sim, 100), SIM14_HALT);
+    CHECK_EQ(sim.w, 0x42);
+
+    // Corrupted checksum
+    f = fopen(path, "w");
+    fprintf(f, ":0400000042300128FF\n:00000001FF\n");
+    fclose(f);
+    CHECK_EQ(sim14_load_hex(&sim, path, err, sizeof(err)), -1);
+    CHECK(strstr(err, ":1:") != NULL);
+    unlink(path);
+}
+
+int main(void)
+{
+    RUN_TEST(test_literal_flags);
+    RUN_TEST(test_loop_cycles);
+    RUN_TEST(test_banks_mirrors_and_indirect);
+    RUN_TEST(test_pclath_paging_and_table);
+    RUN_TEST(test_stack_wraps_after_eight_levels);
+    RUN_TEST(test_interrupt_vector);
+    RUN_TEST(test_sleep_wakes_on_enabled_flag);
+    RUN_TEST(test_unprogrammed_word_stops);
+    RUN_TEST(test_hex_image);
+    return TEST_RESULT();
+}
@@ -0,0 +1,189 @@
+/* File:   test_spi.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Host tests for the interrupt-driven SPI driver (common/spi.c).
+ * shift() plays the MSSP and the device on the other end: it completes the byte in SSPBUF,
+ * exchanging it with the next byte of 'remote', then raises SSPIF and calls the ISR.
+ */
+
+#include <xc.h>
+#include "test.h"
+#include "../../common/spi.h"
+
+static const uint8_t remote[] = { 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88 };
+static uint8_t sent[16];
+static uint8_t shifted;
+static uint8_t cs_low_while_shifting;
+
+static void shift(void)
+{
+    if (RA5 == 0) {
+        cs_low_while_shifting++;
+    }
+    sent[shifted & 15] = SSPBUF;
+    SSPBUF = remote[shifted & 7];
+    shifted++;
+    BF = 1;
+    SSPIF = 1;
+    spi_isr();
+}
+
+static void run_master(void)
+{
+    int guard = 100;
+    shifted = 0;
+    cs_low_while_shifting = 0;
+    while (spi_busy() && guard--) {
+        shift();
+    }
+}
+
+// Slave: a byte arrives from the master
+static void receive(uint8_t data)
+{
+    SSPBUF = data;
+    BF = 1;
+    SSPIF = 1;
+    spi_isr();
+}
+
+static void test_master_init_modes(void)
+{
+    spi_master_init(SPI_MODE_1, SPI_CLOCK_FOSC_64);
+    CHECK_EQ(SSPCON, 0x22);             // SSPEN, Fosc/64
+    CHECK_EQ(CKP, 0);
+    CHECK_EQ(CKE, 0);
+    CHECK_EQ(RA5, 1);                   // Chip select released
+    CHECK_EQ(TRISA5, 0);
+    CHECK_EQ(TRISC & 0x38, 0x10);       // SCK, SDO out; SDI in
+    CHECK_EQ(SSPIE, 1);
+    CHECK_EQ(GIE, 1);
+
+    spi_master_init(SPI_MODE_0, SPI_CLOCK_FOSC_4);
+    CHECK_EQ(SSPCON, 0x20);
+    CHECK_EQ(CKE, 1);
+    spi_master_init(SPI_MODE_3, SPI_CLOCK_FOSC_16);
+    CHECK_EQ(SSPCON, 0x31);
+    CHECK_EQ(CKP, 1);
+    CHECK_EQ(CKE, 0);
+}
+
+static void test_full_duplex_block(void)
+{
+    static const uint8_t tx[] = { 0xA0, 0xA1, 0xA2, 0xA3, 0xA4 };
+    uint8_t rx[5] = { 0 };
+    spi_stats_t stats;
+
+    spi_master_init(SPI_MODE_1, SPI_CLOCK_FOSC_4);
+    CHECK_EQ(spi_transfer(tx, rx, 5), 1);
+    CHECK_EQ(RA5, 0);
+    CHECK_EQ(SSPBUF, 0xA0);             // First byte loaded by spi_transfer()
+    CHECK_EQ(spi_transfer(tx, rx, 1), 0);   // Busy
+    run_master();
+    CHECK_EQ(shifted, 5);
+    CHECK_EQ(cs_low_while_shifting, 5);
+    CHECK_EQ(RA5, 1);
+    CHECK_EQ(spi_busy(), 0);
+    CHECK_EQ(sent[0], 0xA0);
+    CHECK_EQ(sent[4], 0xA4);
+    CHECK_EQ(rx[0], 0x11);
+    CHECK_EQ(rx[4], 0x55);
+    spi_get_stats(&stats);
+    CHECK_EQ(stats.transfers, 1);
+    CHECK_EQ(SSPIE, 1);
+}
+
+static void test_write_only_and_read_only(void)
+{
+    static const uint8_t tx[] = { 1, 2, 3 };
+    uint8_t rx[3] = { 0 };
+
+    spi_master_init(SPI_MODE_1, SPI_CLOCK_FOSC_4);
+    CHECK_EQ(spi_transfer(tx, 0, 3), 1);
+    run_master();
+    CHECK_EQ(sent[2], 3);
+
+    CHECK_EQ(spi_transfer(0, rx, 3), 1);
+    run_master();
+    CHECK_EQ(sent[0], SPI_FILL_BYTE);
+    CHECK_EQ(sent[2], SPI_FILL_BYTE);
+    CHECK_EQ(rx[2], 0x33);
+
+    CHECK_EQ(spi_transfer(tx, rx, 0), 0);
+    CHECK_EQ(RA5, 1);
+}
+
+static void test_slave_init(void)
+{
+    spi_slave_init(SPI_MODE_1, 0);
+    CHECK_EQ(SSPCON, 0x25);             // SS disabled
+    CHECK_EQ(TRISC & 0x38, 0x18);       // SCK, SDI in; SDO out
+    ADCON1 = 0x02;                      // Application's ADC setup
+    spi_slave_init(SPI_MODE_1, 1);
+    CHECK_EQ(SSPCON, 0x24);
+    CHECK_EQ(TRISA5, 1);
+    CHECK_EQ(ADCON1, 0x02);             // Left alone
+    spi_slave_init(SPI_MODE_0, 0);      // CKE = 1 requires SS
+    CHECK_EQ(SSPCON, 0x24);
+    CHECK_EQ(CKE, 1);
+}
+
+static void test_slave_fifo(void)
+{
+    uint8_t data = 0;
+    uint8_t i;
+
+    spi_slave_init(SPI_MODE_1, 1);
+    CHECK_EQ(spi_slave_read(&data), 0);
+    for (i = 0; i < 3; i++) {
+        receive((uint8_t)(0x30 + i));
+    }
+    CHECK_EQ(spi_slave_available(), 3);
+    CHECK_EQ(spi_slave_read(&data), 1);
+    CHECK_EQ(data, 0x30);
+    CHECK_EQ(spi_slave_read(&data), 1);
+    CHECK_EQ(spi_slave_read(&data), 1);
+    CHECK_EQ(data, 0x32);
+    CHECK_EQ(spi_slave_available(), 0);
+}
+
+static void test_slave_overflow_and_drops(void)
+{
+    spi_stats_t stats;
+    uint8_t data = 0;
+    uint16_t i;
+
+    spi_slave_init(SPI_MODE_1, 1);
+    for (i = 0; i < SPI_RX_FIFO_SIZE + 2; i++) {
+        receive((uint8_t)i);
+    }
+    SSPOV = 1;
+    receive(0xEE);
+    CHECK_EQ(SSPOV, 0);
+
+    spi_get_stats(&stats);
+    CHECK_EQ(stats.overflows, 1);
+    CHECK_EQ(stats.rx_dropped, 3);
+    CHECK_EQ(spi_slave_available(), SPI_RX_FIFO_SIZE);
+
+    // The oldest bytes are kept
+    CHECK_EQ(spi_slave_read(&data), 1);
+    CHECK_EQ(data, 0);
+    receive(0x5A);
+    for (i = 0; i < SPI_RX_FIFO_SIZE; i++) {
+        spi_slave_read(&data);
+    }
+    CHECK_EQ(data, 0x5A);
+}
+
+int main(void)
+{
+    RUN_TEST(test_master_init_modes);
+    RUN_TEST(test_full_duplex_block);
+    RUN_TEST(test_write_only_and_read_only);
+    RUN_TEST(test_slave_init);
+    RUN_TEST(test_slave_fifo);
+    RUN_TEST(test_slave_overflow_and_drops);
+    return TEST_RESULT();
+}
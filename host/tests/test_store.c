@@ -0,0 +1,213 @@
+/* File:   test_store.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Host tests for the wear-levelled record store of 12-PIC16F_Internal_EEPROM (store.c),
+ * on top of the EEPROM writer and the shim's EEPROM model. reboot() keeps the EEPROM
+ * contents and starts the drivers again, as a reset does.
+ */
+
+#include <string.h>
+#include <xc.h>
+#include "test.h"
+#include "../../12-PIC16F_Internal_EEPROM/EEPROM.X/store.h"
+
+static void finish_writes(void)
+{
+    while (pic_host_eeprom_complete()) {
+        eeprom_isr();
+    }
+}
+
+static uint8_t reboot(void)
+{
+    finish_writes();
+    eeprom_init();
+    return store_init(0);
+}
+
+static void make_record(uint8_t *record, uint8_t value)
+{
+    uint8_t i;
+    for (i = 0; i < STORE_RECORD_SIZE; i++) {
+        record[i] = (uint8_t)(value + i);
+    }
+}
+
+static void test_blank_eeprom_uses_defaults(void)
+{
+    static const uint8_t defaults[STORE_RECORD_SIZE] = { 9, 8, 7 };
+
+    eeprom_init();
+    CHECK_EQ(store_init(defaults), 0);
+    CHECK(memcmp(store_get(), defaults, STORE_RECORD_SIZE) == 0);
+    CHECK_EQ(store_slot(), STORE_SLOTS);
+    eeprom_init();
+    CHECK_EQ(store_init(0), 0);
+    CHECK_EQ(store_get()[0], 0);
+}
+
+static void test_save_survives_reset(void)
+{
+    uint8_t record[STORE_RECORD_SIZE];
+
+    reboot();
+    make_record(record, 0x40);
+    CHECK_EQ(store_save(record), 1);
+    CHECK_EQ(store_slot(), 0);
+    CHECK(memcmp(store_get(), record, STORE_RECORD_SIZE) == 0);     // Before the write ends
+    CHECK_EQ(EEADR, STORE_BASE);
+    CHECK_EQ(EEDATA, 0);                // Sequence 0 in its write cycle
+    CHECK_EQ(reboot(), 1);
+    CHECK(memcmp(store_get(), record, STORE_RECORD_SIZE) == 0);
+    CHECK_EQ(store_slot(), 0);
+}
+
+static void test_saves_rotate_over_every_slot(void)
+{
+    uint8_t record[STORE_RECORD_SIZE];
+    unsigned i, a, max = 0;
+    unsigned counts[256] = { 0 };
+    uint8_t before[256];
+
+    reboot();
+    for (i = 0; i < 10 * STORE_SLOTS; i++) {
+        make_record(record, (uint8_t)i);
+        memcpy(before, pic_host_eeprom, 256);
+        CHECK_EQ(store_save(record), 1);
+        finish_writes();
+        for (a = 0; a < 256; a++) {
+            counts[a] += before[a] != pic_host_eeprom[a];
+        }
+        CHECK_EQ(store_slot(), i % STORE_SLOTS);
+    }
+    for (i = 0; i < 256; i++) {
+        if (counts[i] > max) {
+            max = counts[i];
+        }
+    }
+    CHECK_EQ(max, 10);                  // Every cell written once per turn of the ring
+    CHECK_EQ(reboot(), 1);
+    CHECK_EQ(store_slot(), (10 * STORE_SLOTS - 1) % STORE_SLOTS);
+    CHECK_EQ(store_get()[0], (uint8_t)(10 * STORE_SLOTS - 1));
+}
+
+static void test_sequence_wrap_keeps_newest(void)
+{
+    uint8_t record[STORE_RECORD_SIZE];
+    unsigned i;
+
+    // Run the 0..254 sequence through several wraps, rebooting at different points
+    reboot();
+    for (i = 0; i < 700; i++) {
+        make_record(record, (uint8_t)(i * 7));
+        CHECK_EQ(store_save(record), 1);
+        finish_writes();
+        if (i % 37 == 0) {
+            CHECK_EQ(reboot(), 1);
+            CHECK_EQ(store_get()[0], (uint8_t)(i * 7));
+        }
+    }
+    CHECK_EQ(reboot(), 1);
+    CHECK_EQ(store_get()[0], (uint8_t)(699 * 7));
+    for (i = 0; i < STORE_SLOTS; i++) {
+        CHECK(pic_host_eeprom[STORE_BASE + i * STORE_SLOT_SIZE] != 0xFF);
+    }
+}
+
+static void test_torn_write_keeps_previous_record(void)
+{
+    uint8_t record[STORE_RECORD_SIZE];
+
+    reboot();
+    make_record(record, 1);
+    store_save(record);
+    make_record(record, 2);
+    store_save(record);
+    finish_writes();
+
+    // Reset after three bytes of the third save
+    make_record(record, 3);
+    store_save(record);
+    pic_host_eeprom_complete();
+    eeprom_isr();
+    pic_host_eeprom_complete();
+    eeprom_isr();
+    pic_host_eeprom_complete();
+    eeprom_init();
+    CHECK_EQ(store_init(0), 1);
+    CHECK_EQ(store_get()[0], 2);
+    CHECK_EQ(store_slot(), 1);
+
+    // The next save goes over the torn slot
+    make_record(record, 4);
+    store_save(record);
+    CHECK_EQ(reboot(), 1);
+    CHECK_EQ(store_get()[0], 4);
+    CHECK_EQ(store_slot(), 2);
+
+    // A corrupted newest slot falls back as well
+    pic_host_eeprom[STORE_BASE + 2 * STORE_SLOT_SIZE + 1] ^= 0x10;
+    CHECK_EQ(reboot(), 1);
+    CHECK_EQ(store_get()[0], 2);
+}
+
+static void test_cleared_eeprom_is_not_a_record(void)
+{
+    static const uint8_t defaults[STORE_RECORD_SIZE] = { 9, 8, 7 };
+
+    // Zeros are a valid sequence number and would check against a CRC started from 0
+    memset(pic_host_eeprom, 0, sizeof(pic_host_eeprom));
+    eeprom_init();
+    CHECK_EQ(store_init(defaults), 0);
+    CHECK(memcmp(store_get(), defaults, STORE_RECORD_SIZE) == 0);
+    CHECK_EQ(store_slot(), STORE_SLOTS);
+}
+
+static void test_unchanged_record_is_not_written(void)
+{
+    uint8_t record[STORE_RECORD_SIZE];
+
+    reboot();
+    make_record(record, 5);
+    store_save(record);
+    finish_writes();
+    pic_host_eeprom_writes = 0;
+    CHECK_EQ(store_save(record), 1);
+    CHECK_EQ(eeprom_busy(), 0);
+    CHECK_EQ(store_slot(), 0);
+    CHECK_EQ(pic_host_eeprom_writes, 0);
+}
+
+static void test_full_queue_is_reported(void)
+{
+    uint8_t record[STORE_RECORD_SIZE];
+    uint8_t saved = 0;
+
+    reboot();
+    // Fill the EEPROM queue without letting a write finish
+    do {
+        make_record(record, (uint8_t)(saved + 1));
+    } while (store_save(record) && ++saved < 100);
+    CHECK_EQ(saved, EEPROM_QUEUE_SIZE / STORE_SLOT_SIZE);
+    CHECK_EQ(store_get()[0], saved);    // Shadow unchanged by the refused save
+    CHECK_EQ(store_slot(), saved - 1);
+
+    finish_writes();
+    CHECK_EQ(store_save(record), 1);
+    CHECK_EQ(reboot(), 1);
+    CHECK_EQ(store_get()[0], saved + 1);
+}
+
+int main(void)
+{
+    RUN_TEST(test_blank_eeprom_uses_defaults);
+    RUN_TEST(test_save_survives_reset);
+    RUN_TEST(test_saves_rotate_over_every_slot);
+    RUN_TEST(test_sequence_wrap_keeps_newest);
+    RUN_TEST(test_torn_write_keeps_previous_record);
+    RUN_TEST(test_cleared_eeprom_is_not_a_record);
+    RUN_TEST(test_unchanged_record_is_not_written);
+    RUN_TEST(test_full_queue_is_reported);
+    return TEST_RESULT();
+}
@@ -0,0 +1,118 @@
+/* File:   test_timer.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Host tests for the Timer2 tasks of 07-PIC16F_TIMER (newmain.c): the LEDs on RB0..RB3
+ * must toggle every 100/200/300/400 Timer2 interrupts, each tick followed by a pass of the
+ * scheduler's dispatcher as in the main loop. The report task must queue one loop-counter
+ * frame, checked by draining the UART and decoding it with host/tools/framedec.c.
+ */
+
+#include <string.h>
+#include <xc.h>
+#include "test.h"
+#include "../../common/sched.h"
+#include "../../common/uart.h"
+#include "../tools/framedec.h"
+
+void ISR(void);
+void Tasks_Init(void);
+
+// Simulate n Timer2 period matches
+static void timer2_ticks(unsigned n)
+{
+    while (n--) {
+        TMR2IF = 1;
+        ISR();
+        CHECK_EQ(TMR2IF, 0);
+        sched_dispatch();
+    }
+}
+
+static void test_led_intervals(void)
+{
+    sched_task_stats_t stats;
+
+    Tasks_Init();
+    PORTB = 0;
+    timer2_ticks(99);
+    CHECK_EQ(PORTB & 0x0F, 0x00);
+    timer2_ticks(1);
+    CHECK_EQ(RB0, 1);
+    timer2_ticks(100);
+    CHECK_EQ(PORTB & 0x0F, 0x02);   // RB0 toggled back, RB1 on
+    timer2_ticks(100);
+    CHECK_EQ(PORTB & 0x0F, 0x07);   // RB0 on again, RB1 still on, RB2 on
+    timer2_ticks(100);
+    CHECK_EQ(PORTB & 0x0F, 0x0C);   // RB0 and RB1 off, RB2 and RB3 on
+    sched_get_task_stats(4, &stats);
+    CHECK_EQ(stats.runs, 1);        // UART report at tick 50
+    CHECK_EQ(stats.overruns, 0);
+}
+
+static uint8_t got_type, got_payload[16];
+static unsigned got_length, got_frames;
+
+static void on_frame(void *context, const framedec_frame_t *frame)
+{
+    (void)context;
+    got_type = frame->type;
+    got_length = frame->length;
+    memcpy(got_payload, frame->payload, frame->length < 16 ? frame->length : 16);
+    got_frames++;
+}
+
+// Run TX interrupts until the ring is empty and feed the bytes to the decoder
+static void drain_uart(framedec_t *dec)
+{
+    uint8_t byte;
+
+    while (TXIE) {
+        TXIF = 1;
+        uart_isr();
+        byte = TXREG;
+        framedec_feed(dec, &byte, 1);
+    }
+}
+
+static void test_report_is_a_frame(void)
+{
+    static framedec_t dec;
+    uint8_t first;
+
+    uart_init(51);
+    Tasks_Init();
+    framedec_init(&dec, on_frame, NULL);
+    got_frames = 0;
+    timer2_ticks(50);                   // First report
+    drain_uart(&dec);
+    CHECK_EQ(got_frames, 1);
+    first = got_payload[0];
+    timer2_ticks(1000);                 // Second report
+    drain_uart(&dec);
+    CHECK_EQ(got_frames, 2);
+    CHECK_EQ(got_type, 0x20);
+    CHECK_EQ(got_length, 5);
+    CHECK_EQ(got_payload[0], (uint8_t)(first + 1));     // Loop counter, little-endian
+    CHECK_EQ(got_payload[1] | got_payload[2] | got_payload[3], 0);
+    CHECK(got_payload[4] <= 100);       // Idle percent
+    CHECK_EQ(dec.lost + dec.crc_errors + dec.malformed, 0);
+}
+
+static void test_ignores_other_interrupts(void)
+{
+    Tasks_Init();
+    PORTB = 0;
+    TMR2IF = 0;
+    ISR();
+    CHECK_EQ(sched_ticks(), 0);
+    CHECK_EQ(PORTB, 0);
+}
+
+int main(void)
+{
+    RUN_TEST(test_led_intervals);
+    RUN_TEST(test_report_is_a_frame);
+    RUN_TEST(test_ignores_other_interrupts);
+    return TEST_RESULT();
+}
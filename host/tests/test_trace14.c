@@ -0,0 +1,228 @@
+/* File:   test_trace14.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Host tests for the trace capture and timing analysis (host/tools/trace14.c): the VCD
+ * written for a PWM output, the period and duty cycle measured on the pin, the USART text
+ * file and the jitter histogram of register writes from hand-assembled programs.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "test.h"
+#include "../tools/trace14.h"
+
+// Opcodes
+#define NOP_           0x0000
+#define MOVWF_(f)      (0x0080 | (f))
+#define INCF_(f, d)    (0x0A00 | ((d) << 7) | (f))
+#define BCF_(f, b)     (0x1000 | ((b) << 7) | (f))
+#define BSF_(f, b)     (0x1400 | ((b) << 7) | (f))
+#define BTFSS_(f, b)   (0x1C00 | ((b) << 7) | (f))
+#define GOTO_(k)       (0x2800 | (k))
+#define MOVLW_(k)      (0x3000 | (k))
+
+// Register file offsets (bank selected with RP0)
+#define F_STATUS  0x03
+#define F_PORTB   0x06
+#define F_PIR1    0x0C
+#define F_T2CON   0x12
+#define F_CCPR1L  0x15
+#define F_CCP1CON 0x17
+#define F_RCSTA   0x18
+#define F_TXREG   0x19
+#define F_TRISC   0x07      // Bank 1
+#define F_PR2     0x12
+#define F_TXSTA   0x18
+#define F_SPBRG   0x19
+
+#define BANK1     BSF_(F_STATUS, 5)
+#define BANK0     BCF_(F_STATUS, 5)
+
+static sim14_t sim;
+static periph14_t periph;
+static trace14_t trace;
+
+static void start(const uint16_t *words, unsigned count)
+{
+    unsigned i;
+
+    sim14_init(&sim);
+    for (i = 0; i < count; i++) {
+        sim14_set_word(&sim, (uint16_t)i, words[i]);
+    }
+    periph14_attach(&periph, &sim, 4000000);   // 1 us per cycle
+    trace14_free(&trace);
+    trace14_init(&trace, &periph);
+}
+
+static long read_file(const char *path, char *buf, long size)
+{
+    FILE *f = fopen(path, "r");
+    long n;
+
+    if (f == NULL) {
+        return -1;
+    }
+    n = (long)fread(buf, 1, (size_t)(size - 1), f);
+    buf[n] = '\0';
+    fclose(f);
+    return n;
+}
+
+static void test_pwm_period_duty_and_vcd(void)
+{
+    static const uint16_t prog[] = {
+        BANK1, MOVLW_(99), MOVWF_(F_PR2),       // 100-cycle period
+        BCF_(F_TRISC, 2), BANK0,
+        MOVLW_(25), MOVWF_(F_CCPR1L),           // Duty 25 cycles
+        MOVLW_(0x0C), MOVWF_(F_CCP1CON),
+        MOVLW_(0x04), MOVWF_(F_T2CON),          // First rising edge at cycle 111
+        NOP_, GOTO_(11)
+    };
+    char path[] = "/tmp/trace14_XXXXXX";
+    char err[128];
+    static char text[16384];
+    const trace14_measure_t *m;
+    int fd = mkstemp(path);
+
+    CHECK(fd >= 0);
+    close(fd);
+    start(prog, sizeof(prog) / sizeof(prog[0]));
+    CHECK_EQ(trace14_measure(&trace, "rc2", err, sizeof(err)), 0);
+    CHECK_EQ(trace14_watch(&trace, "CCPR1L", err, sizeof(err)), 0);
+    CHECK_EQ(trace14_open_vcd(&trace, path), 0);
+    trace14_start(&trace, "pwm");
+    sim14_run(&sim, 1050);
+    trace14_finish(&trace, sim.cycles);
+
+    m = &trace.measures[0];
+    CHECK(m->is_pin);
+    CHECK_EQ(strcmp(m->name, "RC2"), 0);
+    CHECK_EQ(m->count, 9);                  // Rising edges at 111, 211, ... 1011
+    CHECK_EQ(m->min, 100);
+    CHECK_EQ(m->max, 100);
+    CHECK_EQ(m->distinct, 1);
+    CHECK_EQ(m->counts[0], 9);
+    CHECK_EQ(m->high_count, 10);
+    CHECK_EQ(m->high_sum, 250);
+    CHECK_EQ(trace.pin_changes[PERIPH14_PORTC], 20);
+
+    CHECK(read_file(path, text, sizeof(text)) > 0);
+    CHECK(strstr(text, "$timescale 1ns $end") != NULL);
+    CHECK(strstr(text, "$var wire 1 B RC2 $end") != NULL);
+    CHECK(strstr(text, "$var reg 8 X CCPR1L $end") != NULL);
+    CHECK(strstr(text, "#0\n$dumpvars\n") != NULL);
+    CHECK(strstr(text, "#7000\nb00011001 X\n") != NULL);     // MOVWF CCPR1L, cycle 7
+    CHECK(strstr(text, "#111000\n1B\n#136000\n0B\n#211000\n1B\n") != NULL);
+    CHECK(strstr(text, "\n#1050000\n") != NULL);             // End of the run
+    CHECK_EQ(trace.vcd_changes, 21);
+    unlink(path);
+}
+
+static void test_uart_text_lines(void)
+{
+    static const uint16_t prog[] = {
+        BANK1, MOVLW_(25), MOVWF_(F_SPBRG),
+        MOVLW_(0x24), MOVWF_(F_TXSTA),          // 4 x 26 cycles per bit
+        BANK0, MOVLW_(0x80), MOVWF_(F_RCSTA),
+        MOVLW_('A'), MOVWF_(F_TXREG),           // TSR loaded during cycle 10
+        BTFSS_(F_PIR1, 4), GOTO_(10),
+        MOVLW_('\r'), MOVWF_(F_TXREG),
+        BTFSS_(F_PIR1, 4), GOTO_(14),
+        MOVLW_('\n'), MOVWF_(F_TXREG),
+        BTFSS_(F_PIR1, 4), GOTO_(18),
+        MOVLW_(0x07), MOVWF_(F_TXREG),          // Unterminated last line
+        NOP_, GOTO_(22)
+    };
+    char path[] = "/tmp/trace14_XXXXXX";
+    char text[256];
+    int fd = mkstemp(path);
+
+    CHECK(fd >= 0);
+    close(fd);
+    start(prog, sizeof(prog) / sizeof(prog[0]));
+    CHECK_EQ(trace14_open_uart(&trace, path), 0);
+    trace14_start(&trace, "uart");
+    sim14_run(&sim, 6000);
+    trace14_finish(&trace, sim.cycles);
+
+    CHECK_EQ(periph.bytes[PERIPH14_UART_TX], 4);
+    CHECK_EQ(trace.uart_lines, 2);
+    CHECK_EQ(trace.first[PERIPH14_UART_TX], 1050);
+    CHECK_EQ(trace.min_gap[PERIPH14_UART_TX], 1040);   // Back to back frames
+    CHECK_EQ(trace.max_gap[PERIPH14_UART_TX], 1040);
+    CHECK(read_file(path, text, sizeof(text)) > 0);
+    CHECK_EQ(strcmp(text, "    0.001050  A\n    0.004170  \\x07\n"), 0);
+    unlink(path);
+}
+
+static void test_register_write_jitter(void)
+{
+    static const uint16_t prog[] = {
+        INCF_(F_PORTB, 1), NOP_,                // Writes 2 then 3 cycles apart
+        INCF_(F_PORTB, 1), GOTO_(0)
+    };
+    char err[128];
+    const trace14_measure_t *m;
+    FILE *out;
+    char text[2048];
+    long n;
+
+    start(prog, sizeof(prog) / sizeof(prog[0]));
+    CHECK_EQ(trace14_measure(&trace, "0x106", err, sizeof(err)), 0);    // PORTB, bank 2
+    trace14_start(&trace, "jitter");
+    sim14_run(&sim, 5000);
+    trace14_finish(&trace, sim.cycles);
+
+    m = &trace.measures[0];
+    CHECK(!m->is_pin);
+    CHECK_EQ(m->address, SIM14_PORTB);
+    CHECK_EQ(strcmp(m->name, "PORTB"), 0);
+    CHECK_EQ(m->min, 2);
+    CHECK_EQ(m->max, 3);
+    CHECK_EQ(m->distinct, 2);
+    CHECK(m->counts[0] - m->counts[1] <= 1);
+    CHECK_EQ(m->count, m->counts[0] + m->counts[1]);
+
+    out = tmpfile();
+    CHECK(out != NULL);
+    trace14_report(&trace, out);
+    rewind(out);
+    n = (long)fread(text, 1, sizeof(text) - 1, out);
+    text[n] = '\0';
+    fclose(out);
+    CHECK(strstr(text, "PORTB write interval: ") != NULL);
+    CHECK(strstr(text, "mean 2.500 us (") != NULL);
+    CHECK(strstr(text, "jitter 500 ns RMS / 1.000 us p-p") != NULL);
+    CHECK(strstr(text, "2.000 us") != NULL);
+    CHECK(strstr(text, "3.000 us") != NULL);
+}
+
+static void test_bad_signals(void)
+{
+    char err[128];
+
+    start(NULL, 0);
+    CHECK_EQ(trace14_measure(&trace, "RA7", err, sizeof(err)), -1);     // Not bonded out
+    CHECK(strstr(err, "RA7") != NULL);
+    CHECK_EQ(trace14_watch(&trace, "NOSUCH", err, sizeof(err)), -1);
+    CHECK(strstr(err, "unknown register") != NULL);
+    CHECK_EQ(trace14_watch(&trace, "STATUS", err, sizeof(err)), -1);
+    CHECK(strstr(err, "core register") != NULL);
+    CHECK_EQ(trace14_watch(&trace, "portb", err, sizeof(err)), 0);
+    CHECK_EQ(trace14_watch(&trace, "0x06", err, sizeof(err)), 0);       // Already watched
+    CHECK_EQ(trace.reg_count, 1);
+    CHECK_EQ(trace.measure_count, 0);
+}
+
+int main(void)
+{
+    RUN_TEST(test_pwm_period_duty_and_vcd);
+    RUN_TEST(test_uart_text_lines);
+    RUN_TEST(test_register_write_jitter);
+    RUN_TEST(test_bad_signals);
+    trace14_free(&trace);
+    return TEST_RESULT();
+}
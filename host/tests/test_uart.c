@@ -0,0 +1,250 @@
+/* File:   test_uart.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Host tests for the interrupt-driven UART driver (common/uart.c).
+ * The ISR is called by hand after setting RCIF/TXIF the way the USART would. Frames are
+ * checked byte for byte here; their decoding is covered by test_frame.c.
+ */
+
+#include <string.h>
+#include <xc.h>
+#include "test.h"
+#include "../../common/uart.h"
+
+// Deliver one received byte through the RX interrupt
+static void receive_byte(uint8_t data)
+{
+    RCREG = data;
+    RCIF = 1;
+    uart_isr();
+    RCIF = 0;
+}
+
+// Run TX interrupts until the driver masks TXIE, collecting what went to TXREG
+static uint8_t drain_tx(uint8_t *out, uint8_t max)
+{
+    uint8_t n = 0;
+    while (TXIE && n < max) {
+        TXIF = 1;
+        uart_isr();
+        out[n++] = TXREG;
+    }
+    return n;
+}
+
+static void test_init_enables_receiver(void)
+{
+    uart_init(103);
+    CHECK_EQ(SPBRG, 103);
+    CHECK_EQ(BRGH, 1);
+    CHECK_EQ(SPEN, 1);
+    CHECK_EQ(CREN, 1);
+    CHECK_EQ(TXEN, 1);
+    CHECK_EQ(RCIE, 1);
+    CHECK_EQ(TXIE, 0);
+    CHECK_EQ(GIE, 1);
+}
+
+static void test_write_is_sent_in_order(void)
+{
+    uint8_t out[8];
+    uart_init(103);
+    CHECK(uart_write('O'));
+    CHECK(uart_write('K'));
+    CHECK_EQ(TXIE, 1);
+    CHECK_EQ(drain_tx(out, sizeof(out)), 2);
+    CHECK_EQ(out[0], 'O');
+    CHECK_EQ(out[1], 'K');
+    CHECK_EQ(TXIE, 0);
+    CHECK_EQ(uart_tx_free(), UART_TX_BUFFER_SIZE);
+}
+
+static void test_write_reports_full_buffer(void)
+{
+    uint8_t out[UART_TX_BUFFER_SIZE + 1];
+    uint16_t i;
+    uart_init(103);
+    for (i = 0; i < UART_TX_BUFFER_SIZE; i++) {
+        CHECK(uart_write((uint8_t)i));
+    }
+    CHECK_EQ(uart_tx_free(), 0);
+    CHECK_EQ(uart_write(0xFF), 0);
+    CHECK_EQ(uart_write_text("x"), 0);
+    CHECK_EQ(drain_tx(out, sizeof(out)), UART_TX_BUFFER_SIZE);
+    CHECK_EQ(out[UART_TX_BUFFER_SIZE - 1], UART_TX_BUFFER_SIZE - 1);
+}
+
+static void test_write_text_is_all_or_nothing(void)
+{
+    uint8_t out[UART_TX_BUFFER_SIZE];
+    uint16_t i;
+    uart_init(103);
+    for (i = 0; i < UART_TX_BUFFER_SIZE - 3; i++) {
+        uart_write('.');
+    }
+    CHECK_EQ(uart_write_text("abcd"), 0);
+    CHECK_EQ(uart_tx_free(), 3);
+    CHECK_EQ(uart_write_text("abc"), 1);
+    CHECK_EQ(uart_tx_free(), 0);
+    CHECK_EQ(drain_tx(out, sizeof(out)), UART_TX_BUFFER_SIZE);
+    CHECK_EQ(out[UART_TX_BUFFER_SIZE - 1], 'c');
+}
+
+static void test_write_some_resumes_long_text(void)
+{
+    static const char text[] = "A line longer than the whole transmit buffer of the driver, "
+                               "sent in pieces as the interrupt makes room.";
+    uint8_t out[sizeof(text)];
+    uint16_t sent = 0, got = 0;
+
+    uart_init(103);
+    CHECK_EQ(uart_write_text(text), 0);             // Longer than UART_TX_BUFFER_SIZE
+    sent = uart_write_some(text);
+    CHECK_EQ(sent, UART_TX_BUFFER_SIZE);
+    CHECK_EQ(uart_write_some(text + sent), 0);      // Full: nothing queued
+    while (text[sent] != '\0') {
+        got += drain_tx(out + got, 10);
+        sent += uart_write_some(text + sent);
+    }
+    got += drain_tx(out + got, (uint8_t)(sizeof(out) - got));
+    CHECK_EQ(got, sizeof(text) - 1);
+    CHECK_EQ(memcmp(out, text, sizeof(text) - 1), 0);
+    CHECK_EQ(TXIE, 0);
+}
+
+static void test_receive_and_read(void)
+{
+    uint8_t data = 0;
+    uart_init(103);
+    CHECK_EQ(uart_read(&data), 0);
+    receive_byte('h');
+    receive_byte('i');
+    CHECK_EQ(uart_available(), 2);
+    CHECK(uart_read(&data));
+    CHECK_EQ(data, 'h');
+    CHECK(uart_read(&data));
+    CHECK_EQ(data, 'i');
+    CHECK_EQ(uart_available(), 0);
+}
+
+static void test_receive_wraps_around(void)
+{
+    uint8_t data;
+    uint16_t i;
+    uart_init(103);
+    // Push the indices past the 8-bit wrap several times
+    for (i = 0; i < 1000; i++) {
+        receive_byte((uint8_t)i);
+        CHECK(uart_read(&data));
+        CHECK_EQ(data, (uint8_t)i);
+    }
+}
+
+static void test_rx_overflow_is_counted(void)
+{
+    uart_stats_t stats;
+    uint8_t data;
+    uint16_t i;
+    uart_init(103);
+    for (i = 0; i < UART_RX_BUFFER_SIZE + 3; i++) {
+        receive_byte((uint8_t)i);
+    }
+    CHECK_EQ(uart_available(), UART_RX_BUFFER_SIZE);
+    uart_get_stats(&stats);
+    CHECK_EQ(stats.rx_dropped, 3);
+    CHECK(uart_read(&data));
+    CHECK_EQ(data, 0);
+}
+
+static void test_framing_error_discards_byte(void)
+{
+    uart_stats_t stats;
+    uart_init(103);
+    FERR = 1;
+    receive_byte(0x55);
+    FERR = 0;
+    CHECK_EQ(uart_available(), 0);
+    uart_get_stats(&stats);
+    CHECK_EQ(stats.framing_errors, 1);
+    CHECK_EQ(RCIE, 1);
+}
+
+static void test_overrun_restarts_receiver(void)
+{
+    uart_stats_t stats;
+    uart_init(103);
+    OERR = 1;
+    receive_byte('a');
+    CHECK_EQ(uart_available(), 1);
+    CHECK_EQ(CREN, 1);
+    uart_get_stats(&stats);
+    CHECK_EQ(stats.overrun_errors, 1);
+    RCIE = 0;                           // Receiver masked by the caller stays masked
+    uart_get_stats(&stats);
+    CHECK_EQ(RCIE, 0);
+}
+
+static void test_frame_is_queued_whole(void)
+{
+    // COBS(01 00 | 00 41 | CRC AA 91) 00
+    static const uint8_t expected[] = { 0x02, 0x01, 0x01, 0x04, 0x41, 0xAA, 0x91, 0x00 };
+    uint8_t out[16];
+    frame_t frame;
+    uint8_t i;
+
+    uart_init(103);
+    uart_frame_begin(&frame, 0x01);
+    frame_put(&frame, 0x00);
+    frame_put(&frame, 'A');
+    CHECK_EQ(TXIE, 0);                          // Nothing published yet
+    CHECK_EQ(uart_tx_free(), UART_TX_BUFFER_SIZE);
+    CHECK_EQ(uart_frame_end(&frame), 1);
+    CHECK_EQ(uart_tx_free(), UART_TX_BUFFER_SIZE - sizeof(expected));
+    CHECK_EQ(drain_tx(out, sizeof(out)), sizeof(expected));
+    for (i = 0; i < sizeof(expected); i++) {
+        CHECK_EQ(out[i], expected[i]);
+    }
+}
+
+static void test_frame_that_does_not_fit_is_dropped(void)
+{
+    uint8_t out[UART_TX_BUFFER_SIZE];
+    frame_t frame;
+    uint16_t i;
+
+    uart_init(103);
+    for (i = 0; i < UART_TX_BUFFER_SIZE - FRAME_OVERHEAD; i++) {
+        uart_write('.');
+    }
+    uart_frame_begin(&frame, 0x02);             // Seq 0, one byte too long
+    frame_put(&frame, 0x33);
+    CHECK_EQ(uart_frame_end(&frame), 0);
+    CHECK_EQ(uart_tx_free(), FRAME_OVERHEAD);
+    CHECK_EQ(drain_tx(out, sizeof(out)), UART_TX_BUFFER_SIZE - FRAME_OVERHEAD);
+    CHECK_EQ(out[UART_TX_BUFFER_SIZE - FRAME_OVERHEAD - 1], '.');
+
+    uart_frame_begin(&frame, 0x02);             // Seq 1: the receiver sees one lost
+    CHECK_EQ(uart_frame_end(&frame), 1);
+    CHECK_EQ(drain_tx(out, sizeof(out)), FRAME_OVERHEAD);
+    CHECK_EQ(out[1], 0x02);
+    CHECK_EQ(out[2], 0x01);
+    CHECK_EQ(out[FRAME_OVERHEAD - 1], 0x00);
+}
+
+int main(void)
+{
+    RUN_TEST(test_init_enables_receiver);
+    RUN_TEST(test_write_is_sent_in_order);
+    RUN_TEST(test_write_reports_full_buffer);
+    RUN_TEST(test_write_text_is_all_or_nothing);
+    RUN_TEST(test_write_some_resumes_long_text);
+    RUN_TEST(test_receive_and_read);
+    RUN_TEST(test_receive_wraps_around);
+    RUN_TEST(test_rx_overflow_is_counted);
+    RUN_TEST(test_framing_error_discards_byte);
+    RUN_TEST(test_overrun_restarts_receiver);
+    RUN_TEST(test_frame_is_queued_whole);
+    RUN_TEST(test_frame_that_does_not_fit_is_dropped);
+    return TEST_RESULT();
+}
@@ -0,0 +1,131 @@
+/* File:   framedec.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Telemetry frame decoder (see framedec.h). The CRC is the firmware's own crc16() from
+ * common/crc.c, so both ends always agree on the polynomial and byte order.
+ */
+
+#include <string.h>
+#include "framedec.h"
+#include "../../common/crc.h"
+
+void framedec_init(framedec_t *d, framedec_handler_t handler, void *context)
+{
+    memset(d, 0, sizeof(*d));
+    d->handler = handler;
+    d->context = context;
+}
+
+int framedec_cobs(const uint8_t *in, unsigned length, uint8_t *out)
+{
+    unsigned i = 0, n = 0;
+
+    while (i < length) {
+        unsigned code = in[i++];
+        unsigned end = i + code - 1;
+
+        if (code == 0 || end > length) {
+            return -1;
+        }
+        while (i < end) {
+            if (in[i] == 0) {
+                return -1;
+            }
+            out[n++] = in[i++];
+        }
+        // Each block but the last and the full ones stands for a zero
+        if (code != 0xFF && i < length) {
+            out[n++] = 0;
+        }
+    }
+    return (int)n;
+}
+
+// Check and deliver the frame held in raw[]
+static void framedec_frame(framedec_t *d)
+{
+    uint8_t data[FRAMEDEC_MAX_FRAME];
+    framedec_frame_t frame;
+    uint16_t crc = CRC16_INIT;
+    int n, i;
+
+    n = framedec_cobs(d->raw, d->raw_length, data);
+    if (n < FRAMEDEC_HEADER + FRAMEDEC_TRAILER) {
+        d->malformed++;
+        return;
+    }
+    for (i = 0; i < n - FRAMEDEC_TRAILER; i++) {
+        crc = crc16_update(crc, data[i]);
+    }
+    if (crc != (uint16_t)(data[n - 2] << 8 | data[n - 1])) {
+        d->crc_errors++;
+        return;
+    }
+
+    frame.type = data[0];
+    frame.seq = data[1];
+    frame.payload = data + FRAMEDEC_HEADER;
+    frame.length = (unsigned)n - FRAMEDEC_HEADER - FRAMEDEC_TRAILER;
+    if (d->synced) {
+        d->lost += (uint8_t)(frame.seq - d->next_seq);
+    }
+    d->synced = 1;
+    d->next_seq = (uint8_t)(frame.seq + 1);
+    d->frames++;
+    d->payload_bytes += frame.length;
+    d->types[frame.type]++;
+    if (d->handler != NULL) {
+        d->handler(d->context, &frame);
+    }
+}
+
+void framedec_feed(framedec_t *d, const uint8_t *data, size_t length)
+{
+    size_t i;
+
+    d->bytes += length;
+    for (i = 0; i < length; i++) {
+        if (data[i] != 0) {
+            if (d->raw_length < FRAMEDEC_MAX_FRAME) {
+                d->raw[d->raw_length++] = data[i];
+            } else {
+                d->overlong = 1;
+            }
+            continue;
+        }
+        // Delimiter: empty frames (repeated delimiters) only resynchronise
+        if (d->overlong) {
+            d->malformed++;
+        } else if (d->raw_length > 0) {
+            framedec_frame(d);
+        }
+        d->raw_length = 0;
+        d->overlong = 0;
+    }
+}
+
+void framedec_report(const framedec_t *d, FILE *out)
+{
+    unsigned t;
+
+    fprintf(out, "Frames %llu, payload %llu bytes in %llu wire bytes",
+            (unsigned long long)d->frames, (unsigned long long)d->payload_bytes,
+            (unsigned long long)d->bytes);
+    if (d->bytes) {
+        fprintf(out, " (%.1f%% payload)", 100.0 * (double)d->payload_bytes / (double)d->bytes);
+    }
+    fprintf(out, "\n");
+    fprintf(out, "Lost %llu, CRC errors %llu, malformed %llu",
+            (unsigned long long)d->lost, (unsigned long long)d->crc_errors,
+            (unsigned long long)d->malformed);
+    if (d->raw_length || d->overlong) {
+        fprintf(out, ", %u bytes of an unfinished frame", d->raw_length);
+    }
+    fprintf(out, "\n");
+    for (t = 0; t < 256; t++) {
+        if (d->types[t]) {
+            fprintf(out, "  type 0x%02X: %llu frames\n", t, (unsigned long long)d->types[t]);
+        }
+    }
+}
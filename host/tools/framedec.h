@@ -0,0 +1,71 @@
+/* File:   framedec.h
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Host decoder for the binary telemetry frames of common/frame.h, used by the telem tool
+ * and the host tests. Bytes are fed in arbitrary chunks as they arrive from a capture file
+ * or a serial port; each complete frame (up to its 0x00 delimiter) is unstuffed, its
+ * CRC-16 checked and, if valid, handed to a callback with its type, sequence number and
+ * payload.
+ *
+ * The decoder keeps link statistics: frames lost (gaps in the sequence numbers), CRC
+ * failures, malformed frames (bad COBS code, shorter than the header, longer than
+ * FRAMEDEC_MAX_FRAME), the count of frames per type, and the wire bytes against the payload
+ * bytes they carried. A stream picked up mid-frame costs one malformed or CRC-failed frame
+ * before the first delimiter.
+ */
+
+#ifndef FRAMEDEC_H
+#define FRAMEDEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define FRAMEDEC_MAX_FRAME 1024     // Encoded bytes between delimiters
+#define FRAMEDEC_HEADER    2        // Type, seq
+#define FRAMEDEC_TRAILER   2        // CRC-16
+
+typedef struct {
+    uint8_t type;
+    uint8_t seq;
+    const uint8_t *payload;
+    unsigned length;
+} framedec_frame_t;
+
+typedef void (*framedec_handler_t)(void *context, const framedec_frame_t *frame);
+
+typedef struct {
+    framedec_handler_t handler;
+    void *context;
+
+    uint8_t raw[FRAMEDEC_MAX_FRAME];    // Encoded bytes of the frame being received
+    unsigned raw_length;
+    int overlong;                       // Current frame exceeded raw[]
+    int synced;                         // A valid frame set next_seq
+    uint8_t next_seq;
+
+    // Statistics
+    uint64_t bytes;                     // All bytes fed
+    uint64_t frames;                    // Valid frames
+    uint64_t payload_bytes;             // Payload carried by the valid frames
+    uint64_t lost;                      // Sequence numbers skipped
+    uint64_t crc_errors;
+    uint64_t malformed;
+    uint64_t types[256];
+} framedec_t;
+
+// Reset the decoder and its statistics; 'handler' (may be NULL) receives each valid frame
+void framedec_init(framedec_t *d, framedec_handler_t handler, void *context);
+
+// Decode a chunk of the byte stream
+void framedec_feed(framedec_t *d, const uint8_t *data, size_t length);
+
+// Unstuff one COBS frame (without its delimiter). Returns the decoded length, or -1 if a
+// code byte points past the end or the frame holds a zero. 'out' needs 'length' bytes.
+int framedec_cobs(const uint8_t *in, unsigned length, uint8_t *out);
+
+// Frame counts, errors, loss and line efficiency
+void framedec_report(const framedec_t *d, FILE *out);
+
+#endif /* FRAMEDEC_H */
@@ -0,0 +1,890 @@
+/* File:   lstprof.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Offline timing profiler for the XC8 assembler listings of the projects
+ * (<project>.X/dist/default/production/<project>.X.production.lst).
+ *
+ * The listing holds the final address and opcode of every instruction, so the program
+ * memory image is rebuilt from it and walked as a control-flow graph:
+ *   - best/worst-case cycle counts of every function (calls included),
+ *   - the interrupt path: hardware latency, context save/restore and the handler itself,
+ *   - the call depth of main plus the interrupt against the 8-level hardware stack,
+ *   - blocking constructs reachable from the interrupt: XC8 __delay_ms()/__delay_us()
+ *     loops (timed exactly from their counter loads), busy-waits on SFR bits and other
+ *     loops whose trip count depends on data.
+ *
+ * Usage: lstprof [-f fosc_hz] [-b max_isr_cycles] listing.lst...
+ * Without -f, _XTAL_FREQ is read from the project sources next to the listing.
+ * With -b, the exit status is 1 when the interrupt can occupy the CPU longer than that.
+ */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pic14.h"
+
+#define NAME_SIZE     64
+#define LINE_SIZE     1024
+#define MAX_PSECTS    128
+#define COST_INF      UINT64_MAX
+#define HW_LATENCY_MIN 3    // Interrupt latency in Tcy (datasheet, section 14.11)
+#define HW_LATENCY_MAX 4
+
+// Path flags
+#define PATH_LOOP     0x01  // Contains a loop without a known trip count
+#define PATH_UNKNOWN  0x02  // Branches to an address that is not in the listing
+#define PATH_COMPUTED 0x04  // Computed jump (write to PCL), assumed to land on a retlw table
+
+typedef struct {
+    uint8_t valid;
+    uint8_t label;          // A code label points here (bank selection unknown)
+    int8_t rp;              // STATUS<RP1:RP0> when executed, -1 if unknown
+    pic14_insn_t insn;
+    int src;                // Index in sources[], -1 if none
+} cell_t;
+
+typedef struct {
+    char name[NAME_SIZE];
+    int entry;              // -1 until its label is seen
+    int stack_required;     // XC8 "Hardware stack levels required when called"
+    char defined[NAME_SIZE];
+} func_t;
+
+typedef struct {
+    uint64_t best;
+    uint64_t worst;
+    uint8_t flags;
+    uint8_t depth;          // Return-address stack levels used below this point
+} cost_t;
+
+typedef struct {
+    uint16_t head;
+    uint16_t tail;
+} loop_t;
+
+// Program image and per-address analysis state
+static cell_t code[PIC14_PROGRAM_WORDS];
+static uint8_t kernel_len[PIC14_PROGRAM_WORDS];     // Words of an XC8 delay kernel starting here
+static uint64_t kernel_cycles[PIC14_PROGRAM_WORDS];
+static uint8_t state[PIC14_PROGRAM_WORDS];          // 0 = new, 1 = on the walk, 2 = done
+static cost_t memo[PIC14_PROGRAM_WORDS];
+static uint8_t reached[PIC14_PROGRAM_WORDS];
+static int owner[PIC14_PROGRAM_WORDS];              // Index in funcs[], -1 if outside any function
+
+static func_t *funcs;
+static int func_count, func_cap;
+static char (*sources)[NAME_SIZE];
+static int source_count, source_cap;
+static loop_t *loops;
+static int loop_count, loop_cap;
+
+typedef struct {
+    char name[NAME_SIZE];
+    int func;               // Function whose code the psect holds, -1 if none yet
+} psect_t;
+
+static psect_t code_psects[MAX_PSECTS];
+static int code_psect_count;
+static int has_vector;      // XC8 emitted interrupt_function at the interrupt vector
+
+/* ------------------------------------------------------------------------------------------ */
+/* Helpers                                                                                    */
+/* ------------------------------------------------------------------------------------------ */
+
+static void *grow(void *array, int *cap, size_t item)
+{
+    void *p;
+    *cap = *cap ? *cap * 2 : 64;
+    p = realloc(array, (size_t)*cap * item);
+    if (p == NULL) {
+        fprintf(stderr, "lstprof: out of memory\n");
+        exit(2);
+    }
+    return p;
+}
+
+static uint64_t add_sat(uint64_t a, uint64_t b)
+{
+    return (a == COST_INF || b == COST_INF || a + b < a) ? COST_INF : a + b;
+}
+
+static int is_hex4(const char *s)
+{
+    int i;
+    for (i = 0; i < 4; i++) {
+        if (!isdigit((unsigned char)s[i]) && !(s[i] >= 'A' && s[i] <= 'F')) {
+            return 0;
+        }
+    }
+    return s[4] == ' ' || s[4] == '\t' || s[4] == '\n' || s[4] == '\r' || s[4] == '\0';
+}
+
+static const pic14_sfr_t *find_sfr(int f, int rp)
+{
+    const pic14_sfr_t *sfr;
+
+    // INDF, PCL, STATUS, FSR, PCLATH and INTCON are mirrored in every bank
+    if (f == 0x00 || f == 0x02 || f == 0x03 || f == 0x04 || f == 0x0A || f == 0x0B) {
+        rp = 0;
+    }
+    if (rp < 0) {
+        return NULL;
+    }
+    sfr = pic14_sfr_at((uint16_t)(rp * 0x80 + f));
+    // Banks 2/3 mirror TMR0, PORTB, OPTION_REG and TRISB of banks 0/1
+    if (sfr == NULL && rp >= 2) {
+        sfr = pic14_sfr_at((uint16_t)(rp * 0x80 + f - 0x100));
+    }
+    return sfr;
+}
+
+static func_t *function_at(int address)
+{
+    return owner[address] >= 0 ? &funcs[owner[address]] : NULL;
+}
+
+static func_t *function_named(const char *name)
+{
+    int i;
+    for (i = 0; i < func_count; i++) {
+        if (strcmp(funcs[i].name, name) == 0) {
+            return &funcs[i];
+        }
+    }
+    return NULL;
+}
+
+// Closest C source line, or the definition of the enclosing function
+static const char *source_of(int address)
+{
+    func_t *f = function_at(address);
+    if (code[address].src >= 0) {
+        return sources[code[address].src];
+    }
+    return (f != NULL && f->defined[0]) ? f->defined : "-";
+}
+
+/* ------------------------------------------------------------------------------------------ */
+/* Listing parser                                                                             */
+/* ------------------------------------------------------------------------------------------ */
+
+typedef struct {
+    int psect;              // Index in code_psects[] of the current psect, -1 if not code
+    int src;                // Last ";file.c: line:" comment
+    func_t *header;         // Function whose ";; *****" header block is being read
+    int header_field;       // 1 while reading the "Defined at:" line
+} parser_t;
+
+static void parse_psect(parser_t *p, const char *args)
+{
+    char name[NAME_SIZE];
+    int i, n = 0;
+
+    while (*args == ' ' || *args == '\t') {
+        args++;
+    }
+    while (args[n] && args[n] != ',' && !isspace((unsigned char)args[n]) && n < NAME_SIZE - 1) {
+        name[n] = args[n];
+        n++;
+    }
+    name[n] = '\0';
+
+    // A declaration carries the flags; only the class matters here
+    if (args[n] == ',' && (strstr(args, "class=CODE") || strstr(args, "class=STRING"))) {
+        if (code_psect_count < MAX_PSECTS) {
+            strcpy(code_psects[code_psect_count].name, name);
+            code_psects[code_psect_count].func = -1;
+            code_psect_count++;
+        }
+    }
+    p->psect = -1;
+    for (i = 0; i < code_psect_count; i++) {
+        if (strcmp(code_psects[i].name, name) == 0) {
+            p->psect = i;
+        }
+    }
+
+    // "text6_split_1" continues the function placed in "text6"
+    if (p->psect >= 0 && code_psects[p->psect].func < 0 && strstr(name, "_split_") != NULL) {
+        size_t base = (size_t)(strstr(name, "_split_") - name);
+        for (i = 0; i < code_psect_count; i++) {
+            if (strlen(code_psects[i].name) == base && strncmp(code_psects[i].name, name, base) == 0) {
+                code_psects[p->psect].func = code_psects[i].func;
+            }
+        }
+    }
+}
+
+static void parse_comment(parser_t *p, const char *text)
+{
+    const char *s;
+
+    if (strncmp(text, ";; ****", 7) == 0 && (s = strstr(text, " function ")) != NULL) {
+        char name[NAME_SIZE];
+        if (sscanf(s + 10, "%63s", name) == 1) {
+            if (func_count == func_cap) {
+                funcs = grow(funcs, &func_cap, sizeof(func_t));
+            }
+            p->header = &funcs[func_count++];
+            p->src = -1;
+            memset(p->header, 0, sizeof(func_t));
+            strcpy(p->header->name, name);
+            p->header->entry = -1;
+            p->header->stack_required = -1;
+        }
+        return;
+    }
+    if (p->header != NULL && strncmp(text, ";;", 2) == 0) {
+        int line;
+        char file[48];
+        if ((s = strstr(text, "Hardware stack levels required when called:")) != NULL) {
+            p->header->stack_required = atoi(s + 43);
+        } else if (strstr(text, "Defined at:") != NULL) {
+            p->header_field = 1;
+        } else if (p->header_field && sscanf(text, ";; line %d in file \"%47[^\"]\"", &line, file) == 2) {
+            // Library sources carry a full Windows path
+            const char *base = strrchr(file, '\\') ? strrchr(file, '\\') + 1 : file;
+            snprintf(p->header->defined, NAME_SIZE, "%s:%d", base, line);
+            p->header_field = 0;
+        }
+        return;
+    }
+
+    // Source line comment: ";newmain.c: 32: <text>"
+    if (text[0] == ';' && text[1] != ';') {
+        char file[48];
+        int line;
+        if (sscanf(text + 1, "%47[^:]: %d:", file, &line) == 2 && strchr(file, '.') != NULL) {
+            if (source_count == source_cap) {
+                sources = grow(sources, &source_cap, NAME_SIZE);
+            }
+            snprintf(sources[source_count], NAME_SIZE, "%s:%d", file, line);
+            p->src = source_count++;
+        }
+    }
+}
+
+static void parse_label(parser_t *p, int address, const char *name)
+{
+    int i;
+
+    if (p->psect < 0 || address > PIC14_PROGRAM_WORDS) {
+        return;
+    }
+    if (address < PIC14_PROGRAM_WORDS) {
+        code[address].label = 1;
+    }
+    if (address == PIC14_INT_VECTOR && strcmp(name, "interrupt_function") == 0) {
+        has_vector = 1;
+    }
+
+    for (i = 0; i < func_count; i++) {
+        func_t *f = &funcs[i];
+        if (f->entry < 0 && strcmp(f->name, name) == 0) {
+            f->entry = address;
+            code_psects[p->psect].func = i;
+        }
+    }
+}
+
+static void parse_line(parser_t *p, char *line)
+{
+    char *s = line;
+    int address;
+
+    // Every listing line starts with its line number; page headers and symbols do not
+    while (*s == ' ') {
+        s++;
+    }
+    if (!isdigit((unsigned char)*s)) {
+        return;
+    }
+    while (isdigit((unsigned char)*s)) {
+        s++;
+    }
+    while (*s == ' ') {
+        s++;
+    }
+
+    if (*s == ';') {
+        parse_comment(p, s);
+        return;
+    }
+    if (!is_hex4(s)) {
+        // Directive without an address
+        while (*s == ' ' || *s == '\t') {
+            s++;
+        }
+        if (strncmp(s, "psect", 5) == 0 && (s[5] == '\t' || s[5] == ' ')) {
+            parse_psect(p, s + 5);
+            p->header = NULL;
+        }
+        return;
+    }
+
+    address = (int)strtol(s, NULL, 16);
+    s += 4;
+    while (*s == ' ') {
+        s++;
+    }
+
+    if (is_hex4(s)) {
+        // Instruction: one or more opcode words (fcall/ljmp expand to several)
+        while (is_hex4(s)) {
+            uint16_t word = (uint16_t)strtol(s, NULL, 16);
+            if (p->psect >= 0 && address < PIC14_PROGRAM_WORDS && !code[address].valid) {
+                code[address].valid = 1;
+                code[address].src = p->src;
+                owner[address] = code_psects[p->psect].func;
+                pic14_decode(word, &code[address].insn);
+                if (code[address].insn.op == PIC14_CALL || code[address].insn.op == PIC14_GOTO) {
+                    // The 11-bit target is completed by PCLATH<4:3>, which XC8 always sets
+                    // for the current page (goto) or just before (fcall/ljmp)
+                    code[address].insn.k |= (uint16_t)(address & 0x1800);
+                }
+            }
+            address++;
+            s += 4;
+            while (*s == ' ') {
+                s++;
+            }
+        }
+        return;
+    }
+
+    // Label definition: "name:"
+    {
+        char name[NAME_SIZE];
+        int n = 0;
+        while (s[n] && s[n] != ':' && !isspace((unsigned char)s[n]) && n < NAME_SIZE - 1) {
+            name[n] = s[n];
+            n++;
+        }
+        if (n > 0 && s[n] == ':') {
+            name[n] = '\0';
+            parse_label(p, address, name);
+        }
+    }
+}
+
+/*
+ * fcall/ljmp set PCLATH with bsf/bcf before the call/goto word; the page computed in
+ * parse_line() is the page of the instruction itself, so patch it from those writes.
+ */
+static void fix_far_targets(void)
+{
+    int a;
+    for (a = 2; a < PIC14_PROGRAM_WORDS; a++) {
+        pic14_insn_t *insn = &code[a].insn;
+        if (code[a].valid && (insn->op == PIC14_CALL || insn->op == PIC14_GOTO)) {
+            int page = insn->k & 0x1800;
+            int i;
+            for (i = a - 2; i < a; i++) {
+                const pic14_insn_t *w = &code[i].insn;
+                if (code[i].valid && w->f == PIC14_PCLATH && (w->b == 3 || w->b == 4)) {
+                    int mask = (w->b == 3) ? 0x0800 : 0x1000;
+                    if (w->op == PIC14_BSF) {
+                        page |= mask;
+                    } else if (w->op == PIC14_BCF) {
+                        page &= ~mask;
+                    }
+                }
+            }
+            insn->k = (uint16_t)((insn->k & 0x07FF) | page);
+        }
+    }
+}
+
+// Follow STATUS<RP1:RP0> along straight-line code so SFR operands can be named
+static void track_banks(void)
+{
+    int a, rp0 = -1, rp1 = -1;
+    for (a = 0; a < PIC14_PROGRAM_WORDS; a++) {
+        const pic14_insn_t *insn = &code[a].insn;
+        if (!code[a].valid || code[a].label) {
+            rp0 = rp1 = -1;
+        }
+        if (!code[a].valid) {
+            continue;
+        }
+        code[a].rp = (rp0 >= 0 && rp1 >= 0) ? (int8_t)(rp1 * 2 + rp0) : -1;
+
+        if ((insn->op == PIC14_BCF || insn->op == PIC14_BSF) && insn->f == PIC14_STATUS) {
+            if (insn->b == 5) {
+                rp0 = (insn->op == PIC14_BSF);
+            } else if (insn->b == 6) {
+                rp1 = (insn->op == PIC14_BSF);
+            }
+        } else if (insn->op == PIC14_CALL || insn->op == PIC14_GOTO || insn->op == PIC14_RETURN ||
+                   insn->op == PIC14_RETLW || insn->op == PIC14_RETFIE ||
+                   (pic14_writes_file(insn) && insn->f == PIC14_STATUS)) {
+            rp0 = rp1 = -1;
+        }
+    }
+}
+
+/* ------------------------------------------------------------------------------------------ */
+/* XC8 delay kernels                                                                          */
+/* ------------------------------------------------------------------------------------------ */
+
+/*
+ * _delay() expands to counter loads followed by a chain of "decfsz Rn,f / goto L" pairs
+ * that all branch back to the first decfsz. The loads make the trip count a constant,
+ * so the chain is simulated once instead of being reported as an unbounded loop.
+ */
+static void find_kernels(void)
+{
+    int a;
+    for (a = 0; a < PIC14_PROGRAM_WORDS - 1; a++) {
+        int n = 0, i;
+        uint8_t file[4], count[4];
+
+        while (n < 4 && a + 2 * n + 1 < PIC14_PROGRAM_WORDS &&
+               code[a + 2 * n].valid && code[a + 2 * n + 1].valid &&
+               code[a + 2 * n].insn.op == PIC14_DECFSZ && code[a + 2 * n].insn.d == 1 &&
+               code[a + 2 * n + 1].insn.op == PIC14_GOTO && code[a + 2 * n + 1].insn.k == a) {
+            file[n] = code[a + 2 * n].insn.f;
+            n++;
+        }
+        if (n == 0 || n == 4) {
+            continue;
+        }
+
+        // Each counter must be loaded by "movlw k / movwf Rn" just before the kernel
+        for (i = 0; i < n; i++) {
+            int j, found = 0;
+            for (j = a - 1; j > 0 && j >= a - 2 * n - 2; j--) {
+                if (code[j].insn.op == PIC14_MOVWF && code[j].insn.f == file[i] &&
+                    code[j - 1].insn.op == PIC14_MOVLW) {
+                    count[i] = (uint8_t)code[j - 1].insn.k;
+                    found = 1;
+                    break;
+                }
+            }
+            if (!found) {
+                break;
+            }
+        }
+        if (i < n) {
+            continue;
+        }
+
+        {
+            uint64_t cycles = 0;
+            int pc = 0;
+            while (pc < 2 * n) {
+                int r = pc / 2;
+                count[r]--;
+                if (count[r] == 0) {
+                    cycles += 2;    // decfsz skips the goto
+                    pc += 2;
+                } else {
+                    cycles += 3;    // decfsz + goto
+                    pc = 0;
+                }
+            }
+            kernel_len[a] = (uint8_t)(2 * n);
+            kernel_cycles[a] = cycles;
+        }
+    }
+}
+
+/* ------------------------------------------------------------------------------------------ */
+/* Path analysis                                                                              */
+/* ------------------------------------------------------------------------------------------ */
+
+static void add_loop(int head, int tail)
+{
+    int i;
+    for (i = 0; i < loop_count; i++) {
+        if (loops[i].head == head && loops[i].tail == tail) {
+            return;
+        }
+    }
+    if (loop_count == loop_cap) {
+        loops = grow(loops, &loop_cap, sizeof(loop_t));
+    }
+    loops[loop_count].head = (uint16_t)head;
+    loops[loop_count].tail = (uint16_t)tail;
+    loop_count++;
+}
+
+static cost_t seq(uint64_t cycles, cost_t next)
+{
+    next.best = add_sat(cycles, next.best);
+    next.worst = add_sat(cycles, next.worst);
+    return next;
+}
+
+static cost_t walk(int a, int from)
+{
+    static const cost_t unknown = { 0, 0, PATH_UNKNOWN, 0 };
+    const pic14_insn_t *insn;
+    cost_t c;
+
+    if (a < 0 || a >= PIC14_PROGRAM_WORDS || !code[a].valid) {
+        return unknown;
+    }
+    if (state[a] == 2) {
+        return memo[a];
+    }
+    if (state[a] == 1) {
+        // Back edge: this path never terminates without a trip count
+        cost_t loop = { COST_INF, 0, PATH_LOOP, 0 };
+        add_loop(a, from);
+        return loop;
+    }
+    state[a] = 1;
+    insn = &code[a].insn;
+
+    if (kernel_len[a]) {
+        c = seq(kernel_cycles[a], walk(a + kernel_len[a], a + kernel_len[a] - 1));
+    } else if (insn->op == PIC14_RETURN || insn->op == PIC14_RETLW || insn->op == PIC14_RETFIE) {
+        c.best = c.worst = 2;
+        c.flags = 0;
+        c.depth = 0;
+    } else if (insn->op == PIC14_GOTO) {
+        c = seq(2, walk(insn->k, a));
+    } else if (insn->op == PIC14_CALL) {
+        cost_t callee = walk(insn->k, a);
+        cost_t after = walk(a + 1, a);
+        c.best = add_sat(add_sat(2, callee.best), after.best);
+        c.worst = add_sat(add_sat(2, callee.worst), after.worst);
+        c.flags = callee.flags | after.flags;
+        c.depth = (uint8_t)((callee.depth + 1 > after.depth) ? callee.depth + 1 : after.depth);
+    } else if (pic14_writes_file(insn) && insn->f == PIC14_PCL) {
+        // Computed jump into a retlw table (XC8 string and switch tables)
+        c.best = c.worst = 4;
+        c.flags = PATH_COMPUTED;
+        c.depth = 0;
+    } else if (pic14_is_skip(insn->op)) {
+        cost_t fall = seq(1, walk(a + 1, a));
+        cost_t skip = seq(2, walk(a + 2, a));
+        c.best = fall.best < skip.best ? fall.best : skip.best;
+        c.worst = fall.worst > skip.worst ? fall.worst : skip.worst;
+        c.flags = fall.flags | skip.flags;
+        c.depth = fall.depth > skip.depth ? fall.depth : skip.depth;
+    } else {
+        c = seq(pic14_cycles(insn), walk(a + 1, a));
+    }
+
+    state[a] = 2;
+    memo[a] = c;
+    return c;
+}
+
+// Mark everything executable from address a (calls included)
+static void reach(int a)
+{
+    while (a >= 0 && a < PIC14_PROGRAM_WORDS && code[a].valid && !reached[a]) {
+        const pic14_insn_t *insn = &code[a].insn;
+        reached[a] = 1;
+        if (insn->op == PIC14_RETURN || insn->op == PIC14_RETLW || insn->op == PIC14_RETFIE) {
+            return;
+        }
+        if (insn->op == PIC14_GOTO) {
+            a = insn->k;
+            continue;
+        }
+        if (insn->op == PIC14_CALL) {
+            reach(insn->k);
+        } else if (pic14_is_skip(insn->op)) {
+            reach(a + 2);
+        }
+        a++;
+    }
+}
+
+/* ------------------------------------------------------------------------------------------ */
+/* Report                                                                                     */
+/* ------------------------------------------------------------------------------------------ */
+
+static void format_cycles(char *buf, size_t size, uint64_t cycles, uint8_t flags, int worst)
+{
+    if (cycles == COST_INF) {
+        snprintf(buf, size, "-");
+    } else if (worst && (flags & PATH_LOOP)) {
+        snprintf(buf, size, "unbounded");
+    } else {
+        snprintf(buf, size, "%llu", (unsigned long long)cycles);
+    }
+}
+
+static void format_time(char *buf, size_t size, uint64_t cycles, unsigned long fosc)
+{
+    double us;
+    if (fosc == 0) {
+        buf[0] = '\0';
+        return;
+    }
+    us = (double)cycles * 4.0e6 / (double)fosc;
+    if (us >= 1000.0) {
+        snprintf(buf, size, " (%.3f ms)", us / 1000.0);
+    } else {
+        snprintf(buf, size, " (%.1f us)", us);
+    }
+}
+
+// Describe the first SFR bit test or read inside the loop body [head, tail]
+static void describe_loop(const loop_t *l, char *buf, size_t size)
+{
+    int a, lo = l->head < l->tail ? l->head : l->tail, hi = l->head < l->tail ? l->tail : l->head;
+
+    for (a = lo; a <= hi; a++) {
+        const pic14_insn_t *insn = &code[a].insn;
+        const pic14_sfr_t *sfr;
+        if (!code[a].valid || (insn->op != PIC14_BTFSC && insn->op != PIC14_BTFSS)) {
+            continue;
+        }
+        sfr = (insn->f < 0x20) ? find_sfr(insn->f, code[a].rp) : NULL;
+        if (sfr != NULL && sfr->address != PIC14_STATUS) {
+            if (sfr->bits[insn->b] != NULL) {
+                snprintf(buf, size, "busy-wait on %s.%s", sfr->name, sfr->bits[insn->b]);
+            } else {
+                snprintf(buf, size, "busy-wait on %s bit %u", sfr->name, insn->b);
+            }
+            return;
+        }
+    }
+    for (a = lo; a <= hi; a++) {
+        const pic14_insn_t *insn = &code[a].insn;
+        const pic14_sfr_t *sfr;
+        if (!code[a].valid || insn->op != PIC14_MOVF || insn->f >= 0x20) {
+            continue;
+        }
+        sfr = find_sfr(insn->f, code[a].rp);
+        if (sfr != NULL && sfr->address != PIC14_STATUS && sfr->address != PIC14_FSR &&
+            sfr->address != PIC14_INDF && sfr->address != PIC14_PCLATH) {
+            snprintf(buf, size, "busy-wait polling %s", sfr->name);
+            return;
+        }
+    }
+    snprintf(buf, size, "loop with data-dependent trip count");
+}
+
+static void print_site(int address, const char *what)
+{
+    func_t *f = function_at(address);
+    const char *src = source_of(address);
+    printf("  0x%04X  %-24s %-16s %s\n", address, f ? f->name : "?", src[0] ? src : "-", what);
+}
+
+static int profile(const char *path, unsigned long fosc, long long budget)
+{
+    FILE *in;
+    char line[LINE_SIZE];
+    parser_t p = { -1, -1, NULL, 0 };
+    int i, a, isr_entry = -1, save_end = -1, result = 0;
+    func_t *main_fn;
+    cost_t isr = { 0, 0, 0, 0 };
+    char best[32], worst[32], time[32];
+
+    in = fopen(path, "r");
+    if (in == NULL) {
+        perror(path);
+        return 2;
+    }
+
+    memset(code, 0, sizeof(code));
+    memset(kernel_len, 0, sizeof(kernel_len));
+    memset(state, 0, sizeof(state));
+    memset(reached, 0, sizeof(reached));
+    func_count = source_count = loop_count = code_psect_count = has_vector = 0;
+    for (a = 0; a < PIC14_PROGRAM_WORDS; a++) {
+        code[a].src = -1;
+        owner[a] = -1;
+    }
+
+    while (fgets(line, sizeof(line), in) != NULL) {
+        if (strncmp(line, "Symbol Table", 12) == 0) {
+            break;
+        }
+        parse_line(&p, line);
+    }
+    fclose(in);
+
+    fix_far_targets();
+    track_banks();
+    find_kernels();
+    if (fosc == 0) {
+        fosc = pic14_project_fosc(path);
+    }
+
+    printf("%s\n", path);
+    if (fosc) {
+        printf("Fosc %lu Hz, Tcy %.3f us\n", fosc, 4.0e6 / (double)fosc);
+    } else {
+        printf("Fosc unknown (use -f), cycles only\n");
+    }
+
+    // Per-function cycle counts
+    printf("\n  %-26s %-7s %6s %10s %12s %6s %5s\n", "function", "entry", "words", "BCET", "WCET", "stack", "xc8");
+    for (i = 0; i < func_count; i++) {
+        func_t *f = &funcs[i];
+        cost_t c;
+        char xc8[16];
+        int words = 0;
+        if (f->entry < 0) {
+            continue;
+        }
+        for (a = 0; a < PIC14_PROGRAM_WORDS; a++) {
+            words += (owner[a] == i);
+        }
+        c = walk(f->entry, f->entry);
+        format_cycles(best, sizeof(best), c.best, c.flags, 0);
+        format_cycles(worst, sizeof(worst), c.worst, c.flags, 1);
+        snprintf(xc8, sizeof(xc8), f->stack_required >= 0 ? "%d" : "-", f->stack_required);
+        printf("  %-26s 0x%04X  %6d %10s %12s %6d %5s\n", f->name, f->entry, words, best, worst,
+               c.depth + 1, xc8);
+    }
+    printf("  (stack: levels used when called, own return address included;\n"
+           "   xc8: levels XC8 reserves when called, interrupt included)\n");
+
+    // Interrupt path: vector, context save, ljmp to the handler
+    if (has_vector && code[PIC14_INT_VECTOR].valid) {
+        uint64_t save = 0;
+        for (a = PIC14_INT_VECTOR; a < PIC14_PROGRAM_WORDS && code[a].valid; a++) {
+            save += pic14_cycles(&code[a].insn);
+            if (code[a].insn.op == PIC14_GOTO) {
+                isr_entry = code[a].insn.k;
+                save_end = a;
+                break;
+            }
+        }
+        if (isr_entry < 0) {
+            isr_entry = PIC14_INT_VECTOR;
+            save = 0;
+        }
+        isr = walk(PIC14_INT_VECTOR, PIC14_INT_VECTOR);
+        reach(PIC14_INT_VECTOR);
+
+        printf("\nInterrupt\n");
+        printf("  hardware latency       %d-%d cycles\n", HW_LATENCY_MIN, HW_LATENCY_MAX);
+        printf("  context save           %llu cycles (0x%04X-0x%04X)\n",
+               (unsigned long long)save, PIC14_INT_VECTOR, save_end >= 0 ? save_end : PIC14_INT_VECTOR);
+        for (a = isr_entry; a < PIC14_PROGRAM_WORDS; a++) {
+            if (code[a].valid && reached[a] && code[a].insn.op == PIC14_RETFIE) {
+                // Restore epilogue: the moves/swaps between the last label and retfie
+                int start = a;
+                uint64_t restore = 2;
+                while (start > 0 && code[start - 1].valid && !code[start].label &&
+                       (code[start - 1].insn.op == PIC14_MOVF || code[start - 1].insn.op == PIC14_MOVWF ||
+                        code[start - 1].insn.op == PIC14_SWAPF)) {
+                    start--;
+                    restore += 1;
+                }
+                printf("  context restore        %llu cycles (0x%04X-0x%04X, retfie included)\n",
+                       (unsigned long long)restore, start, a);
+                break;
+            }
+        }
+        format_cycles(best, sizeof(best), isr.best, isr.flags, 0);
+        format_cycles(worst, sizeof(worst), isr.worst, isr.flags, 1);
+        printf("  vector to retfie       BCET %s, WCET %s cycles\n", best, worst);
+        if (!(isr.flags & PATH_LOOP)) {
+            uint64_t total = add_sat(isr.worst, HW_LATENCY_MAX);
+            format_time(time, sizeof(time), total, fosc);
+            printf("  worst-case occupancy   %llu cycles%s\n", (unsigned long long)total, time);
+        } else {
+            printf("  worst-case occupancy   unbounded\n");
+        }
+        if (isr.flags & PATH_COMPUTED) {
+            printf("  (computed jumps are assumed to land on a retlw table)\n");
+        }
+        if (isr.flags & PATH_UNKNOWN) {
+            printf("  (some branch targets are not in the listing and count as 0 cycles)\n");
+        }
+    } else {
+        printf("\nInterrupt\n  no interrupt vector code\n");
+    }
+
+    // Hardware stack: main's deepest call chain plus the interrupt return address and
+    // whatever the handler calls
+    main_fn = function_named("_main");
+    if (main_fn != NULL && main_fn->entry >= 0) {
+        cost_t m = walk(main_fn->entry, main_fn->entry);
+        int total = m.depth + (isr_entry >= 0 ? 1 + isr.depth : 0);
+        printf("\nStack\n  main %u + interrupt %s%u = %d of %d levels%s\n", m.depth,
+               isr_entry >= 0 ? "1+" : "", isr_entry >= 0 ? isr.depth : 0, total,
+               PIC14_STACK_LEVELS, total > PIC14_STACK_LEVELS ? "  ** OVERFLOW **" : "");
+        if (main_fn->stack_required >= 0) {
+            printf("  XC8 reports %d level(s) required by main\n", main_fn->stack_required);
+        }
+    }
+
+    // Blocking constructs the interrupt can reach
+    if (isr_entry >= 0) {
+        int count = 0;
+        printf("\nBlocking constructs in interrupt context\n");
+        for (a = 0; a < PIC14_PROGRAM_WORDS; a++) {
+            if (reached[a] && kernel_len[a]) {
+                char what[160];
+                format_time(time, sizeof(time), kernel_cycles[a], fosc);
+                snprintf(what, sizeof(what), "delay loop, %llu cycles%s",
+                         (unsigned long long)kernel_cycles[a], time);
+                print_site(a, what);
+                count++;
+            }
+        }
+        for (i = 0; i < loop_count; i++) {
+            if (reached[loops[i].head]) {
+                char what[160];
+                describe_loop(&loops[i], what, sizeof(what));
+                print_site(loops[i].head, what);
+                count++;
+            }
+        }
+        for (i = 0; i < func_count; i++) {
+            func_t *f = &funcs[i];
+            if (f->entry >= 0 && reached[f->entry] && f->entry != isr_entry) {
+                char what[160];
+                snprintf(what, sizeof(what), "called from the interrupt%s%s",
+                         f->defined[0] ? ", defined at " : "", f->defined);
+                print_site(f->entry, what);
+            }
+        }
+        if (count == 0) {
+            printf("  none\n");
+        }
+    }
+
+    if (budget >= 0 && isr_entry >= 0) {
+        if ((isr.flags & PATH_LOOP) || add_sat(isr.worst, HW_LATENCY_MAX) > (uint64_t)budget) {
+            printf("\nInterrupt exceeds the budget of %lld cycles\n", budget);
+            result = 1;
+        }
+    }
+    printf("\n");
+    return result;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned long fosc = 0;
+    long long budget = -1;
+    int i, status = 0, files = 0;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+            fosc = strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            budget = strtoll(argv[++i], NULL, 0);
+        } else if (argv[i][0] == '-') {
+            fprintf(stderr, "usage: lstprof [-f fosc_hz] [-b max_isr_cycles] listing.lst...\n");
+            return 2;
+        } else {
+            int r = profile(argv[i], fosc, budget);
+            if (r > status) {
+                status = r;
+            }
+            files++;
+        }
+    }
+    if (files == 0) {
+        fprintf(stderr, "usage: lstprof [-f fosc_hz] [-b max_isr_cycles] listing.lst...\n");
+        return 2;
+    }
+    return status;
+}
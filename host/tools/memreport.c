@@ -0,0 +1,864 @@
+/* File:   memreport.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Program memory, data memory and stack usage of the projects, read from the files MPLAB X
+ * writes next to the HEX image (<project>.X/dist/default/production/):
+ *   - <project>.X.production.mum (or memoryfile.xml): used and free space per memory,
+ *   - <project>.X.production.map: the psects with their class and size, the words of each
+ *     function (module information) and the global and static variables, sized from the
+ *     symbol table,
+ *   - <project>.X.production.lst: the XC8 call graph, with the compiled-stack bytes (autos and
+ *     parameters) of each function, giving the call depth of main and of the interrupt and
+ *     the heaviest compiled-stack path of each.
+ * The .sym file holds the same symbols as the symbol table of the map and is not read.
+ *
+ * A baseline stores one line per project and symbol; compared with it, every change in a
+ * function, variable, psect, total or stack figure is printed with its cost.
+ *
+ * Usage: memreport [-s] [-b baseline] [-w baseline] project.map...
+ * -s prints only the totals, the stack and the comparison. -b compares with a baseline and
+ * makes the exit status 1 when the program or data space of a project grew; -w writes the
+ * figures of this run as the new baseline. The exit status is 2 on a usage or read error.
+ */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NAME_SIZE   64
+#define LINE_SIZE   1024
+#define SPACES      5       // Program, data, EEPROM, configuration, ID locations
+#define HW_STACK    8
+
+typedef struct {
+    char name[NAME_SIZE];   // "Program space"
+    long used, total;
+    char units[8];
+} space_t;
+
+typedef struct {
+    char name[NAME_SIZE];
+    char cls[16];
+    long address, length;
+    int space;              // 0 program, 1 data
+} psect_t;
+
+typedef struct {
+    char name[NAME_SIZE];
+    char module[NAME_SIZE];
+    long words;
+    long ram;               // Compiled stack bytes (autos + parameters), -1 if not in the call graph
+} func_t;
+
+typedef struct {
+    char name[NAME_SIZE];
+    char psect[NAME_SIZE];
+    long address, size;
+} var_t;
+
+// Call graph of the listing
+typedef struct {
+    char name[NAME_SIZE];
+    long used;
+    int root;               // Heads a table: main or the interrupt function
+    int first_call, call_count;
+    int state;              // 0 new, 1 on the walk, 2 done
+    int levels;             // Deepest call chain below, in return-address levels
+    long bytes;             // Heaviest compiled-stack path from here
+    int deep_next, heavy_next;
+} node_t;
+
+typedef struct {
+    char project[NAME_SIZE * 2];
+    char kind[16];
+    char name[NAME_SIZE];
+    long value;
+    int seen;
+} entry_t;
+
+static space_t spaces[SPACES];
+static int space_count;
+static char version[32];
+static psect_t *psects;
+static int psect_count, psect_cap;
+static func_t *funcs;
+static int func_count, func_cap;
+static var_t *vars;
+static int var_count, var_cap;
+static node_t *nodes;
+static int node_count, node_cap;
+static char (*calls)[NAME_SIZE];
+static int *call_targets;
+static int call_count, call_cap, call_target_cap;
+
+static entry_t *current;
+static int current_count, current_cap;
+static entry_t *baseline;
+static int baseline_count, baseline_cap;
+
+static void *grow(void *array, int *cap, size_t item)
+{
+    void *p;
+    *cap = *cap ? *cap * 2 : 64;
+    p = realloc(array, (size_t)*cap * item);
+    if (p == NULL) {
+        fprintf(stderr, "memreport: out of memory\n");
+        exit(2);
+    }
+    return p;
+}
+
+static void copy(char *dst, const char *src, size_t size)
+{
+    snprintf(dst, size, "%s", src);
+}
+
+// C name of an assembler symbol: XC8 prefixes one underscore
+static const char *c_name(const char *symbol)
+{
+    return symbol[0] == '_' ? symbol + 1 : symbol;
+}
+
+static int is_hex(const char *s)
+{
+    if (*s == '\0') {
+        return 0;
+    }
+    for (; *s; s++) {
+        if (!isxdigit((unsigned char)*s)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int split(char *line, char **tokens, int max)
+{
+    int n = 0;
+    char *t = strtok(line, " \t\r\n");
+    while (t != NULL && n < max) {
+        tokens[n++] = t;
+        t = strtok(NULL, " \t\r\n");
+    }
+    return n;
+}
+
+// Sibling of the map: same directory, "<base><suffix>" or a fixed file name
+static void sibling(char *out, size_t size, const char *map, const char *suffix, int replace_name)
+{
+    const char *slash = strrchr(map, '/');
+    size_t dir = slash ? (size_t)(slash - map + 1) : 0;
+    size_t base = strlen(map);
+
+    if (base > 4 && strcmp(map + base - 4, ".map") == 0) {
+        base -= 4;
+    }
+    if (replace_name) {
+        snprintf(out, size, "%.*s%s", (int)dir, map, suffix);
+    } else {
+        snprintf(out, size, "%.*s%s", (int)base, map, suffix);
+    }
+}
+
+// "06-PIC16F_IT/TUTO_7.X" from ../06-PIC16F_IT/TUTO_7.X/dist/default/production/x.map
+static void project_key(char *out, size_t size, const char *map)
+{
+    const char *end = strstr(map, "/dist/");
+    const char *start = map;
+
+    if (end == NULL) {
+        end = map + strlen(map);
+    }
+    while (strncmp(start, "../", 3) == 0 || strncmp(start, "./", 2) == 0) {
+        start = strchr(start, '/') + 1;
+    }
+    snprintf(out, size, "%.*s", (int)(end - start), start);
+}
+
+/* ------------------------------------------------------------------------------------------ */
+/* Parsers                                                                                    */
+/* ------------------------------------------------------------------------------------------ */
+
+// "    Program space        used  1A84h (  6788) of  2000h words   ( 82.9%)"
+static int read_mum(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    char line[LINE_SIZE];
+
+    if (f == NULL) {
+        return -1;
+    }
+    while (fgets(line, sizeof(line), f) != NULL && space_count < SPACES) {
+        char *used = strstr(line, " used ");
+        char *open = strchr(line, '(');
+        char *of = strstr(line, ") of ");
+        space_t *s = &spaces[space_count];
+        char *p, *end;
+
+        if (used == NULL || open == NULL || of == NULL) {
+            continue;
+        }
+        for (p = line; *p == ' '; p++) {
+        }
+        snprintf(s->name, sizeof(s->name), "%.*s", (int)(used - p), p);
+        for (end = s->name + strlen(s->name); end > s->name && end[-1] == ' '; end--) {
+            end[-1] = '\0';
+        }
+        s->used = strtol(open + 1, NULL, 10);
+        s->total = strtol(of + 5, &end, 16);
+        if (*end == 'h') {
+            end++;
+        }
+        sscanf(end, "%7s", s->units);
+        space_count++;
+    }
+    fclose(f);
+    return 0;
+}
+
+static long xml_value(const char *block, const char *tag)
+{
+    char open[32];
+    const char *p;
+
+    snprintf(open, sizeof(open), "<%s>", tag);
+    p = strstr(block, open);
+    return p ? strtol(p + strlen(open), NULL, 10) : 0;
+}
+
+// memoryfile.xml: <memory name="program"><units>words</units><length>8192</length><used>...
+static int read_memoryfile(const char *path)
+{
+    static const char *const names[] = { "program", "data" };
+    static const char *const labels[] = { "Program space", "Data space" };
+    static char text[8192];
+    FILE *f = fopen(path, "r");
+    size_t n;
+    int i;
+
+    if (f == NULL) {
+        return -1;
+    }
+    n = fread(text, 1, sizeof(text) - 1, f);
+    text[n] = '\0';
+    fclose(f);
+    for (i = 0; i < 2; i++) {
+        char key[48];
+        const char *block, *units;
+        space_t *s = &spaces[space_count];
+
+        snprintf(key, sizeof(key), "<memory name=\"%s\">", names[i]);
+        block = strstr(text, key);
+        if (block == NULL) {
+            continue;
+        }
+        copy(s->name, labels[i], sizeof(s->name));
+        s->used = xml_value(block, "used");
+        s->total = xml_value(block, "length");
+        units = strstr(block, "<units>");
+        if (units != NULL) {
+            sscanf(units + 7, "%7[a-z]", s->units);
+        }
+        space_count++;
+    }
+    return 0;
+}
+
+static int find_psect(const char *name)
+{
+    int i;
+    for (i = 0; i < psect_count; i++) {
+        if (strcmp(psects[i].name, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int find_func(const char *name)
+{
+    int i;
+    for (i = 0; i < func_count; i++) {
+        if (strcmp(funcs[i].name, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int is_data_class(const char *cls)
+{
+    return strcmp(cls, "COMMON") == 0 || strncmp(cls, "BANK", 4) == 0 || strcmp(cls, "RAM") == 0;
+}
+
+static int read_map(const char *path)
+{
+    enum { NONE, TOTAL, SYMBOLS, MODULES } section = NONE;
+    FILE *f = fopen(path, "r");
+    char line[LINE_SIZE], raw[LINE_SIZE];
+    char cls[16] = "", module[NAME_SIZE] = "";
+    char *tok[8];
+    int n;
+
+    if (f == NULL) {
+        return -1;
+    }
+    while (fgets(line, sizeof(line), f) != NULL) {
+        if (strncmp(line, "Microchip MPLAB XC8 Compiler ", 29) == 0) {
+            sscanf(line + 29, "%31s", version);
+            continue;
+        }
+        if (strncmp(line, "TOTAL", 5) == 0) {
+            section = TOTAL;
+            continue;
+        }
+        if (strncmp(line, "SEGMENTS", 8) == 0) {
+            section = NONE;
+            continue;
+        }
+        if (strstr(line, "Symbol Table") != NULL) {
+            section = SYMBOLS;
+            continue;
+        }
+        if (strncmp(line, "MODULE INFORMATION", 18) == 0) {
+            section = MODULES;
+            continue;
+        }
+        copy(raw, line, sizeof(raw));
+        n = split(line, tok, 8);
+        if (n == 0 || section == NONE) {
+            continue;
+        }
+        if (section == TOTAL) {
+            if (n == 2 && strcmp(tok[0], "CLASS") == 0) {
+                copy(cls, tok[1], sizeof(cls));
+            } else if (n == 5 && is_hex(tok[1]) && is_hex(tok[3]) && find_psect(tok[0]) < 0) {
+                psect_t *p;
+                if (psect_count == psect_cap) {
+                    psects = grow(psects, &psect_cap, sizeof(*psects));
+                }
+                p = &psects[psect_count++];
+                copy(p->name, tok[0], sizeof(p->name));
+                copy(p->cls, cls, sizeof(p->cls));
+                p->address = strtol(tok[1], NULL, 16);
+                p->length = strtol(tok[3], NULL, 16);
+                p->space = atoi(tok[4]) == 1;
+            }
+        } else if (section == SYMBOLS) {
+            int ps;
+            var_t *v;
+            size_t len;
+            if (n != 3 || !is_hex(tok[2]) || (ps = find_psect(tok[1])) < 0 ||
+                !is_data_class(psects[ps].cls) || strncmp(tok[1], "cstack", 6) == 0) {
+                continue;
+            }
+            // __pbssBANK2, __HbssBANK2, __LbssBANK2 mark the psect itself
+            len = strlen(tok[0]);
+            if (len >= strlen(tok[1]) && strcmp(tok[0] + len - strlen(tok[1]), tok[1]) == 0) {
+                continue;
+            }
+            if (var_count == var_cap) {
+                vars = grow(vars, &var_cap, sizeof(*vars));
+            }
+            v = &vars[var_count++];
+            copy(v->name, c_name(tok[0]), sizeof(v->name));
+            copy(v->psect, tok[1], sizeof(v->psect));
+            v->address = strtol(tok[2], NULL, 16);
+            v->size = 0;
+        } else if (raw[0] == '\t') {
+            // "\t\t_main \t\tCODE \t072F\t0000\t50"
+            func_t *fn;
+            if (n != 5 || find_func(c_name(tok[0])) >= 0) {
+                continue;
+            }
+            if (func_count == func_cap) {
+                funcs = grow(funcs, &func_cap, sizeof(*funcs));
+            }
+            fn = &funcs[func_count++];
+            copy(fn->name, c_name(tok[0]), sizeof(fn->name));
+            copy(fn->module, module, sizeof(fn->module));
+            fn->words = strtol(tok[4], NULL, 10);
+            fn->ram = -1;
+        } else if (strstr(raw, " estimated size:") == NULL && strncmp(raw, "Module", 6) != 0) {
+            // Module path, possibly with spaces: keep the file name
+            char *end = raw + strlen(raw);
+            char *base = raw;
+            char *p;
+            while (end > raw && isspace((unsigned char)end[-1])) {
+                *--end = '\0';
+            }
+            for (p = raw; *p; p++) {
+                if (*p == '/' || *p == '\\') {
+                    base = p + 1;
+                }
+            }
+            copy(module, base, sizeof(module));
+        }
+    }
+    fclose(f);
+    return psect_count ? 0 : -1;
+}
+
+static int compare_var_address(const void *a, const void *b)
+{
+    const var_t *x = a, *y = b;
+    int c = strcmp(x->psect, y->psect);
+    if (c != 0) {
+        return c;
+    }
+    return (x->address > y->address) - (x->address < y->address);
+}
+
+// A variable runs to the next symbol of its psect, the last one to the end of the psect
+static void size_vars(void)
+{
+    int i;
+
+    qsort(vars, (size_t)var_count, sizeof(*vars), compare_var_address);
+    for (i = 0; i < var_count; i++) {
+        const psect_t *p = &psects[find_psect(vars[i].psect)];
+        long end = p->address + p->length;
+        if (i + 1 < var_count && strcmp(vars[i + 1].psect, vars[i].psect) == 0) {
+            end = vars[i + 1].address;
+        }
+        vars[i].size = end - vars[i].address;
+    }
+}
+
+static int find_node(const char *name)
+{
+    int i;
+    for (i = 0; i < node_count; i++) {
+        if (strcmp(nodes[i].name, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// "Call Graph Tables:" of the listing, up to "Call Graph Graphs:"
+static int read_call_graph(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    char line[LINE_SIZE];
+    char *tok[8];
+    int in_tables = 0, next_root = 1, n, i;
+
+    if (f == NULL) {
+        return -1;
+    }
+    while (fgets(line, sizeof(line), f) != NULL) {
+        if (!in_tables) {
+            in_tables = strncmp(line, "Call Graph Tables:", 18) == 0;
+            continue;
+        }
+        if (strstr(line, "Call Graph Graphs:") != NULL) {
+            break;
+        }
+        if (strstr(line, "Estimated maximum stack depth") != NULL) {
+            next_root = 1;
+            continue;
+        }
+        n = split(line, tok, 8);
+        if (n == 0 || tok[0][0] == '-' || strcmp(tok[0], "(Depth)") == 0) {
+            continue;
+        }
+        if (tok[0][0] == '(' && n == 6) {
+            // " (0) _main   41 41 0 27136": Used, Autos, Params, Refs
+            node_t *nd;
+            if (node_count == node_cap) {
+                nodes = grow(nodes, &node_cap, sizeof(*nodes));
+            }
+            nd = &nodes[node_count++];
+            memset(nd, 0, sizeof(*nd));
+            copy(nd->name, tok[1], sizeof(nd->name));
+            nd->used = strtol(tok[2], NULL, 10);
+            nd->root = next_root;
+            nd->first_call = call_count;
+            nd->deep_next = nd->heavy_next = -1;
+            next_root = 0;
+        } else if (isdigit((unsigned char)tok[0][0])) {
+            continue;                       // Per-bank line: base, space, used, autos, params
+        } else if (node_count > 0 && !(n > 1 && strcmp(tok[1], "(ARG)") == 0)) {
+            // Callee; "(ARG)" only marks a call made to compute an argument of this function,
+            // by its caller, so the two frames overlap in the compiled stack, not a nested call
+            if (call_count == call_cap) {
+                calls = grow(calls, &call_cap, sizeof(*calls));
+            }
+            copy(calls[call_count++], tok[0], NAME_SIZE);
+            nodes[node_count - 1].call_count++;
+        }
+    }
+    fclose(f);
+    if (call_target_cap < call_cap) {
+        call_target_cap = call_cap;
+        call_targets = realloc(call_targets, (size_t)call_target_cap * sizeof(*call_targets));
+        if (call_targets == NULL) {
+            fprintf(stderr, "memreport: out of memory\n");
+            exit(2);
+        }
+    }
+    for (i = 0; i < call_count; i++) {
+        call_targets[i] = find_node(calls[i]);
+    }
+    return in_tables ? 0 : -1;
+}
+
+static void walk(int k)
+{
+    node_t *nd = &nodes[k];
+    int i;
+
+    if (nd->state != 0) {
+        return;                             // Done, or a cycle (XC8 rejects recursion)
+    }
+    nd->state = 1;
+    nd->bytes = nd->used;
+    for (i = 0; i < nd->call_count; i++) {
+        int c = call_targets[nd->first_call + i];
+        if (c < 0 || nodes[c].state == 1) {
+            continue;
+        }
+        walk(c);
+        if (nd->deep_next < 0 || nodes[c].levels + 1 > nd->levels) {
+            nd->levels = nodes[c].levels + 1;
+            nd->deep_next = c;
+        }
+        if (nd->used + nodes[c].bytes > nd->bytes) {
+            nd->bytes = nd->used + nodes[c].bytes;
+            nd->heavy_next = c;
+        }
+    }
+    nd->state = 2;
+}
+
+/* ------------------------------------------------------------------------------------------ */
+/* Baseline                                                                                   */
+/* ------------------------------------------------------------------------------------------ */
+
+static void record(const char *project, const char *kind, const char *name, long value)
+{
+    entry_t *e;
+
+    if (current_count == current_cap) {
+        current = grow(current, &current_cap, sizeof(*current));
+    }
+    e = &current[current_count++];
+    copy(e->project, project, sizeof(e->project));
+    copy(e->kind, kind, sizeof(e->kind));
+    copy(e->name, name, sizeof(e->name));
+    e->value = value;
+    e->seen = 0;
+}
+
+static int load_baseline(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    char line[LINE_SIZE];
+
+    if (f == NULL) {
+        return -1;
+    }
+    while (fgets(line, sizeof(line), f) != NULL) {
+        entry_t e;
+        memset(&e, 0, sizeof(e));
+        if (line[0] == '#' || sscanf(line, "%127s %15s %63s %ld", e.project, e.kind, e.name, &e.value) != 4) {
+            continue;
+        }
+        if (baseline_count == baseline_cap) {
+            baseline = grow(baseline, &baseline_cap, sizeof(*baseline));
+        }
+        baseline[baseline_count++] = e;
+    }
+    fclose(f);
+    return 0;
+}
+
+static int save_baseline(const char *path)
+{
+    FILE *f = fopen(path, "w");
+    int i;
+
+    if (f == NULL) {
+        return -1;
+    }
+    fprintf(f, "# memreport baseline: project kind name value (words, bytes or levels)\n");
+    for (i = 0; i < current_count; i++) {
+        fprintf(f, "%s %s %s %ld\n", current[i].project, current[i].kind, current[i].name, current[i].value);
+    }
+    fclose(f);
+    return 0;
+}
+
+static const char *units_of(const char *kind)
+{
+    if (strcmp(kind, "program") == 0 || strcmp(kind, "function") == 0 || strcmp(kind, "psect-code") == 0) {
+        return "words";
+    }
+    return strcmp(kind, "stack-levels") == 0 ? "levels" : "bytes";
+}
+
+static entry_t *find_entry(entry_t *list, int count, const entry_t *key)
+{
+    int i;
+    for (i = 0; i < count; i++) {
+        if (strcmp(list[i].project, key->project) == 0 && strcmp(list[i].kind, key->kind) == 0 &&
+            strcmp(list[i].name, key->name) == 0) {
+            return &list[i];
+        }
+    }
+    return NULL;
+}
+
+// Prints the changes of one project; returns 1 when its program or data space grew
+static int compare(const char *project, int first)
+{
+    long totals[2] = { 0, 0 };             // Program, data
+    int i, changes = 0, known = 0;
+
+    for (i = 0; i < baseline_count; i++) {
+        known |= strcmp(baseline[i].project, project) == 0;
+    }
+    if (!known) {
+        printf("  Baseline: project not in the baseline\n");
+        return 0;
+    }
+    for (i = first; i < current_count; i++) {
+        entry_t *e = &current[i];
+        entry_t *b = find_entry(baseline, baseline_count, e);
+        if (b != NULL) {
+            b->seen = 1;
+        }
+        if (b != NULL && b->value == e->value) {
+            continue;
+        }
+        if (strcmp(e->name, "total") == 0 && b != NULL) {
+            totals[strcmp(e->kind, "data") == 0] = e->value - b->value;
+        }
+        if (changes++ == 0) {
+            printf("  Baseline changes\n");
+        }
+        if (b == NULL) {
+            printf("    %-12s %-28s new, %ld %s\n", e->kind, e->name, e->value, units_of(e->kind));
+        } else {
+            printf("    %-12s %-28s %+ld %s (%ld -> %ld)\n", e->kind, e->name, e->value - b->value,
+                   units_of(e->kind), b->value, e->value);
+        }
+    }
+    for (i = 0; i < baseline_count; i++) {
+        entry_t *b = &baseline[i];
+        if (b->seen || strcmp(b->project, project) != 0) {
+            continue;
+        }
+        if (changes++ == 0) {
+            printf("  Baseline changes\n");
+        }
+        printf("    %-12s %-28s removed, was %ld %s\n", b->kind, b->name, b->value, units_of(b->kind));
+    }
+    if (changes == 0) {
+        printf("  Baseline: no change\n");
+    }
+    return totals[0] > 0 || totals[1] > 0;
+}
+
+/* ------------------------------------------------------------------------------------------ */
+/* Report                                                                                     */
+/* ------------------------------------------------------------------------------------------ */
+
+static int compare_func(const void *a, const void *b)
+{
+    const func_t *x = a, *y = b;
+    return (y->words > x->words) - (y->words < x->words);
+}
+
+static int compare_var_size(const void *a, const void *b)
+{
+    const var_t *x = a, *y = b;
+    return (y->size > x->size) - (y->size < x->size);
+}
+
+static int compare_psect(const void *a, const void *b)
+{
+    const psect_t *x = a, *y = b;
+    if (x->space != y->space) {
+        return x->space - y->space;
+    }
+    return (y->length > x->length) - (y->length < x->length);
+}
+
+static void print_path(int k, int by_bytes)
+{
+    printf("%s", c_name(nodes[k].name));
+    for (k = by_bytes ? nodes[k].heavy_next : nodes[k].deep_next; k >= 0;
+         k = by_bytes ? nodes[k].heavy_next : nodes[k].deep_next) {
+        printf(" > %s", c_name(nodes[k].name));
+    }
+}
+
+static void reset(void)
+{
+    space_count = psect_count = func_count = var_count = node_count = call_count = 0;
+    version[0] = '\0';
+    memset(spaces, 0, sizeof(spaces));
+}
+
+static int report(const char *map, int summary, int compare_baseline)
+{
+    char path[LINE_SIZE], project[NAME_SIZE * 2];
+    int main_levels = 0, isr_levels = -1, first = current_count, i;
+    int grew = 0;
+
+    reset();
+    project_key(project, sizeof(project), map);
+    if (read_map(map) != 0) {
+        fprintf(stderr, "memreport: %s: not an XC8 map file\n", map);
+        return 2;
+    }
+    sibling(path, sizeof(path), map, ".mum", 0);
+    if (read_mum(path) != 0) {
+        sibling(path, sizeof(path), map, "memoryfile.xml", 1);
+        read_memoryfile(path);
+    }
+    sibling(path, sizeof(path), map, ".lst", 0);
+    read_call_graph(path);
+    size_vars();
+    for (i = 0; i < node_count; i++) {
+        int fn = find_func(c_name(nodes[i].name));
+        walk(i);
+        if (fn >= 0) {
+            funcs[fn].ram = nodes[i].used;
+        }
+    }
+
+    printf("%s (XC8 %s)\n", project, version[0] ? version : "?");
+    for (i = 0; i < space_count; i++) {
+        const space_t *s = &spaces[i];
+        printf("  %-20s %5ld of %5ld %-6s (%5.1f%%)\n", s->name, s->used, s->total, s->units,
+               s->total ? 100.0 * (double)s->used / (double)s->total : 0.0);
+        if (strncmp(s->name, "Program", 7) == 0) {
+            record(project, "program", "total", s->used);
+        } else if (strncmp(s->name, "Data", 4) == 0) {
+            record(project, "data", "total", s->used);
+        }
+    }
+
+    qsort(funcs, (size_t)func_count, sizeof(*funcs), compare_func);
+    qsort(vars, (size_t)var_count, sizeof(*vars), compare_var_size);
+    qsort(psects, (size_t)psect_count, sizeof(*psects), compare_psect);
+    if (!summary) {
+        printf("\n  %-28s %-20s %6s %6s\n", "function", "module", "words", "stack");
+        for (i = 0; i < func_count; i++) {
+            printf("  %-28s %-20s %6ld ", funcs[i].name, funcs[i].module, funcs[i].words);
+            if (funcs[i].ram >= 0) {
+                printf("%6ld\n", funcs[i].ram);
+            } else {
+                printf("%6s\n", "-");
+            }
+        }
+        printf("  (stack: compiled-stack bytes of the function's autos and parameters)\n");
+        if (var_count) {
+            printf("\n  %-28s %-20s %6s %6s\n", "variable", "psect", "addr", "bytes");
+            for (i = 0; i < var_count; i++) {
+                printf("  %-28s %-20s 0x%04lX %6ld%s\n", vars[i].name, vars[i].psect, vars[i].address,
+                       vars[i].size, strncmp(vars[i].psect, "data", 4) == 0 ? "  (+ initial value in program memory)" : "");
+            }
+        }
+        printf("\n  %-28s %-20s %6s %6s\n", "psect", "class", "addr", "size");
+        for (i = 0; i < psect_count; i++) {
+            if (psects[i].length == 0) {
+                continue;
+            }
+            printf("  %-28s %-20s 0x%04lX %6ld %s\n", psects[i].name, psects[i].cls, psects[i].address,
+                   psects[i].length, psects[i].space ? "bytes" : "words");
+        }
+        printf("\n");
+    }
+    for (i = 0; i < func_count; i++) {
+        record(project, "function", funcs[i].name, funcs[i].words);
+    }
+    for (i = 0; i < var_count; i++) {
+        record(project, "variable", vars[i].name, vars[i].size);
+    }
+    for (i = 0; i < psect_count; i++) {
+        // textN numbering changes from build to build; functions cover them
+        if (psects[i].length && strncmp(psects[i].name, "text", 4) != 0 && strcmp(psects[i].name, "maintext") != 0) {
+            record(project, psects[i].space ? "psect-data" : "psect-code", psects[i].name, psects[i].length);
+        }
+    }
+
+    for (i = 0; i < node_count; i++) {
+        const node_t *nd = &nodes[i];
+        int levels;
+        if (!nd->root) {
+            continue;
+        }
+        levels = nd->levels + (strcmp(nd->name, "_main") == 0 ? 0 : 1);   // Interrupt return address
+        printf("  Call depth of %s: %d level%s, ", c_name(nd->name), levels, levels == 1 ? "" : "s");
+        print_path(i, 0);
+        printf("\n  Compiled stack of %s: %ld bytes on ", c_name(nd->name), nd->bytes);
+        print_path(i, 1);
+        printf("\n");
+        if (strcmp(nd->name, "_main") == 0) {
+            main_levels = levels;
+            record(project, "stack-levels", "main", levels);
+            record(project, "stack-bytes", "main", nd->bytes);
+        } else {
+            isr_levels = levels;
+            record(project, "stack-levels", c_name(nd->name), levels);
+            record(project, "stack-bytes", c_name(nd->name), nd->bytes);
+        }
+    }
+    if (node_count == 0) {
+        printf("  no call graph in %s\n", path);
+    } else {
+        int total = main_levels + (isr_levels > 0 ? isr_levels : 0);
+        printf("  Hardware stack: main %d + interrupt %d = %d of %d levels%s\n", main_levels,
+               isr_levels > 0 ? isr_levels : 0, total, HW_STACK, total > HW_STACK ? "  OVERFLOW" : "");
+    }
+    if (compare_baseline) {
+        grew = compare(project, first);
+    }
+    printf("\n");
+    return grew;
+}
+
+int main(int argc, char **argv)
+{
+    const char *load = NULL, *save = NULL;
+    int i, summary = 0, status = 0, files = 0;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-s") == 0) {
+            summary = 1;
+        } else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            load = argv[++i];
+        } else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+            save = argv[++i];
+        } else if (argv[i][0] == '-') {
+            fprintf(stderr, "usage: memreport [-s] [-b baseline] [-w baseline] project.map...\n");
+            return 2;
+        } else {
+            int r;
+            if (load != NULL && baseline_count == 0 && load_baseline(load) != 0) {
+                fprintf(stderr, "memreport: cannot read %s\n", load);
+                return 2;
+            }
+            r = report(argv[i], summary, load != NULL);
+            if (r > status) {
+                status = r;
+            }
+            files++;
+        }
+    }
+    if (files == 0) {
+        fprintf(stderr, "usage: memreport [-s] [-b baseline] [-w baseline] project.map...\n");
+        return 2;
+    }
+    if (save != NULL && save_baseline(save) != 0) {
+        fprintf(stderr, "memreport: cannot write %s\n", save);
+        return 2;
+    }
+    return status;
+}
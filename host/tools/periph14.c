@@ -0,0 +1,1791 @@
+/* File:   periph14.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * PIC16F877A peripheral models for the sim14 core (see periph14.h).
+ *
+ * Every peripheral keeps the cycle of its next visible change in due[]; the smallest one
+ * is the core's next_event. Timers are stored as (value, base cycle) and computed on
+ * demand, so a running timer costs one event per overflow, match or postscaler period,
+ * never one per count. During SLEEP the Fosc-clocked events are frozen and shifted by the
+ * sleep time on wake-up; EEPROM writes, RC-clocked conversions, external clocks and
+ * stimuli keep running and can wake the core.
+ */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "periph14.h"
+
+#define DEFAULT_FOSC 4000000UL
+#define LINE_SIZE    512
+
+// Register file (canonical addresses)
+#define TMR0     0x001
+#define PORTA    0x005
+#define INTCON   0x00B
+#define PIR1     0x00C
+#define PIR2     0x00D
+#define TMR1L    0x00E
+#define TMR1H    0x00F
+#define T1CON    0x010
+#define TMR2     0x011
+#define T2CON    0x012
+#define SSPBUF   0x013
+#define SSPCON   0x014
+#define CCPR1L   0x015
+#define CCPR1H   0x016
+#define CCP1CON  0x017
+#define RCSTA    0x018
+#define TXREG    0x019
+#define RCREG    0x01A
+#define CCPR2L   0x01B
+#define CCPR2H   0x01C
+#define CCP2CON  0x01D
+#define ADRESH   0x01E
+#define ADCON0   0x01F
+#define OPTION   0x081
+#define TRISA    0x085
+#define SSPCON2  0x091
+#define PR2      0x092
+#define SSPADD   0x093
+#define SSPSTAT  0x094
+#define TXSTA    0x098
+#define SPBRG    0x099
+#define ADRESL   0x09E
+#define ADCON1   0x09F
+#define EEDATA   0x10C
+#define EEADR    0x10D
+#define EEDATH   0x10E
+#define EEADRH   0x10F
+#define EECON1   0x18C
+#define EECON2   0x18D
+
+// Bits
+#define T0IF     0x04
+#define INTF     0x02
+#define RBIF     0x01
+#define TMR1IF   0x01
+#define TMR2IF   0x02
+#define CCP1IF   0x04
+#define SSPIF    0x08
+#define TXIF     0x10
+#define RCIF     0x20
+#define ADIF     0x40
+#define CCP2IF   0x01
+#define EEIF     0x10
+#define SSPEN    0x20
+#define CKP      0x10
+#define SSPOV    0x40
+#define WCOL     0x80
+#define BF       0x01
+#define R_W      0x04
+#define S_BIT    0x08
+#define P_BIT    0x10
+#define D_A      0x20
+#define SEN      0x01
+#define RSEN     0x02
+#define PEN      0x04
+#define RCEN     0x08
+#define ACKEN    0x10
+#define ACKDT    0x20
+#define ACKSTAT  0x40
+#define SPEN     0x80
+#define CREN     0x10
+#define OERR     0x02
+#define TXEN     0x20
+#define SYNC     0x10
+#define BRGH     0x04
+#define TRMT     0x02
+#define TX9      0x40
+#define ADON     0x01
+#define GO       0x04
+#define RD       0x01
+#define WR       0x02
+#define WREN     0x04
+#define EEPGD    0x80
+
+// Stimulus kinds
+enum { STIM_PIN, STIM_CLOCK, STIM_ANALOG, STIM_UART, STIM_SPI, STIM_I2C };
+
+// I2C master operations
+enum { OP_NONE, OP_START, OP_RSTART, OP_STOP, OP_WRITE, OP_READ, OP_ACK };
+
+#define R(a) (p->sim->ram[a])
+
+static const uint8_t port_masks[PERIPH14_PORTS] = { 0x3F, 0xFF, 0xFF, 0xFF, 0x07 };
+static const uint8_t tmr2_prescales[4] = { 1, 4, 16, 16 };
+static const uint8_t adc_clocks[8] = { 2, 8, 32, 0, 4, 16, 64, 0 };    // Tosc per TAD, 0 = RC
+
+/* ------------------------------------------------------------------------------------------ */
+/* Scheduling                                                                                 */
+/* ------------------------------------------------------------------------------------------ */
+
+static void update_next(periph14_t *p)
+{
+    uint64_t next = SIM14_NEVER;
+    int i;
+
+    for (i = 0; i < PERIPH14_EVENTS; i++) {
+        if (p->due[i] < next && !(p->asleep && (p->frozen & (1u << i)))) {
+            next = p->due[i];
+        }
+    }
+    p->sim->next_event = next;
+}
+
+static void schedule(periph14_t *p, int ev, uint64_t at)
+{
+    p->due[ev] = at;
+    update_next(p);
+}
+
+static uint64_t now(const periph14_t *p)
+{
+    return p->sim->cycles;
+}
+
+// Time seen by the Fosc-clocked peripherals: it stops while the core sleeps
+static uint64_t cpu_time(const periph14_t *p, uint64_t at)
+{
+    return (p->asleep && at > p->sleep_at) ? p->sleep_at : at;
+}
+
+static void set_flag(periph14_t *p, uint16_t reg, uint8_t mask)
+{
+    R(reg) |= mask;
+    sim14_update_irq(p->sim);
+}
+
+static void clear_flag(periph14_t *p, uint16_t reg, uint8_t mask)
+{
+    R(reg) &= (uint8_t)~mask;
+    sim14_update_irq(p->sim);
+}
+
+static void serial_out(periph14_t *p, uint64_t at, uint8_t channel, uint8_t byte)
+{
+    p->bytes[channel]++;
+    if (p->observer.serial) {
+        p->observer.serial(p->observer.ctx, at, channel, byte);
+    }
+}
+
+/* ------------------------------------------------------------------------------------------ */
+/* Ports                                                                                      */
+/* ------------------------------------------------------------------------------------------ */
+
+static int ccp_mode(const periph14_t *p, int x)
+{
+    return R(x ? CCP2CON : CCP1CON) & 0x0F;
+}
+
+static int ccp_drives_pin(const periph14_t *p, int x)
+{
+    int mode = ccp_mode(p, x);
+    return mode == 0x08 || mode == 0x09 || mode >= 0x0C;
+}
+
+static uint8_t port_level(const periph14_t *p, uint8_t port)
+{
+    uint8_t tris = R(TRISA + port);
+    uint8_t out = p->latch[port];
+    int x;
+
+    if (port == PERIPH14_PORTC) {
+        for (x = 0; x < 2; x++) {
+            if (ccp_drives_pin(p, x)) {
+                uint8_t bit = x ? 0x02 : 0x04;     // CCP2 on RC1, CCP1 on RC2
+                out = (uint8_t)(p->t.ccp_pin[x] ? (out | bit) : (out & ~bit));
+            }
+        }
+    }
+    return (uint8_t)(((out & ~tris) | (p->input[port] & tris)) & port_masks[port]);
+}
+
+static void notify_pins(periph14_t *p, uint8_t port, uint64_t at)
+{
+    uint8_t level = port_level(p, port);
+
+    if (level != p->pins[port]) {
+        p->pins[port] = level;
+        if (p->observer.pin) {
+            p->observer.pin(p->observer.ctx, at, port, level);
+        }
+    }
+}
+
+/* ------------------------------------------------------------------------------------------ */
+/* Timer0                                                                                     */
+/* ------------------------------------------------------------------------------------------ */
+
+static int tmr0_counter(const periph14_t *p)
+{
+    return R(OPTION) & 0x20;                // T0CS: T0CKI pin
+}
+
+static unsigned tmr0_prescale(const periph14_t *p)
+{
+    uint8_t option = R(OPTION);
+    return (option & 0x08) ? 1 : 2u << (option & 0x07);
+}
+
+static uint8_t tmr0_at(const periph14_t *p, uint64_t at)
+{
+    if (tmr0_counter(p)) {
+        return R(TMR0);
+    }
+    at = cpu_time(p, at);
+    if (at < p->t.tmr0_base) {
+        return p->t.tmr0_value;
+    }
+    return (uint8_t)(p->t.tmr0_value + (at - p->t.tmr0_base) / tmr0_prescale(p));
+}
+
+static void tmr0_start(periph14_t *p, uint8_t value, uint64_t base)
+{
+    p->t.tmr0_value = value;
+    p->t.tmr0_base = base;
+    p->t.tmr0_edges = 0;
+    R(TMR0) = value;
+    schedule(p, PERIPH14_EV_TMR0,
+             tmr0_counter(p) ? SIM14_NEVER : base + (uint64_t)(256 - value) * tmr0_prescale(p));
+}
+
+static void tmr0_edge(periph14_t *p)
+{
+    if (++p->t.tmr0_edges >= tmr0_prescale(p)) {
+        p->t.tmr0_edges = 0;
+        if (++R(TMR0) == 0) {
+            set_flag(p, INTCON, T0IF);
+        }
+    }
+}
+
+/* ------------------------------------------------------------------------------------------ */
+/* Timer1 and CCP                                                                             */
+/* ------------------------------------------------------------------------------------------ */
+
+static int tmr1_internal(const periph14_t *p)
+{
+    return (R(T1CON) & 0x03) == 0x01;       // TMR1ON, TMR1CS = 0
+}
+
+static unsigned tmr1_prescale(const periph14_t *p)
+{
+    return 1u << ((R(T1CON) >> 4) & 0x03);
+}
+
+static uint16_t tmr1_at(const periph14_t *p, uint64_t at)
+{
+    if (!tmr1_internal(p)) {
+        return p->t.tmr1_value;
+    }
+    at = cpu_time(p, at);
+    if (at < p->t.tmr1_base) {
+        return p->t.tmr1_value;
+    }
+    return (uint16_t)(p->t.tmr1_value + (at - p->t.tmr1_base) / tmr1_prescale(p));
+}
+
+static uint16_t ccpr(const periph14_t *p, int x)
+{
+    return x ? (uint16_t)(R(CCPR2H) << 8 | R(CCPR2L)) : (uint16_t)(R(CCPR1H) << 8 | R(CCPR1L));
+}
+
+// Cycle of the first increment after 'from' that brings TMR1 to 'target'
+static uint64_t tmr1_reaches(const periph14_t *p, uint16_t target, uint64_t from)
+{
+    unsigned ps = tmr1_prescale(p);
+    uint64_t done = from > p->t.tmr1_base ? (from - p->t.tmr1_base) / ps : 0;
+    uint32_t counts = (uint16_t)(target - (uint16_t)(p->t.tmr1_value + done));
+
+    if (counts == 0) {
+        counts = 0x10000;
+    }
+    return p->t.tmr1_base + (done + counts) * ps;
+}
+
+static void tmr1_schedule(periph14_t *p, uint64_t from)
+{
+    int x;
+
+    if (!tmr1_internal(p)) {
+        p->due[PERIPH14_EV_TMR1] = SIM14_NEVER;
+        p->due[PERIPH14_EV_CCP1] = SIM14_NEVER;
+        p->due[PERIPH14_EV_CCP2] = SIM14_NEVER;
+    } else {
+        p->due[PERIPH14_EV_TMR1] = tmr1_reaches(p, 0, from);
+        for (x = 0; x < 2; x++) {
+            int mode = ccp_mode(p, x);
+            p->due[PERIPH14_EV_CCP1 + x] = (mode >= 0x08 && mode <= 0x0B) ?
+                                           tmr1_reaches(p, ccpr(p, x), from) : SIM14_NEVER;
+        }
+    }
+    update_next(p);
+}
+
+static void tmr1_start(periph14_t *p, uint16_t value, uint64_t base)
+{
+    p->t.tmr1_value = value;
+    p->t.tmr1_base = base;
+    tmr1_schedule(p, base);
+}
+
+static void adc_start(periph14_t *p, uint64_t at);
+
+// TMR1 == CCPRx in compare mode
+static void ccp_match(periph14_t *p, int x, uint64_t at)
+{
+    switch (ccp_mode(p, x)) {
+    case 0x08:
+        p->t.ccp_pin[x] = 1;
+        notify_pins(p, PERIPH14_PORTC, at);
+        break;
+    case 0x09:
+        p->t.ccp_pin[x] = 0;
+        notify_pins(p, PERIPH14_PORTC, at);
+        break;
+    case 0x0B:
+        // Special event trigger: Timer1 restarts from 0 (CCPRx is its period), CCP2 starts the ADC
+        if (tmr1_internal(p)) {
+            p->t.tmr1_value = 0;
+            p->t.tmr1_base = at + tmr1_prescale(p);
+        } else {
+            p->t.tmr1_value = 0;
+        }
+        if (x == 1 && (R(ADCON0) & ADON)) {
+            R(ADCON0) |= GO;
+            adc_start(p, at);
+        }
+        break;
+    default:
+        break;
+    }
+    if (x) {
+        set_flag(p, PIR2, CCP2IF);
+    } else {
+        set_flag(p, PIR1, CCP1IF);
+    }
+}
+
+static void tmr1_edge(periph14_t *p, uint64_t at)
+{
+    int x;
+
+    if (++p->t.tmr1_edges < tmr1_prescale(p)) {
+        return;
+    }
+    p->t.tmr1_edges = 0;
+    if (++p->t.tmr1_value == 0) {
+        set_flag(p, PIR1, TMR1IF);
+    }
+    for (x = 0; x < 2; x++) {
+        int mode = ccp_mode(p, x);
+        if (mode >= 0x08 && mode <= 0x0B && p->t.tmr1_value == ccpr(p, x)) {
+            ccp_match(p, x, at);
+        }
+    }
+}
+
+// Capture modes: 4 every falling edge, 5 every rising edge, 6 every 4th, 7 every 16th rising
+static void ccp_edge(periph14_t *p, int x, uint8_t level, uint64_t at)
+{
+    static const uint8_t every[4] = { 1, 1, 4, 16 };
+    int mode = ccp_mode(p, x);
+    uint16_t value;
+
+    if (mode < 0x04 || mode > 0x07 || level != (mode != 0x04)) {
+        return;
+    }
+    if (++p->t.ccp_edges[x] < every[mode - 0x04]) {
+        return;
+    }
+    p->t.ccp_edges[x] = 0;
+    value = tmr1_at(p, at);
+    if (x) {
+        R(CCPR2L) = (uint8_t)value;
+        R(CCPR2H) = (uint8_t)(value >> 8);
+        set_flag(p, PIR2, CCP2IF);
+    } else {
+        R(CCPR1L) = (uint8_t)value;
+        R(CCPR1H) = (uint8_t)(value >> 8);
+        set_flag(p, PIR1, CCP1IF);
+    }
+}
+
+/* ------------------------------------------------------------------------------------------ */
+/* Timer2 and PWM                                                                             */
+/* ------------------------------------------------------------------------------------------ */
+
+static int tmr2_on(const periph14_t *p)
+{
+    return R(T2CON) & 0x04;
+}
+
+static unsigned tmr2_prescale(const periph14_t *p)
+{
+    return tmr2_prescales[R(T2CON) & 0x03];
+}
+
+static unsigned tmr2_period(const periph14_t *p)
+{
+    return R(PR2) + 1u;
+}
+
+static uint64_t tmr2_ticks(const periph14_t *p, uint64_t at)
+{
+    at = cpu_time(p, at);
+    if (!tmr2_on(p) || at < p->t.tmr2_base) {
+        return 0;
+    }
+    return (at - p->t.tmr2_base) / tmr2_prescale(p);
+}
+
+static uint8_t tmr2_at(const periph14_t *p, uint64_t at)
+{
+    return (uint8_t)((p->t.tmr2_value + tmr2_ticks(p, at)) % tmr2_period(p));
+}
+
+// Cycle of the next TMR2 = PR2 -> 0 reset after 'at'
+static uint64_t tmr2_next_reset(const periph14_t *p, uint64_t at)
+{
+    unsigned period = tmr2_period(p);
+    uint64_t total = p->t.tmr2_value + tmr2_ticks(p, at);
+    uint64_t next = (total / period + 1) * period;
+
+    return p->t.tmr2_base + (next - p->t.tmr2_value) * tmr2_prescale(p);
+}
+
+static void pwm_schedule(periph14_t *p, int x, uint64_t at)
+{
+    p->t.pwm_high[x] = 0;
+    p->due[PERIPH14_EV_PWM1 + x] = (ccp_mode(p, x) >= 0x0C && tmr2_on(p) && p->observer.pin) ?
+                                   tmr2_next_reset(p, at) : SIM14_NEVER;
+}
+
+static void tmr2_schedule(periph14_t *p)
+{
+    unsigned post = ((R(T2CON) >> 3) & 0x0F) + 1u;
+    unsigned period = tmr2_period(p);
+    int x;
+
+    if (p->t.tmr2_value >= period) {
+        p->t.tmr2_value = 0;                // PR2 written below TMR2
+    }
+    p->due[PERIPH14_EV_TMR2] = tmr2_on(p) ?
+        p->t.tmr2_base + ((uint64_t)(post - p->t.tmr2_post) * period - p->t.tmr2_value) * tmr2_prescale(p) :
+        SIM14_NEVER;
+    for (x = 0; x < 2; x++) {
+        pwm_schedule(p, x, p->t.tmr2_base);
+    }
+    update_next(p);
+}
+
+// Fold the counts up to 'at' into (value, post) so the configuration can change
+static void tmr2_rebase(periph14_t *p, uint64_t at)
+{
+    unsigned post = ((R(T2CON) >> 3) & 0x0F) + 1u;
+    uint64_t total = p->t.tmr2_value + tmr2_ticks(p, at);
+
+    p->t.tmr2_post = (uint8_t)((p->t.tmr2_post + total / tmr2_period(p)) % post);
+    p->t.tmr2_value = (uint8_t)(total % tmr2_period(p));
+    p->t.tmr2_base = at;
+}
+
+static void pwm_event(periph14_t *p, int x, uint64_t at)
+{
+    unsigned ps = tmr2_prescale(p);
+    uint64_t period = (uint64_t)tmr2_period(p) * ps;
+    uint64_t high;
+
+    if (p->t.pwm_high[x]) {
+        p->t.ccp_pin[x] = 0;
+        p->t.pwm_high[x] = 0;
+        notify_pins(p, PERIPH14_PORTC, at);
+        schedule(p, PERIPH14_EV_PWM1 + x, tmr2_next_reset(p, at));
+        return;
+    }
+    // Period start: the duty cycle in CCPRxL:CCPxCON<5:4> is latched (Tosc units)
+    if (x) {
+        p->t.pwm_duty[1] = (uint16_t)(R(CCPR2L) << 2 | ((R(CCP2CON) >> 4) & 0x03));
+        R(CCPR2H) = R(CCPR2L);
+    } else {
+        p->t.pwm_duty[0] = (uint16_t)(R(CCPR1L) << 2 | ((R(CCP1CON) >> 4) & 0x03));
+        R(CCPR1H) = R(CCPR1L);
+    }
+    high = (uint64_t)p->t.pwm_duty[x] * ps / 4;
+    p->t.ccp_pin[x] = p->t.pwm_duty[x] != 0;
+    notify_pins(p, PERIPH14_PORTC, at);
+    if (p->t.pwm_duty[x] != 0 && high < period) {
+        p->t.pwm_high[x] = 1;
+        schedule(p, PERIPH14_EV_PWM1 + x, at + (high ? high : 1));
+    } else {
+        schedule(p, PERIPH14_EV_PWM1 + x, at + period);
+    }
+}
+
+/* ------------------------------------------------------------------------------------------ */
+/* USART                                                                                      */
+/* ------------------------------------------------------------------------------------------ */
+
+static uint32_t uart_frame(const periph14_t *p)
+{
+    uint8_t txsta = R(TXSTA);
+    uint32_t n = R(SPBRG) + 1u;
+
+    if (txsta & SYNC) {
+        return 8 * n;
+    }
+    return ((txsta & BRGH) ? 4 * n : 16 * n) * ((txsta & TX9) ? 11u : 10u);
+}
+
+static int uart_tx_on(const periph14_t *p)
+{
+    return (R(RCSTA) & SPEN) && (R(TXSTA) & TXEN);
+}
+
+static void uart_tx_start(periph14_t *p, uint64_t at)
+{
+    p->tsr = p->txreg;
+    p->txreg_full = 0;
+    p->tx_busy = 1;
+    R(TXSTA) &= (uint8_t)~TRMT;
+    set_flag(p, PIR1, TXIF);
+    schedule(p, PERIPH14_EV_TX, at + uart_frame(p));
+}
+
+static void uart_tx_done(periph14_t *p, uint64_t at)
+{
+    serial_out(p, at, PERIPH14_UART_TX, p->tsr);
+    p->tx_busy = 0;
+    if (p->txreg_full && uart_tx_on(p)) {
+        uart_tx_start(p, at);
+    } else {
+        R(TXSTA) |= TRMT;
+    }
+}
+
+static void uart_rx_done(periph14_t *p, uint64_t at)
+{
+    uint8_t byte = p->rx_line[p->rx_tail++];
+
+    if ((R(RCSTA) & (SPEN | CREN)) == (SPEN | CREN) && !(R(RCSTA) & OERR)) {
+        if (p->rx_count < 2) {
+            p->rx_fifo[p->rx_count++] = byte;
+            p->rx_bytes++;
+            set_flag(p, PIR1, RCIF);
+        } else {
+            R(RCSTA) |= OERR;               // Receiver stops until CREN is cleared
+            p->rx_overruns++;
+        }
+    }
+    if (p->rx_tail != p->rx_head) {
+        schedule(p, PERIPH14_EV_RX, at + uart_frame(p));
+    }
+}
+
+static uint8_t uart_read_rcreg(periph14_t *p)
+{
+    if (p->rx_count) {
+        R(RCREG) = p->rx_fifo[0];
+        p->rx_fifo[0] = p->rx_fifo[1];
+        if (--p->rx_count == 0) {
+            clear_flag(p, PIR1, RCIF);
+        }
+    }
+    return R(RCREG);
+}
+
+/* ------------------------------------------------------------------------------------------ */
+/* MSSP                                                                                       */
+/* ------------------------------------------------------------------------------------------ */
+
+static uint8_t sspm(const periph14_t *p)
+{
+    return (R(SSPCON) & SSPEN) ? (R(SSPCON) & 0x0F) : 0xFF;
+}
+
+static int spi_master(const periph14_t *p)
+{
+    return sspm(p) <= 0x03;
+}
+
+static int spi_slave(const periph14_t *p)
+{
+    return sspm(p) == 0x04 || sspm(p) == 0x05;
+}
+
+static int i2c_slave(const periph14_t *p)
+{
+    uint8_t m = sspm(p);
+    return m == 0x06 || m == 0x07 || m == 0x0E || m == 0x0F;
+}
+
+static int i2c_master(const periph14_t *p)
+{
+    return sspm(p) == 0x08;
+}
+
+// Bus cycles of an external master for 'bits' bits
+static uint64_t bus_cycles(const periph14_t *p, unsigned bits)
+{
+    uint64_t c = (uint64_t)bits * p->fosc / 4 / PERIPH14_BUS_HZ;
+    return c ? c : 1;
+}
+
+static uint64_t spi_byte_cycles(const periph14_t *p)
+{
+    static const uint8_t bit[3] = { 1, 4, 16 };
+    uint8_t m = sspm(p);
+
+    if (m == 0x03) {
+        return 16ULL * tmr2_period(p) * tmr2_prescale(p);   // TMR2 output / 2
+    }
+    return 8u * bit[m];
+}
+
+static void spi_master_done(periph14_t *p, uint64_t at)
+{
+    uint8_t in = 0xFF;
+
+    serial_out(p, at, PERIPH14_SPI_OUT, p->ssp_out);
+    if (p->spi_in_tail != p->spi_in_head) {
+        in = p->spi_in[p->spi_in_tail++];
+    }
+    serial_out(p, at, PERIPH14_SPI_IN, in);
+    R(SSPBUF) = in;
+    R(SSPSTAT) |= BF;
+    p->ssp_busy = 0;
+    set_flag(p, PIR1, SSPIF);
+}
+
+// Register-file device on the bus of the I2C master
+static int device_write(periph14_t *p, uint8_t byte)
+{
+    switch (p->i2c_state) {
+    case 0:
+        if (p->i2c_device && (byte >> 1) == p->i2c_device) {
+            p->i2c_state = (byte & 1) ? 3 : 1;
+            return 1;
+        }
+        p->i2c_state = 4;
+        return 0;
+    case 1:
+        p->i2c_pointer = byte;
+        p->i2c_state = 2;
+        return 1;
+    case 2:
+        p->i2c_regs[p->i2c_pointer++] = byte;
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+static void i2c_master_start(periph14_t *p, uint64_t at)
+{
+    static const uint8_t bits[] = { 0, 2, 3, 2, 9, 8, 1 };
+    uint8_t con2 = R(SSPCON2);
+    uint8_t op = OP_NONE;
+
+    if (p->ssp_op != OP_NONE) {
+        return;
+    }
+    if (con2 & SEN) {
+        op = OP_START;
+    } else if (con2 & RSEN) {
+        op = OP_RSTART;
+    } else if (con2 & PEN) {
+        op = OP_STOP;
+    } else if (con2 & RCEN) {
+        op = OP_READ;
+    } else if (con2 & ACKEN) {
+        op = OP_ACK;
+    }
+    if (op != OP_NONE) {
+        p->ssp_op = op;
+        schedule(p, PERIPH14_EV_SSP, at + (uint64_t)bits[op] * (R(SSPADD) + 1u));
+    }
+}
+
+static void i2c_master_done(periph14_t *p, uint64_t at)
+{
+    uint8_t byte;
+
+    switch (p->ssp_op) {
+    case OP_START:
+    case OP_RSTART:
+        R(SSPCON2) &= (uint8_t)~(SEN | RSEN);
+        R(SSPSTAT) = (uint8_t)((R(SSPSTAT) | S_BIT) & ~P_BIT);
+        p->i2c_state = 0;
+        break;
+    case OP_STOP:
+        R(SSPCON2) &= (uint8_t)~PEN;
+        R(SSPSTAT) = (uint8_t)((R(SSPSTAT) | P_BIT) & ~S_BIT);
+        p->i2c_state = 0;
+        break;
+    case OP_WRITE:
+        R(SSPSTAT) &= (uint8_t)~(BF | R_W);
+        serial_out(p, at, PERIPH14_I2C_OUT, p->ssp_out);
+        if (device_write(p, p->ssp_out)) {
+            R(SSPCON2) &= (uint8_t)~ACKSTAT;
+        } else {
+            R(SSPCON2) |= ACKSTAT;
+        }
+        break;
+    case OP_READ:
+        R(SSPCON2) &= (uint8_t)~RCEN;
+        byte = (p->i2c_state == 3) ? p->i2c_regs[p->i2c_pointer++] : 0xFF;
+        R(SSPBUF) = byte;
+        R(SSPSTAT) |= BF;
+        serial_out(p, at, PERIPH14_I2C_IN, byte);
+        break;
+    case OP_ACK:
+        R(SSPCON2) &= (uint8_t)~ACKEN;
+        break;
+    default:
+        return;
+    }
+    p->ssp_op = OP_NONE;
+    set_flag(p, PIR1, SSPIF);
+}
+
+// A byte from the external master reaches SSPBUF (SPI and I2C slave modes)
+static void slave_receive(periph14_t *p, uint8_t byte, uint8_t channel, uint64_t at)
+{
+    serial_out(p, at, channel, byte);
+    if (R(SSPSTAT) & BF) {
+        R(SSPCON) |= SSPOV;                 // Previous byte not read: this one is lost
+    } else {
+        R(SSPBUF) = byte;
+        R(SSPSTAT) |= BF;
+    }
+    set_flag(p, PIR1, SSPIF);
+}
+
+static void slave_wait_or_continue(periph14_t *p, int stretch, uint64_t at)
+{
+    if (stretch) {
+        R(SSPCON) &= (uint8_t)~CKP;         // SCL held low until the firmware sets CKP
+        p->slave_wait_ckp = 1;
+    } else {
+        schedule(p, PERIPH14_EV_SSP, at + bus_cycles(p, 9));
+    }
+}
+
+static void slave_finish(periph14_t *p)
+{
+    p->slave_xfer.kind = 0xFF;
+    p->slave_wait_ckp = 0;
+}
+
+static void slave_step(periph14_t *p, uint64_t at)
+{
+    periph14_stimulus_t *x = &p->slave_xfer;
+    const uint8_t *data = p->pool + x->offset;
+    uint16_t step = p->slave_step++;
+
+    if (x->kind == STIM_SPI) {
+        if (spi_slave(p)) {
+            serial_out(p, at, PERIPH14_SPI_OUT, p->ssp_out);
+            slave_receive(p, data[step], PERIPH14_SPI_IN, at);
+        }
+        if (step + 1u < x->length) {
+            schedule(p, PERIPH14_EV_SSP, at + bus_cycles(p, 8));
+        } else {
+            slave_finish(p);
+        }
+        return;
+    }
+
+    if (step == 0) {
+        // Address byte; a read always holds SCL until the firmware has loaded SSPBUF
+        if (!i2c_slave(p) || (R(SSPADD) >> 1) != x->address) {
+            slave_finish(p);                // Not acknowledged
+            return;
+        }
+        R(SSPSTAT) = (uint8_t)((R(SSPSTAT) | S_BIT) & ~(P_BIT | D_A | R_W));
+        if (x->read_count) {
+            R(SSPSTAT) |= R_W;
+        }
+        slave_receive(p, (uint8_t)(x->address << 1 | (x->read_count ? 1 : 0)), PERIPH14_I2C_IN, at);
+        slave_wait_or_continue(p, x->read_count || (R(SSPCON2) & SEN), at);
+    } else if (!x->read_count) {
+        if (step <= x->length) {
+            R(SSPSTAT) = (uint8_t)((R(SSPSTAT) | D_A) & ~R_W);
+            slave_receive(p, data[step - 1], PERIPH14_I2C_IN, at);
+            slave_wait_or_continue(p, R(SSPCON2) & SEN, at);
+        } else {
+            R(SSPSTAT) = (uint8_t)((R(SSPSTAT) | P_BIT) & ~S_BIT);
+            if (sspm(p) >= 0x0E) {
+                set_flag(p, PIR1, SSPIF);   // Start/stop interrupts enabled
+            }
+            slave_finish(p);
+        }
+    } else {
+        // The byte the firmware loaded has been shifted out; the master ACKs all but the last
+        serial_out(p, at, PERIPH14_I2C_OUT, p->ssp_out);
+        R(SSPSTAT) = (uint8_t)((R(SSPSTAT) | D_A) & ~BF);
+        if (step < x->read_count) {
+            R(SSPSTAT) |= R_W;
+            set_flag(p, PIR1, SSPIF);
+            slave_wait_or_continue(p, 1, at);
+        } else {
+            R(SSPSTAT) = (uint8_t)((R(SSPSTAT) | P_BIT) & ~(R_W | S_BIT));
+            set_flag(p, PIR1, SSPIF);       // NACK: the firmware resets its transmit logic
+            slave_finish(p);
+        }
+    }
+}
+
+static void ssp_event(periph14_t *p, uint64_t at)
+{
+    if (p->slave_xfer.kind != 0xFF) {
+        slave_step(p, at);
+    } else if (i2c_master(p)) {
+        i2c_master_done(p, at);
+    } else if (p->ssp_busy) {
+        spi_master_done(p, at);
+    }
+}
+
+/* ------------------------------------------------------------------------------------------ */
+/* ADC and EEPROM                                                                             */
+/* ------------------------------------------------------------------------------------------ */
+
+static int adc_rc_clock(const periph14_t *p)
+{
+    return adc_clocks[(R(ADCON1) & 0x40) >> 4 | R(ADCON0) >> 6] == 0;
+}
+
+static void adc_start(periph14_t *p, uint64_t at)
+{
+    uint8_t tosc = adc_clocks[(R(ADCON1) & 0x40) >> 4 | R(ADCON0) >> 6];
+    uint64_t cycles;
+
+    // 12 TAD per conversion
+    if (tosc) {
+        cycles = 12u * tosc / 4;
+    } else {
+        cycles = (uint64_t)12 * PERIPH14_ADC_RC_US * p->fosc / 4 / 1000000;
+    }
+    schedule(p, PERIPH14_EV_ADC, at + (cycles ? cycles : 1));
+}
+
+static void adc_done(periph14_t *p)
+{
+    uint8_t channel = (R(ADCON0) >> 3) & 0x07;
+    uint32_t code = ((uint32_t)p->analog_mv[channel] * 1023 + PERIPH14_VDD_MV / 2) / PERIPH14_VDD_MV;
+
+    if (code > 1023) {
+        code = 1023;
+    }
+    if (R(ADCON1) & 0x80) {                 // ADFM: right justified
+        R(ADRESH) = (uint8_t)(code >> 8);
+        R(ADRESL) = (uint8_t)code;
+    } else {
+        R(ADRESH) = (uint8_t)(code >> 2);
+        R(ADRESL) = (uint8_t)(code << 6);
+    }
+    R(ADCON0) &= (uint8_t)~GO;
+    p->conversions++;
+    set_flag(p, PIR1, ADIF);
+}
+
+static void ee_done(periph14_t *p)
+{
+    if (R(EECON1) & EEPGD) {
+        sim14_set_word(p->sim, (uint16_t)(R(EEADRH) << 8 | R(EEADR)), (uint16_t)(R(EEDATH) << 8 | R(EEDATA)));
+    } else {
+        p->eeprom[R(EEADR)] = R(EEDATA);
+    }
+    p->ee_writes++;
+    R(EECON1) &= (uint8_t)~WR;
+    set_flag(p, PIR2, EEIF);
+}
+
+static void eecon1_write(periph14_t *p, uint8_t value)
+{
+    uint8_t old = R(EECON1);
+    uint8_t next = (uint8_t)((value & ~RD) | (old & WR));     // WR is cleared by hardware only
+
+    if (value & RD) {
+        if (value & EEPGD) {
+            uint16_t word = p->sim->program[(R(EEADRH) << 8 | R(EEADR)) & (PIC14_PROGRAM_WORDS - 1)];
+            R(EEDATA) = (uint8_t)word;
+            R(EEDATH) = (uint8_t)(word >> 8);
+        } else {
+            R(EEDATA) = p->eeprom[R(EEADR)];
+        }
+    }
+    if ((value & WR) && !(old & WR)) {
+        if ((value & WREN) && p->ee_unlock == 2) {
+            schedule(p, PERIPH14_EV_EE, now(p) + (uint64_t)PERIPH14_EE_WRITE_US * p->fosc / 4 / 1000000);
+        } else {
+            next &= (uint8_t)~WR;           // No 55h/AAh sequence: the write does not start
+        }
+    }
+    p->ee_unlock = 0;
+    R(EECON1) = next;
+}
+
+/* ------------------------------------------------------------------------------------------ */
+/* Stimuli                                                                                    */
+/* ------------------------------------------------------------------------------------------ */
+
+static void input_edge(periph14_t *p, uint8_t port, uint8_t bit, uint8_t level, uint64_t at)
+{
+    uint8_t mask = (uint8_t)(1u << bit);
+    uint8_t option = R(OPTION);
+
+    if (((p->input[port] & mask) != 0) == level) {
+        return;
+    }
+    p->input[port] = (uint8_t)(level ? (p->input[port] | mask) : (p->input[port] & ~mask));
+
+    if (port == PERIPH14_PORTB) {
+        if (bit == 0 && level == ((option & 0x40) != 0)) {
+            set_flag(p, INTCON, INTF);      // INTEDG selects the edge
+        }
+        if (bit >= 4 && (R(TRISA + PERIPH14_PORTB) & mask) &&
+            (port_level(p, PERIPH14_PORTB) & 0xF0) != p->rb_read) {
+            set_flag(p, INTCON, RBIF);
+        }
+    } else if (port == PERIPH14_PORTA && bit == 4) {
+        if (tmr0_counter(p) && level == !(option & 0x10)) {
+            tmr0_edge(p);                   // T0SE: 0 = rising edge
+        }
+    } else if (port == PERIPH14_PORTC) {
+        if (bit == 0 && level && (R(T1CON) & 0x03) == 0x03) {
+            tmr1_edge(p, at);               // T1CKI rising edge
+        } else if (bit == 1) {
+            ccp_edge(p, 1, level, at);
+        } else if (bit == 2) {
+            ccp_edge(p, 0, level, at);
+        }
+    }
+    notify_pins(p, port, at);
+}
+
+static void stimulus_due(periph14_t *p)
+{
+    uint64_t next = SIM14_NEVER;
+    int i;
+
+    for (i = 0; i < p->stimulus_count; i++) {
+        if (p->stimuli[i].at < next) {
+            next = p->stimuli[i].at;
+        }
+    }
+    schedule(p, PERIPH14_EV_STIM, next);
+}
+
+static void stimulus_event(periph14_t *p, uint64_t at)
+{
+    for (;;) {
+        periph14_stimulus_t *s = NULL;
+        int i, index = -1;
+
+        for (i = 0; i < p->stimulus_count; i++) {
+            if (p->stimuli[i].at <= at && (s == NULL || p->stimuli[i].at < s->at)) {
+                s = &p->stimuli[i];
+                index = i;
+            }
+        }
+        if (s == NULL) {
+            break;
+        }
+        switch (s->kind) {
+        case STIM_PIN:
+            input_edge(p, s->port, s->bit, s->level, s->at);
+            break;
+        case STIM_CLOCK:
+            input_edge(p, s->port, s->bit, s->level, s->at);
+            s->level ^= 1;
+            if (s->edges == 0 || --s->edges != 0) {
+                s->at += s->half_period;
+                continue;                   // Stays queued
+            }
+            break;
+        case STIM_ANALOG:
+            p->analog_mv[s->bit] = (uint16_t)(s->offset);
+            break;
+        case STIM_UART:
+            for (i = 0; i < s->length; i++) {
+                if ((uint8_t)(p->rx_head - p->rx_tail) == (uint8_t)(PERIPH14_RX_SIZE - 1)) {
+                    break;                  // Line buffer full
+                }
+                p->rx_line[p->rx_head++] = p->pool[s->offset + i];
+            }
+            if (p->due[PERIPH14_EV_RX] == SIM14_NEVER && p->rx_tail != p->rx_head) {
+                schedule(p, PERIPH14_EV_RX, s->at + uart_frame(p));
+            }
+            break;
+        default:
+            // SPI/I2C transfers from an external master, one at a time
+            if (p->slave_xfer.kind != 0xFF) {
+                s->at += bus_cycles(p, 9);
+                continue;
+            }
+            p->slave_xfer = *s;
+            p->slave_step = 0;
+            p->slave_wait_ckp = 0;
+            schedule(p, PERIPH14_EV_SSP, s->at + bus_cycles(p, s->kind == STIM_SPI ? 8 : 9));
+            break;
+        }
+        p->stimuli[index] = p->stimuli[--p->stimulus_count];
+    }
+    stimulus_due(p);
+}
+
+static periph14_stimulus_t *stimulus_add(periph14_t *p, uint64_t at, uint8_t kind)
+{
+    periph14_stimulus_t *s;
+
+    if (p->stimulus_count == PERIPH14_STIMULI) {
+        return NULL;
+    }
+    s = &p->stimuli[p->stimulus_count++];
+    memset(s, 0, sizeof(*s));
+    s->at = at;
+    s->kind = kind;
+    if (at < p->due[PERIPH14_EV_STIM]) {
+        schedule(p, PERIPH14_EV_STIM, at);
+    }
+    return s;
+}
+
+static int pool_add(periph14_t *p, const uint8_t *data, uint16_t length, uint16_t *offset)
+{
+    if (length > PERIPH14_POOL_SIZE - p->pool_used) {
+        return 0;
+    }
+    memcpy(p->pool + p->pool_used, data, length);
+    *offset = p->pool_used;
+    p->pool_used += length;
+    return 1;
+}
+
+/* ------------------------------------------------------------------------------------------ */
+/* Core hooks                                                                                 */
+/* ------------------------------------------------------------------------------------------ */
+
+static uint8_t read_hook(sim14_t *sim, uint16_t c)
+{
+    periph14_t *p = sim->context;
+    uint64_t t = now(p);
+    uint16_t value;
+
+    switch (c) {
+    case TMR0:
+        return tmr0_at(p, t);
+    case TMR1L:
+    case TMR1H:
+        value = tmr1_at(p, t);
+        return (uint8_t)(c == TMR1L ? value : value >> 8);
+    case TMR2:
+        return tmr2_at(p, t);
+    case SSPBUF:
+        R(SSPSTAT) &= (uint8_t)~BF;
+        return R(SSPBUF);
+    case RCREG:
+        return uart_read_rcreg(p);
+    default:
+        if (c >= PORTA && c < PORTA + PERIPH14_PORTS) {
+            uint8_t level = port_level(p, (uint8_t)(c - PORTA));
+            if (c == PORTA + PERIPH14_PORTB) {
+                p->rb_read = level & 0xF0;  // Ends the RB<7:4> mismatch
+            }
+            return level;
+        }
+        return R(c);
+    }
+}
+
+static void write_register(periph14_t *p, uint16_t c, uint8_t value)
+{
+    uint64_t t = now(p);
+    uint16_t timer;
+    int x;
+
+    switch (c) {
+    case TMR0:
+        tmr0_start(p, value, t + 2);        // Increment inhibited for two cycles
+        break;
+    case OPTION: {
+        uint8_t current = tmr0_at(p, t);
+        R(OPTION) = value;
+        tmr0_start(p, current, t);
+        break;
+    }
+    case TMR1L:
+    case TMR1H:
+        timer = tmr1_at(p, t);
+        timer = (c == TMR1L) ? (uint16_t)((timer & 0xFF00) | value) : (uint16_t)((timer & 0x00FF) | value << 8);
+        tmr1_start(p, timer, t);
+        break;
+    case T1CON:
+        timer = tmr1_at(p, t);
+        R(T1CON) = value;
+        tmr1_start(p, timer, t);
+        break;
+    case CCPR1L: case CCPR1H: case CCPR2L: case CCPR2H:
+        R(c) = value;
+        tmr1_schedule(p, t);
+        break;
+    case CCP1CON:
+    case CCP2CON:
+        x = (c == CCP2CON);
+        if ((value & 0x0F) != (R(c) & 0x0F)) {
+            p->t.ccp_edges[x] = 0;
+            p->t.ccp_pin[x] = (value & 0x0F) == 0x09;  // Compare: the pin starts opposite to its match level
+        }
+        R(c) = value;
+        tmr1_schedule(p, t);
+        pwm_schedule(p, x, t);
+        update_next(p);
+        notify_pins(p, PERIPH14_PORTC, t);
+        break;
+    case TMR2:
+        tmr2_rebase(p, t);
+        p->t.tmr2_value = value;
+        tmr2_schedule(p);
+        break;
+    case T2CON:
+        tmr2_rebase(p, t);
+        R(T2CON) = value;
+        p->t.tmr2_post = 0;                 // Writing T2CON clears the prescaler and postscaler
+        tmr2_schedule(p);
+        break;
+    case PR2:
+        tmr2_rebase(p, t);
+        R(PR2) = value;
+        tmr2_schedule(p);
+        break;
+    case TXREG:
+        R(TXREG) = value;
+        p->txreg = value;
+        p->txreg_full = 1;
+        clear_flag(p, PIR1, TXIF);
+        if (uart_tx_on(p) && !p->tx_busy) {
+            uart_tx_start(p, t);
+        }
+        break;
+    case TXSTA:
+    case RCSTA:
+        if (c == TXSTA) {
+            R(TXSTA) = (uint8_t)((value & ~TRMT) | (R(TXSTA) & TRMT));
+        } else {
+            R(RCSTA) = (uint8_t)((value & 0xF8) | (R(RCSTA) & 0x07));   // FERR, OERR, RX9D read-only
+            if (!(value & CREN)) {
+                R(RCSTA) &= (uint8_t)~OERR;
+            }
+        }
+        if (uart_tx_on(p)) {
+            if (p->txreg_full && !p->tx_busy) {
+                uart_tx_start(p, t);
+            } else if (!p->txreg_full) {
+                set_flag(p, PIR1, TXIF);
+            }
+        }
+        break;
+    case SSPBUF:
+        if ((spi_master(p) && p->ssp_busy) || (i2c_master(p) && p->ssp_op != OP_NONE)) {
+            R(SSPCON) |= WCOL;              // Written while a transfer is in progress
+            break;
+        }
+        R(SSPBUF) = value;
+        p->ssp_out = value;
+        if (spi_master(p)) {
+            p->ssp_busy = 1;
+            schedule(p, PERIPH14_EV_SSP, t + spi_byte_cycles(p));
+        } else if (i2c_master(p)) {
+            p->ssp_op = OP_WRITE;
+            R(SSPSTAT) |= BF | R_W;
+            schedule(p, PERIPH14_EV_SSP, t + 9ULL * (R(SSPADD) + 1u));
+        }
+        break;
+    case SSPCON:
+        R(SSPCON) = value;
+        if (!(value & SSPEN)) {
+            p->ssp_busy = 0;
+            p->ssp_op = OP_NONE;
+            if (p->slave_xfer.kind == 0xFF) {
+                schedule(p, PERIPH14_EV_SSP, SIM14_NEVER);
+            }
+        } else if ((value & CKP) && p->slave_wait_ckp) {
+            p->slave_wait_ckp = 0;
+            schedule(p, PERIPH14_EV_SSP, t + bus_cycles(p, 9));
+        }
+        break;
+    case SSPCON2:
+        R(SSPCON2) = (uint8_t)((value & ~ACKSTAT) | (R(SSPCON2) & ACKSTAT));
+        if (i2c_master(p)) {
+            i2c_master_start(p, t);
+        }
+        break;
+    case ADCON0: {
+        uint8_t old = R(ADCON0);
+        R(ADCON0) = value;
+        if ((value & (ADON | GO)) == (ADON | GO) && !(old & GO)) {
+            adc_start(p, t);
+        } else if (!(value & GO)) {
+            schedule(p, PERIPH14_EV_ADC, SIM14_NEVER);     // Conversion aborted
+        }
+        break;
+    }
+    case EECON1:
+        eecon1_write(p, value);
+        break;
+    case EECON2:
+        // Reads as 0; only the 55h/AAh unlock sequence matters
+        p->ee_unlock = (value == 0x55) ? 1 : (value == 0xAA && p->ee_unlock == 1) ? 2 : 0;
+        break;
+    default:
+        R(c) = value;
+        if (c >= PORTA && c < PORTA + PERIPH14_PORTS) {
+            p->latch[c - PORTA] = value;
+            notify_pins(p, (uint8_t)(c - PORTA), t);
+        } else if (c >= TRISA && c < TRISA + PERIPH14_PORTS) {
+            notify_pins(p, (uint8_t)(c - TRISA), t);
+        }
+        break;
+    }
+}
+
+static void write_hook(sim14_t *sim, uint16_t c, uint8_t value)
+{
+    periph14_t *p = sim->context;
+
+    write_register(p, c, value);
+    if ((p->watched[c >> 3] & (1u << (c & 7))) && p->observer.reg) {
+        p->observer.reg(p->observer.ctx, now(p), c, p->sim->ram[c]);
+    }
+}
+
+static uint16_t frozen_events(const periph14_t *p)
+{
+    uint16_t mask = (1u << PERIPH14_EV_TMR2) | (1u << PERIPH14_EV_PWM1) | (1u << PERIPH14_EV_PWM2) |
+                    (1u << PERIPH14_EV_TX) | (1u << PERIPH14_EV_RX);
+
+    if (!tmr0_counter(p)) {
+        mask |= 1u << PERIPH14_EV_TMR0;
+    }
+    if (tmr1_internal(p)) {
+        mask |= (1u << PERIPH14_EV_TMR1) | (1u << PERIPH14_EV_CCP1) | (1u << PERIPH14_EV_CCP2);
+    }
+    if (spi_master(p) || i2c_master(p)) {
+        mask |= 1u << PERIPH14_EV_SSP;
+    }
+    if (!adc_rc_clock(p)) {
+        mask |= 1u << PERIPH14_EV_ADC;
+    }
+    return mask;
+}
+
+static void sleep_change(periph14_t *p, uint64_t t)
+{
+    uint64_t slept;
+    int i;
+
+    if (p->sim->asleep) {
+        p->asleep = 1;
+        p->sleep_at = t;
+        p->frozen = frozen_events(p);
+        return;
+    }
+    // Wake-up: the Fosc-clocked peripherals resume where they stopped
+    slept = t - p->sleep_at;
+    for (i = 0; i < PERIPH14_EVENTS; i++) {
+        if ((p->frozen & (1u << i)) && p->due[i] != SIM14_NEVER) {
+            p->due[i] += slept;
+        }
+    }
+    if (!tmr0_counter(p)) {
+        p->t.tmr0_base += slept;
+    }
+    if (tmr1_internal(p)) {
+        p->t.tmr1_base += slept;
+    }
+    p->t.tmr2_base += slept;
+    p->asleep = 0;
+}
+
+static void on_event(sim14_t *sim)
+{
+    periph14_t *p = sim->context;
+    uint64_t t = sim->cycles;
+
+    p->events++;
+    if (sim->asleep != p->asleep) {
+        sleep_change(p, t);
+    }
+    for (;;) {
+        uint64_t at = SIM14_NEVER;
+        int i, ev = -1;
+
+        for (i = 0; i < PERIPH14_EVENTS; i++) {
+            if (p->due[i] < at && !(p->asleep && (p->frozen & (1u << i)))) {
+                at = p->due[i];
+                ev = i;
+            }
+        }
+        if (ev < 0 || at > t) {
+            break;
+        }
+        p->due[ev] = SIM14_NEVER;
+        switch (ev) {
+        case PERIPH14_EV_TMR0:
+            set_flag(p, INTCON, T0IF);
+            tmr0_start(p, 0, at);
+            break;
+        case PERIPH14_EV_TMR1:
+            set_flag(p, PIR1, TMR1IF);
+            tmr1_schedule(p, at);
+            break;
+        case PERIPH14_EV_CCP1:
+        case PERIPH14_EV_CCP2:
+            ccp_match(p, ev - PERIPH14_EV_CCP1, at);
+            tmr1_schedule(p, at);
+            break;
+        case PERIPH14_EV_TMR2:
+            set_flag(p, PIR1, TMR2IF);
+            p->t.tmr2_value = 0;
+            p->t.tmr2_post = 0;
+            p->t.tmr2_base = at;
+            p->due[PERIPH14_EV_TMR2] = tmr2_on(p) ?
+                at + (uint64_t)(((R(T2CON) >> 3) & 0x0F) + 1u) * tmr2_period(p) * tmr2_prescale(p) :
+                SIM14_NEVER;
+            break;
+        case PERIPH14_EV_PWM1:
+        case PERIPH14_EV_PWM2:
+            pwm_event(p, ev - PERIPH14_EV_PWM1, at);
+            break;
+        case PERIPH14_EV_TX:
+            uart_tx_done(p, at);
+            break;
+        case PERIPH14_EV_RX:
+            uart_rx_done(p, at);
+            break;
+        case PERIPH14_EV_SSP:
+            ssp_event(p, at);
+            break;
+        case PERIPH14_EV_ADC:
+            adc_done(p);
+            break;
+        case PERIPH14_EV_EE:
+            ee_done(p);
+            break;
+        default:
+            stimulus_event(p, at);
+            break;
+        }
+    }
+    update_next(p);
+}
+
+/* ------------------------------------------------------------------------------------------ */
+/* API                                                                                        */
+/* ------------------------------------------------------------------------------------------ */
+
+void periph14_attach(periph14_t *p, sim14_t *sim, unsigned long fosc)
+{
+    static const uint16_t read_hooked[] = { TMR0, TMR1L, TMR1H, TMR2, SSPBUF, RCREG };
+    static const uint16_t write_hooked[] = {
+        TMR0, OPTION, TMR1L, TMR1H, T1CON, TMR2, T2CON, PR2, CCPR1L, CCPR1H, CCP1CON,
+        CCPR2L, CCPR2H, CCP2CON, SSPBUF, SSPCON, SSPCON2, RCSTA, TXREG, TXSTA, ADCON0,
+        EECON1, EECON2
+    };
+    unsigned i;
+
+    memset(p, 0, sizeof(*p));
+    p->sim = sim;
+    p->fosc = fosc ? fosc : DEFAULT_FOSC;
+    p->slave_xfer.kind = 0xFF;
+    sim->context = p;
+    sim->read_hook = read_hook;
+    sim->write_hook = write_hook;
+    sim->event = on_event;
+    for (i = 0; i < sizeof(write_hooked) / sizeof(write_hooked[0]); i++) {
+        sim14_hook(sim, write_hooked[i], 0, 1);
+    }
+    for (i = 0; i < sizeof(read_hooked) / sizeof(read_hooked[0]); i++) {
+        sim14_hook(sim, read_hooked[i], 1, 0);
+    }
+    for (i = 0; i < PERIPH14_PORTS; i++) {
+        sim14_hook(sim, (uint16_t)(PORTA + i), 1, 1);
+        sim14_hook(sim, (uint16_t)(TRISA + i), 0, 1);
+    }
+    periph14_reset(p);
+}
+
+void periph14_reset(periph14_t *p)
+{
+    int i;
+
+    sim14_reset(p->sim);
+    for (i = 0; i < PERIPH14_EVENTS; i++) {
+        p->due[i] = SIM14_NEVER;
+    }
+    p->asleep = 0;
+    p->frozen = 0;
+    memset(p->latch, 0, sizeof(p->latch));
+    memset(&p->t, 0, sizeof(p->t));
+    p->tx_busy = p->txreg_full = 0;
+    p->rx_count = 0;
+    p->ssp_busy = 0;
+    p->ssp_op = OP_NONE;
+    p->i2c_state = 0;
+    p->slave_xfer.kind = 0xFF;
+    p->slave_wait_ckp = 0;
+    p->ee_unlock = 0;
+    memcpy(p->eeprom, p->sim->eeprom, sizeof(p->eeprom));
+    memset(p->bytes, 0, sizeof(p->bytes));
+    p->rx_bytes = p->rx_overruns = p->conversions = p->ee_writes = p->events = 0;
+    for (i = 0; i < PERIPH14_PORTS; i++) {
+        p->pins[i] = port_level(p, (uint8_t)i);
+    }
+    p->rb_read = p->pins[PERIPH14_PORTB] & 0xF0;
+    stimulus_due(p);
+}
+
+void periph14_sync(periph14_t *p)
+{
+    uint64_t t = now(p);
+    uint16_t timer = tmr1_at(p, t);
+    int i;
+
+    R(TMR0) = tmr0_at(p, t);
+    R(TMR1L) = (uint8_t)timer;
+    R(TMR1H) = (uint8_t)(timer >> 8);
+    R(TMR2) = tmr2_at(p, t);
+    for (i = 0; i < PERIPH14_PORTS; i++) {
+        R(PORTA + i) = port_level(p, (uint8_t)i);
+    }
+}
+
+uint64_t periph14_cycles(const periph14_t *p, double seconds)
+{
+    return (uint64_t)(seconds * (double)p->fosc / 4.0 + 0.5);
+}
+
+int periph14_pin(periph14_t *p, uint64_t at, uint8_t port, uint8_t bit, uint8_t level)
+{
+    periph14_stimulus_t *s;
+
+    if (port >= PERIPH14_PORTS || bit > 7 || (s = stimulus_add(p, at, STIM_PIN)) == NULL) {
+        return 0;
+    }
+    s->port = port;
+    s->bit = bit;
+    s->level = level ? 1 : 0;
+    return 1;
+}
+
+int periph14_clock(periph14_t *p, uint64_t at, uint8_t port, uint8_t bit, double hz, uint32_t edges)
+{
+    periph14_stimulus_t *s;
+    uint64_t half = (uint64_t)((double)p->fosc / 8.0 / hz + 0.5);
+
+    if (port >= PERIPH14_PORTS || bit > 7 || hz <= 0.0 || (s = stimulus_add(p, at, STIM_CLOCK)) == NULL) {
+        return 0;
+    }
+    s->port = port;
+    s->bit = bit;
+    s->level = (p->input[port] >> bit & 1) ^ 1;
+    s->half_period = (uint32_t)(half ? half : 1);
+    s->edges = edges;
+    return 1;
+}
+
+int periph14_analog(periph14_t *p, uint64_t at, uint8_t channel, uint16_t millivolts)
+{
+    periph14_stimulus_t *s;
+
+    if (channel >= PERIPH14_ANALOG || (s = stimulus_add(p, at, STIM_ANALOG)) == NULL) {
+        return 0;
+    }
+    s->bit = channel;
+    s->offset = millivolts;
+    return 1;
+}
+
+static int data_stimulus(periph14_t *p, uint64_t at, uint8_t kind, const uint8_t *data, uint16_t length,
+                         uint8_t address, uint16_t read_count)
+{
+    periph14_stimulus_t *s;
+    uint16_t offset = 0;
+
+    if (p->stimulus_count == PERIPH14_STIMULI || !pool_add(p, data, length, &offset)) {
+        return 0;
+    }
+    s = stimulus_add(p, at, kind);
+    s->offset = offset;
+    s->length = length;
+    s->address = address;
+    s->read_count = read_count;
+    return 1;
+}
+
+int periph14_uart(periph14_t *p, uint64_t at, const uint8_t *data, uint16_t length)
+{
+    return data_stimulus(p, at, STIM_UART, data, length, 0, 0);
+}
+
+int periph14_spi(periph14_t *p, uint64_t at, const uint8_t *data, uint16_t length)
+{
+    return length && data_stimulus(p, at, STIM_SPI, data, length, 0, 0);
+}
+
+int periph14_i2c(periph14_t *p, uint64_t at, uint8_t address, const uint8_t *data, uint16_t length,
+                 uint16_t read_count)
+{
+    return data_stimulus(p, at, STIM_I2C, data, length, address, read_count);
+}
+
+int periph14_spi_reply(periph14_t *p, const uint8_t *data, uint16_t length)
+{
+    uint16_t i;
+
+    for (i = 0; i < length; i++) {
+        if ((uint8_t)(p->spi_in_head - p->spi_in_tail) == (uint8_t)(PERIPH14_RX_SIZE - 1)) {
+            return 0;
+        }
+        p->spi_in[p->spi_in_head++] = data[i];
+    }
+    return 1;
+}
+
+void periph14_i2c_device(periph14_t *p, uint8_t address)
+{
+    p->i2c_device = address;
+}
+
+int periph14_watch(periph14_t *p, uint16_t address)
+{
+    uint16_t c = p->sim->map[address & (SIM14_RAM_SIZE - 1)];
+
+    if (!sim14_hook(p->sim, c, 0, 1)) {
+        return 0;
+    }
+    p->watched[c >> 3] |= (uint8_t)(1u << (c & 7));
+    return 1;
+}
+
+/* ------------------------------------------------------------------------------------------ */
+/* Script                                                                                     */
+/* ------------------------------------------------------------------------------------------ */
+
+static int parse_time(const periph14_t *p, const char *s, uint64_t *at)
+{
+    char *end;
+    double value = strtod(s, &end);
+
+    if (end == s || value < 0.0) {
+        return 0;
+    }
+    if (strcmp(end, "c") == 0) {
+        *at = (uint64_t)value;
+        return 1;
+    }
+    if (strcmp(end, "ms") == 0) {
+        value /= 1e3;
+    } else if (strcmp(end, "us") == 0) {
+        value /= 1e6;
+    } else if (*end != '\0' && strcmp(end, "s") != 0) {
+        return 0;
+    }
+    *at = periph14_cycles(p, value);
+    return 1;
+}
+
+static int parse_pin(const char *s, uint8_t *port, uint8_t *bit)
+{
+    if (toupper((unsigned char)s[0]) != 'R' || toupper((unsigned char)s[1]) < 'A' ||
+        toupper((unsigned char)s[1]) > 'E' || s[2] < '0' || s[2] > '7' || s[3] != '\0') {
+        return 0;
+    }
+    *port = (uint8_t)(toupper((unsigned char)s[1]) - 'A');
+    *bit = (uint8_t)(s[2] - '0');
+    return 1;
+}
+
+// Hexadecimal bytes from the remaining tokens
+static int parse_bytes(char *rest, uint8_t *bytes, uint16_t size, uint16_t *count)
+{
+    char *tok;
+
+    *count = 0;
+    for (tok = strtok(rest, " \t\r\n"); tok != NULL; tok = strtok(NULL, " \t\r\n")) {
+        char *end;
+        unsigned long value = strtoul(tok, &end, 16);
+        if (*end != '\0' || value > 0xFF || *count == size) {
+            return 0;
+        }
+        bytes[(*count)++] = (uint8_t)value;
+    }
+    return 1;
+}
+
+// "text" with C escapes
+static int parse_string(const char *s, uint8_t *bytes, uint16_t size, uint16_t *count)
+{
+    *count = 0;
+    while (*s == ' ' || *s == '\t') {
+        s++;
+    }
+    if (*s++ != '"') {
+        return 0;
+    }
+    while (*s && *s != '"') {
+        uint8_t c = (uint8_t)*s++;
+        if (c == '\\') {
+            switch (*s++) {
+            case 'r': c = '\r'; break;
+            case 'n': c = '\n'; break;
+            case 't': c = '\t'; break;
+            case '\\': c = '\\'; break;
+            case '"': c = '"'; break;
+            case 'x': {
+                char hex[3] = { 0, 0, 0 };
+                if (!isxdigit((unsigned char)s[0]) || !isxdigit((unsigned char)s[1])) {
+                    return 0;
+                }
+                hex[0] = s[0];
+                hex[1] = s[1];
+                s += 2;
+                c = (uint8_t)strtoul(hex, NULL, 16);
+                break;
+            }
+            default:
+                return 0;
+            }
+        }
+        if (*count == size) {
+            return 0;
+        }
+        bytes[(*count)++] = c;
+    }
+    return *s == '"';
+}
+
+static const char *script_line(periph14_t *p, char *line)
+{
+    uint8_t bytes[256];
+    uint16_t count;
+    uint64_t at = 0;
+    uint8_t port, bit;
+    char *hash = strchr(line, '#');
+    char *first, *cmd, *arg, *rest;
+
+    if (hash && (strchr(line, '"') == NULL || hash < strchr(line, '"'))) {
+        *hash = '\0';
+    }
+    first = strtok(line, " \t\r\n");
+    if (first == NULL) {
+        return NULL;
+    }
+    if (strcmp(first, "i2c-device") == 0 || strcmp(first, "spi-reply") == 0) {
+        cmd = first;
+    } else {
+        if (!parse_time(p, first, &at)) {
+            return "bad time";
+        }
+        cmd = strtok(NULL, " \t\r\n");
+        if (cmd == NULL) {
+            return "missing command";
+        }
+    }
+    rest = strtok(NULL, "");
+
+    if (strcmp(cmd, "uart") == 0) {
+        if (rest == NULL || !parse_string(rest, bytes, sizeof(bytes), &count)) {
+            return "expected \"text\"";
+        }
+        return periph14_uart(p, at, bytes, count) ? NULL : "stimulus queue full";
+    }
+    if (strcmp(cmd, "spi") == 0 || strcmp(cmd, "spi-reply") == 0 || strcmp(cmd, "i2c-device") == 0) {
+        if (rest == NULL || !parse_bytes(rest, bytes, sizeof(bytes), &count) || count == 0) {
+            return "expected hexadecimal bytes";
+        }
+        if (cmd[0] == 'i') {
+            periph14_i2c_device(p, bytes[0]);
+            return NULL;
+        }
+        if (strcmp(cmd, "spi") == 0) {
+            return periph14_spi(p, at, bytes, count) ? NULL : "stimulus queue full";
+        }
+        return periph14_spi_reply(p, bytes, count) ? NULL : "reply buffer full";
+    }
+    if (strcmp(cmd, "i2c-write") == 0 || strcmp(cmd, "i2c-read") == 0) {
+        if (rest == NULL || !parse_bytes(rest, bytes, sizeof(bytes), &count) || count < 1) {
+            return "expected address and bytes";
+        }
+        if (cmd[4] == 'r') {
+            if (count != 2 || bytes[1] == 0) {
+                return "expected address and byte count";
+            }
+            // The count is decimal for readability
+            return periph14_i2c(p, at, bytes[0], NULL, 0, (uint16_t)strtoul(strrchr(rest, ' ') + 1, NULL, 10)) ?
+                   NULL : "stimulus queue full";
+        }
+        return periph14_i2c(p, at, bytes[0], bytes + 1, (uint16_t)(count - 1), 0) ? NULL : "stimulus queue full";
+    }
+
+    arg = rest ? strtok(rest, " \t\r\n") : NULL;
+    if (strcmp(cmd, "analog") == 0) {
+        char *volts = strtok(NULL, " \t\r\n");
+        if (arg == NULL || volts == NULL || toupper((unsigned char)arg[0]) != 'A' ||
+            toupper((unsigned char)arg[1]) != 'N' || arg[2] < '0' || arg[2] > '7') {
+            return "expected ANx volts";
+        }
+        return periph14_analog(p, at, (uint8_t)(arg[2] - '0'), (uint16_t)(strtod(volts, NULL) * 1000.0 + 0.5)) ?
+               NULL : "stimulus queue full";
+    }
+    if (arg == NULL || !parse_pin(arg, &port, &bit)) {
+        return "expected a pin (RA0..RE2)";
+    }
+    if (strcmp(cmd, "pin") == 0) {
+        char *level = strtok(NULL, " \t\r\n");
+        if (level == NULL || (strcmp(level, "0") != 0 && strcmp(level, "1") != 0)) {
+            return "expected 0 or 1";
+        }
+        return periph14_pin(p, at, port, bit, (uint8_t)(level[0] - '0')) ? NULL : "stimulus queue full";
+    }
+    if (strcmp(cmd, "clock") == 0) {
+        char *hz = strtok(NULL, " \t\r\n");
+        char *edges = strtok(NULL, " \t\r\n");
+        if (hz == NULL || strtod(hz, NULL) <= 0.0) {
+            return "expected a frequency in Hz";
+        }
+        return periph14_clock(p, at, port, bit, strtod(hz, NULL), edges ? (uint32_t)strtoul(edges, NULL, 0) : 0) ?
+               NULL : "stimulus queue full";
+    }
+    return "unknown command";
+}
+
+int periph14_load_script(periph14_t *p, const char *path, char *err, unsigned err_size)
+{
+    FILE *f = fopen(path, "r");
+    char line[LINE_SIZE];
+    unsigned line_no = 0;
+
+    if (f == NULL) {
+        snprintf(err, err_size, "%s: cannot open", path);
+        return -1;
+    }
+    while (fgets(line, sizeof(line), f) != NULL) {
+        const char *msg;
+        line_no++;
+        msg = script_line(p, line);
+        if (msg != NULL) {
+            snprintf(err, err_size, "%s:%u: %s", path, line_no, msg);
+            fclose(f);
+            return -1;
+        }
+    }
+    fclose(f);
+    return 0;
+}
@@ -0,0 +1,202 @@
+/* File:   periph14.h
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Peripheral models of the PIC16F877A for the instruction-set simulator (sim14.h):
+ * ports with RB0/INT and RB<7:4> change, Timer0, Timer1, Timer2, CCP1/CCP2 (capture,
+ * compare, PWM), the USART (asynchronous), the MSSP (SPI master/slave, I2C master with a
+ * register-file device, I2C slave driven by scripted transfers), the 10-bit ADC and the
+ * data EEPROM.
+ *
+ * The models are event-scheduled: a peripheral computes the cycle of its next visible
+ * change (an overflow, the end of a frame or a conversion, a stimulus) and the core calls
+ * back only then, so a peripheral that is off or idle costs nothing per instruction.
+ * Timer registers are computed from the cycle counter when the program reads them.
+ *
+ * External stimuli (pin levels and clocks, UART bytes, analog voltages, SPI/I2C transfers
+ * from an external master) are queued with the cycle they happen at, either through the
+ * functions below or from a script (periph14_load_script()). Output (port pins, bytes
+ * sent on the USART, SPI and I2C, writes to watched registers) is reported to an observer
+ * with its cycle.
+ */
+
+#ifndef PERIPH14_H
+#define PERIPH14_H
+
+#include <stdint.h>
+#include "sim14.h"
+
+#define PERIPH14_PORTS        5       // PORTA..PORTE
+#define PERIPH14_ANALOG       8       // AN0..AN7
+#define PERIPH14_STIMULI      64      // Pending stimulus entries
+#define PERIPH14_POOL_SIZE    4096    // Bytes of UART/SPI/I2C stimulus data
+#define PERIPH14_RX_SIZE      256     // Bytes waiting on the UART line
+#define PERIPH14_VDD_MV       5000    // ADC reference (Vref+ = VDD, Vref- = VSS)
+#define PERIPH14_EE_WRITE_US  4000    // Data EEPROM write time (datasheet TDEW, typical)
+#define PERIPH14_ADC_RC_US    4       // TAD with the internal RC clock (typical)
+#define PERIPH14_BUS_HZ       100000  // SCL/SCK rate of an external I2C or SPI master
+
+// Ports
+enum { PERIPH14_PORTA, PERIPH14_PORTB, PERIPH14_PORTC, PERIPH14_PORTD, PERIPH14_PORTE };
+
+// Serial output channels reported to the observer
+typedef enum {
+    PERIPH14_UART_TX,       // Frame shifted out by the USART
+    PERIPH14_SPI_OUT,       // Byte shifted out on SDO (master or slave)
+    PERIPH14_SPI_IN,        // Byte received on SDI
+    PERIPH14_I2C_OUT,       // Byte the PIC drove on SDA (master address/data, slave data)
+    PERIPH14_I2C_IN,        // Byte the PIC received
+    PERIPH14_CHANNELS
+} periph14_channel_t;
+
+typedef struct {
+    // Port pin levels after a change; 'level' holds all pins of the port
+    void (*pin)(void *ctx, uint64_t cycle, uint8_t port, uint8_t level);
+    void (*serial)(void *ctx, uint64_t cycle, uint8_t channel, uint8_t byte);
+    // Program write to a register passed to periph14_watch() (canonical address, value stored)
+    void (*reg)(void *ctx, uint64_t cycle, uint16_t address, uint8_t value);
+    void *ctx;
+} periph14_observer_t;
+
+// Scheduled events
+enum {
+    PERIPH14_EV_TMR0, PERIPH14_EV_TMR1, PERIPH14_EV_CCP1, PERIPH14_EV_CCP2,
+    PERIPH14_EV_TMR2, PERIPH14_EV_PWM1, PERIPH14_EV_PWM2,
+    PERIPH14_EV_TX, PERIPH14_EV_RX, PERIPH14_EV_SSP, PERIPH14_EV_ADC, PERIPH14_EV_EE,
+    PERIPH14_EV_STIM,
+    PERIPH14_EVENTS
+};
+
+typedef struct {
+    uint64_t at;
+    uint8_t kind;
+    uint8_t port, bit, level;
+    uint32_t half_period;       // Clock stimulus: cycles between edges
+    uint32_t edges;             // Clock stimulus: edges left
+    uint16_t offset, length;    // Data in pool[]
+    uint8_t address;            // I2C transfer: 7-bit address
+    uint16_t read_count;        // I2C transfer: bytes the master reads
+} periph14_stimulus_t;
+
+typedef struct {
+    uint64_t tmr0_base;
+    uint8_t tmr0_value;         // TMR0 at tmr0_base (timer mode)
+    uint8_t tmr0_edges;         // Prescaler count (counter mode)
+    uint64_t tmr1_base;
+    uint16_t tmr1_value;        // TMR1 at tmr1_base
+    uint8_t tmr1_edges;
+    uint64_t tmr2_base;
+    uint8_t tmr2_value;
+    uint8_t tmr2_post;          // Period matches counted by the postscaler
+    uint8_t ccp_edges[2];       // Capture prescaler counts
+    uint8_t ccp_pin[2];         // Compare/PWM output level
+    uint16_t pwm_duty[2];       // Duty latched at the start of the PWM period
+    uint8_t pwm_high[2];        // 1 while the next PWM event is the falling edge
+} periph14_timers_t;
+
+typedef struct {
+    sim14_t *sim;
+    unsigned long fosc;
+    periph14_observer_t observer;
+    uint8_t watched[SIM14_RAM_SIZE / 8];    // Registers whose writes go to observer.reg
+
+    uint64_t due[PERIPH14_EVENTS];
+    uint16_t frozen;            // Events stopped during SLEEP (Fosc-clocked peripherals)
+    uint64_t sleep_at;
+    uint8_t asleep;
+
+    // Ports
+    uint8_t latch[PERIPH14_PORTS];
+    uint8_t input[PERIPH14_PORTS];      // External levels
+    uint8_t pins[PERIPH14_PORTS];       // Last level reported to the observer
+    uint8_t rb_read;                    // RB<7:4> at the last PORTB read (RBIF mismatch)
+
+    periph14_timers_t t;
+
+    // USART
+    uint8_t tsr, txreg;
+    uint8_t tx_busy, txreg_full;
+    uint8_t rx_line[PERIPH14_RX_SIZE];  // Bytes the external device still has to send
+    uint8_t rx_head, rx_tail;
+    uint8_t rx_fifo[2], rx_count;
+
+    // MSSP
+    uint8_t ssp_out;                    // Byte being shifted out
+    uint8_t ssp_busy;
+    uint8_t ssp_op;                     // I2C master operation in progress
+    uint8_t spi_in[PERIPH14_RX_SIZE];   // SDI bytes for the SPI master, 0xFF when empty
+    uint8_t spi_in_head, spi_in_tail;
+    uint8_t i2c_device;                 // Register-file device address, 0 = none
+    uint8_t i2c_regs[256];
+    uint8_t i2c_pointer;
+    uint8_t i2c_state;                  // Device: 0 idle, 1 addressed (write), 2 write pointer set, 3 read
+    uint16_t slave_step;
+    uint8_t slave_wait_ckp;
+
+    // ADC and EEPROM
+    uint16_t analog_mv[PERIPH14_ANALOG];
+    uint8_t eeprom[SIM14_EEPROM_SIZE];
+    uint8_t ee_unlock;
+
+    // Stimuli
+    periph14_stimulus_t stimuli[PERIPH14_STIMULI];
+    uint8_t stimulus_count;
+    uint8_t pool[PERIPH14_POOL_SIZE];
+    uint16_t pool_used;
+    periph14_stimulus_t slave_xfer;     // SPI/I2C slave transfer in progress, kind 0xFF = none
+
+    // Statistics
+    uint32_t bytes[PERIPH14_CHANNELS];
+    uint32_t rx_bytes, rx_overruns;
+    uint32_t conversions, ee_writes;
+    uint32_t events;                    // Event callbacks from the core
+} periph14_t;
+
+// Attach the models to a simulator (which keeps its program image) and reset both
+void periph14_attach(periph14_t *p, sim14_t *sim, unsigned long fosc);
+
+// Power-on reset of the core and the peripherals; stimuli and the observer are kept,
+// the data EEPROM is reloaded from the HEX image
+void periph14_reset(periph14_t *p);
+
+// Store the lazily computed timer and port values in the register file (for sim14_peek)
+void periph14_sync(periph14_t *p);
+
+// Cycles for a time in seconds at the configured Fosc
+uint64_t periph14_cycles(const periph14_t *p, double seconds);
+
+// Stimuli; 'at' is an absolute cycle. Functions return 0 when the queue or pool is full.
+int periph14_pin(periph14_t *p, uint64_t at, uint8_t port, uint8_t bit, uint8_t level);
+int periph14_clock(periph14_t *p, uint64_t at, uint8_t port, uint8_t bit, double hz, uint32_t edges);
+int periph14_analog(periph14_t *p, uint64_t at, uint8_t channel, uint16_t millivolts);
+int periph14_uart(periph14_t *p, uint64_t at, const uint8_t *data, uint16_t length);
+int periph14_spi(periph14_t *p, uint64_t at, const uint8_t *data, uint16_t length);
+int periph14_i2c(periph14_t *p, uint64_t at, uint8_t address, const uint8_t *data, uint16_t length,
+                 uint16_t read_count);
+
+// SDI bytes returned to the SPI master, in order
+int periph14_spi_reply(periph14_t *p, const uint8_t *data, uint16_t length);
+
+// Register-file I2C device seen by the I2C master (first written byte sets the pointer)
+void periph14_i2c_device(periph14_t *p, uint8_t address);
+
+// Report every program write of a register or RAM location (any mirror) to observer.reg;
+// returns 0 for the core registers (INDF, PCL, STATUS, INTCON, PIR, PIE)
+int periph14_watch(periph14_t *p, uint16_t address);
+
+// Read a stimulus script; returns 0, or -1 with "path:line: message" in err.
+// Each line is "<time> <command> <arguments>"; time is in seconds, or with a unit
+// (10ms, 250us, 1200c for cycles):
+//   <t> pin RB0 1              external level
+//   <t> clock RA4 1000 [edges] square wave in Hz, 'edges' edges (default: no end)
+//   <t> analog AN0 2.5         volts
+//   <t> uart "text\r\n"        bytes sent to RX (\r \n \t \\ \" \xNN escapes)
+//   <t> spi 12 34              bytes clocked in by an external SPI master
+//   <t> i2c-write 20 04 11 22  external I2C master writes bytes to address 0x20
+//   <t> i2c-read 20 3          external I2C master reads 3 bytes from address 0x20
+//   i2c-device 50              register-file slave for the I2C master
+//   spi-reply A5 5A            SDI bytes for the SPI master
+// Bytes are hexadecimal. '#' starts a comment.
+int periph14_load_script(periph14_t *p, const char *path, char *err, unsigned err_size);
+
+#endif /* PERIPH14_H */
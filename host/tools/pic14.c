@@ -0,0 +1,305 @@
+/* File:   pic14.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * 14-bit mid-range instruction decoder (PIC16F87XA datasheet, Table 15-2) and the
+ * register names shared by the host tools.
+ */
+
+#include <ctype.h>
+#include <dirent.h>
+#include <stdio.h>
+#include <string.h>
+#include "pic14.h"
+
+#define PATH_SIZE 1024
+
+// Table 2-1 of the datasheet, in address order
+static const pic14_sfr_t sfrs[] = {
+    { 0x000, "INDF",       { 0, 0, 0, 0, 0, 0, 0, 0 } },
+    { 0x001, "TMR0",       { 0, 0, 0, 0, 0, 0, 0, 0 } },
+    { 0x002, "PCL",        { 0, 0, 0, 0, 0, 0, 0, 0 } },
+    { 0x003, "STATUS",     { "C", "DC", "Z", "nPD", "nTO", "RP0", "RP1", "IRP" } },
+    { 0x004, "FSR",        { 0, 0, 0, 0, 0, 0, 0, 0 } },
+    { 0x005, "PORTA",      { "RA0", "RA1", "RA2", "RA3", "RA4", "RA5", 0, 0 } },
+    { 0x006, "PORTB",      { "RB0", "RB1", "RB2", "RB3", "RB4", "RB5", "RB6", "RB7" } },
+    { 0x007, "PORTC",      { "RC0", "RC1", "RC2", "RC3", "RC4", "RC5", "RC6", "RC7" } },
+    { 0x008, "PORTD",      { "RD0", "RD1", "RD2", "RD3", "RD4", "RD5", "RD6", "RD7" } },
+    { 0x009, "PORTE",      { "RE0", "RE1", "RE2", 0, 0, 0, 0, 0 } },
+    { 0x00A, "PCLATH",     { 0, 0, 0, 0, 0, 0, 0, 0 } },
+    { 0x00B, "INTCON",     { "RBIF", "INTF", "TMR0IF", "RBIE", "INTE", "TMR0IE", "PEIE", "GIE" } },
+    { 0x00C, "PIR1",       { "TMR1IF", "TMR2IF", "CCP1IF", "SSPIF", "TXIF", "RCIF", "ADIF", "PSPIF" } },
+    { 0x00D, "PIR2",       { "CCP2IF", 0, 0, "BCLIF", "EEIF", 0, "CMIF", 0 } },
+    { 0x00E, "TMR1L",      { 0, 0, 0, 0, 0, 0, 0, 0 } },
+    { 0x00F, "TMR1H",      { 0, 0, 0, 0, 0, 0, 0, 0 } },
+    { 0x010, "T1CON",      { "TMR1ON", "TMR1CS", "nT1SYNC", "T1OSCEN", "T1CKPS0", "T1CKPS1", 0, 0 } },
+    { 0x011, "TMR2",       { 0, 0, 0, 0, 0, 0, 0, 0 } },
+    { 0x012, "T2CON",      { "T2CKPS0", "T2CKPS1", "TMR2ON", "TOUTPS0", "TOUTPS1", "TOUTPS2", "TOUTPS3", 0 } },
+    { 0x013, "SSPBUF",     { 0, 0, 0, 0, 0, 0, 0, 0 } },
+    { 0x014, "SSPCON",     { "SSPM0", "SSPM1", "SSPM2", "SSPM3", "CKP", "SSPEN", "SSPOV", "WCOL" } },
+    { 0x015, "CCPR1L",     { 0, 0, 0, 0, 0, 0, 0, 0 } },
+    { 0x016, "CCPR1H",     { 0, 0, 0, 0, 0, 0, 0, 0 } },
+    { 0x017, "CCP1CON",    { "CCP1M0", "CCP1M1", "CCP1M2", "CCP1M3", "CCP1Y", "CCP1X", 0, 0 } },
+    { 0x018, "RCSTA",      { "RX9D", "OERR", "FERR", "ADDEN", "CREN", "SREN", "RX9", "SPEN" } },
+    { 0x019, "TXREG",      { 0, 0, 0, 0, 0, 0, 0, 0 } },
+    { 0x01A, "RCREG",      { 0, 0, 0, 0, 0, 0, 0, 0 } },
+    { 0x01B, "CCPR2L",     { 0, 0, 0, 0, 0, 0, 0, 0 } },
+    { 0x01C, "CCPR2H",     { 0, 0, 0, 0, 0, 0, 0, 0 } },
+    { 0x01D, "CCP2CON",    { "CCP2M0", "CCP2M1", "CCP2M2", "CCP2M3", "CCP2Y", "CCP2X", 0, 0 } },
+    { 0x01E, "ADRESH",     { 0, 0, 0, 0, 0, 0, 0, 0 } },
+    { 0x01F, "ADCON0",     { "ADON", 0, "GO_nDONE", 0, 0, 0, 0, 0 } },
+    { 0x081, "OPTION_REG", { "PS0", "PS1", "PS2", "PSA", "T0SE", "T0CS", "INTEDG", "nRBPU" } },
+    { 0x085, "TRISA",      { "TRISA0", "TRISA1", "TRISA2", "TRISA3", "TRISA4", "TRISA5", 0, 0 } },
+    { 0x086, "TRISB",      { "TRISB0", "TRISB1", "TRISB2", "TRISB3", "TRISB4", "TRISB5", "TRISB6", "TRISB7" } },
+    { 0x087, "TRISC",      { "TRISC0", "TRISC1", "TRISC2", "TRISC3", "TRISC4", "TRISC5", "TRISC6", "TRISC7" } },
+    { 0x088, "TRISD",      { "TRISD0", "TRISD1", "TRISD2", "TRISD3", "TRISD4", "TRISD5", "TRISD6", "TRISD7" } },
+    { 0x089, "TRISE",      { "TRISE0", "TRISE1", "TRISE2", 0, "PSPMODE", "IBOV", "OBF", "IBF" } },
+    { 0x08C, "PIE1",       { "TMR1IE", "TMR2IE", "CCP1IE", "SSPIE", "TXIE", "RCIE", "ADIE", "PSPIE" } },
+    { 0x08D, "PIE2",       { "CCP2IE", 0, 0, "BCLIE", "EEIE", 0, "CMIE", 0 } },
+    { 0x08E, "PCON",       { "nBOR", "nPOR", 0, 0, 0, 0, 0, 0 } },
+    { 0x091, "SSPCON2",    { "SEN", "RSEN", "PEN", "RCEN", "ACKEN", "ACKDT", "ACKSTAT", "GCEN" } },
+    { 0x092, "PR2",        { 0, 0, 0, 0, 0, 0, 0, 0 } },
+    { 0x093, "SSPADD",     { 0, 0, 0, 0, 0, 0, 0, 0 } },
+    { 0x094, "SSPSTAT",    { "BF", "UA", "R_nW", "S", "P", "D_nA", "CKE", "SMP" } },
+    { 0x098, "TXSTA",      { "TX9D", "TRMT", "BRGH", 0, "SYNC", "TXEN", "TX9", "CSRC" } },
+    { 0x099, "SPBRG",      { 0, 0, 0, 0, 0, 0, 0, 0 } },
+    { 0x09C, "CMCON",      { "CM0", "CM1", "CM2", "CIS", "C1INV", "C2INV", "C1OUT", "C2OUT" } },
+    { 0x09D, "CVRCON",     { "CVR0", "CVR1", "CVR2", "CVR3", 0, "CVRR", "CVROE", "CVREN" } },
+    { 0x09E, "ADRESL",     { 0, 0, 0, 0, 0, 0, 0, 0 } },
+    { 0x09F, "ADCON1",     { "PCFG0", "PCFG1", "PCFG2", "PCFG3", 0, 0, "ADCS2", "ADFM" } },
+    { 0x10C, "EEDATA",     { 0, 0, 0, 0, 0, 0, 0, 0 } },
+    { 0x10D, "EEADR",      { 0, 0, 0, 0, 0, 0, 0, 0 } },
+    { 0x10E, "EEDATH",     { 0, 0, 0, 0, 0, 0, 0, 0 } },
+    { 0x10F, "EEADRH",     { 0, 0, 0, 0, 0, 0, 0, 0 } },
+    { 0x18C, "EECON1",     { "RD", "WR", "WREN", "WRERR", 0, 0, 0, "EEPGD" } },
+    { 0x18D, "EECON2",     { 0, 0, 0, 0, 0, 0, 0, 0 } },
+};
+#define SFR_COUNT (sizeof(sfrs) / sizeof(sfrs[0]))
+
+static const char *const mnemonics[PIC14_OP_COUNT] = {
+    "addwf", "andwf", "clrf",  "clrw",   "comf",  "decf",
+    "decfsz", "incf", "incfsz", "iorwf", "movf",  "movwf",
+    "nop",   "rlf",   "rrf",   "subwf",  "swapf", "xorwf",
+    "bcf",   "bsf",   "btfsc", "btfss",
+    "addlw", "andlw", "call",  "clrwdt", "goto",  "iorlw",
+    "movlw", "retfie", "retlw", "return", "sleep", "sublw",
+    "xorlw", "option", "tris",
+    "???"
+};
+
+// Byte-oriented file register operations, indexed by bits 11..8
+static const uint8_t byte_ops[16] = {
+    PIC14_MOVWF, PIC14_CLRF, PIC14_SUBWF, PIC14_DECF,
+    PIC14_IORWF, PIC14_ANDWF, PIC14_XORWF, PIC14_ADDWF,
+    PIC14_MOVF, PIC14_COMF, PIC14_INCF, PIC14_DECFSZ,
+    PIC14_RRF, PIC14_RLF, PIC14_SWAPF, PIC14_INCFSZ
+};
+
+void pic14_decode(uint16_t word, pic14_insn_t *insn)
+{
+    uint8_t group = (word >> 12) & 0x03;
+
+    insn->op = PIC14_INVALID;
+    insn->f = word & 0x7F;
+    insn->d = (word >> 7) & 0x01;
+    insn->b = (word >> 7) & 0x07;
+    insn->k = word & 0xFF;
+
+    switch (group) {
+    case 0:
+        if ((word & 0x0F00) == 0x0000) {
+            if (word & 0x0080) {
+                insn->op = PIC14_MOVWF;
+                insn->d = 1;
+            } else if ((word & 0x009F) == 0x0000) {
+                insn->op = PIC14_NOP;
+            } else if (word == 0x0008) {
+                insn->op = PIC14_RETURN;
+            } else if (word == 0x0009) {
+                insn->op = PIC14_RETFIE;
+            } else if (word == 0x0062) {
+                insn->op = PIC14_OPTION;
+            } else if (word == 0x0063) {
+                insn->op = PIC14_SLEEP;
+            } else if (word == 0x0064) {
+                insn->op = PIC14_CLRWDT;
+            } else if (word >= 0x0065 && word <= 0x0067) {
+                insn->op = PIC14_TRIS;
+                insn->f = word & 0x07;
+            }
+        } else if ((word & 0x0F00) == 0x0100) {
+            insn->op = (word & 0x0080) ? PIC14_CLRF : PIC14_CLRW;
+            insn->d = (word & 0x0080) ? 1 : 0;
+        } else {
+            insn->op = byte_ops[(word >> 8) & 0x0F];
+        }
+        break;
+    case 1:
+        insn->op = PIC14_BCF + ((word >> 10) & 0x03);
+        break;
+    case 2:
+        insn->op = (word & 0x0800) ? PIC14_GOTO : PIC14_CALL;
+        insn->k = word & 0x07FF;
+        break;
+    default:
+        switch ((word >> 8) & 0x0F) {
+        case 0x0: case 0x1: case 0x2: case 0x3: insn->op = PIC14_MOVLW; break;
+        case 0x4: case 0x5: case 0x6: case 0x7: insn->op = PIC14_RETLW; break;
+        case 0x8: insn->op = PIC14_IORLW; break;
+        case 0x9: insn->op = PIC14_ANDLW; break;
+        case 0xA: insn->op = PIC14_XORLW; break;
+        case 0xC: case 0xD: insn->op = PIC14_SUBLW; break;
+        case 0xE: case 0xF: insn->op = PIC14_ADDLW; break;
+        default: break;
+        }
+        break;
+    }
+}
+
+const char *pic14_mnemonic(uint8_t op)
+{
+    return op < PIC14_OP_COUNT ? mnemonics[op] : mnemonics[PIC14_INVALID];
+}
+
+char *pic14_disassemble(const pic14_insn_t *insn, char *buf, unsigned size)
+{
+    const char *m = pic14_mnemonic(insn->op);
+
+    switch (insn->op) {
+    case PIC14_MOVWF: case PIC14_CLRF: case PIC14_TRIS:
+        snprintf(buf, size, "%s\t0x%02X", m, insn->f);
+        break;
+    case PIC14_BCF: case PIC14_BSF: case PIC14_BTFSC: case PIC14_BTFSS:
+        snprintf(buf, size, "%s\t0x%02X,%u", m, insn->f, insn->b);
+        break;
+    case PIC14_CALL: case PIC14_GOTO:
+        snprintf(buf, size, "%s\t0x%03X", m, insn->k);
+        break;
+    case PIC14_ADDLW: case PIC14_ANDLW: case PIC14_IORLW: case PIC14_MOVLW:
+    case PIC14_RETLW: case PIC14_SUBLW: case PIC14_XORLW:
+        snprintf(buf, size, "%s\t0x%02X", m, insn->k);
+        break;
+    case PIC14_NOP: case PIC14_CLRW: case PIC14_CLRWDT: case PIC14_RETFIE:
+    case PIC14_RETURN: case PIC14_SLEEP: case PIC14_OPTION: case PIC14_INVALID:
+        snprintf(buf, size, "%s", m);
+        break;
+    default:
+        snprintf(buf, size, "%s\t0x%02X,%c", m, insn->f, insn->d ? 'f' : 'w');
+        break;
+    }
+    return buf;
+}
+
+int pic14_is_skip(uint8_t op)
+{
+    return op == PIC14_BTFSC || op == PIC14_BTFSS || op == PIC14_DECFSZ || op == PIC14_INCFSZ;
+}
+
+int pic14_writes_file(const pic14_insn_t *insn)
+{
+    switch (insn->op) {
+    case PIC14_MOVWF: case PIC14_CLRF: case PIC14_BCF: case PIC14_BSF:
+        return 1;
+    case PIC14_ADDWF: case PIC14_ANDWF: case PIC14_COMF: case PIC14_DECF:
+    case PIC14_DECFSZ: case PIC14_INCF: case PIC14_INCFSZ: case PIC14_IORWF:
+    case PIC14_MOVF: case PIC14_RLF: case PIC14_RRF: case PIC14_SUBWF:
+    case PIC14_SWAPF: case PIC14_XORWF:
+        return insn->d;
+    default:
+        return 0;
+    }
+}
+
+unsigned pic14_cycles(const pic14_insn_t *insn)
+{
+    switch (insn->op) {
+    case PIC14_CALL: case PIC14_GOTO: case PIC14_RETURN: case PIC14_RETLW: case PIC14_RETFIE:
+        return 2;
+    default:
+        // Writing PCL is a computed jump and flushes the pipeline
+        return (pic14_writes_file(insn) && insn->f == PIC14_PCL) ? 2 : 1;
+    }
+}
+
+unsigned long pic14_project_fosc(const char *artifact)
+{
+    char dir[PATH_SIZE];
+    char *slash;
+    int i;
+    DIR *d;
+    struct dirent *e;
+    unsigned long fosc = 0;
+
+    snprintf(dir, sizeof(dir), "%s", artifact);
+    for (i = 0; i < 4; i++) {
+        slash = strrchr(dir, '/');
+        if (slash == NULL) {
+            if (i < 3) {
+                return 0;
+            }
+            strcpy(dir, ".");
+            break;
+        }
+        *slash = '\0';
+    }
+    if (dir[0] == '\0') {
+        strcpy(dir, "/");
+    }
+
+    d = opendir(dir);
+    if (d == NULL) {
+        return 0;
+    }
+    while (fosc == 0 && (e = readdir(d)) != NULL) {
+        size_t len = strlen(e->d_name);
+        char path[PATH_SIZE * 2], line[PATH_SIZE];
+        FILE *f;
+        if (len < 3 || (strcmp(e->d_name + len - 2, ".c") != 0 && strcmp(e->d_name + len - 2, ".h") != 0)) {
+            continue;
+        }
+        snprintf(path, sizeof(path), "%s/%s", dir, e->d_name);
+        f = fopen(path, "r");
+        if (f == NULL) {
+            continue;
+        }
+        while (fgets(line, sizeof(line), f) != NULL) {
+            char *s = line;
+            while (*s == ' ' || *s == '\t') {
+                s++;
+            }
+            if (sscanf(s, "#define _XTAL_FREQ %lu", &fosc) == 1) {
+                break;
+            }
+            fosc = 0;
+        }
+        fclose(f);
+    }
+    closedir(d);
+    return fosc;
+}
+
+const pic14_sfr_t *pic14_sfr_at(uint16_t address)
+{
+    size_t i;
+
+    for (i = 0; i < SFR_COUNT; i++) {
+        if (sfrs[i].address == address) {
+            return &sfrs[i];
+        }
+    }
+    return NULL;
+}
+
+const pic14_sfr_t *pic14_sfr_named(const char *name)
+{
+    size_t i, j;
+
+    for (i = 0; i < SFR_COUNT; i++) {
+        for (j = 0; name[j] != '\0' && toupper((unsigned char)name[j]) == sfrs[i].name[j]; j++) {
+        }
+        if (name[j] == '\0' && sfrs[i].name[j] == '\0') {
+            return &sfrs[i];
+        }
+    }
+    return NULL;
+}
@@ -0,0 +1,81 @@
+/* File:   pic14.h
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Decoder for the 35-instruction, 14-bit PIC16 mid-range core (PIC16F877A).
+ * Shared by the host tools that work on XC8 listings and HEX images.
+ */
+
+#ifndef PIC14_H
+#define PIC14_H
+
+#include <stdint.h>
+
+#define PIC14_PROGRAM_WORDS 0x2000  // 8K words of program memory
+#define PIC14_STACK_LEVELS  8       // Hardware return-address stack
+#define PIC14_RESET_VECTOR  0x0000
+#define PIC14_INT_VECTOR    0x0004
+
+// SFR addresses used by the tools (7-bit, any bank)
+#define PIC14_INDF   0x00
+#define PIC14_PCL    0x02
+#define PIC14_STATUS 0x03
+#define PIC14_FSR    0x04
+#define PIC14_PCLATH 0x0A
+#define PIC14_INTCON 0x0B
+
+typedef enum {
+    PIC14_ADDWF, PIC14_ANDWF, PIC14_CLRF,  PIC14_CLRW,   PIC14_COMF,  PIC14_DECF,
+    PIC14_DECFSZ, PIC14_INCF, PIC14_INCFSZ, PIC14_IORWF, PIC14_MOVF,  PIC14_MOVWF,
+    PIC14_NOP,   PIC14_RLF,   PIC14_RRF,   PIC14_SUBWF,  PIC14_SWAPF, PIC14_XORWF,
+    PIC14_BCF,   PIC14_BSF,   PIC14_BTFSC, PIC14_BTFSS,
+    PIC14_ADDLW, PIC14_ANDLW, PIC14_CALL,  PIC14_CLRWDT, PIC14_GOTO,  PIC14_IORLW,
+    PIC14_MOVLW, PIC14_RETFIE, PIC14_RETLW, PIC14_RETURN, PIC14_SLEEP, PIC14_SUBLW,
+    PIC14_XORLW, PIC14_OPTION, PIC14_TRIS,
+    PIC14_INVALID,
+    PIC14_OP_COUNT
+} pic14_op_t;
+
+typedef struct {
+    uint8_t  op;    // pic14_op_t
+    uint8_t  f;     // File register (7 bits, bank-relative)
+    uint8_t  d;     // Destination: 0 = W, 1 = f
+    uint8_t  b;     // Bit number for BCF/BSF/BTFSC/BTFSS
+    uint16_t k;     // Literal (8 bits) or CALL/GOTO address (11 bits)
+} pic14_insn_t;
+
+// PIC16F877A register names and bit names (bank 0..3 addresses)
+typedef struct {
+    uint16_t address;
+    const char *name;
+    const char *bits[8];
+} pic14_sfr_t;
+
+// Decode one 14-bit program word
+void pic14_decode(uint16_t word, pic14_insn_t *insn);
+
+// Lower-case mnemonic ("movwf", "btfss", ...)
+const char *pic14_mnemonic(uint8_t op);
+
+// Format "mnemonic operands" into buf; returns buf
+char *pic14_disassemble(const pic14_insn_t *insn, char *buf, unsigned size);
+
+// 1 for BTFSC/BTFSS/DECFSZ/INCFSZ
+int pic14_is_skip(uint8_t op);
+
+// 1 if the instruction writes its result to file register f
+int pic14_writes_file(const pic14_insn_t *insn);
+
+// Instruction cycles when no skip/branch is taken (2 for CALL/GOTO/RETURN/RETLW/RETFIE
+// and for any instruction that writes PCL)
+unsigned pic14_cycles(const pic14_insn_t *insn);
+
+// _XTAL_FREQ from the sources of the project that produced
+// <project>/dist/default/production/<artifact> (listing, HEX, map...); 0 if not found
+unsigned long pic14_project_fosc(const char *artifact);
+
+// Register at a banked address (0x000-0x1FF, no mirror lookup) or named (case-insensitive)
+const pic14_sfr_t *pic14_sfr_at(uint16_t address);
+const pic14_sfr_t *pic14_sfr_named(const char *name);
+
+#endif /* PIC14_H */
@@ -0,0 +1,207 @@
+/* File:   picsim.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Command-line runner for the PIC16F877A simulator (sim14.c with the periph14.c peripheral
+ * models): loads the HEX image of a project
+ * (<project>.X/dist/default/production/<project>.X.production.hex), runs it for a number
+ * of instruction cycles and reports why it stopped, the cycle and instruction counts, the
+ * interrupts taken, the return stack depth, the pin changes and serial bytes per peripheral
+ * with their throughput, and the simulation speed.
+ *
+ * Usage: picsim [-f fosc_hz] [-c cycles | -t seconds] [-s script] [-e]
+ *               [-v trace.vcd] [-u uart.txt] [-w REG]... [-m SIGNAL]... image.hex...
+ * Without -f, _XTAL_FREQ is read from the project sources next to the image.
+ * -s plays a stimulus script (periph14.h) into every image, -e echoes the USART output.
+ * -v writes a VCD of the pins, of the registers given with -w and of the serial bytes,
+ * -u the USART output as timestamped text lines (trace14.h); both take a single image.
+ * -m measures the period and jitter of a pin (RC4) or the write interval of a register
+ * (PORTB), with a histogram.
+ * The exit status is 1 when an image executes an invalid or unprogrammed word or
+ * overflows the 8-level stack, 2 on a usage or load error.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "trace14.h"
+
+#define DEFAULT_CYCLES 10000000ULL
+
+static const char *const stop_reasons[] = {
+    "cycle limit", "halted (goto $ with GIE = 0)", "asleep, no wake-up source", "invalid opcode"
+};
+
+typedef struct {
+    unsigned long fosc;
+    uint64_t cycles;
+    double seconds;
+    const char *script;
+    int echo;
+    const char *vcd, *uart;             // Trace files (single image)
+    const char *watch[TRACE14_REGS];
+    unsigned watch_count;
+    const char *measure[TRACE14_MEASURES];
+    unsigned measure_count;
+} options_t;
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static int simulate(const char *path, const options_t *opt)
+{
+    static sim14_t sim;
+    static periph14_t periph;
+    static trace14_t trace;
+    unsigned long fosc = opt->fosc;
+    uint64_t cycles = opt->cycles;
+    char err[256];
+    sim14_stop_t stop;
+    double start, host;
+    unsigned i;
+
+    sim14_init(&sim);
+    if (sim14_load_hex(&sim, path, err, sizeof(err)) != 0) {
+        fprintf(stderr, "picsim: %s\n", err);
+        return 2;
+    }
+    if (fosc == 0) {
+        fosc = pic14_project_fosc(path);
+    }
+    periph14_attach(&periph, &sim, fosc);
+    trace14_free(&trace);
+    trace14_init(&trace, &periph);
+    trace.echo = opt->echo;
+    for (i = 0; i < opt->watch_count; i++) {
+        if (trace14_watch(&trace, opt->watch[i], err, sizeof(err)) != 0) {
+            fprintf(stderr, "picsim: -w %s\n", err);
+            return 2;
+        }
+    }
+    for (i = 0; i < opt->measure_count; i++) {
+        if (trace14_measure(&trace, opt->measure[i], err, sizeof(err)) != 0) {
+            fprintf(stderr, "picsim: -m %s\n", err);
+            return 2;
+        }
+    }
+    if (opt->script != NULL && periph14_load_script(&periph, opt->script, err, sizeof(err)) != 0) {
+        fprintf(stderr, "picsim: %s\n", err);
+        return 2;
+    }
+    if (opt->seconds > 0.0) {
+        if (fosc == 0) {
+            fprintf(stderr, "picsim: %s: -t needs the oscillator frequency (-f)\n", path);
+            return 2;
+        }
+        cycles = (uint64_t)(opt->seconds * (double)fosc / 4.0);
+    }
+    if (opt->vcd != NULL && trace14_open_vcd(&trace, opt->vcd) != 0) {
+        fprintf(stderr, "picsim: cannot create %s\n", opt->vcd);
+        return 2;
+    }
+    if (opt->uart != NULL && trace14_open_uart(&trace, opt->uart) != 0) {
+        fprintf(stderr, "picsim: cannot create %s\n", opt->uart);
+        trace14_finish(&trace, sim.cycles);
+        return 2;
+    }
+    trace14_start(&trace, path);
+
+    printf("== %s\n", path);
+    if (fosc) {
+        printf("Fosc %lu Hz, Tcy %.3f us\n", fosc, 4.0e6 / (double)fosc);
+    } else {
+        printf("Fosc unknown, peripherals assume %lu Hz (-f to set)\n", periph.fosc);
+    }
+    fflush(stdout);
+    start = now();
+    stop = sim14_run(&sim, cycles);
+    host = now() - start;
+    periph14_sync(&periph);
+    trace14_finish(&trace, sim.cycles);
+    if (opt->echo && periph.bytes[PERIPH14_UART_TX]) {
+        printf("\n");
+    }
+
+    printf("Stopped: %s at PC 0x%04X\n", stop_reasons[stop], sim.pc);
+    printf("Cycles %llu", (unsigned long long)sim.cycles);
+    if (fosc) {
+        printf(" (%.6f s)", (double)sim.cycles * 4.0 / (double)fosc);
+    }
+    printf(", instructions %llu, interrupts %lu\n",
+           (unsigned long long)sim.instructions, (unsigned long)sim.interrupts);
+    printf("Stack depth %u/%u, overflows %lu\n",
+           sim.max_depth, PIC14_STACK_LEVELS, (unsigned long)sim.stack_overflows);
+    printf("W 0x%02X  STATUS 0x%02X  PORTA 0x%02X  PORTB 0x%02X  PORTC 0x%02X  PORTD 0x%02X  PORTE 0x%02X\n",
+           sim.w, sim14_peek(&sim, PIC14_STATUS), sim14_peek(&sim, SIM14_PORTA),
+           sim14_peek(&sim, SIM14_PORTB), sim14_peek(&sim, SIM14_PORTC),
+           sim14_peek(&sim, SIM14_PORTD), sim14_peek(&sim, SIM14_PORTE));
+    trace14_report(&trace, stdout);
+    if (host > 0.0) {
+        printf("Host %.3f s, %.1f MIPS", host, (double)sim.instructions / host / 1e6);
+        if (fosc) {
+            printf(", %.1fx real time", (double)sim.cycles * 4.0 / (double)fosc / host);
+        }
+        printf("\n");
+    }
+    printf("\n");
+    return (stop == SIM14_BAD_OPCODE || sim.stack_overflows) ? 1 : 0;
+}
+
+static int usage(void)
+{
+    fprintf(stderr, "usage: picsim [-f fosc_hz] [-c cycles | -t seconds] [-s script] [-e]\n"
+                    "              [-v trace.vcd] [-u uart.txt] [-w REG]... [-m SIGNAL]... image.hex...\n");
+    return 2;
+}
+
+int main(int argc, char **argv)
+{
+    options_t opt;
+    int i, status = 0, files = 0;
+
+    memset(&opt, 0, sizeof(opt));
+    opt.cycles = DEFAULT_CYCLES;
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+            opt.fosc = strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            opt.cycles = strtoull(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            opt.seconds = strtod(argv[++i], NULL);
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            opt.script = argv[++i];
+        } else if (strcmp(argv[i], "-e") == 0) {
+            opt.echo = 1;
+        } else if (strcmp(argv[i], "-v") == 0 && i + 1 < argc) {
+            opt.vcd = argv[++i];
+        } else if (strcmp(argv[i], "-u") == 0 && i + 1 < argc) {
+            opt.uart = argv[++i];
+        } else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc && opt.watch_count < TRACE14_REGS) {
+            opt.watch[opt.watch_count++] = argv[++i];
+        } else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc && opt.measure_count < TRACE14_MEASURES) {
+            opt.measure[opt.measure_count++] = argv[++i];
+        } else if (argv[i][0] == '-') {
+            return usage();
+        } else {
+            int r;
+            if (files > 0 && (opt.vcd != NULL || opt.uart != NULL)) {
+                fprintf(stderr, "picsim: -v and -u trace a single image\n");
+                return 2;
+            }
+            r = simulate(argv[i], &opt);
+            if (r > status) {
+                status = r;
+            }
+            files++;
+        }
+    }
+    if (files == 0) {
+        return usage();
+    }
+    return status;
+}
@@ -0,0 +1,637 @@
+/* File:   sim14.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * PIC16F877A instruction-set simulator core (see sim14.h).
+ *
+ * Every banked address is translated once, at init, to a canonical address: mirrored
+ * registers (PCL, STATUS, FSR, PCLATH, INTCON, TMR0, OPTION_REG, PORTB, TRISB and the
+ * 0x70-0x7F common RAM) share one cell and unimplemented locations all land on the INDF
+ * cell, which reads 0 and ignores writes. Registers whose writes act on the core
+ * (PCL, STATUS, INTCON, PIR/PIE) or that a peripheral model hooked are flagged in special[]
+ * so the common path stays a table lookup.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "sim14.h"
+
+#define LINE_SIZE 600
+
+// special[] kinds
+#define SPECIAL_DISCARD 1   // INDF and unimplemented locations
+#define SPECIAL_PCL     2
+#define SPECIAL_STATUS  3
+#define SPECIAL_IRQ     4   // INTCON, PIR1, PIR2, PIE1, PIE2
+#define SPECIAL_HOOK    5   // Written through write_hook
+#define SPECIAL_KIND    0x7F
+#define SPECIAL_READ    0x80 // Read through read_hook (PCL: the program counter)
+
+#define RAM_INTCON  PIC14_INTCON
+#define RAM_STATUS  PIC14_STATUS
+
+static uint16_t canonical(uint16_t address)
+{
+    uint8_t bank = (uint8_t)(address >> 7);
+    uint8_t off = address & 0x7F;
+
+    if (off == 0x00) {
+        return 0;
+    }
+    if (off == PIC14_PCL || off == PIC14_STATUS || off == PIC14_FSR ||
+        off == PIC14_PCLATH || off == PIC14_INTCON || off >= 0x70) {
+        return off;
+    }
+    switch (bank) {
+    case 0:
+        return address;
+    case 1:
+        // 0x8F, 0x90, 0x95-0x97, 0x9A, 0x9B are unimplemented
+        if (off == 0x0F || off == 0x10 || (off >= 0x15 && off <= 0x17) || off == 0x1A || off == 0x1B) {
+            return 0;
+        }
+        return address;
+    case 2:
+        if (off == 0x01 || off == 0x06) {
+            return off;                     // TMR0, PORTB
+        }
+        return (off >= 0x0C) ? address : 0;
+    default:
+        if (off == 0x01 || off == 0x06) {
+            return (uint16_t)(0x80 | off);  // OPTION_REG, TRISB
+        }
+        return (off == 0x0C || off == 0x0D || off >= 0x10) ? address : 0;
+    }
+}
+
+void sim14_update_irq(sim14_t *sim)
+{
+    const uint8_t *ram = sim->ram;
+    uint8_t intcon = ram[RAM_INTCON];
+
+    sim->irq = (intcon & (intcon >> 3) & 0x07) != 0 ||
+               ((intcon & SIM14_PEIE) &&
+                ((ram[SIM14_PIR1] & ram[SIM14_PIE1]) || (ram[SIM14_PIR2] & ram[SIM14_PIE2])));
+}
+
+static void write_special(sim14_t *sim, uint16_t c, uint8_t value)
+{
+    switch (sim->special[c] & SPECIAL_KIND) {
+    case SPECIAL_DISCARD:
+        break;
+    case SPECIAL_PCL:
+        // Computed jump: PCLATH supplies PC<12:8>, one extra cycle to refill the pipeline
+        sim->ram[c] = value;
+        sim->pc = (uint16_t)(((sim->ram[PIC14_PCLATH] << 8) | value) & (PIC14_PROGRAM_WORDS - 1));
+        sim->cycles++;
+        break;
+    case SPECIAL_STATUS:
+        // TO and PD are read-only
+        sim->ram[c] = (uint8_t)((value & ~(SIM14_TO | SIM14_PD)) | (sim->ram[c] & (SIM14_TO | SIM14_PD)));
+        sim->bank = (uint16_t)((value & 0x60) << 2);
+        break;
+    case SPECIAL_IRQ:
+        sim->ram[c] = value;
+        sim14_update_irq(sim);
+        break;
+    case SPECIAL_HOOK:
+        sim->write_hook(sim, c, value);
+        break;
+    default:
+        sim->ram[c] = value;
+        break;
+    }
+}
+
+static inline uint16_t resolve(const sim14_t *sim, uint8_t f)
+{
+    if (f == 0) {
+        return sim->map[((sim->ram[RAM_STATUS] & SIM14_IRP) << 1) | sim->ram[PIC14_FSR]];
+    }
+    return sim->map[sim->bank | f];
+}
+
+static uint8_t read_special(sim14_t *sim, uint16_t c)
+{
+    // PC already points to the next instruction, as on the chip
+    return (c == PIC14_PCL) ? (uint8_t)sim->pc : sim->read_hook(sim, c);
+}
+
+static inline uint8_t read_file(sim14_t *sim, uint16_t c)
+{
+    return (sim->special[c] & SPECIAL_READ) ? read_special(sim, c) : sim->ram[c];
+}
+
+static inline void write_file(sim14_t *sim, uint16_t c, uint8_t value)
+{
+    if (sim->special[c]) {
+        write_special(sim, c, value);
+    } else {
+        sim->ram[c] = value;
+    }
+}
+
+static inline void push(sim14_t *sim, uint16_t address)
+{
+    sim->stack[sim->sp] = address;
+    sim->sp = (sim->sp + 1) & (PIC14_STACK_LEVELS - 1);
+    if (sim->depth < PIC14_STACK_LEVELS) {
+        if (++sim->depth > sim->max_depth) {
+            sim->max_depth = sim->depth;
+        }
+    } else {
+        sim->stack_overflows++;             // The oldest return address is lost
+    }
+}
+
+static inline uint16_t pop(sim14_t *sim)
+{
+    sim->sp = (sim->sp - 1) & (PIC14_STACK_LEVELS - 1);
+    if (sim->depth) {
+        sim->depth--;
+    }
+    return sim->stack[sim->sp];
+}
+
+void sim14_set_word(sim14_t *sim, uint16_t address, uint16_t word)
+{
+    address &= PIC14_PROGRAM_WORDS - 1;
+    sim->program[address] = word & 0x3FFF;
+    pic14_decode(sim->program[address], &sim->code[address]);
+}
+
+void sim14_init(sim14_t *sim)
+{
+    uint16_t a;
+
+    memset(sim, 0, sizeof(*sim));
+    for (a = 0; a < PIC14_PROGRAM_WORDS; a++) {
+        sim->program[a] = 0x3FFF;
+        sim->code[a].op = PIC14_INVALID;    // Unprogrammed: stop rather than run ADDLW 0xFF
+    }
+    for (a = 0; a < SIM14_RAM_SIZE; a++) {
+        sim->map[a] = canonical(a);
+    }
+    sim->special[0] = SPECIAL_DISCARD;
+    sim->special[PIC14_PCL] = SPECIAL_PCL | SPECIAL_READ;
+    sim->special[RAM_STATUS] = SPECIAL_STATUS;
+    sim->special[RAM_INTCON] = SPECIAL_IRQ;
+    sim->special[SIM14_PIR1] = SPECIAL_IRQ;
+    sim->special[SIM14_PIR2] = SPECIAL_IRQ;
+    sim->special[SIM14_PIE1] = SPECIAL_IRQ;
+    sim->special[SIM14_PIE2] = SPECIAL_IRQ;
+    sim->config = 0x3FFF;
+    memset(sim->eeprom, 0xFF, sizeof(sim->eeprom));
+    sim14_reset(sim);
+}
+
+void sim14_reset(sim14_t *sim)
+{
+    memset(sim->ram, 0, sizeof(sim->ram));
+    sim->ram[RAM_STATUS] = SIM14_TO | SIM14_PD;
+    sim->ram[SIM14_OPTION] = 0xFF;
+    sim->ram[SIM14_TRISA] = 0x3F;
+    sim->ram[0x086] = 0xFF;         // TRISB
+    sim->ram[0x087] = 0xFF;         // TRISC
+    sim->ram[0x088] = 0xFF;         // TRISD
+    sim->ram[0x089] = 0x07;         // TRISE
+    sim->ram[0x092] = 0xFF;         // PR2
+    sim->ram[0x098] = 0x02;         // TXSTA: TRMT
+    sim->ram[0x09C] = 0x07;         // CMCON: comparators off
+    sim->w = 0;
+    sim->pc = PIC14_RESET_VECTOR;
+    sim->bank = 0;
+    sim->sp = 0;
+    sim->depth = 0;
+    sim->irq = 0;
+    sim->asleep = 0;
+    sim->cycles = 0;
+    sim->instructions = 0;
+    sim->interrupts = 0;
+    sim->max_depth = 0;
+    sim->stack_overflows = 0;
+    sim->next_event = SIM14_NEVER;
+}
+
+int sim14_hook(sim14_t *sim, uint16_t address, int read, int write)
+{
+    uint16_t c = sim->map[address & (SIM14_RAM_SIZE - 1)];
+
+    if (c == 0 || c == PIC14_PCL || c == RAM_STATUS || (sim->special[c] & SPECIAL_KIND) == SPECIAL_IRQ) {
+        return 0;                           // Owned by the core
+    }
+    sim->special[c] |= (uint8_t)((write ? SPECIAL_HOOK : 0) | (read ? SPECIAL_READ : 0));
+    return 1;
+}
+
+uint8_t sim14_peek(const sim14_t *sim, uint16_t address)
+{
+    uint16_t c = sim->map[address & (SIM14_RAM_SIZE - 1)];
+    return (c == PIC14_PCL) ? (uint8_t)sim->pc : sim->ram[c];
+}
+
+void sim14_poke(sim14_t *sim, uint16_t address, uint8_t value)
+{
+    uint16_t c = sim->map[address & (SIM14_RAM_SIZE - 1)];
+
+    if (sim->special[c] == SPECIAL_DISCARD) {
+        return;
+    }
+    sim->ram[c] = value;
+    if (c == RAM_STATUS) {
+        sim->bank = (uint16_t)((value & 0x60) << 2);
+    } else if ((sim->special[c] & SPECIAL_KIND) == SPECIAL_IRQ) {
+        sim14_update_irq(sim);
+    }
+}
+
+/* ------------------------------------------------------------------------------------------ */
+/* Execution                                                                                  */
+/* ------------------------------------------------------------------------------------------ */
+
+#define STATUS_FLAGS(mask, bits) \
+    (ram[RAM_STATUS] = (uint8_t)((ram[RAM_STATUS] & ~(mask)) | (bits)))
+#define Z_OF(r)  ((r) ? 0 : SIM14_Z)
+
+// Store the result of a byte-oriented instruction in W (d = 0) or the file register
+#define DEST(r) do { \
+    if (in->d) { \
+        write_file(sim, a, (r)); \
+    } else { \
+        sim->w = (r); \
+    } \
+} while (0)
+
+#define SKIP() do { \
+    sim->pc = (sim->pc + 1) & (PIC14_PROGRAM_WORDS - 1); \
+    sim->cycles++; \
+} while (0)
+
+sim14_stop_t sim14_run(sim14_t *sim, uint64_t cycles)
+{
+    uint64_t end = sim->cycles + cycles;
+    uint8_t *ram = sim->ram;
+
+    while (sim->cycles < end) {
+        const pic14_insn_t *in;
+        uint16_t a, here;
+        unsigned sum;
+        uint8_t v, r, flags;
+
+        if (sim->cycles >= sim->next_event) {
+            sim->event(sim);
+        }
+        if (sim->asleep) {
+            if (!sim->irq) {
+                // Nothing executes until a peripheral event sets an enabled flag
+                if (sim->next_event == SIM14_NEVER) {
+                    return SIM14_ASLEEP;
+                }
+                sim->cycles = sim->next_event < end ? sim->next_event : end;
+                continue;
+            }
+            sim->asleep = 0;                // The next instruction runs before the vector
+            if (sim->event) {
+                sim->event(sim);            // Let the peripherals see the wake-up
+            }
+        }
+
+        here = sim->pc;
+        in = &sim->code[here];
+        sim->pc = (here + 1) & (PIC14_PROGRAM_WORDS - 1);
+        sim->cycles++;
+        sim->instructions++;
+
+        switch (in->op) {
+        case PIC14_ADDWF:
+            a = resolve(sim, in->f);
+            v = read_file(sim, a);
+            sum = (unsigned)v + sim->w;
+            r = (uint8_t)sum;
+            flags = (uint8_t)((sum > 0xFF ? SIM14_C : 0) |
+                              (((v & 0x0F) + (sim->w & 0x0F)) > 0x0F ? SIM14_DC : 0) | Z_OF(r));
+            DEST(r);
+            STATUS_FLAGS(SIM14_C | SIM14_DC | SIM14_Z, flags);
+            break;
+        case PIC14_SUBWF:
+            a = resolve(sim, in->f);
+            v = read_file(sim, a);
+            r = (uint8_t)(v - sim->w);
+            flags = (uint8_t)((v >= sim->w ? SIM14_C : 0) |
+                              ((v & 0x0F) >= (sim->w & 0x0F) ? SIM14_DC : 0) | Z_OF(r));
+            DEST(r);
+            STATUS_FLAGS(SIM14_C | SIM14_DC | SIM14_Z, flags);
+            break;
+        case PIC14_ANDWF:
+            a = resolve(sim, in->f);
+            r = read_file(sim, a) & sim->w;
+            DEST(r);
+            STATUS_FLAGS(SIM14_Z, Z_OF(r));
+            break;
+        case PIC14_IORWF:
+            a = resolve(sim, in->f);
+            r = read_file(sim, a) | sim->w;
+            DEST(r);
+            STATUS_FLAGS(SIM14_Z, Z_OF(r));
+            break;
+        case PIC14_XORWF:
+            a = resolve(sim, in->f);
+            r = read_file(sim, a) ^ sim->w;
+            DEST(r);
+            STATUS_FLAGS(SIM14_Z, Z_OF(r));
+            break;
+        case PIC14_CLRF:
+            a = resolve(sim, in->f);
+            write_file(sim, a, 0);
+            STATUS_FLAGS(SIM14_Z, SIM14_Z);
+            break;
+        case PIC14_CLRW:
+            sim->w = 0;
+            STATUS_FLAGS(SIM14_Z, SIM14_Z);
+            break;
+        case PIC14_COMF:
+            a = resolve(sim, in->f);
+            r = (uint8_t)~read_file(sim, a);
+            DEST(r);
+            STATUS_FLAGS(SIM14_Z, Z_OF(r));
+            break;
+        case PIC14_DECF:
+            a = resolve(sim, in->f);
+            r = (uint8_t)(read_file(sim, a) - 1);
+            DEST(r);
+            STATUS_FLAGS(SIM14_Z, Z_OF(r));
+            break;
+        case PIC14_INCF:
+            a = resolve(sim, in->f);
+            r = (uint8_t)(read_file(sim, a) + 1);
+            DEST(r);
+            STATUS_FLAGS(SIM14_Z, Z_OF(r));
+            break;
+        case PIC14_DECFSZ:
+            a = resolve(sim, in->f);
+            r = (uint8_t)(read_file(sim, a) - 1);
+            DEST(r);
+            if (r == 0) {
+                SKIP();
+            }
+            break;
+        case PIC14_INCFSZ:
+            a = resolve(sim, in->f);
+            r = (uint8_t)(read_file(sim, a) + 1);
+            DEST(r);
+            if (r == 0) {
+                SKIP();
+            }
+            break;
+        case PIC14_MOVF:
+            a = resolve(sim, in->f);
+            r = read_file(sim, a);
+            DEST(r);
+            STATUS_FLAGS(SIM14_Z, Z_OF(r));
+            break;
+        case PIC14_MOVWF:
+            write_file(sim, resolve(sim, in->f), sim->w);
+            break;
+        case PIC14_NOP:
+            break;
+        case PIC14_RLF:
+            a = resolve(sim, in->f);
+            v = read_file(sim, a);
+            r = (uint8_t)((v << 1) | (ram[RAM_STATUS] & SIM14_C));
+            DEST(r);
+            STATUS_FLAGS(SIM14_C, v >> 7);
+            break;
+        case PIC14_RRF:
+            a = resolve(sim, in->f);
+            v = read_file(sim, a);
+            r = (uint8_t)((v >> 1) | ((ram[RAM_STATUS] & SIM14_C) << 7));
+            DEST(r);
+            STATUS_FLAGS(SIM14_C, v & 0x01);
+            break;
+        case PIC14_SWAPF:
+            a = resolve(sim, in->f);
+            v = read_file(sim, a);
+            r = (uint8_t)((v << 4) | (v >> 4));
+            DEST(r);
+            break;
+
+        case PIC14_BCF:
+            a = resolve(sim, in->f);
+            write_file(sim, a, (uint8_t)(read_file(sim, a) & ~(1u << in->b)));
+            break;
+        case PIC14_BSF:
+            a = resolve(sim, in->f);
+            write_file(sim, a, (uint8_t)(read_file(sim, a) | (1u << in->b)));
+            break;
+        case PIC14_BTFSC:
+            if (!(read_file(sim, resolve(sim, in->f)) & (1u << in->b))) {
+                SKIP();
+            }
+            break;
+        case PIC14_BTFSS:
+            if (read_file(sim, resolve(sim, in->f)) & (1u << in->b)) {
+                SKIP();
+            }
+            break;
+
+        case PIC14_ADDLW:
+            sum = (unsigned)in->k + sim->w;
+            r = (uint8_t)sum;
+            STATUS_FLAGS(SIM14_C | SIM14_DC | SIM14_Z,
+                         (sum > 0xFF ? SIM14_C : 0) |
+                         (((in->k & 0x0F) + (sim->w & 0x0F)) > 0x0F ? SIM14_DC : 0) | Z_OF(r));
+            sim->w = r;
+            break;
+        case PIC14_SUBLW:
+            r = (uint8_t)(in->k - sim->w);
+            STATUS_FLAGS(SIM14_C | SIM14_DC | SIM14_Z,
+                         (in->k >= sim->w ? SIM14_C : 0) |
+                         ((in->k & 0x0F) >= (sim->w & 0x0F) ? SIM14_DC : 0) | Z_OF(r));
+            sim->w = r;
+            break;
+        case PIC14_ANDLW:
+            sim->w &= (uint8_t)in->k;
+            STATUS_FLAGS(SIM14_Z, Z_OF(sim->w));
+            break;
+        case PIC14_IORLW:
+            sim->w |= (uint8_t)in->k;
+            STATUS_FLAGS(SIM14_Z, Z_OF(sim->w));
+            break;
+        case PIC14_XORLW:
+            sim->w ^= (uint8_t)in->k;
+            STATUS_FLAGS(SIM14_Z, Z_OF(sim->w));
+            break;
+        case PIC14_MOVLW:
+            sim->w = (uint8_t)in->k;
+            break;
+
+        case PIC14_CALL:
+            push(sim, sim->pc);
+            sim->pc = (uint16_t)(((ram[PIC14_PCLATH] & 0x18) << 8) | in->k);
+            sim->cycles++;
+            break;
+        case PIC14_GOTO:
+            sim->pc = (uint16_t)(((ram[PIC14_PCLATH] & 0x18) << 8) | in->k);
+            sim->cycles++;
+            if (sim->pc == here && !(ram[RAM_INTCON] & SIM14_GIE)) {
+                return SIM14_HALT;
+            }
+            break;
+        case PIC14_RETURN:
+            sim->pc = pop(sim);
+            sim->cycles++;
+            break;
+        case PIC14_RETLW:
+            sim->w = (uint8_t)in->k;
+            sim->pc = pop(sim);
+            sim->cycles++;
+            break;
+        case PIC14_RETFIE:
+            sim->pc = pop(sim);
+            ram[RAM_INTCON] |= SIM14_GIE;
+            sim->cycles++;
+            break;
+
+        case PIC14_CLRWDT:
+            ram[RAM_STATUS] |= SIM14_TO | SIM14_PD;
+            break;
+        case PIC14_SLEEP:
+            // With an enabled flag already set, SLEEP completes as a NOP
+            if (!sim->irq) {
+                ram[RAM_STATUS] = (uint8_t)((ram[RAM_STATUS] | SIM14_TO) & ~SIM14_PD);
+                sim->asleep = 1;
+                if (sim->event) {
+                    sim->next_event = sim->cycles;
+                }
+            }
+            break;
+        case PIC14_OPTION:
+            write_file(sim, SIM14_OPTION, sim->w);
+            break;
+        case PIC14_TRIS:
+            write_file(sim, sim->map[0x80 | in->f], sim->w);
+            break;
+
+        default:
+            sim->pc = here;
+            sim->cycles--;
+            sim->instructions--;
+            return SIM14_BAD_OPCODE;
+        }
+
+        if (sim->irq && (ram[RAM_INTCON] & SIM14_GIE)) {
+            // Two dummy cycles while the hardware calls the vector
+            push(sim, sim->pc);
+            sim->pc = PIC14_INT_VECTOR;
+            ram[RAM_INTCON] &= (uint8_t)~SIM14_GIE;
+            sim->cycles += 2;
+            sim->interrupts++;
+        }
+    }
+    return SIM14_LIMIT;
+}
+
+/* ------------------------------------------------------------------------------------------ */
+/* Intel HEX                                                                                  */
+/* ------------------------------------------------------------------------------------------ */
+
+static int hex_byte(const char *s)
+{
+    int i, value = 0;
+    for (i = 0; i < 2; i++) {
+        char c = s[i];
+        value <<= 4;
+        if (c >= '0' && c <= '9') {
+            value |= c - '0';
+        } else if (c >= 'A' && c <= 'F') {
+            value |= c - 'A' + 10;
+        } else if (c >= 'a' && c <= 'f') {
+            value |= c - 'a' + 10;
+        } else {
+            return -1;
+        }
+    }
+    return value;
+}
+
+int sim14_load_hex(sim14_t *sim, const char *path, char *err, unsigned err_size)
+{
+    FILE *f = fopen(path, "r");
+    char line[LINE_SIZE];
+    uint8_t bytes[256];
+    uint32_t base = 0;
+    unsigned line_no = 0;
+    int eof = 0;
+
+    if (f == NULL) {
+        snprintf(err, err_size, "%s: cannot open", path);
+        return -1;
+    }
+    while (!eof && fgets(line, sizeof(line), f) != NULL) {
+        int count, type, i, sum = 0;
+        uint32_t offset;
+
+        line_no++;
+        if (line[0] != ':') {
+            continue;
+        }
+        count = hex_byte(line + 1);
+        for (i = 0; count >= 0 && i < count + 5; i++) {
+            int b = hex_byte(line + 1 + 2 * i);
+            if (b < 0) {
+                count = -1;
+                break;
+            }
+            if (i >= 4 && i < count + 4) {
+                bytes[i - 4] = (uint8_t)b;
+            }
+            sum += b;
+        }
+        if (count < 0 || (sum & 0xFF) != 0) {
+            snprintf(err, err_size, "%s:%u: bad record or checksum", path, line_no);
+            fclose(f);
+            return -1;
+        }
+        offset = (uint32_t)(hex_byte(line + 3) << 8 | hex_byte(line + 5));
+        type = hex_byte(line + 7);
+
+        switch (type) {
+        case 0x00:
+            for (i = 0; i < count; i++) {
+                uint32_t byte_address = base + offset + (uint32_t)i;
+                uint32_t word = byte_address >> 1;
+                int high = byte_address & 1;
+
+                if (word < PIC14_PROGRAM_WORDS) {
+                    uint16_t value = sim->program[word];
+                    value = high ? (uint16_t)((value & 0x00FF) | (bytes[i] << 8))
+                                 : (uint16_t)((value & 0xFF00) | bytes[i]);
+                    sim14_set_word(sim, (uint16_t)word, value);
+                } else if (word == SIM14_CONFIG_WORD) {
+                    sim->config = high ? (uint16_t)((sim->config & 0x00FF) | ((bytes[i] & 0x3F) << 8))
+                                       : (uint16_t)((sim->config & 0xFF00) | bytes[i]);
+                } else if (word >= SIM14_EEPROM_WORDS && word < SIM14_EEPROM_WORDS + SIM14_EEPROM_SIZE && !high) {
+                    sim->eeprom[word - SIM14_EEPROM_WORDS] = bytes[i];
+                }
+            }
+            break;
+        case 0x01:
+            eof = 1;
+            break;
+        case 0x02:
+            base = (uint32_t)(bytes[0] << 8 | bytes[1]) << 4;
+            break;
+        case 0x04:
+            base = (uint32_t)(bytes[0] << 8 | bytes[1]) << 16;
+            break;
+        default:
+            break;                          // Start address records
+        }
+    }
+    fclose(f);
+    if (!eof) {
+        snprintf(err, err_size, "%s: no end-of-file record", path);
+        return -1;
+    }
+    return 0;
+}
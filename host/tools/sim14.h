@@ -0,0 +1,138 @@
+/* File:   sim14.h
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Instruction-set simulator for the PIC16F877A mid-range core, used by the picsim tool
+ * and the host tests to run the XC8 HEX images without Proteus.
+ *
+ * Modelled: the 35 instructions with their exact cycle counts (2 for CALL/GOTO/returns,
+ * taken skips and writes to PCL), the four 128-byte RAM banks selected by STATUS<RP1:RP0>
+ * with the datasheet mirrors (Figure 2-3), INDF/FSR with STATUS<IRP>, PCLATH paging of
+ * CALL/GOTO and computed jumps, the 8-level circular return stack, the interrupt vector
+ * (GIE, PEIE and the INTCON/PIE1/PIE2 enables) and SLEEP.
+ *
+ * Program memory is decoded once when the image is loaded, so the run loop only
+ * dispatches on the decoded opcode.
+ *
+ * Peripheral models (periph14.c) attach through three hooks: read_hook/write_hook for the
+ * registers they claim with sim14_hook(), and event(), called before the first instruction
+ * at or after next_event and whenever the core enters or leaves SLEEP. The core itself
+ * costs nothing extra per instruction beyond one compare against next_event.
+ */
+
+#ifndef SIM14_H
+#define SIM14_H
+
+#include <stdint.h>
+#include "pic14.h"
+
+#define SIM14_RAM_SIZE      0x200   // 4 banks of 128 bytes
+#define SIM14_EEPROM_SIZE   256
+#define SIM14_CONFIG_WORD   0x2007
+#define SIM14_EEPROM_WORDS  0x2100  // HEX word address of the data EEPROM image
+#define SIM14_NEVER         UINT64_MAX
+
+// Register file addresses (bank << 7 | offset) used by the core
+#define SIM14_TMR0     0x001
+#define SIM14_PORTA    0x005
+#define SIM14_PORTB    0x006
+#define SIM14_PORTC    0x007
+#define SIM14_PORTD    0x008
+#define SIM14_PORTE    0x009
+#define SIM14_PIR1     0x00C
+#define SIM14_PIR2     0x00D
+#define SIM14_OPTION   0x081
+#define SIM14_TRISA    0x085
+#define SIM14_PIE1     0x08C
+#define SIM14_PIE2     0x08D
+
+// STATUS bits
+#define SIM14_C    0x01
+#define SIM14_DC   0x02
+#define SIM14_Z    0x04
+#define SIM14_PD   0x08
+#define SIM14_TO   0x10
+#define SIM14_IRP  0x80
+
+// INTCON bits
+#define SIM14_GIE  0x80
+#define SIM14_PEIE 0x40
+
+// Why sim14_run() returned
+typedef enum {
+    SIM14_LIMIT,        // Cycle limit reached
+    SIM14_HALT,         // GOTO to itself with interrupts disabled
+    SIM14_ASLEEP,       // SLEEP with no interrupt enabled to wake the core
+    SIM14_BAD_OPCODE    // Invalid or unprogrammed word executed
+} sim14_stop_t;
+
+typedef struct sim14 sim14_t;
+
+typedef uint8_t (*sim14_read_fn)(sim14_t *sim, uint16_t address);
+typedef void (*sim14_write_fn)(sim14_t *sim, uint16_t address, uint8_t value);
+typedef void (*sim14_event_fn)(sim14_t *sim);
+
+struct sim14 {
+    uint8_t w;
+    uint16_t pc;                            // Address of the next instruction
+    uint8_t ram[SIM14_RAM_SIZE];            // Indexed by canonical address, see map[]
+    uint16_t map[SIM14_RAM_SIZE];           // Banked address -> canonical address
+    uint8_t special[SIM14_RAM_SIZE];        // Canonical addresses with side effects
+    uint16_t bank;                          // STATUS<RP1:RP0> << 7
+    uint16_t stack[PIC14_STACK_LEVELS];
+    uint8_t sp;                             // Next free level, wraps like the hardware
+    uint8_t depth;                          // Current call depth, saturates at 8
+    uint8_t irq;                            // An enabled interrupt flag is set
+    uint8_t asleep;
+
+    // Program image
+    uint16_t program[PIC14_PROGRAM_WORDS];
+    pic14_insn_t code[PIC14_PROGRAM_WORDS];
+    uint16_t config;
+    uint8_t eeprom[SIM14_EEPROM_SIZE];      // __EEPROM_DATA from the HEX image, 0xFF if none
+
+    // Statistics
+    uint64_t cycles;                        // Instruction cycles (Fosc / 4)
+    uint64_t instructions;
+    uint32_t interrupts;
+    uint8_t max_depth;
+    uint32_t stack_overflows;
+
+    // Peripheral hooks; addresses passed to them are canonical (bank 0 for mirrors)
+    sim14_read_fn read_hook;
+    sim14_write_fn write_hook;              // Must store the value in ram[] itself
+    sim14_event_fn event;
+    uint64_t next_event;                    // SIM14_NEVER when no event is pending
+    void *context;
+};
+
+// Blank program memory (all words 0x3FFF) and power-on reset
+void sim14_init(sim14_t *sim);
+
+// Load an Intel HEX image (INHX32, byte addresses); returns 0 on success, otherwise -1
+// with a message in err
+int sim14_load_hex(sim14_t *sim, const char *path, char *err, unsigned err_size);
+
+// Store one program word and decode it
+void sim14_set_word(sim14_t *sim, uint16_t address, uint16_t word);
+
+// Power-on reset: registers take their datasheet Table 2-1 values, PC = 0
+void sim14_reset(sim14_t *sim);
+
+// Run until 'cycles' more instruction cycles have elapsed or the core stops
+sim14_stop_t sim14_run(sim14_t *sim, uint64_t cycles);
+
+// Route reads and/or writes of a register (any mirror) through read_hook/write_hook, in
+// addition to the hooks it already has. Returns 0 for the core registers (INDF, PCL,
+// STATUS, INTCON, PIR, PIE), which cannot be hooked.
+int sim14_hook(sim14_t *sim, uint16_t address, int read, int write);
+
+// Register access by banked address (0x000-0x1FF), without side effects: hooked registers
+// return the value last stored in ram[]
+uint8_t sim14_peek(const sim14_t *sim, uint16_t address);
+void sim14_poke(sim14_t *sim, uint16_t address, uint8_t value);
+
+// Recompute the pending interrupt after INTCON, PIR or PIE changed outside the program
+void sim14_update_irq(sim14_t *sim);
+
+#endif /* SIM14_H */
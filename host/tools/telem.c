@@ -0,0 +1,182 @@
+/* File:   telem.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Command-line receiver for the binary telemetry frames of common/frame.h (framedec.c).
+ * Reads a capture file, standard input ("-") or a serial device: a USB-UART adapter
+ * (/dev/ttyUSB0) or the pty end of a Proteus COMPIM/socat bridge (/dev/pts/N), which is put
+ * in raw mode at the given baud rate. Prints one line per valid frame with its sequence
+ * number, type, length and payload in hex, then the frame counts, the frames lost, the CRC
+ * failures and the share of the wire bytes that was payload.
+ *
+ * Usage: telem [-b baud] [-n frames] [-q] file|device|-
+ * -n stops after that many valid frames (a device is otherwise read until Ctrl-C), -q only
+ * prints the summary.
+ * The exit status is 1 when CRC failures, malformed frames or lost frames were seen, 2 on
+ * a usage or open error.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+#include "framedec.h"
+
+typedef struct {
+    int quiet;
+    unsigned long limit;
+    unsigned long count;
+} options_t;
+
+static volatile sig_atomic_t interrupted = 0;
+
+static void on_interrupt(int sig)
+{
+    (void)sig;
+    interrupted = 1;
+}
+
+static speed_t baud_constant(unsigned long baud)
+{
+    switch (baud) {
+    case 1200:   return B1200;
+    case 2400:   return B2400;
+    case 4800:   return B4800;
+    case 9600:   return B9600;
+    case 19200:  return B19200;
+    case 38400:  return B38400;
+    case 57600:  return B57600;
+    case 115200: return B115200;
+    case 230400: return B230400;
+    default:     return 0;
+    }
+}
+
+// Raw 8N1 at 'baud', reads return as soon as a byte is there
+static int configure_tty(int fd, unsigned long baud)
+{
+    struct termios tio;
+    speed_t speed = baud_constant(baud);
+
+    if (speed == 0) {
+        fprintf(stderr, "telem: unsupported baud rate %lu\n", baud);
+        return -1;
+    }
+    if (tcgetattr(fd, &tio) != 0) {
+        perror("telem: tcgetattr");
+        return -1;
+    }
+    cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cflag &= ~(tcflag_t)(CSTOPB | CRTSCTS);
+    tio.c_cc[VMIN] = 1;
+    tio.c_cc[VTIME] = 0;
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+    if (tcsetattr(fd, TCSANOW, &tio) != 0) {
+        perror("telem: tcsetattr");
+        return -1;
+    }
+    tcflush(fd, TCIFLUSH);
+    return 0;
+}
+
+static void print_frame(void *context, const framedec_frame_t *frame)
+{
+    options_t *opt = context;
+    unsigned i;
+
+    opt->count++;
+    if (opt->quiet) {
+        return;
+    }
+    printf("seq %3u  type 0x%02X  len %3u ", frame->seq, frame->type, frame->length);
+    for (i = 0; i < frame->length; i++) {
+        printf(" %02X", frame->payload[i]);
+    }
+    printf("\n");
+}
+
+static int usage(void)
+{
+    fprintf(stderr, "usage: telem [-b baud] [-n frames] [-q] file|device|-\n");
+    return 2;
+}
+
+int main(int argc, char **argv)
+{
+    static framedec_t dec;
+    options_t opt;
+    unsigned long baud = 9600;
+    const char *path = NULL;
+    uint8_t buf[4096];
+    struct sigaction sa;
+    int fd, i;
+
+    memset(&opt, 0, sizeof(opt));
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            baud = strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            opt.limit = strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "-q") == 0) {
+            opt.quiet = 1;
+        } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            return usage();
+        } else if (path == NULL) {
+            path = argv[i];
+        } else {
+            return usage();
+        }
+    }
+    if (path == NULL) {
+        return usage();
+    }
+
+    if (strcmp(path, "-") == 0) {
+        fd = STDIN_FILENO;
+    } else {
+        fd = open(path, O_RDONLY | O_NOCTTY);
+        if (fd < 0) {
+            fprintf(stderr, "telem: cannot open %s: %s\n", path, strerror(errno));
+            return 2;
+        }
+    }
+    if (isatty(fd) && configure_tty(fd, baud) != 0) {
+        return 2;
+    }
+
+    // Ctrl-C ends a live capture with the summary; no SA_RESTART so read() returns
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_interrupt;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    framedec_init(&dec, print_frame, &opt);
+    while (!interrupted && (opt.limit == 0 || opt.count < opt.limit)) {
+        ssize_t n = read(fd, buf, opt.limit ? 1 : sizeof(buf));
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            fprintf(stderr, "telem: read %s: %s\n", path, strerror(errno));
+            break;
+        }
+        if (n == 0) {
+            break;      // End of file
+        }
+        framedec_feed(&dec, buf, (size_t)n);
+        fflush(stdout);
+    }
+    if (fd != STDIN_FILENO) {
+        close(fd);
+    }
+
+    framedec_report(&dec, stdout);
+    return (dec.crc_errors || dec.malformed || dec.lost) ? 1 : 0;
+}
@@ -0,0 +1,589 @@
+/* File:   trace14.c
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Trace capture and timing analysis for simulated runs (see trace14.h).
+ *
+ * Each measurement keeps the distinct interval values it has seen with their counts: the
+ * simulator is cycle-exact, so a periodic signal produces a handful of distinct intervals
+ * and the histogram is exact without storing every edge.
+ */
+
+#include <ctype.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "trace14.h"
+
+#define BAR_WIDTH 40
+
+// VCD identifiers: one printable character per variable
+#define ID_PIN(port, bit)  ((char)('0' + (port) * 8 + (bit)))
+#define ID_REG(i)          ((char)('0' + PERIPH14_PORTS * 8 + (i)))
+#define ID_CHANNEL(c)      ((char)('0' + PERIPH14_PORTS * 8 + TRACE14_REGS + (c)))
+
+static const uint8_t port_masks[PERIPH14_PORTS] = { 0x3F, 0xFF, 0xFF, 0xFF, 0x07 };
+
+static const char *const channel_names[PERIPH14_CHANNELS] = {
+    "UART TX", "SPI out", "SPI in", "I2C out", "I2C in"
+};
+
+static const char *const channel_vars[PERIPH14_CHANNELS] = {
+    "uart_tx", "spi_out", "spi_in", "i2c_out", "i2c_in"
+};
+
+/* ------------------------------------------------------------------------------------------ */
+/* Helpers                                                                                    */
+/* ------------------------------------------------------------------------------------------ */
+
+static double seconds(const trace14_t *t, double cycles)
+{
+    return cycles * t->ns_per_cycle * 1e-9;
+}
+
+static char *format_time(char *buf, unsigned size, double s)
+{
+    if (s >= 1.0) {
+        snprintf(buf, size, "%.3f s", s);
+    } else if (s >= 1e-3) {
+        snprintf(buf, size, "%.3f ms", s * 1e3);
+    } else if (s >= 1e-6) {
+        snprintf(buf, size, "%.3f us", s * 1e6);
+    } else {
+        snprintf(buf, size, "%.0f ns", s * 1e9);
+    }
+    return buf;
+}
+
+static const char *pin_name(uint8_t port, uint8_t bit)
+{
+    return pic14_sfr_at((uint16_t)(0x005 + port))->bits[bit];
+}
+
+static int parse_pin(const char *s, uint8_t *port, uint8_t *bit)
+{
+    int p = toupper((unsigned char)s[1]) - 'A';
+
+    if (toupper((unsigned char)s[0]) != 'R' || p < 0 || p >= PERIPH14_PORTS ||
+        s[2] < '0' || s[2] > '7' || s[3] != '\0' || !(port_masks[p] & (1u << (s[2] - '0')))) {
+        return 0;
+    }
+    *port = (uint8_t)p;
+    *bit = (uint8_t)(s[2] - '0');
+    return 1;
+}
+
+// Register by name or address, canonical; 'label' receives the name used in the VCD and the report
+static int parse_register(const sim14_t *sim, const char *s, uint16_t *address, char *label, unsigned size)
+{
+    const pic14_sfr_t *sfr;
+    char *end;
+
+    if (isdigit((unsigned char)s[0])) {
+        unsigned long a = strtoul(s, &end, 0);
+        if (*end != '\0' || a >= SIM14_RAM_SIZE) {
+            return 0;
+        }
+        *address = sim->map[a];
+        sfr = pic14_sfr_at(*address);
+        if (sfr != NULL) {
+            snprintf(label, size, "%s", sfr->name);
+        } else {
+            snprintf(label, size, "r%03X", (unsigned)*address);
+        }
+        return 1;
+    }
+    sfr = pic14_sfr_named(s);
+    if (sfr == NULL) {
+        return 0;
+    }
+    *address = sim->map[sfr->address];
+    snprintf(label, size, "%s", sfr->name);
+    return 1;
+}
+
+static void add_interval(trace14_measure_t *m, uint64_t interval)
+{
+    unsigned lo = 0, hi = m->distinct;
+
+    if (m->count == 0 || interval < m->min) {
+        m->min = interval;
+    }
+    if (interval > m->max) {
+        m->max = interval;
+    }
+    m->count++;
+    m->sum += (double)interval;
+    m->sum_sq += (double)interval * (double)interval;
+
+    while (lo < hi) {
+        unsigned mid = (lo + hi) / 2;
+        if (m->values[mid] < interval) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo < m->distinct && m->values[lo] == interval) {
+        m->counts[lo]++;
+        return;
+    }
+    if (m->distinct == m->capacity) {
+        unsigned cap = m->capacity ? m->capacity * 2 : 16;
+        uint64_t *values = realloc(m->values, cap * sizeof(*values));
+        uint64_t *counts = values ? realloc(m->counts, cap * sizeof(*counts)) : NULL;
+        if (values == NULL || counts == NULL) {
+            if (values != NULL) {
+                m->values = values;
+            }
+            return;                         // Statistics stay exact, the histogram misses it
+        }
+        m->values = values;
+        m->counts = counts;
+        m->capacity = cap;
+    }
+    memmove(m->values + lo + 1, m->values + lo, (m->distinct - lo) * sizeof(*m->values));
+    memmove(m->counts + lo + 1, m->counts + lo, (m->distinct - lo) * sizeof(*m->counts));
+    m->values[lo] = interval;
+    m->counts[lo] = 1;
+    m->distinct++;
+}
+
+/* ------------------------------------------------------------------------------------------ */
+/* VCD and USART text                                                                         */
+/* ------------------------------------------------------------------------------------------ */
+
+static void vcd_time(trace14_t *t, uint64_t cycle)
+{
+    if (t->vcd_time != cycle) {
+        fprintf(t->vcd, "#%llu\n", (unsigned long long)((double)cycle * t->ns_per_cycle + 0.5));
+        t->vcd_time = cycle;
+    }
+}
+
+static void vcd_byte(trace14_t *t, uint8_t value, char id)
+{
+    int i;
+
+    fputc('b', t->vcd);
+    for (i = 7; i >= 0; i--) {
+        fputc('0' + ((value >> i) & 1), t->vcd);
+    }
+    fprintf(t->vcd, " %c\n", id);
+    t->vcd_changes++;
+}
+
+static void uart_line(trace14_t *t)
+{
+    if (t->uart != NULL) {
+        fprintf(t->uart, "%12.6f  %.*s\n", seconds(t, (double)t->line_start), (int)t->line_length, t->line);
+    }
+    t->line_length = 0;
+    t->uart_lines++;
+}
+
+static void uart_byte(trace14_t *t, uint64_t cycle, uint8_t byte)
+{
+    char text[5];
+    unsigned length;
+
+    if (byte == '\r') {
+        return;
+    }
+    if (t->line_length == 0) {
+        t->line_start = cycle;
+    }
+    if (byte == '\n') {
+        uart_line(t);
+        return;
+    }
+    if (byte >= 0x20 && byte < 0x7F && byte != '\\') {
+        text[0] = (char)byte;
+        text[1] = '\0';
+    } else {
+        snprintf(text, sizeof(text), "\\x%02X", byte);
+    }
+    length = (unsigned)strlen(text);
+    if (t->line_length + length > TRACE14_LINE_SIZE) {
+        uart_line(t);                       // Continues on a new line with its own time
+        t->line_start = cycle;
+    }
+    memcpy(t->line + t->line_length, text, length);
+    t->line_length += length;
+}
+
+/* ------------------------------------------------------------------------------------------ */
+/* Observer                                                                                   */
+/* ------------------------------------------------------------------------------------------ */
+
+static void on_pin(void *ctx, uint64_t cycle, uint8_t port, uint8_t level)
+{
+    trace14_t *t = ctx;
+    uint8_t changed = (uint8_t)((t->levels[port] ^ level) & port_masks[port]);
+    unsigned i;
+    int bit;
+
+    t->pin_changes[port]++;
+    if (t->vcd != NULL && changed) {
+        vcd_time(t, cycle);
+        for (bit = 0; bit < 8; bit++) {
+            if (changed & (1u << bit)) {
+                fprintf(t->vcd, "%c%c\n", '0' + ((level >> bit) & 1), ID_PIN(port, bit));
+                t->vcd_changes++;
+            }
+        }
+    }
+    for (i = 0; i < t->measure_count; i++) {
+        trace14_measure_t *m = &t->measures[i];
+        if (!m->is_pin || m->port != port || !(changed & (1u << m->bit))) {
+            continue;
+        }
+        if (level & (1u << m->bit)) {
+            if (m->last != SIM14_NEVER) {
+                add_interval(m, cycle - m->last);
+            }
+            m->last = cycle;
+        } else if (m->last != SIM14_NEVER) {
+            m->high_sum += cycle - m->last;
+            m->high_count++;
+        }
+    }
+    t->levels[port] = level;
+}
+
+static void on_serial(void *ctx, uint64_t cycle, uint8_t channel, uint8_t byte)
+{
+    trace14_t *t = ctx;
+
+    if (t->first[channel] == SIM14_NEVER) {
+        t->first[channel] = cycle;
+    } else {
+        uint64_t gap = cycle - t->last[channel];
+        if (t->min_gap[channel] == 0 || gap < t->min_gap[channel]) {
+            t->min_gap[channel] = gap;
+        }
+        if (gap > t->max_gap[channel]) {
+            t->max_gap[channel] = gap;
+        }
+    }
+    t->last[channel] = cycle;
+    if (t->vcd != NULL) {
+        vcd_time(t, cycle);
+        vcd_byte(t, byte, ID_CHANNEL(channel));
+    }
+    if (channel == PERIPH14_UART_TX) {
+        uart_byte(t, cycle, byte);
+        if (t->echo) {
+            putchar(byte);
+        }
+    }
+}
+
+static void on_reg(void *ctx, uint64_t cycle, uint16_t address, uint8_t value)
+{
+    trace14_t *t = ctx;
+    unsigned i;
+
+    for (i = 0; i < t->reg_count; i++) {
+        if (t->regs[i] == address && t->reg_values[i] != value) {
+            t->reg_values[i] = value;
+            if (t->vcd != NULL) {
+                vcd_time(t, cycle);
+                vcd_byte(t, value, ID_REG(i));
+            }
+        }
+    }
+    for (i = 0; i < t->measure_count; i++) {
+        trace14_measure_t *m = &t->measures[i];
+        if (!m->is_pin && m->address == address) {
+            if (m->last != SIM14_NEVER) {
+                add_interval(m, cycle - m->last);
+            }
+            m->last = cycle;
+        }
+    }
+}
+
+/* ------------------------------------------------------------------------------------------ */
+/* API                                                                                        */
+/* ------------------------------------------------------------------------------------------ */
+
+void trace14_init(trace14_t *t, periph14_t *p)
+{
+    int i;
+
+    memset(t, 0, sizeof(*t));
+    t->periph = p;
+    t->ns_per_cycle = 4e9 / (double)p->fosc;
+    memcpy(t->levels, p->pins, sizeof(t->levels));
+    t->vcd_time = SIM14_NEVER;
+    for (i = 0; i < PERIPH14_CHANNELS; i++) {
+        t->first[i] = SIM14_NEVER;
+    }
+    p->observer.pin = on_pin;
+    p->observer.serial = on_serial;
+    p->observer.reg = on_reg;
+    p->observer.ctx = t;
+}
+
+int trace14_watch(trace14_t *t, const char *name, char *err, unsigned err_size)
+{
+    char label[16];
+    uint16_t address;
+    unsigned i;
+
+    if (!parse_register(t->periph->sim, name, &address, label, sizeof(label))) {
+        snprintf(err, err_size, "%s: unknown register", name);
+        return -1;
+    }
+    for (i = 0; i < t->reg_count; i++) {
+        if (t->regs[i] == address) {
+            return 0;
+        }
+    }
+    if (t->reg_count == TRACE14_REGS) {
+        snprintf(err, err_size, "%s: more than %d registers", name, TRACE14_REGS);
+        return -1;
+    }
+    if (!periph14_watch(t->periph, address)) {
+        snprintf(err, err_size, "%s: core register, writes cannot be traced", name);
+        return -1;
+    }
+    t->regs[t->reg_count] = address;
+    t->reg_values[t->reg_count] = t->periph->sim->ram[address];
+    snprintf(t->reg_names[t->reg_count], sizeof(t->reg_names[0]), "%s", label);
+    t->reg_count++;
+    return 0;
+}
+
+int trace14_measure(trace14_t *t, const char *signal, char *err, unsigned err_size)
+{
+    trace14_measure_t *m;
+
+    if (t->measure_count == TRACE14_MEASURES) {
+        snprintf(err, err_size, "%s: more than %d measurements", signal, TRACE14_MEASURES);
+        return -1;
+    }
+    m = &t->measures[t->measure_count];
+    memset(m, 0, sizeof(*m));
+    m->last = SIM14_NEVER;
+    if (parse_pin(signal, &m->port, &m->bit)) {
+        m->is_pin = 1;
+        snprintf(m->name, sizeof(m->name), "%s", pin_name(m->port, m->bit));
+    } else if (parse_register(t->periph->sim, signal, &m->address, m->name, sizeof(m->name))) {
+        if (!periph14_watch(t->periph, m->address)) {
+            snprintf(err, err_size, "%s: core register, writes cannot be traced", signal);
+            return -1;
+        }
+    } else {
+        snprintf(err, err_size, "%s: not a pin (RC4) or a register (PORTB, 0x20)", signal);
+        return -1;
+    }
+    t->measure_count++;
+    return 0;
+}
+
+int trace14_open_vcd(trace14_t *t, const char *path)
+{
+    t->vcd = fopen(path, "w");
+    return t->vcd ? 0 : -1;
+}
+
+int trace14_open_uart(trace14_t *t, const char *path)
+{
+    t->uart = fopen(path, "w");
+    return t->uart ? 0 : -1;
+}
+
+void trace14_start(trace14_t *t, const char *comment)
+{
+    uint8_t port, bit;
+    unsigned i;
+
+    if (t->vcd == NULL) {
+        return;
+    }
+    fprintf(t->vcd, "$comment %s $end\n$version picsim $end\n$timescale 1ns $end\n", comment);
+    fprintf(t->vcd, "$scope module pic16f877a $end\n");
+    for (port = 0; port < PERIPH14_PORTS; port++) {
+        for (bit = 0; bit < 8; bit++) {
+            if (port_masks[port] & (1u << bit)) {
+                fprintf(t->vcd, "$var wire 1 %c %s $end\n", ID_PIN(port, bit), pin_name(port, bit));
+            }
+        }
+    }
+    for (i = 0; i < t->reg_count; i++) {
+        fprintf(t->vcd, "$var reg 8 %c %s $end\n", ID_REG(i), t->reg_names[i]);
+    }
+    for (i = 0; i < PERIPH14_CHANNELS; i++) {
+        fprintf(t->vcd, "$var reg 8 %c %s $end\n", ID_CHANNEL(i), channel_vars[i]);
+    }
+    fprintf(t->vcd, "$upscope $end\n$enddefinitions $end\n");
+
+    vcd_time(t, t->periph->sim->cycles);
+    fprintf(t->vcd, "$dumpvars\n");
+    for (port = 0; port < PERIPH14_PORTS; port++) {
+        for (bit = 0; bit < 8; bit++) {
+            if (port_masks[port] & (1u << bit)) {
+                fprintf(t->vcd, "%c%c\n", '0' + ((t->levels[port] >> bit) & 1), ID_PIN(port, bit));
+            }
+        }
+    }
+    for (i = 0; i < t->reg_count; i++) {
+        vcd_byte(t, t->reg_values[i], ID_REG(i));
+    }
+    for (i = 0; i < PERIPH14_CHANNELS; i++) {
+        fprintf(t->vcd, "bxxxxxxxx %c\n", ID_CHANNEL(i));
+    }
+    fprintf(t->vcd, "$end\n");
+    t->vcd_changes = 0;
+}
+
+void trace14_finish(trace14_t *t, uint64_t cycle)
+{
+    if (t->line_length) {
+        uart_line(t);
+    }
+    if (t->uart != NULL) {
+        fclose(t->uart);
+        t->uart = NULL;
+    }
+    if (t->vcd != NULL) {
+        vcd_time(t, cycle);                 // The viewer shows the whole run
+        fclose(t->vcd);
+        t->vcd = NULL;
+    }
+}
+
+static void report_histogram(const trace14_t *t, const trace14_measure_t *m, FILE *out)
+{
+    uint64_t rows[TRACE14_BINS], starts[TRACE14_BINS];
+    uint64_t width = 1, peak = 0;
+    unsigned count, i, j;
+    char a[32], b[32], label[72];
+
+    if (m->distinct <= TRACE14_BINS) {
+        count = m->distinct;
+        for (i = 0; i < count; i++) {
+            starts[i] = m->values[i];
+            rows[i] = m->counts[i];
+        }
+    } else {
+        count = TRACE14_BINS;
+        width = (m->max - m->min) / TRACE14_BINS + 1;
+        memset(rows, 0, sizeof(rows));
+        for (i = 0; i < count; i++) {
+            starts[i] = m->min + i * width;
+        }
+        for (i = 0; i < m->distinct; i++) {
+            rows[(m->values[i] - m->min) / width] += m->counts[i];
+        }
+    }
+    for (i = 0; i < count; i++) {
+        if (rows[i] > peak) {
+            peak = rows[i];
+        }
+    }
+    for (i = 0; i < count; i++) {
+        unsigned bar = (unsigned)(rows[i] * BAR_WIDTH / peak);
+        format_time(a, sizeof(a), seconds(t, (double)starts[i]));
+        if (width == 1) {
+            snprintf(label, sizeof(label), "%s", a);
+        } else {
+            format_time(b, sizeof(b), seconds(t, (double)(starts[i] + width - 1)));
+            snprintf(label, sizeof(label), "%s - %s", a, b);
+        }
+        fprintf(out, "  %28s %10llu ", label, (unsigned long long)rows[i]);
+        for (j = 0; j < (bar ? bar : (rows[i] ? 1u : 0u)); j++) {
+            fputc('#', out);
+        }
+        fputc('\n', out);
+    }
+}
+
+static void report_measure(const trace14_t *t, const trace14_measure_t *m, FILE *out)
+{
+    double mean, sd;
+    char a[32], b[32], c[32], d[32], e[32];
+
+    if (m->count == 0) {
+        fprintf(out, "%s: no complete %s\n", m->name, m->is_pin ? "period" : "interval between writes");
+        return;
+    }
+    mean = m->sum / (double)m->count;
+    sd = m->sum_sq / (double)m->count - mean * mean;
+    sd = sd > 0.0 ? sqrt(sd) : 0.0;
+    fprintf(out, "%s %s: %llu, mean %s (%.3f Hz), min %s, max %s, jitter %s RMS / %s p-p",
+            m->name, m->is_pin ? "period" : "write interval", (unsigned long long)m->count,
+            format_time(a, sizeof(a), seconds(t, mean)), 1.0 / seconds(t, mean),
+            format_time(b, sizeof(b), seconds(t, (double)m->min)),
+            format_time(c, sizeof(c), seconds(t, (double)m->max)),
+            format_time(d, sizeof(d), seconds(t, sd)),
+            format_time(e, sizeof(e), seconds(t, (double)(m->max - m->min))));
+    if (m->is_pin && m->high_count) {
+        fprintf(out, ", duty %.1f %%", 100.0 * ((double)m->high_sum / (double)m->high_count) / mean);
+    }
+    fprintf(out, "\n");
+    if (m->distinct) {
+        report_histogram(t, m, out);
+    }
+}
+
+void trace14_report(const trace14_t *t, FILE *out)
+{
+    static const char ports[] = "ABCDE";
+    const periph14_t *p = t->periph;
+    char a[32], b[32], c[32];
+    unsigned i;
+
+    fprintf(out, "Pin changes:");
+    for (i = 0; i < PERIPH14_PORTS; i++) {
+        fprintf(out, " PORT%c %lu", ports[i], (unsigned long)t->pin_changes[i]);
+    }
+    fprintf(out, "\n");
+    for (i = 0; i < PERIPH14_CHANNELS; i++) {
+        if (p->bytes[i] == 0) {
+            continue;
+        }
+        fprintf(out, "%s %lu bytes", channel_names[i], (unsigned long)p->bytes[i]);
+        if (p->bytes[i] > 1) {
+            // Average between the first and the last byte, peak from the shortest gap
+            double span = seconds(t, (double)(t->last[i] - t->first[i]));
+            fprintf(out, " in %s: %.1f bytes/s, peak %.1f bytes/s, gaps %s - %s",
+                    format_time(a, sizeof(a), span), (double)(p->bytes[i] - 1) / span,
+                    1.0 / seconds(t, (double)t->min_gap[i]),
+                    format_time(b, sizeof(b), seconds(t, (double)t->min_gap[i])),
+                    format_time(c, sizeof(c), seconds(t, (double)t->max_gap[i])));
+        }
+        fprintf(out, "\n");
+    }
+    if (p->rx_bytes || p->rx_overruns) {
+        fprintf(out, "UART RX %lu bytes, %lu overruns\n", (unsigned long)p->rx_bytes, (unsigned long)p->rx_overruns);
+    }
+    if (p->conversions || p->ee_writes) {
+        fprintf(out, "ADC conversions %lu, EEPROM writes %lu\n",
+                (unsigned long)p->conversions, (unsigned long)p->ee_writes);
+    }
+    fprintf(out, "Peripheral events %lu\n", (unsigned long)p->events);
+    if (t->vcd_changes) {
+        fprintf(out, "VCD %llu value changes\n", (unsigned long long)t->vcd_changes);
+    }
+    if (t->uart_lines) {
+        fprintf(out, "UART text %lu lines\n", (unsigned long)t->uart_lines);
+    }
+    for (i = 0; i < t->measure_count; i++) {
+        report_measure(t, &t->measures[i], out);
+    }
+}
+
+void trace14_free(trace14_t *t)
+{
+    unsigned i;
+
+    for (i = 0; i < t->measure_count; i++) {
+        free(t->measures[i].values);
+        free(t->measures[i].counts);
+        t->measures[i].values = NULL;
+        t->measures[i].counts = NULL;
+    }
+}
@@ -0,0 +1,104 @@
+/* File:   trace14.h
+ * Author: Marwen Maghrebi
+ *
+ * Description:
+ * Trace capture and timing analysis for simulated runs (sim14 + periph14), used by picsim:
+ *   - Value Change Dump (IEEE 1364 VCD) of every port pin, of the registers given to
+ *     trace14_watch() and of the bytes on each serial channel, for GTKWave. Only changes are
+ *     written, so the file grows with activity, not with simulated time.
+ *   - USART TX decoded to a text file, one line per '\n' with the time of its first byte.
+ *   - Measurements: the period, duty cycle and jitter of a pin (rising edge to rising edge)
+ *     or the interval between program writes of a register, with a histogram of the
+ *     intervals; bytes, throughput and inter-byte gaps of every serial channel.
+ *
+ * The tracer installs itself as the periph14 observer. Times are in instruction cycles
+ * internally and converted with the Fosc given to periph14_attach().
+ */
+
+#ifndef TRACE14_H
+#define TRACE14_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "periph14.h"
+
+#define TRACE14_REGS      16      // Watched registers in the VCD
+#define TRACE14_MEASURES  8
+#define TRACE14_BINS      16      // Histogram rows
+#define TRACE14_LINE_SIZE 256     // UART text line buffer
+
+typedef struct {
+    char name[16];
+    uint8_t is_pin;
+    uint8_t port, bit;          // Pin
+    uint16_t address;           // Register (canonical)
+    uint64_t last;              // Previous rising edge or write, SIM14_NEVER before the first
+    uint64_t count;             // Intervals measured
+    uint64_t min, max;
+    double sum, sum_sq;
+    uint64_t high_sum, high_count;  // Pin: high time of each period
+    // Exact histogram: distinct interval values (cycles) and their counts, sorted
+    uint64_t *values;
+    uint64_t *counts;
+    unsigned distinct, capacity;
+} trace14_measure_t;
+
+typedef struct {
+    periph14_t *periph;
+    double ns_per_cycle;
+    uint8_t levels[PERIPH14_PORTS];     // Pin levels seen so far
+
+    // VCD
+    FILE *vcd;
+    uint64_t vcd_time;                  // Last timestamp written (cycles), SIM14_NEVER = none
+    uint64_t vcd_changes;
+    uint16_t regs[TRACE14_REGS];
+    uint8_t reg_values[TRACE14_REGS];
+    char reg_names[TRACE14_REGS][16];
+    unsigned reg_count;
+
+    // USART text
+    FILE *uart;
+    char line[TRACE14_LINE_SIZE];
+    unsigned line_length;
+    uint64_t line_start;
+    uint32_t uart_lines;
+    int echo;                           // Also copy the USART output to stdout
+
+    trace14_measure_t measures[TRACE14_MEASURES];
+    unsigned measure_count;
+
+    // Activity
+    uint32_t pin_changes[PERIPH14_PORTS];
+    uint64_t first[PERIPH14_CHANNELS], last[PERIPH14_CHANNELS];
+    uint64_t min_gap[PERIPH14_CHANNELS], max_gap[PERIPH14_CHANNELS];
+} trace14_t;
+
+// Start tracing a simulator with its peripherals attached (replaces p->observer)
+void trace14_init(trace14_t *t, periph14_t *p);
+
+// Record program writes of a register, by name ("CCPR1L", case-insensitive) or address
+// ("0x20"), in the VCD. Returns 0, or -1 with a message in err.
+int trace14_watch(trace14_t *t, const char *name, char *err, unsigned err_size);
+
+// Measure a pin ("RC4": period, duty cycle, jitter) or the writes of a register ("PORTB":
+// update interval). Returns 0, or -1 with a message in err.
+int trace14_measure(trace14_t *t, const char *signal, char *err, unsigned err_size);
+
+// Output files; return 0, or -1 if the file cannot be created
+int trace14_open_vcd(trace14_t *t, const char *path);
+int trace14_open_uart(trace14_t *t, const char *path);
+
+// Write the VCD header and the initial values; call after the watches, before running
+void trace14_start(trace14_t *t, const char *comment);
+
+// Flush the last UART line, write the end time to the VCD and close the files
+void trace14_finish(trace14_t *t, uint64_t cycle);
+
+// Pin changes, serial throughput and the measurements with their histograms
+void trace14_report(const trace14_t *t, FILE *out);
+
+// Release the histograms
+void trace14_free(trace14_t *t);
+
+#endif /* TRACE14_H */